@@ -0,0 +1,80 @@
+/**
+ *  @file    append_writer.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief writer, which keeps a file open to append text to it
+ *
+ *  @detail The appended text is collected in a buffer, which is written into the file, when it
+ *          is full or regularly by a background-thread. Multiple threads can append at the same
+ *          time and a sync can be requested for each append. Concurrent sync-requests are
+ *          grouped, so a single fdatasync covers the text of all threads, which waited for it.
+ */
+
+#ifndef APPEND_WRITER_H
+#define APPEND_WRITER_H
+
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class AppendWriter
+{
+public:
+    AppendWriter(const uint64_t bufferSize = 64 * 1024,
+                 const uint32_t flushInterval = 100);
+    ~AppendWriter();
+
+    AppendWriter(const AppendWriter &other) = delete;
+    AppendWriter &operator=(const AppendWriter &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage);
+    bool closeFile();
+
+    bool appendText(const std::string &newText,
+                    const bool sync = false);
+    bool flush();
+    bool syncFile();
+
+    // public variables to avoid stupid getter
+    std::string m_filePath = "";
+
+private:
+    uint64_t m_bufferSize = 0;
+    uint32_t m_flushInterval = 0;
+
+    int m_fileDescriptor = -1;
+    std::string m_buffer = "";
+    std::mutex m_lock;
+
+    // number of appended bytes and number of bytes, which are already synced to the storage
+    uint64_t m_appendedSize = 0;
+    uint64_t m_syncedSize = 0;
+    bool m_syncInProgress = false;
+    std::condition_variable m_syncCondition;
+
+    std::thread* m_flushThread = nullptr;
+    std::mutex m_threadLock;
+    std::condition_variable m_threadCondition;
+    bool m_stopThread = false;
+
+    bool writeBuffer();
+    bool writeIntoFile(const char* data,
+                       const uint64_t dataSize,
+                       uint64_t &writtenSize);
+    void runFlushThread();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // APPEND_WRITER_H
@@ -53,6 +53,16 @@ public:
                       const uint64_t startBlockInFile,
                       const uint64_t numberOfBlocks,
                       const uint64_t startBlockInBuffer = 0);
+
+    bool readDataFromFile(void* data,
+                          const uint64_t startBytePosition,
+                          const uint64_t numberOfBytes);
+    bool writeDataIntoFile(const void* data,
+                           const uint64_t startBytePosition,
+                           const uint64_t numberOfBytes);
+    bool truncateFile(const uint64_t numberOfBytes);
+    bool syncFile();
+
     bool closeFile();
 
     // public variables to avoid stupid getter
@@ -0,0 +1,133 @@
+/**
+ *  @file    change_tracker.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief incremental detection of added, removed and modified files of a directory-tree
+ *
+ *  @detail The tracker keeps a manifest with inode, size and modification-time of all files
+ *          and directories of the tree, which is persisted in a compact binary file. At a
+ *          rescan, directories with unchanged inode and modification-time are not read again,
+ *          because their list of entries can not have changed. Only their files are checked with
+ *          a cheap statx-call, which can also be disabled. In the live-mode all directories are
+ *          watched with inotify and only the directories and files of the events are checked
+ *          again, so the costs depend only on the number of changes.
+ */
+
+#ifndef CHANGE_TRACKER_H
+#define CHANGE_TRACKER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+enum ChangeType
+{
+    FILE_ADDED = 0,
+    FILE_REMOVED = 1,
+    FILE_MODIFIED = 2,
+};
+
+struct FileChange
+{
+    ChangeType type = FILE_ADDED;
+    std::string path = "";
+};
+
+class ChangeTracker
+{
+public:
+    ChangeTracker(const bool checkFiles = true);
+    ~ChangeTracker();
+
+    ChangeTracker(const ChangeTracker &other) = delete;
+    ChangeTracker &operator=(const ChangeTracker &other) = delete;
+
+    bool initTracker(const std::string &rootPath,
+                     const std::string &manifestPath,
+                     std::string &errorMessage);
+    bool closeTracker(std::string &errorMessage);
+
+    bool scanChanges(std::vector<FileChange> &changes,
+                     std::string &errorMessage);
+    bool startWatching(std::string &errorMessage);
+    bool waitForChanges(std::vector<FileChange> &changes,
+                        const uint32_t timeoutMs,
+                        std::string &errorMessage);
+    bool saveManifest(std::string &errorMessage);
+
+    uint64_t getNumberOfFiles() const;
+
+    // public variables to avoid stupid getter
+    std::string m_rootPath = "";
+    std::string m_manifestPath = "";
+
+private:
+    struct FileRecord
+    {
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        int64_t modificationTime = 0;
+    };
+
+    struct DirectoryRecord
+    {
+        uint64_t inode = 0;
+        // -1, if the modification-time was too new to be trusted at the next scan
+        int64_t modificationTime = -1;
+        std::vector<std::string> subdirectories;
+        std::unordered_map<std::string, FileRecord> files;
+        int watchDescriptor = -1;
+    };
+
+    struct DirtyDirectory
+    {
+        // true, if entries were created, deleted or moved
+        bool structureChanged = false;
+        std::unordered_set<std::string> fileNames;
+    };
+
+    bool m_isInit = false;
+    bool m_checkFiles = true;
+    bool m_manifestChanged = false;
+    std::unordered_map<std::string, DirectoryRecord> m_directories;
+    std::vector<uint8_t> m_entryBuffer;
+
+    int m_inotifyDescriptor = -1;
+    std::unordered_map<int, std::string> m_watches;
+
+    bool loadManifest();
+    bool scanTree(const std::string &relativePath,
+                  std::vector<FileChange> &changes,
+                  std::string &errorMessage);
+    bool scanDirectory(const std::string &relativePath,
+                       const bool forceRead,
+                       std::vector<FileChange> &changes,
+                       std::vector<std::string> &subdirectories,
+                       std::vector<std::string> &newSubdirectories,
+                       std::string &errorMessage);
+    void checkFiles(const std::string &relativePath,
+                    const std::unordered_set<std::string> &fileNames,
+                    DirtyDirectory &dirty,
+                    std::vector<FileChange> &changes);
+    void removeDirectory(const std::string &relativePath,
+                         std::vector<FileChange> &changes);
+    bool addWatch(const std::string &relativePath,
+                  DirectoryRecord &record,
+                  std::string &errorMessage);
+
+    const std::string getFullPath(const std::string &relativePath) const;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // CHANGE_TRACKER_H
@@ -0,0 +1,105 @@
+/**
+ *  @file    compressed_file.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief read and write gzip- and zstd-compressed text-files
+ *
+ *  @detail The compression of a file is detected by the magic bytes at its beginning, so
+ *          compressed and uncompressed files can be read with the same functions. The
+ *          decompression runs in a separate thread, which fills a small ring of blocks, while
+ *          the caller consumes the already decompressed data. The LineReader uses the same
+ *          mechanism to read the lines of compressed files. Zstd is only available, if the
+ *          library was build with the config-option "with_zstd".
+ */
+
+#ifndef COMPRESSED_FILE_H
+#define COMPRESSED_FILE_H
+
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+struct TempFile;
+
+enum CompressionType
+{
+    NO_COMPRESSION = 0,
+    GZIP_COMPRESSION = 1,
+    ZSTD_COMPRESSION = 2,
+};
+
+bool detectCompression(CompressionType &compression,
+                       const std::string &filePath,
+                       std::string &errorMessage);
+
+bool readCompressedFile(std::string &content,
+                        const std::string &filePath,
+                        std::string &errorMessage);
+bool writeCompressedFile(const std::string &filePath,
+                         const std::string &content,
+                         const CompressionType compression,
+                         std::string &errorMessage,
+                         const int compressionLevel = 0);
+bool appendCompressedText(const std::string &filePath,
+                          const std::string &newText,
+                          const CompressionType compression,
+                          std::string &errorMessage,
+                          const int compressionLevel = 0);
+
+//==================================================================================================
+
+class CompressedWriter
+{
+public:
+    CompressedWriter(const CompressionType compression = GZIP_COMPRESSION,
+                     const int compressionLevel = 0,
+                     const uint64_t bufferSize = 256 * 1024);
+    ~CompressedWriter();
+
+    CompressedWriter(const CompressedWriter &other) = delete;
+    CompressedWriter &operator=(const CompressedWriter &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage,
+                  const bool append = false);
+    bool closeFile(std::string &errorMessage);
+
+    bool writeText(const std::string &newText,
+                   std::string &errorMessage);
+
+    // public variables to avoid stupid getter
+    std::string m_filePath = "";
+
+private:
+    CompressionType m_compression = GZIP_COMPRESSION;
+    int m_compressionLevel = 0;
+
+    int m_fileDescriptor = -1;
+    // temporary file, which replaces the target-file while closing, if not appended
+    TempFile* m_tempFile = nullptr;
+    // size of the file before appending
+    uint64_t m_appendPosition = 0;
+    std::vector<uint8_t> m_outputBuffer;
+    // z_stream or ZSTD_CStream, depending on the compression
+    void* m_stream = nullptr;
+
+    bool compress(const uint8_t* data,
+                  const uint64_t dataSize,
+                  const bool finish,
+                  std::string &errorMessage);
+    bool writeOutput(const uint64_t outputSize,
+                     std::string &errorMessage);
+    void discardFile();
+    void clearStream();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // COMPRESSED_FILE_H
@@ -0,0 +1,90 @@
+/**
+ *  @file    delimited_file_reader.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief tokenizer for text-files with delimited fields, like csv- or tsv-files
+ *
+ *  @detail The file is mapped into the memory and the fields are returned as views into the
+ *          mapped file, so no field is copied. Delimiters, quotes and line-breaks are searched
+ *          with vectorized compares. Quoted fields can contain delimiters, line-breaks and
+ *          doubled quotes. The views of quoted fields are without the surrounding quotes, but
+ *          still contain the doubled quotes, which can be removed with unescapeField. For big
+ *          files all records can be parsed in parallel into column-oriented offsets.
+ */
+
+#ifndef DELIMITED_FILE_READER_H
+#define DELIMITED_FILE_READER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class MappedFile;
+
+struct FieldPosition
+{
+    // offset of the field within the file and length of the field
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+struct DelimitedColumns
+{
+    // positions of the fields of all records for each column. Records with less fields have
+    // empty fields in the missing columns.
+    std::vector<std::vector<FieldPosition>> columns;
+    uint64_t numberOfRecords = 0;
+};
+
+std::string unescapeField(const std::string_view &field,
+                          const char quote = '"');
+
+//==================================================================================================
+
+class DelimitedFileReader
+{
+public:
+    DelimitedFileReader(const char delimiter = ',',
+                        const char quote = '"');
+    ~DelimitedFileReader();
+
+    DelimitedFileReader(const DelimitedFileReader &other) = delete;
+    DelimitedFileReader &operator=(const DelimitedFileReader &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage);
+    bool closeFile();
+
+    bool nextRecord(std::vector<std::string_view> &fields);
+    bool readColumns(DelimitedColumns &columns,
+                     std::string &errorMessage,
+                     const uint32_t numberOfThreads = 0,
+                     const uint64_t chunkSize = 4 * 1024 * 1024);
+
+    std::string_view getField(const FieldPosition &position) const;
+
+    // public variables to avoid stupid getter
+    uint64_t m_recordNumber = 0;
+    std::string m_filePath = "";
+
+private:
+    char m_delimiter = ',';
+    char m_quote = '"';
+
+    MappedFile* m_file = nullptr;
+    bool m_isOpen = false;
+    uint64_t m_position = 0;
+    std::vector<FieldPosition> m_fields;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // DELIMITED_FILE_READER_H
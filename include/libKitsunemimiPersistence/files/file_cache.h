@@ -0,0 +1,98 @@
+/**
+ *  @file    file_cache.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief cache for the content of text-files
+ *
+ *  @detail The content of read files is kept in memory and returned as shared immutable buffer.
+ *          Before an entry is used, it is validated with a single stat-call against device,
+ *          inode, size and modification-time of the file, so changed files are read again. When
+ *          the cache exceeds its size-limit, the least recently used files are removed.
+ *          Besides own instances, a process-wide cache can be used with the free functions.
+ */
+
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+bool readCachedFile(std::shared_ptr<const std::string> &content,
+                    const std::string &filePath,
+                    std::string &errorMessage);
+void setFileCacheSize(const uint64_t maxCacheSize);
+void clearFileCache();
+
+//==================================================================================================
+
+class FileCache
+{
+public:
+    FileCache(const uint64_t maxCacheSize = 64 * 1024 * 1024);
+    ~FileCache();
+
+    bool readFile(std::shared_ptr<const std::string> &content,
+                  const std::string &filePath,
+                  std::string &errorMessage);
+    void removeFile(const std::string &filePath);
+    void clear();
+
+    void setMaxCacheSize(const uint64_t maxCacheSize);
+    uint64_t getCacheSize();
+    uint64_t getNumberOfFiles();
+
+private:
+    struct FileState
+    {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+        uint64_t size = 0;
+        uint64_t modifyTime = 0;
+        uint64_t changeTime = 0;
+
+        bool operator==(const FileState &other) const
+        {
+            return device == other.device
+                   && inode == other.inode
+                   && size == other.size
+                   && modifyTime == other.modifyTime
+                   && changeTime == other.changeTime;
+        }
+    };
+
+    struct CacheEntry
+    {
+        FileState state;
+        std::shared_ptr<const std::string> content;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    uint64_t m_maxCacheSize = 0;
+    uint64_t m_cacheSize = 0;
+
+    // most recently used file at the front
+    std::list<std::string> m_lruList;
+    std::unordered_map<std::string, CacheEntry> m_entries;
+    std::mutex m_lock;
+
+    bool getFileState(const std::string &filePath,
+                      FileState &state);
+    void removeEntry(const std::unordered_map<std::string, CacheEntry>::iterator &it);
+    void evict();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_CACHE_H
@@ -0,0 +1,97 @@
+/**
+ *  @file    file_filter.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief include- and exclude-rules for files and directories of a directory-walk
+ *
+ *  @detail The rules are compiled once, when they are added. Patterns without wildcards are
+ *          stored in hash-sets of names and patterns like "*.txt" in hash-sets of suffixes, so
+ *          only real glob-patterns have to be compared one by one. Names are checked before the
+ *          size and the modification-time, so the metadata are only read for files, which
+ *          passed the name-rules.
+ */
+
+#ifndef FILE_FILTER_H
+#define FILE_FILTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileFilter
+{
+public:
+    FileFilter();
+    ~FileFilter();
+
+    FileFilter(const FileFilter &other) = delete;
+    FileFilter &operator=(const FileFilter &other) = delete;
+
+    bool addIncludePattern(const std::string &pattern,
+                           std::string &errorMessage);
+    bool addExcludePattern(const std::string &pattern,
+                           std::string &errorMessage);
+    bool addExcludedDirectory(const std::string &pattern,
+                              std::string &errorMessage);
+    void addIncludeExtension(const std::string &extension);
+    void addExcludeExtension(const std::string &extension);
+
+    void setSizeRange(const uint64_t minSize,
+                      const uint64_t maxSize);
+    void setModificationTimeRange(const int64_t minTime,
+                                  const int64_t maxTime);
+
+    bool matchFile(FileEntry &entry) const;
+    bool matchDirectory(const FileEntry &entry) const;
+
+private:
+    struct NameRules
+    {
+        std::unordered_set<std::string_view> names;
+        std::unordered_set<std::string_view> suffixes;
+        std::vector<std::string> globs;
+
+        bool isEmpty() const;
+        bool match(const std::string_view &name) const;
+    };
+
+    // storage for the hash-sets of views, which doesn't move its content while growing
+    std::deque<std::string> m_literals;
+
+    NameRules m_includedFiles;
+    NameRules m_excludedFiles;
+    NameRules m_excludedDirectories;
+
+    bool m_checkSize = false;
+    uint64_t m_minSize = 0;
+    uint64_t m_maxSize = 0;
+    bool m_checkTime = false;
+    int64_t m_minTime = 0;
+    int64_t m_maxTime = 0;
+
+    bool addPattern(NameRules &rules,
+                    const std::string &pattern,
+                    std::string &errorMessage);
+    void addExtension(NameRules &rules,
+                      const std::string &extension);
+};
+
+bool matchGlob(const std::string_view &pattern,
+               const std::string_view &name);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FILTER_H
@@ -0,0 +1,151 @@
+/**
+ *  @file    file_fingerprint.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel fingerprinting of file-contents and detection of duplicate files
+ *
+ *  @detail The fingerprint of a file is a non-cryptographic 128-bit hash of its content. To find
+ *          duplicates, the files are grouped by size at first, so files with a unique size are
+ *          never read. Of the remaining files only the first block is hashed and only files with
+ *          equal size and equal first block are hashed completely. All reads and hashes are done
+ *          by multiple threads. The fingerprints are cached with device, inode, size and
+ *          modification-time of the file, so unchanged files are not read again, and the cache
+ *          can be stored in a file.
+ */
+
+#ifndef FILE_FINGERPRINT_H
+#define FILE_FINGERPRINT_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+struct FileFingerprint
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const FileFingerprint &other) const
+    {
+        return low == other.low && high == other.high;
+    }
+    bool operator!=(const FileFingerprint &other) const
+    {
+        return low != other.low || high != other.high;
+    }
+};
+
+struct DuplicateGroup
+{
+    uint64_t fileSize = 0;
+    FileFingerprint fingerprint;
+    std::vector<std::string> paths;
+};
+
+class FingerprintEngine
+{
+public:
+    FingerprintEngine(const uint32_t numberOfThreads = 0);
+    ~FingerprintEngine();
+
+    FingerprintEngine(const FingerprintEngine &other) = delete;
+    FingerprintEngine &operator=(const FingerprintEngine &other) = delete;
+
+    bool getFingerprint(FileFingerprint &fingerprint,
+                        const std::string &filePath,
+                        std::string &errorMessage);
+    bool findDuplicates(std::vector<DuplicateGroup> &groups,
+                        const std::vector<std::string> &filePaths,
+                        std::string &errorMessage,
+                        const uint64_t minimalSize = 1);
+    bool findDuplicates(std::vector<DuplicateGroup> &groups,
+                        const std::string &rootPath,
+                        std::string &errorMessage,
+                        const uint64_t minimalSize = 1);
+
+    bool loadCache(const std::string &cachePath,
+                   std::string &errorMessage);
+    bool saveCache(const std::string &cachePath,
+                   std::string &errorMessage);
+    uint64_t getNumberOfCachedFiles() const;
+
+    // public variables to avoid stupid getter
+    // number of bytes, which were read for the last request
+    uint64_t m_readBytes = 0;
+
+private:
+    struct CacheKey
+    {
+        uint64_t device = 0;
+        uint64_t inode = 0;
+
+        bool operator==(const CacheKey &other) const
+        {
+            return device == other.device && inode == other.inode;
+        }
+    };
+
+    struct CacheKeyHash
+    {
+        std::size_t operator()(const CacheKey &key) const
+        {
+            return std::hash<uint64_t>()(key.inode ^ (key.device * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    struct CacheEntry
+    {
+        uint64_t size = 0;
+        int64_t modificationTime = 0;
+        FileFingerprint firstBlock;
+        FileFingerprint content;
+        bool hasContent = false;
+    };
+
+    struct FileInfo
+    {
+        std::string path = "";
+        CacheKey key;
+        uint64_t size = 0;
+        int64_t modificationTime = 0;
+        FileFingerprint firstBlock;
+        FileFingerprint content;
+        bool hasFirstBlock = false;
+        bool hasContent = false;
+        // false, if the file is not a regular file or was changed while it was read
+        bool isValid = false;
+    };
+
+    uint32_t m_numberOfThreads = 0;
+    std::unordered_map<CacheKey, CacheEntry, CacheKeyHash> m_cache;
+
+    bool readFileInfos(std::vector<FileInfo> &files,
+                       const std::vector<std::string> &filePaths,
+                       std::string &errorMessage);
+    bool hashFiles(std::vector<FileInfo> &files,
+                   const std::vector<uint64_t> &indexes,
+                   const bool completeFile,
+                   std::string &errorMessage);
+    std::vector<std::vector<uint64_t>> groupFiles(const std::vector<FileInfo> &files,
+                                                  std::vector<uint64_t> indexes,
+                                                  const bool byContent) const;
+    void runParallel(const uint64_t numberOfTasks,
+                     const std::function<void(const uint64_t task,
+                                              std::vector<uint8_t> &buffer)> &processTask);
+    void readCache(FileInfo &file) const;
+    void updateCache(const std::vector<FileInfo> &files);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FINGERPRINT_H
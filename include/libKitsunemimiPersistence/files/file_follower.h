@@ -0,0 +1,73 @@
+/**
+ *  @file    file_follower.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief follow a growing text-file, which is written by another process
+ *
+ *  @detail The follower remembers its read-position and only reads the new data of the file.
+ *          Incomplete lines at the end of the file are held back, until they are completed. A truncated file is read again from the start and if the file was
+ *          replaced by a new file (for example by a log-rotation), the rest of the old file is
+ *          read, before the new file is followed. With inotify the caller can wait for changes
+ *          of the file instead of polling.
+ */
+
+#ifndef FILE_FOLLOWER_H
+#define FILE_FOLLOWER_H
+
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileFollower
+{
+public:
+    FileFollower(const uint64_t readBufferSize = 64 * 1024);
+    ~FileFollower();
+
+    FileFollower(const FileFollower &other) = delete;
+    FileFollower &operator=(const FileFollower &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage,
+                  const bool fromStart = true);
+    bool closeFile();
+
+    bool readNewLines(std::vector<std::string> &lines,
+                      std::string &errorMessage);
+    bool waitForChange(const uint32_t timeout);
+
+    // public variables to avoid stupid getter
+    std::string m_filePath = "";
+    uint64_t m_position = 0;
+
+private:
+    uint64_t m_readBufferSize = 0;
+    std::string m_readBuffer = "";
+    std::string m_fileName = "";
+
+    int m_fileDescriptor = -1;
+    uint64_t m_device = 0;
+    uint64_t m_inode = 0;
+    std::string m_incompleteLine = "";
+
+    int m_inotifyDescriptor = -1;
+    int m_watchDescriptor = -1;
+
+    bool readUntilEnd(std::vector<std::string> &lines,
+                      std::string &errorMessage);
+    bool switchToNewFile(std::string &errorMessage);
+    bool readEvents();
+    bool hasUnreadChanges() const;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FOLLOWER_H
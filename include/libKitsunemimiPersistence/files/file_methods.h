@@ -10,6 +10,8 @@
 #define FILE_METHODS_H
 
 #include <sstream>
+#include <string_view>
+#include <functional>
 #include <assert.h>
 #include <boost/filesystem.hpp>
 
@@ -20,10 +22,78 @@ namespace Kitsunemimi
 namespace Persistence
 {
 
+class DirectoryWalker;
+class FileFilter;
+
+enum WalkAction
+{
+    CONTINUE_WALK = 0,
+    // only valid for directories, which are not entered
+    SKIP_DIRECTORY = 1,
+    STOP_WALK = 2,
+};
+
+enum EntryType
+{
+    UNKNOWN_ENTRY = 0,
+    FILE_ENTRY = 1,
+    DIRECTORY_ENTRY = 2,
+    SYMLINK_ENTRY = 3,
+    // devices, sockets and pipes
+    OTHER_ENTRY = 4,
+};
+
+class FileEntry
+{
+public:
+    const std::string getPath() const;
+    bool getSize(uint64_t &size);
+    bool getModificationTime(int64_t &modificationTime);
+    bool getMode(uint32_t &mode);
+
+    // public variables to avoid stupid getter
+    std::string_view m_name;
+    std::string_view m_directoryPath;
+    EntryType m_type = UNKNOWN_ENTRY;
+    uint64_t m_inode = 0;
+    uint32_t m_threadId = 0;
+    // descriptor of the parent directory to access the entry with openat, unlinkat and so on.
+    // The name is null-terminated for these calls.
+    int m_directoryDescriptor = -1;
+
+private:
+    friend class DirectoryWalker;
+
+    uint32_t m_fetchedMask = 0;
+    uint64_t m_size = 0;
+    int64_t m_modificationTime = 0;
+    uint32_t m_mode = 0;
+
+    bool fetchMetadata(const uint32_t mask);
+};
+
+typedef std::function<WalkAction(FileEntry &entry)> FileEntryCallback;
+
+bool iterateFiles(const std::string &path,
+                  const FileEntryCallback &processEntry,
+                  std::string &errorMessage,
+                  const bool withSubdirs = true,
+                  const uint32_t numberOfThreads = 0);
+bool iterateFiles(const std::string &path,
+                  const FileFilter &filter,
+                  const FileEntryCallback &processEntry,
+                  std::string &errorMessage,
+                  const bool withSubdirs = true,
+                  const uint32_t numberOfThreads = 0);
+
 bool listFiles(std::vector<std::string> &fileList,
                const std::string &path,
                const bool withSubdirs=true,
                const std::vector<std::string> &exceptions = {});
+bool listFiles(std::vector<std::string> &fileList,
+               const std::string &path,
+               const FileFilter &filter,
+               const bool withSubdirs=true);
 
 bool renameFileOrDir(const bfs::path &oldPath,
                      const bfs::path &newPath,
@@ -0,0 +1,84 @@
+/**
+ *  @file    line_index.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief index of the start-positions of all lines of a text-file
+ *
+ *  @detail The positions are stored in a sidecar-file next to the text-file, together with the
+ *          size, inode and modification-time of the text-file. When opened again, the index is
+ *          reused, if the file was not changed, and only the new lines are indexed, if the file
+ *          only grew. To detect a rewrite of the already indexed part, a checksum of its first
+ *          and last block is stored too. With the index each line can be read directly and a
+ *          line can be replaced without rewriting the whole file.
+ */
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+
+class LineIndex
+{
+public:
+    LineIndex();
+    ~LineIndex();
+
+    LineIndex(const LineIndex &other) = delete;
+    LineIndex &operator=(const LineIndex &other) = delete;
+
+    bool openIndex(const std::string &filePath,
+                   std::string &errorMessage);
+    bool closeIndex();
+    bool updateIndex(std::string &errorMessage);
+
+    bool readLine(const uint64_t lineNumber,
+                  std::string &line,
+                  std::string &errorMessage);
+    bool replaceLine(const uint64_t lineNumber,
+                     const std::string &newLineContent,
+                     std::string &errorMessage);
+
+    uint64_t getNumberOfLines() const;
+
+    // public variables to avoid stupid getter
+    std::string m_filePath = "";
+    std::string m_indexPath = "";
+
+private:
+    BinaryFile* m_file = nullptr;
+    std::vector<uint64_t> m_lineOffsets;
+    uint64_t m_fileSize = 0;
+    uint64_t m_inode = 0;
+    uint64_t m_modifyTime = 0;
+    uint32_t m_prefixChecksum = 0;
+    bool m_endsWithLineBreak = false;
+
+    bool getFileState(uint64_t &fileSize,
+                      uint64_t &inode,
+                      uint64_t &modifyTime);
+    bool scanLines(const uint64_t startPosition,
+                   const uint64_t fileSize,
+                   std::string &errorMessage);
+    bool getPrefixChecksum(uint32_t &checksum);
+    uint64_t getLineEnd(const uint64_t lineNumber) const;
+    bool moveTail(const uint64_t tailStart,
+                  const int64_t distance);
+
+    bool loadIndex();
+    bool writeIndex();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // LINE_INDEX_H
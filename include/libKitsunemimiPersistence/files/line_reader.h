@@ -0,0 +1,65 @@
+/**
+ *  @file    line_reader.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief streaming reader for the lines of a text-file
+ *
+ *  @detail The file is read block-wise into an aligned buffer and the lines are returned as
+ *          views into this buffer, so the memory-consumption is independent of the file-size
+ *          and no line is copied. The buffer only grows, if a single line is bigger than the
+ *          buffer. Gzip- and zstd-compressed files are detected by their magic bytes and
+ *          decompressed in a separate thread.
+ */
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <string>
+#include <string_view>
+
+namespace Kitsunemimi
+{
+struct DataBuffer;
+namespace Persistence
+{
+class Decompressor;
+
+class LineReader
+{
+public:
+    LineReader(const uint64_t bufferSize = 1024 * 1024);
+    ~LineReader();
+
+    LineReader(const LineReader &other) = delete;
+    LineReader &operator=(const LineReader &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage);
+    bool closeFile();
+
+    bool next(std::string_view &line);
+
+    // public variables to avoid stupid getter
+    uint64_t m_lineNumber = 0;
+    std::string m_filePath = "";
+    std::string m_errorMessage = "";
+
+private:
+    int m_fileDescriptor = -1;
+    // only used for compressed files
+    Decompressor* m_decompressor = nullptr;
+    DataBuffer* m_buffer = nullptr;
+    uint64_t m_lineStart = 0;
+    uint64_t m_searchPosition = 0;
+    bool m_endOfFile = false;
+
+    bool fillBuffer();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // LINE_READER_H
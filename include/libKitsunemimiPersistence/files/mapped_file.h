@@ -0,0 +1,55 @@
+/**
+ *  @file    mapped_file.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief read-only memory-mapping of a file
+ *
+ *  @detail The content of the file is mapped into the memory and accessed without copy. The
+ *          kernel loads the pages on demand, so even very big files don't have to fit into the
+ *          memory. The content is only valid as long as the file stays mapped.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    bool openFile(const std::string &filePath,
+                  std::string &errorMessage,
+                  const bool sequentialAccess = false);
+    bool closeFile();
+
+    std::string_view getContent() const;
+
+    // public variables to avoid stupid getter
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    std::string m_filePath = "";
+
+private:
+    int m_fileDescriptor = -1;
+    void* m_mapping = nullptr;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,58 @@
+/**
+ *  @file    text_chunk_processor.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel processing of the content of a text-file
+ *
+ *  @detail The file is mapped into the memory and split into chunks of nearly the same size.
+ *          The borders of the chunks are moved behind the next line-break, so no line is split
+ *          over two chunks. The chunks are processed by multiple threads and each chunk has its
+ *          own result, so the results can be combined in the order of the file.
+ */
+
+#ifndef TEXT_CHUNK_PROCESSOR_H
+#define TEXT_CHUNK_PROCESSOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+struct TextChunk
+{
+    uint64_t chunkId = 0;
+    // position of the chunk within the file
+    uint64_t offset = 0;
+    std::string_view content;
+};
+
+bool
+processTextChunks(const std::string &filePath,
+                  const std::function<bool(const TextChunk &chunk,
+                                           std::string &result)> &processChunk,
+                  std::vector<std::string> &results,
+                  std::string &errorMessage,
+                  const uint32_t numberOfThreads = 0,
+                  const uint64_t chunkSize = 4 * 1024 * 1024);
+
+bool
+processTextLines(const std::string &filePath,
+                 const std::function<bool(const std::string_view &line,
+                                          std::string &result)> &processLine,
+                 std::vector<std::string> &results,
+                 std::string &errorMessage,
+                 const uint32_t numberOfThreads = 0,
+                 const uint64_t chunkSize = 4 * 1024 * 1024);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TEXT_CHUNK_PROCESSOR_H
@@ -17,23 +17,42 @@
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <vector>
 
 namespace Kitsunemimi
 {
 namespace Persistence
 {
 
+struct ReadFileResult
+{
+    bool success = false;
+    std::string content = "";
+    std::string errorMessage = "";
+};
+
 bool
 readFile(std::string &readContent,
          const std::string &filePath,
          std::string &errorMessage);
 
+bool
+readFiles(std::vector<ReadFileResult> &results,
+          const std::vector<std::string> &filePaths,
+          const uint32_t numberOfThreads=16);
+
 bool
 writeFile(const std::string &filePath,
           const std::string &content,
           std::string &errorMessage,
           const bool force=true);
 
+bool
+writeFileAtomic(const std::string &filePath,
+                const std::string &content,
+                std::string &errorMessage,
+                const bool syncDirectory=false);
+
 bool
 appendText(const std::string &filePath,
            const std::string &newText,
@@ -0,0 +1,84 @@
+/**
+ *  @file    text_file_editor.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief collect multiple changes of a text-file and apply them together
+ *
+ *  @detail Line-replacements, inserts, deletes and substring-replacements are only registered
+ *          and applied by the commit in a single pass over the file. The result is written into
+ *          a temporary file, which replaces the original file atomically. Line-numbers always
+ *          refer to the lines of the original file, independent of other registered changes.
+ *          Substring-replacements are applied line by line in the order of registration and
+ *          only to content, which was registered before.
+ */
+
+#ifndef TEXT_FILE_EDITOR_H
+#define TEXT_FILE_EDITOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class TextFileEditor
+{
+public:
+    TextFileEditor(const std::string &filePath);
+    ~TextFileEditor();
+
+    void replaceLine(const uint64_t lineNumber,
+                     const std::string &newLineContent);
+    void insertLine(const uint64_t lineNumber,
+                    const std::string &newLineContent);
+    void deleteLine(const uint64_t lineNumber);
+    void replaceContent(const std::string &oldContent,
+                        const std::string &newContent);
+
+    bool commit(std::string &errorMessage,
+                const bool syncDirectory = false);
+    void clear();
+
+    uint64_t getNumberOfChanges() const;
+
+    // public variables to avoid stupid getter
+    std::string m_filePath = "";
+
+private:
+    struct LineContent
+    {
+        // position of the change, which set this content, in the order of all changes
+        uint64_t changeId = 0;
+        std::string content = "";
+    };
+
+    struct ContentReplacement
+    {
+        uint64_t changeId = 0;
+        std::string oldContent = "";
+        std::string newContent = "";
+    };
+
+    uint64_t m_nextChangeId = 1;
+    std::map<uint64_t, LineContent> m_replacedLines;
+    std::map<uint64_t, std::vector<LineContent>> m_insertedLines;
+    std::map<uint64_t, bool> m_deletedLines;
+    std::vector<ContentReplacement> m_contentReplacements;
+
+    void appendLine(std::string &output,
+                    const std::string_view &line,
+                    const uint64_t changeId,
+                    bool &firstLine) const;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TEXT_FILE_EDITOR_H
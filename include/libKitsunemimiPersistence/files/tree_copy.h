@@ -0,0 +1,51 @@
+/**
+ *  @file    tree_copy.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel copy of files and directory-trees
+ *
+ *  @detail At first the source-tree is walked in parallel, where the directories and symbolic
+ *          links are created and all files are collected. Afterwards the files are copied by
+ *          multiple threads, beginning with the biggest files. Each file is cloned as reflink,
+ *          if the filesystem supports this. Otherwise the data are copied inside of the kernel
+ *          with copy_file_range or sendfile and only if both are not possible, the data are
+ *          read and written. Holes of sparse files are skipped, so they stay sparse.
+ */
+
+#ifndef TREE_COPY_H
+#define TREE_COPY_H
+
+#include <string>
+#include <functional>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+struct CopyProgress
+{
+    uint64_t numberOfFiles = 0;
+    uint64_t copiedFiles = 0;
+    uint64_t numberOfBytes = 0;
+    uint64_t copiedBytes = 0;
+    // average throughput since the start of the copy
+    double bytesPerSecond = 0.0;
+};
+
+typedef std::function<void(const CopyProgress &progress)> CopyProgressCallback;
+
+bool copyTree(const std::string &sourcePath,
+              const std::string &targetPath,
+              std::string &errorMessage,
+              const bool force = true,
+              const CopyProgressCallback &progressCallback = nullptr,
+              const uint32_t numberOfThreads = 0);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TREE_COPY_H
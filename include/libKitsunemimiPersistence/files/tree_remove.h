@@ -0,0 +1,74 @@
+/**
+ *  @file    tree_remove.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel deletion of files and directory-trees
+ *
+ *  @detail The directory-tree is walked in parallel and all files are unlinked relative to the
+ *          descriptor of their directory, while the directory is read, so the path of a file has
+ *          never to be resolved. Afterwards the empty directories are removed level by level,
+ *          beginning with the deepest one. The tree-remover renames trees into a trash-directory
+ *          and deletes them in a background-thread, so the caller doesn't have to wait.
+ */
+
+#ifndef TREE_REMOVE_H
+#define TREE_REMOVE_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+bool removeTree(const std::string &path,
+                std::string &errorMessage,
+                const uint32_t numberOfThreads = 0);
+
+//==================================================================================================
+
+class TreeRemover
+{
+public:
+    TreeRemover(const uint32_t numberOfThreads = 0);
+    ~TreeRemover();
+
+    TreeRemover(const TreeRemover &other) = delete;
+    TreeRemover &operator=(const TreeRemover &other) = delete;
+
+    bool initTrash(const std::string &trashPath,
+                   std::string &errorMessage);
+    bool removeAsync(const std::string &path,
+                     std::string &errorMessage);
+    bool waitUntilEmpty(std::string &errorMessage);
+
+    // public variables to avoid stupid getter
+    std::string m_trashPath = "";
+
+private:
+    uint32_t m_numberOfThreads = 0;
+    uint64_t m_entryCounter = 0;
+
+    std::thread* m_removeThread = nullptr;
+    std::mutex m_threadLock;
+    std::condition_variable m_threadCondition;
+    std::condition_variable m_emptyCondition;
+    bool m_stopThread = false;
+    bool m_isRemoving = false;
+    std::deque<std::string> m_pendingPaths;
+    std::string m_errorMessage = "";
+
+    void runRemoveThread();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TREE_REMOVE_H
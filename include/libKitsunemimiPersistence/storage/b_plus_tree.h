@@ -0,0 +1,143 @@
+/**
+ *  @file    b_plus_tree.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief page-based b+tree within a binary-file for ordered key-value-data
+ *
+ *  @detail All nodes are stored in pages of fixed size, which is a multiple of the block-size
+ *          of direct-io. The keys within a page are stored with prefix-compression. Leafs are
+ *          linked, so ordered range-scans only have to follow these links. Lookups and iterators
+ *          can run in parallel, while modifications are exclusive. Decoded pages are held in an
+ *          lru-cache. Removing keys doesn't merge pages, so pages can become underfull. The
+ *          meta-page is only rewritten by a modification, when the root or the number of pages
+ *          changed. The number of keys is persisted by flush and closeTree.
+ */
+
+#ifndef B_PLUS_TREE_H
+#define B_PLUS_TREE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+class BPlusTreeIterator;
+
+class BPlusTree
+{
+public:
+    BPlusTree(const uint32_t pageSize = 4096,
+              const uint64_t cacheSize = 1024,
+              const bool directIO = false);
+    ~BPlusTree();
+
+    bool initTree(const std::string &filePath,
+                  std::string &errorMessage);
+    bool closeTree();
+
+    bool insert(const std::string &key,
+                const std::string &value);
+    bool get(const std::string &key,
+             std::string &value);
+    bool remove(const std::string &key);
+    bool bulkLoad(const std::vector<std::pair<std::string, std::string>> &sortedEntries,
+                  std::string &errorMessage);
+    bool flush();
+
+    uint64_t getNumberOfKeys();
+    uint64_t getMaxEntrySize() const;
+
+private:
+    friend BPlusTreeIterator;
+
+    struct Node
+    {
+        uint64_t pageId = 0;
+        bool isLeaf = true;
+        uint64_t nextLeaf = 0;
+        std::vector<std::string> keys;
+        std::vector<std::string> values;
+        std::vector<uint64_t> children;
+    };
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    uint32_t m_pageSize = 4096;
+    uint64_t m_cacheSize = 0;
+    bool m_directIO = false;
+
+    BinaryFile* m_file = nullptr;
+    uint64_t m_rootPage = 0;
+    uint64_t m_numberOfPages = 0;
+    uint64_t m_numberOfKeys = 0;
+    uint64_t m_height = 0;
+
+    // state of the meta-page within the file
+    uint64_t m_persistedRootPage = 0;
+    uint64_t m_persistedNumberOfPages = 0;
+    bool m_metaChanged = false;
+
+    std::shared_timed_mutex m_treeLock;
+
+    // lru-cache for decoded pages
+    std::mutex m_cacheLock;
+    std::list<NodePtr> m_cacheList;
+    std::unordered_map<uint64_t, std::list<NodePtr>::iterator> m_cacheMap;
+
+    NodePtr loadNode(const uint64_t pageId);
+    bool writeNode(const Node &node);
+    uint64_t allocatePage();
+    bool readMeta();
+    bool writeMeta();
+    bool updateMeta();
+
+    bool fitsIntoPage(const Node &node) const;
+    bool serializeNode(const Node &node,
+                       uint8_t* page) const;
+    bool deserializeNode(const uint8_t* page,
+                         const uint64_t pageId,
+                         Node &node) const;
+    uint64_t getSerializedSize(const Node &node,
+                               const uint64_t begin,
+                               const uint64_t end) const;
+    void splitNode(Node &left,
+                   Node &right,
+                   std::string &separator);
+    NodePtr findLeaf(const std::string &key);
+
+    void addToCache(const NodePtr &node);
+    void clearCache();
+};
+
+//==================================================================================================
+
+class BPlusTreeIterator
+{
+public:
+    BPlusTreeIterator(BPlusTree &tree);
+
+    bool seekToFirst();
+    bool seek(const std::string &key);
+    bool next(std::string &key,
+              std::string &value);
+
+private:
+    BPlusTree* m_tree = nullptr;
+    BPlusTree::NodePtr m_leaf;
+    uint64_t m_position = 0;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // B_PLUS_TREE_H
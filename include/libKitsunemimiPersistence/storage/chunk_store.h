@@ -0,0 +1,165 @@
+/**
+ *  @file    chunk_store.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief content-addressed store, which saves identical chunks of data only once
+ *
+ *  @detail Data are split with content-defined chunking (FastCDC with a gear-hash), so an
+ *          insertion into a file only changes the chunks around the insertion. Each chunk is
+ *          identified by a 128-bit hash of its content and appended only once to pack-files.
+ *          Stored data are described by a recipe, which is the list of the hashes of their
+ *          chunks. When a pack-file is full, it is sealed and an index-file with all its chunks
+ *          is written next to it, so only the active pack-file has to be scanned on startup.
+ */
+
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <shared_mutex>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+
+struct ChunkHash
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const ChunkHash &other) const
+    {
+        return low == other.low && high == other.high;
+    }
+};
+
+//==================================================================================================
+
+class ChunkStore
+{
+public:
+    ChunkStore(const uint32_t averageChunkSize = 8 * 1024,
+               const uint64_t maxPackSize = 256 * 1024 * 1024,
+               const uint32_t numberOfThreads = 4);
+    ~ChunkStore();
+
+    bool initStore(const std::string &directoryPath,
+                   std::string &errorMessage);
+    bool closeStore();
+
+    bool storeData(const void* data,
+                   const uint64_t dataSize,
+                   std::vector<ChunkHash> &recipe);
+    bool restoreData(const std::vector<ChunkHash> &recipe,
+                     std::string &data);
+
+    bool storeFile(const std::string &filePath,
+                   std::vector<ChunkHash> &recipe,
+                   std::string &errorMessage);
+    bool restoreFile(const std::vector<ChunkHash> &recipe,
+                     const std::string &targetPath,
+                     std::string &errorMessage);
+    bool storeFiles(const std::vector<std::string> &filePaths,
+                    std::vector<std::vector<ChunkHash>> &recipes,
+                    std::string &errorMessage);
+    bool restoreFiles(const std::vector<std::vector<ChunkHash>> &recipes,
+                      const std::vector<std::string> &targetPaths,
+                      std::string &errorMessage);
+    bool flush();
+
+    uint64_t getNumberOfChunks();
+    uint64_t getStoredSize();
+
+private:
+    struct ChunkHeader
+    {
+        uint32_t checksum = 0;
+        uint32_t dataSize = 0;
+        uint64_t hashLow = 0;
+        uint64_t hashHigh = 0;
+    } __attribute__((packed));
+
+    struct Location
+    {
+        uint64_t packId = 0;
+        uint64_t position = 0;
+        uint32_t dataSize = 0;
+    };
+
+    struct Pack
+    {
+        BinaryFile* file = nullptr;
+        uint64_t dataSize = 0;
+        bool sealed = false;
+    };
+
+    struct ChunkHashFunction
+    {
+        size_t operator()(const ChunkHash &hash) const
+        {
+            return static_cast<size_t>(hash.low);
+        }
+    };
+
+    uint32_t m_minChunkSize = 0;
+    uint32_t m_averageChunkSize = 0;
+    uint32_t m_maxChunkSize = 0;
+    uint64_t m_maskSmall = 0;
+    uint64_t m_maskLarge = 0;
+    uint64_t m_maxPackSize = 0;
+    uint32_t m_numberOfThreads = 0;
+
+    std::string m_directoryPath = "";
+    std::unordered_map<ChunkHash, Location, ChunkHashFunction> m_index;
+    std::map<uint64_t, Pack> m_packs;
+    uint64_t m_activePackId = 0;
+    std::vector<std::pair<ChunkHash, Location>> m_activeChunks;
+    uint64_t m_storedSize = 0;
+    bool m_isOpen = false;
+
+    // write-lock for adding chunks, read-lock for restoring
+    std::shared_timed_mutex m_indexLock;
+
+    uint64_t findChunkBoundary(const uint8_t* data,
+                               const uint64_t dataSize) const;
+    bool ingestBlock(const uint8_t* data,
+                     const uint64_t dataSize,
+                     const bool lastBlock,
+                     std::vector<ChunkHash> &recipe,
+                     uint64_t &processedSize);
+    bool addChunks(const uint8_t* data,
+                   const std::vector<uint32_t> &chunkSizes,
+                   const std::vector<ChunkHash> &hashes);
+    bool writeToActivePack(std::vector<uint8_t> &writeBuffer,
+                           std::vector<ChunkHash> &addedHashes);
+    bool readChunk(const ChunkHash &hash,
+                   std::vector<uint8_t> &buffer);
+
+    bool loadPack(const uint64_t packId,
+                  const bool lastPack);
+    bool scanPack(const uint64_t packId,
+                  std::vector<std::pair<ChunkHash, Location>> &chunks);
+    bool loadPackIndex(const uint64_t packId);
+    bool writePackIndex(const uint64_t packId,
+                        const std::vector<std::pair<ChunkHash, Location>> &chunks);
+    void addToIndex(const std::vector<std::pair<ChunkHash, Location>> &chunks);
+    bool createPack(const uint64_t packId);
+    bool sealActivePack();
+    void clearStore();
+
+    const std::string getPackPath(const uint64_t packId) const;
+    const std::string getPackIndexPath(const uint64_t packId) const;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // CHUNK_STORE_H
@@ -0,0 +1,139 @@
+/**
+ *  @file    key_value_store.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief persistent key-value-store with a hash-index and a value-log
+ *
+ *  @detail All values are appended to value-log-files. A hash-index in memory maps each key to
+ *          the position of its newest entry within the value-log, so each lookup is a single
+ *          read-call. The index is persisted as snapshot-file when closing the store and after
+ *          each compaction. While opening the store, the snapshot is loaded and only the part of
+ *          the value-log, which was written after the snapshot, is replayed. Entries carry a
+ *          sequence-number, so the newest entry of a key always wins, even if the snapshot is
+ *          missing or broken. A background-thread compacts the sealed value-log-files, when too
+ *          much of their content is outdated. Before the old files of a compaction are deleted,
+ *          a marker with their ids is written, so after a crash the outdated files are removed
+ *          while opening the store instead of being replayed together with their copies.
+ */
+
+#ifndef KEY_VALUE_STORE_H
+#define KEY_VALUE_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+
+class KeyValueStore
+{
+public:
+    KeyValueStore(const uint64_t maxFileSize = 256 * 1024 * 1024,
+                  const float compactionThreshold = 0.5f,
+                  const bool syncOnWrite = false);
+    ~KeyValueStore();
+
+    bool initStore(const std::string &directoryPath,
+                   std::string &errorMessage);
+    bool closeStore();
+
+    bool get(const std::string &key,
+             std::string &value);
+    bool put(const std::string &key,
+             const std::string &value);
+    bool remove(const std::string &key);
+    bool flush();
+
+    bool compact();
+    uint64_t getNumberOfKeys();
+
+private:
+    struct EntryHeader
+    {
+        uint32_t checksum = 0;
+        uint32_t keySize = 0;
+        uint32_t valueSize = 0;
+        uint8_t deleted = 0;
+        uint8_t padding[3] = {0, 0, 0};
+        uint64_t sequence = 0;
+    } __attribute__((packed));
+
+    struct Location
+    {
+        uint64_t fileId = 0;
+        uint64_t position = 0;
+        uint64_t entrySize = 0;
+        uint64_t sequence = 0;
+    };
+
+    struct DataFile
+    {
+        BinaryFile* file = nullptr;
+        uint64_t dataSize = 0;
+        uint64_t garbageSize = 0;
+        bool sealed = false;
+    };
+
+    uint64_t m_maxFileSize = 0;
+    float m_compactionThreshold = 0.5f;
+    bool m_syncOnWrite = false;
+
+    std::string m_directoryPath = "";
+    std::unordered_map<std::string, Location> m_index;
+    std::map<uint64_t, DataFile> m_files;
+    uint64_t m_activeFileId = 0;
+    uint64_t m_nextFileId = 0;
+    uint64_t m_nextSequence = 1;
+    bool m_isOpen = false;
+
+    // write-lock for the index and the files, read-lock for lookups
+    std::shared_timed_mutex m_indexLock;
+    // only one compaction at the same time
+    std::mutex m_compactionLock;
+
+    std::thread* m_compactionThread = nullptr;
+    std::mutex m_threadLock;
+    std::condition_variable m_threadCondition;
+    bool m_stopThread = false;
+
+    bool appendEntry(const std::string &key,
+                     const std::string &value,
+                     const bool deleted,
+                     Location &location);
+    bool createDataFile(const uint64_t fileId);
+    bool sealActiveFile();
+    void markAsGarbage(const Location &location);
+
+    bool loadSnapshot(std::map<uint64_t, uint64_t> &coveredSizes,
+                      uint64_t &maxSequence);
+    bool writeSnapshot();
+    bool writeCompactionMarker(const std::vector<uint64_t> &fileIds);
+    bool finishCompaction();
+    bool replayFile(const uint64_t fileId,
+                    const uint64_t startPosition,
+                    std::unordered_map<std::string, uint64_t> &deletedKeys,
+                    uint64_t &maxSequence);
+    void clearStore();
+
+    bool needsCompaction();
+    void runCompactionThread();
+
+    const std::string getFilePath(const uint64_t fileId) const;
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // KEY_VALUE_STORE_H
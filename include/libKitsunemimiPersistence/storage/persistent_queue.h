@@ -0,0 +1,105 @@
+/**
+ *  @file    persistent_queue.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief persistent fifo-queue with multiple consumers on top of a record-log
+ *
+ *  @detail Items are appended to a segmented record-log, so the tail of the queue is the end of
+ *          the log. Each registered consumer has its own head, which is the id of the oldest not
+ *          acknowledged item. Dequeued items are delivered again after a restart, until they are
+ *          acknowledged. The heads are stored in a separate file and segments, which were
+ *          acknowledged by all consumers, are deleted.
+ */
+
+#ifndef PERSISTENT_QUEUE_H
+#define PERSISTENT_QUEUE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include <libKitsunemimiPersistence/storage/record_log.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+enum QueueDurability
+{
+    // nothing is synced and heads are only written while flushing and closing
+    NO_DURABILITY = 0,
+    // heads are written with each acknowledgement, so they survive a crash of the process
+    PROCESS_DURABILITY = 1,
+    // each enqueue-call and acknowledgement is synced, so they survive a power-loss
+    SYNC_DURABILITY = 2,
+};
+
+struct QueueItem
+{
+    uint64_t itemId = 0;
+    std::string data = "";
+};
+
+//==================================================================================================
+
+class PersistentQueue
+{
+public:
+    PersistentQueue(const QueueDurability durability = PROCESS_DURABILITY,
+                    const uint64_t maxSegmentSize = 64 * 1024 * 1024);
+    ~PersistentQueue();
+
+    bool initQueue(const std::string &directoryPath,
+                   std::string &errorMessage);
+    bool closeQueue();
+
+    bool addConsumer(const std::string &consumerName);
+    bool removeConsumer(const std::string &consumerName);
+
+    bool enqueue(const void* data,
+                 const uint64_t dataSize);
+    bool enqueue(const std::vector<std::string> &items);
+    bool dequeue(const std::string &consumerName,
+                 std::vector<QueueItem> &items,
+                 const uint64_t maxNumberOfItems);
+    bool acknowledge(const std::string &consumerName,
+                     const uint64_t itemId);
+    bool rewind(const std::string &consumerName);
+    bool flush();
+
+    uint64_t getNumberOfPendingItems(const std::string &consumerName);
+
+private:
+    struct Consumer
+    {
+        // id of the oldest not acknowledged item
+        uint64_t headId = 0;
+        // id of the next item, which will be delivered
+        uint64_t readId = 0;
+        RecordLogReader* reader = nullptr;
+    };
+
+    QueueDurability m_durability = PROCESS_DURABILITY;
+    RecordLog m_log;
+    bool m_isOpen = false;
+
+    std::string m_directoryPath = "";
+    std::map<std::string, Consumer> m_consumers;
+    std::mutex m_consumerLock;
+
+    bool loadHeads();
+    bool writeHeads(const bool sync);
+    void removeAcknowledgedSegments();
+    void resetReader(Consumer &consumer);
+    void clearConsumers();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // PERSISTENT_QUEUE_H
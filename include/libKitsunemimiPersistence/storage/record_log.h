@@ -0,0 +1,179 @@
+/**
+ *  @file    record_log.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief append-only log for records, which is split into multiple segment-files
+ *
+ *  @detail Each record is written with a length-prefix, a timestamp and a crc32c-checksum. The
+ *          log-directory contains segment-files, which are named by the id of their first record.
+ *          When a segment reached its maximum size, it is sealed and a sparse index-file is
+ *          written next to it. The sparse index is used to seek to a record-id or a timestamp
+ *          without reading the complete log.
+ */
+
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+class RecordLogReader;
+
+struct LogRecord
+{
+    uint64_t recordId = 0;
+    uint64_t timestamp = 0;
+    const uint8_t* data = nullptr;
+    uint64_t dataSize = 0;
+};
+
+//==================================================================================================
+
+class RecordLog
+{
+public:
+    RecordLog(const uint64_t maxSegmentSize = 64 * 1024 * 1024,
+              const uint32_t indexInterval = 128,
+              const bool syncOnWrite = false);
+    ~RecordLog();
+
+    bool initLog(const std::string &directoryPath,
+                 std::string &errorMessage);
+    bool closeLog();
+
+    bool appendRecord(const void* data,
+                      const uint64_t dataSize,
+                      const uint64_t timestamp = 0);
+    bool appendRecords(const std::vector<std::string> &records,
+                       const uint64_t timestamp = 0);
+    bool flush();
+    uint64_t removeSegmentsBefore(const uint64_t recordId);
+
+    uint64_t getFirstRecordId();
+    uint64_t getNextRecordId();
+
+private:
+    friend RecordLogReader;
+
+    struct RecordHeader
+    {
+        uint32_t dataSize = 0;
+        uint32_t checksum = 0;
+        uint64_t timestamp = 0;
+    } __attribute__((packed));
+
+    struct IndexEntry
+    {
+        uint64_t recordId = 0;
+        uint64_t timestamp = 0;
+        uint64_t segmentId = 0;
+        uint64_t filePosition = 0;
+    } __attribute__((packed));
+
+    struct Segment
+    {
+        uint64_t firstRecordId = 0;
+        uint64_t numberOfRecords = 0;
+        uint64_t dataSize = 0;
+        uint64_t lastTimestamp = 0;
+        bool sealed = false;
+    };
+
+    uint64_t m_maxSegmentSize = 0;
+    uint32_t m_indexInterval = 0;
+    bool m_syncOnWrite = false;
+
+    std::string m_directoryPath = "";
+    std::vector<Segment> m_segments;
+    std::vector<IndexEntry> m_index;
+    BinaryFile* m_activeFile = nullptr;
+    uint64_t m_lastTimestamp = 0;
+    std::mutex m_lock;
+
+    // state of the records, which are serialized, but not written yet
+    std::vector<uint8_t> m_writeBuffer;
+    std::vector<IndexEntry> m_pendingIndex;
+    uint64_t m_pendingRecords = 0;
+    uint64_t m_pendingLastTimestamp = 0;
+    bool m_writeFailed = false;
+
+    void clearLog();
+
+    bool loadSegment(const uint64_t firstRecordId,
+                     const bool lastSegment,
+                     std::string &errorMessage);
+    bool scanSegment(BinaryFile &file,
+                     Segment &segment);
+    bool loadIndexFile(Segment &segment);
+    bool writeIndexFile(const Segment &segment);
+    bool openNewSegment(const uint64_t firstRecordId);
+    bool sealActiveSegment();
+    bool writeBufferToSegment();
+    void addToWriteBuffer(const void* data,
+                          const uint64_t dataSize,
+                          const uint64_t timestamp);
+
+    const std::string getSegmentPath(const uint64_t segmentId) const;
+    const std::string getIndexPath(const uint64_t segmentId) const;
+    bool getSegmentInfo(const uint64_t segmentId,
+                        Segment &segment);
+    bool getNextSegmentInfo(const uint64_t segmentId,
+                            Segment &segment);
+    bool findIndexEntryById(const uint64_t recordId,
+                            IndexEntry &entry);
+    bool findIndexEntryByTimestamp(const uint64_t timestamp,
+                                   IndexEntry &entry);
+};
+
+//==================================================================================================
+
+class RecordLogReader
+{
+public:
+    RecordLogReader(RecordLog &log,
+                    const uint64_t readAheadSize = 1024 * 1024);
+    ~RecordLogReader();
+
+    bool seekToRecord(const uint64_t recordId);
+    bool seekToTimestamp(const uint64_t timestamp);
+    bool next(LogRecord &record);
+
+private:
+    RecordLog* m_log = nullptr;
+    uint64_t m_readAheadSize = 0;
+
+    std::unique_ptr<BinaryFile> m_file;
+    uint64_t m_segmentId = 0;
+    uint64_t m_segmentDataSize = 0;
+    bool m_segmentSealed = false;
+    uint64_t m_filePosition = 0;
+    uint64_t m_nextRecordId = 0;
+
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_bufferFilePosition = 0;
+    uint64_t m_bufferSize = 0;
+
+    uint64_t m_skipUntilId = 0;
+    uint64_t m_skipUntilTimestamp = 0;
+
+    bool openSegment(const uint64_t segmentId,
+                     const uint64_t filePosition,
+                     const uint64_t recordId);
+    bool ensureBuffered(const uint64_t numberOfBytes);
+    bool readNextRecord(LogRecord &record);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // RECORD_LOG_H
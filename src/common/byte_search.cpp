@@ -0,0 +1,242 @@
+/**
+ *  @file    byte_search.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief vectorized search of bytes for internal usage
+ */
+
+#include "byte_search.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief search the first position of a byte within a memory-region. Compares 32 bytes at once,
+ *        if the library was build with avx2-support, 16 bytes with sse2 or neon, else one byte
+ *        after another.
+ *
+ * @param begin pointer to the start of the region
+ * @param end pointer behind the last byte of the region
+ * @param searchedByte byte to search
+ *
+ * @return pointer to the first match, or end, if the byte was not found
+ */
+const char*
+findNextByte(const char* begin,
+             const char* end,
+             const char searchedByte)
+{
+    const char* pos = begin;
+
+#if defined(__AVX2__)
+    const __m256i pattern = _mm256_set1_epi8(searchedByte);
+    while(end - pos >= 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const uint32_t mask = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)));
+        if(mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi8(searchedByte);
+    while(end - pos >= 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const uint32_t mask = static_cast<uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+        if(mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t pattern = vdupq_n_u8(static_cast<uint8_t>(searchedByte));
+    while(end - pos >= 16)
+    {
+        const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(pos));
+        const uint8x16_t compared = vceqq_u8(block, pattern);
+
+        // narrow each byte of the compare-result to 4 bits to get a 64-bit mask
+        const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(compared), 4);
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        if(mask != 0) {
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+        pos += 16;
+    }
+#endif
+
+    // remaining bytes, which don't fill a complete vector
+    while(pos < end)
+    {
+        if(*pos == searchedByte) {
+            return pos;
+        }
+        pos++;
+    }
+
+    return end;
+}
+
+/**
+ * @brief search the first position of one of two bytes within a memory-region. Both bytes are
+ *        compared with the same block of data and the compare-masks are combined, so the region
+ *        is only read once.
+ *
+ * @param begin pointer to the start of the region
+ * @param end pointer behind the last byte of the region
+ * @param firstByte first byte to search
+ * @param secondByte second byte to search
+ *
+ * @return pointer to the first match, or end, if none of the bytes was found
+ */
+const char*
+findNextOfTwoBytes(const char* begin,
+                   const char* end,
+                   const char firstByte,
+                   const char secondByte)
+{
+    const char* pos = begin;
+
+#if defined(__AVX2__)
+    const __m256i firstPattern = _mm256_set1_epi8(firstByte);
+    const __m256i secondPattern = _mm256_set1_epi8(secondByte);
+    while(end - pos >= 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i compared = _mm256_or_si256(_mm256_cmpeq_epi8(block, firstPattern),
+                                                 _mm256_cmpeq_epi8(block, secondPattern));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(compared));
+        if(mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i firstPattern = _mm_set1_epi8(firstByte);
+    const __m128i secondPattern = _mm_set1_epi8(secondByte);
+    while(end - pos >= 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i compared = _mm_or_si128(_mm_cmpeq_epi8(block, firstPattern),
+                                              _mm_cmpeq_epi8(block, secondPattern));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(compared));
+        if(mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t firstPattern = vdupq_n_u8(static_cast<uint8_t>(firstByte));
+    const uint8x16_t secondPattern = vdupq_n_u8(static_cast<uint8_t>(secondByte));
+    while(end - pos >= 16)
+    {
+        const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(pos));
+        const uint8x16_t compared = vorrq_u8(vceqq_u8(block, firstPattern),
+                                             vceqq_u8(block, secondPattern));
+
+        // narrow each byte of the compare-result to 4 bits to get a 64-bit mask
+        const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(compared), 4);
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        if(mask != 0) {
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+        pos += 16;
+    }
+#endif
+
+    // remaining bytes, which don't fill a complete vector
+    while(pos < end)
+    {
+        if(*pos == firstByte
+                || *pos == secondByte)
+        {
+            return pos;
+        }
+        pos++;
+    }
+
+    return end;
+}
+
+/**
+ * @brief count the appearances of a byte within a memory-region with the population-count of
+ *        the compare-masks
+ *
+ * @param begin pointer to the start of the region
+ * @param end pointer behind the last byte of the region
+ * @param searchedByte byte to count
+ *
+ * @return number of appearances of the byte
+ */
+uint64_t
+countByte(const char* begin,
+          const char* end,
+          const char searchedByte)
+{
+    const char* pos = begin;
+    uint64_t counter = 0;
+
+#if defined(__AVX2__)
+    const __m256i pattern = _mm256_set1_epi8(searchedByte);
+    while(end - pos >= 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const uint32_t mask = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)));
+        counter += static_cast<uint64_t>(__builtin_popcount(mask));
+        pos += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi8(searchedByte);
+    while(end - pos >= 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const uint32_t mask = static_cast<uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+        counter += static_cast<uint64_t>(__builtin_popcount(mask));
+        pos += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t pattern = vdupq_n_u8(static_cast<uint8_t>(searchedByte));
+    while(end - pos >= 16)
+    {
+        const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(pos));
+        const uint8x16_t compared = vceqq_u8(block, pattern);
+
+        // each match sets 4 bits in the narrowed mask
+        const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(compared), 4);
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        counter += static_cast<uint64_t>(__builtin_popcountll(mask)) >> 2;
+        pos += 16;
+    }
+#endif
+
+    // remaining bytes, which don't fill a complete vector
+    while(pos < end)
+    {
+        if(*pos == searchedByte) {
+            counter++;
+        }
+        pos++;
+    }
+
+    return counter;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
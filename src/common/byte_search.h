@@ -0,0 +1,35 @@
+/**
+ *  @file    byte_search.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief vectorized search of bytes for internal usage
+ */
+
+#ifndef BYTE_SEARCH_H
+#define BYTE_SEARCH_H
+
+#include <stdint.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+const char* findNextByte(const char* begin,
+                         const char* end,
+                         const char searchedByte);
+const char* findNextOfTwoBytes(const char* begin,
+                               const char* end,
+                               const char firstByte,
+                               const char secondByte);
+uint64_t countByte(const char* begin,
+                   const char* end,
+                   const char searchedByte);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // BYTE_SEARCH_H
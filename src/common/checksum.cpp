@@ -0,0 +1,126 @@
+/**
+ *  @file    checksum.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief checksum-functions for internal usage
+ */
+
+#include "checksum.h"
+
+#include <string.h>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#ifndef __SSE4_2__
+
+/**
+ * @brief lookup-tables for the crc32c-calculation with slicing-by-8
+ */
+struct Crc32cTables
+{
+    uint32_t table[8][256];
+
+    Crc32cTables()
+    {
+        // reflected polynom of crc32c (Castagnoli)
+        const uint32_t polynom = 0x82F63B78;
+
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for(uint32_t j = 0; j < 8; j++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? polynom : 0);
+            }
+            table[0][i] = crc;
+        }
+
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            for(uint32_t slice = 1; slice < 8; slice++) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc32cTables crcTables;
+
+#endif
+
+/**
+ * @brief calculate crc32c-checksum of a memory-region. Uses the crc32-instruction of the cpu,
+ *        if the library was build with sse4.2-support, else slicing-by-8 lookup-tables.
+ *
+ * @param data pointer to the data
+ * @param dataSize number of bytes to process
+ * @param previousCrc result of a previous call to continue the checksum over multiple regions
+ *
+ * @return crc32c-checksum
+ */
+uint32_t
+calcCrc32c(const void* data,
+           const uint64_t dataSize,
+           const uint32_t previousCrc)
+{
+    const uint8_t* pos = static_cast<const uint8_t*>(data);
+    const uint8_t* end = pos + dataSize;
+    uint32_t crc = ~previousCrc;
+
+#ifdef __SSE4_2__
+    uint64_t crc64 = crc;
+    while(end - pos >= 8)
+    {
+        uint64_t value = 0;
+        memcpy(&value, pos, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+        pos += 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+
+    while(pos < end)
+    {
+        crc = _mm_crc32_u8(crc, *pos);
+        pos++;
+    }
+#else
+    while(end - pos >= 8)
+    {
+        uint32_t low = 0;
+        uint32_t high = 0;
+        memcpy(&low, pos, 4);
+        memcpy(&high, pos + 4, 4);
+        low ^= crc;
+
+        crc = crcTables.table[7][low & 0xFF]
+              ^ crcTables.table[6][(low >> 8) & 0xFF]
+              ^ crcTables.table[5][(low >> 16) & 0xFF]
+              ^ crcTables.table[4][low >> 24]
+              ^ crcTables.table[3][high & 0xFF]
+              ^ crcTables.table[2][(high >> 8) & 0xFF]
+              ^ crcTables.table[1][(high >> 16) & 0xFF]
+              ^ crcTables.table[0][high >> 24];
+        pos += 8;
+    }
+
+    while(pos < end)
+    {
+        crc = (crc >> 8) ^ crcTables.table[0][(crc ^ *pos) & 0xFF];
+        pos++;
+    }
+#endif
+
+    return ~crc;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,28 @@
+/**
+ *  @file    checksum.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief checksum-functions for internal usage
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+uint32_t calcCrc32c(const void* data,
+                    const uint64_t dataSize,
+                    const uint32_t previousCrc = 0);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // CHECKSUM_H
@@ -0,0 +1,549 @@
+/**
+ *  @file    decompressor.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief decompression of files in a background-thread for internal usage
+ *
+ *  @detail The thread reads the compressed file and decompresses it into a fixed number of
+ *          blocks. Filled blocks are handed over to the consumer and given back after they were
+ *          read, so the thread blocks, when the consumer is slower, and the memory-consumption
+ *          is limited. Concatenated gzip-members and zstd-frames are read as one stream.
+ */
+
+#include "decompressor.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief detect the compression of an open file by the magic bytes at its beginning
+ *
+ * @param compression reference for the detected compression
+ * @param fileDescriptor descriptor of the file
+ * @param filePath path of the file for the error-message
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if reading the file failed, else true
+ */
+bool
+detectCompression(CompressionType &compression,
+                  const int fileDescriptor,
+                  const std::string &filePath,
+                  std::string &errorMessage)
+{
+    uint8_t magic[4];
+    ssize_t ret = 0;
+    do {
+        ret = pread(fileDescriptor, magic, sizeof(magic), 0);
+    }
+    while(ret < 0 && errno == EINTR);
+
+    if(ret < 0)
+    {
+        errorMessage = "failed to read file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    compression = NO_COMPRESSION;
+    if(ret >= 2
+            && magic[0] == 0x1f
+            && magic[1] == 0x8b)
+    {
+        compression = GZIP_COMPRESSION;
+    }
+    else if(ret == 4
+            && magic[0] == 0x28
+            && magic[1] == 0xb5
+            && magic[2] == 0x2f
+            && magic[3] == 0xfd)
+    {
+        compression = ZSTD_COMPRESSION;
+    }
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ *
+ * @param blockSize size of a single block of decompressed data
+ * @param numberOfBlocks number of blocks, which can be filled in advance
+ */
+Decompressor::Decompressor(const uint64_t blockSize,
+                           const uint32_t numberOfBlocks)
+{
+    m_blockSize = blockSize == 0 ? 1 : blockSize;
+    m_blocks.resize(numberOfBlocks < 2 ? 2 : numberOfBlocks);
+}
+
+/**
+ * @brief destructor
+ */
+Decompressor::~Decompressor()
+{
+    stop();
+}
+
+/**
+ * @brief start the decompression of a file. The file-descriptor is not closed by the
+ *        decompressor and must stay open, until the decompressor was stopped.
+ *
+ * @param fileDescriptor descriptor of the compressed file
+ * @param compression compression of the file
+ * @param filePath path of the file for error-messages
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Decompressor::start(const int fileDescriptor,
+                    const CompressionType compression,
+                    const std::string &filePath,
+                    std::string &errorMessage)
+{
+    if(m_thread != nullptr)
+    {
+        errorMessage = "decompression of file \"" + m_filePath + "\" is already running";
+        return false;
+    }
+
+#ifndef WITH_ZSTD
+    if(compression == ZSTD_COMPRESSION)
+    {
+        errorMessage = "failed to read file \"" + filePath + "\": "
+                       "library was build without zstd-support";
+        return false;
+    }
+#endif
+
+    m_fileDescriptor = fileDescriptor;
+    m_compression = compression;
+    m_filePath = filePath;
+
+    m_freeBlocks.clear();
+    m_filledBlocks.clear();
+    for(Block &block : m_blocks)
+    {
+        block.data.resize(m_blockSize);
+        block.dataSize = 0;
+        m_freeBlocks.push_back(&block);
+    }
+    m_currentBlock = nullptr;
+    m_currentPosition = 0;
+    m_endOfData = false;
+    m_threadError = "";
+    m_stopThread = false;
+
+    m_thread = new std::thread(&Decompressor::run, this);
+
+    return true;
+}
+
+/**
+ * @brief stop the background-thread
+ */
+void
+Decompressor::stop()
+{
+    if(m_thread == nullptr) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stopThread = true;
+    }
+    m_condition.notify_all();
+
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+/**
+ * @brief read the next decompressed data
+ *
+ * @param data target-buffer
+ * @param dataSize size of the target-buffer
+ * @param readSize reference for the number of read bytes, which is 0 at the end of the data
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the decompression failed, else true
+ */
+bool
+Decompressor::read(uint8_t* data,
+                   const uint64_t dataSize,
+                   uint64_t &readSize,
+                   std::string &errorMessage)
+{
+    readSize = 0;
+
+    // give the completely read block back and wait for the next filled block
+    if(m_currentBlock == nullptr
+            || m_currentPosition == m_currentBlock->dataSize)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if(m_currentBlock != nullptr)
+        {
+            m_freeBlocks.push_back(m_currentBlock);
+            m_currentBlock = nullptr;
+            m_condition.notify_all();
+        }
+
+        m_condition.wait(lock, [this] {
+            return m_filledBlocks.size() > 0 || m_endOfData;
+        });
+
+        if(m_filledBlocks.size() == 0)
+        {
+            errorMessage = m_threadError;
+            return m_threadError.size() == 0;
+        }
+
+        m_currentBlock = m_filledBlocks.front();
+        m_filledBlocks.pop_front();
+        m_currentPosition = 0;
+    }
+
+    // the current block is owned by the consumer, so it can be read without lock
+    readSize = std::min(dataSize, m_currentBlock->dataSize - m_currentPosition);
+    memcpy(data, &m_currentBlock->data[m_currentPosition], readSize);
+    m_currentPosition += readSize;
+
+    return true;
+}
+
+/**
+ * @brief decompress the file until its end, an error or a stop
+ */
+void
+Decompressor::run()
+{
+    bool result = false;
+    if(m_compression == GZIP_COMPRESSION) {
+        result = decompressGzip();
+    }
+    else if(m_compression == ZSTD_COMPRESSION) {
+        result = decompressZstd();
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if(result == false
+            && m_threadError.size() == 0
+            && m_stopThread == false)
+    {
+        m_threadError = "failed to decompress file \"" + m_filePath + "\"";
+    }
+    m_endOfData = true;
+    m_condition.notify_all();
+}
+
+/**
+ * @brief decompress gzip-members
+ *
+ * @return false, if the decompression failed or was stopped, else true
+ */
+bool
+Decompressor::decompressGzip()
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // 32 for automatic detection of the gzip-header
+    if(inflateInit2(&stream, 15 + 32) != Z_OK) {
+        return false;
+    }
+
+    std::vector<uint8_t> input(m_blockSize);
+    uint64_t inputSize = 0;
+    bool endOfInput = false;
+    bool streamEnd = false;
+    bool result = true;
+    Block* block = nullptr;
+
+    while(true)
+    {
+        if(stream.avail_in == 0
+                && endOfInput == false)
+        {
+            if(readInput(input, inputSize) == false)
+            {
+                result = false;
+                break;
+            }
+            endOfInput = inputSize == 0;
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(inputSize);
+        }
+
+        if(block == nullptr)
+        {
+            block = getFreeBlock();
+            if(block == nullptr)
+            {
+                result = false;
+                break;
+            }
+            stream.next_out = block->data.data();
+            stream.avail_out = static_cast<uInt>(m_blockSize);
+        }
+
+        const int ret = inflate(&stream, Z_NO_FLUSH);
+        if(ret == Z_STREAM_END)
+        {
+            // the file can contain multiple concatenated gzip-members
+            streamEnd = true;
+            inflateReset(&stream);
+        }
+        else if(ret == Z_OK)
+        {
+            streamEnd = false;
+        }
+        else if(ret != Z_BUF_ERROR)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_threadError = "failed to decompress file \"" + m_filePath + "\": "
+                            + std::string(stream.msg != nullptr ? stream.msg : "invalid data");
+            result = false;
+            break;
+        }
+
+        block->dataSize = m_blockSize - stream.avail_out;
+        const bool blockFull = stream.avail_out == 0;
+        if(blockFull)
+        {
+            pushBlock(block);
+            block = nullptr;
+        }
+
+        // no more input and all pending output is written
+        if(endOfInput
+                && stream.avail_in == 0
+                && blockFull == false)
+        {
+            break;
+        }
+    }
+
+    if(result
+            && streamEnd == false)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_threadError = "failed to decompress file \"" + m_filePath + "\": "
+                        "unexpected end of file";
+        result = false;
+    }
+
+    if(result
+            && block != nullptr
+            && block->dataSize > 0)
+    {
+        pushBlock(block);
+        block = nullptr;
+    }
+
+    inflateEnd(&stream);
+
+    return result;
+}
+
+/**
+ * @brief decompress zstd-frames
+ *
+ * @return false, if the decompression failed or was stopped, else true
+ */
+bool
+Decompressor::decompressZstd()
+{
+#ifdef WITH_ZSTD
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if(stream == nullptr) {
+        return false;
+    }
+    ZSTD_initDStream(stream);
+
+    std::vector<uint8_t> input(m_blockSize);
+    uint64_t inputSize = 0;
+    ZSTD_inBuffer inBuffer = {input.data(), 0, 0};
+    ZSTD_outBuffer outBuffer = {nullptr, 0, 0};
+    bool endOfInput = false;
+    // 0 if the last frame was completely decoded
+    size_t lastRet = 0;
+    bool result = true;
+    Block* block = nullptr;
+
+    while(true)
+    {
+        if(inBuffer.pos == inBuffer.size
+                && endOfInput == false)
+        {
+            if(readInput(input, inputSize) == false)
+            {
+                result = false;
+                break;
+            }
+            endOfInput = inputSize == 0;
+            inBuffer.size = inputSize;
+            inBuffer.pos = 0;
+        }
+
+        if(block == nullptr)
+        {
+            block = getFreeBlock();
+            if(block == nullptr)
+            {
+                result = false;
+                break;
+            }
+            outBuffer.dst = block->data.data();
+            outBuffer.size = m_blockSize;
+            outBuffer.pos = 0;
+        }
+
+        const size_t inputPosition = inBuffer.pos;
+        const size_t outputPosition = outBuffer.pos;
+        const size_t ret = ZSTD_decompressStream(stream, &outBuffer, &inBuffer);
+        if(ZSTD_isError(ret))
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_threadError = "failed to decompress file \"" + m_filePath + "\": "
+                            + std::string(ZSTD_getErrorName(ret));
+            result = false;
+            break;
+        }
+
+        // a call without progress after a complete frame only returns the size of the next header
+        if(inBuffer.pos != inputPosition
+                || outBuffer.pos != outputPosition)
+        {
+            lastRet = ret;
+        }
+
+        block->dataSize = outBuffer.pos;
+        const bool blockFull = outBuffer.pos == outBuffer.size;
+        if(blockFull)
+        {
+            pushBlock(block);
+            block = nullptr;
+        }
+
+        // no more input and all pending output is written
+        if(endOfInput
+                && inBuffer.pos == inBuffer.size
+                && blockFull == false)
+        {
+            break;
+        }
+    }
+
+    if(result
+            && lastRet != 0)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_threadError = "failed to decompress file \"" + m_filePath + "\": "
+                        "unexpected end of file";
+        result = false;
+    }
+
+    if(result
+            && block != nullptr
+            && block->dataSize > 0)
+    {
+        pushBlock(block);
+        block = nullptr;
+    }
+
+    ZSTD_freeDStream(stream);
+
+    return result;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief read the next compressed data from the file
+ *
+ * @param input buffer for the compressed data
+ * @param inputSize reference for the number of read bytes, which is 0 at the end of the file
+ *
+ * @return false, if reading failed, else true
+ */
+bool
+Decompressor::readInput(std::vector<uint8_t> &input,
+                        uint64_t &inputSize)
+{
+    while(true)
+    {
+        const ssize_t ret = ::read(m_fileDescriptor, input.data(), input.size());
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_threadError = "failed to read file \"" + m_filePath + "\": " + strerror(errno);
+            return false;
+        }
+
+        inputSize = static_cast<uint64_t>(ret);
+        return true;
+    }
+}
+
+/**
+ * @brief wait for a block, which was already read by the consumer
+ *
+ * @return nullptr, if the thread should stop, else the free block
+ */
+Decompressor::Block*
+Decompressor::getFreeBlock()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_condition.wait(lock, [this] {
+        return m_freeBlocks.size() > 0 || m_stopThread;
+    });
+
+    if(m_stopThread) {
+        return nullptr;
+    }
+
+    Block* block = m_freeBlocks.front();
+    m_freeBlocks.pop_front();
+    block->dataSize = 0;
+
+    return block;
+}
+
+/**
+ * @brief hand a filled block over to the consumer
+ *
+ * @param block filled block
+ */
+void
+Decompressor::pushBlock(Block* block)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_filledBlocks.push_back(block);
+    m_condition.notify_all();
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
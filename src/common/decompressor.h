@@ -0,0 +1,90 @@
+/**
+ *  @file    decompressor.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief decompression of files in a background-thread for internal usage
+ */
+
+#ifndef DECOMPRESSOR_H
+#define DECOMPRESSOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <libKitsunemimiPersistence/files/compressed_file.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+bool detectCompression(CompressionType &compression,
+                       const int fileDescriptor,
+                       const std::string &filePath,
+                       std::string &errorMessage);
+
+class Decompressor
+{
+public:
+    Decompressor(const uint64_t blockSize = 256 * 1024,
+                 const uint32_t numberOfBlocks = 4);
+    ~Decompressor();
+
+    bool start(const int fileDescriptor,
+               const CompressionType compression,
+               const std::string &filePath,
+               std::string &errorMessage);
+    void stop();
+
+    bool read(uint8_t* data,
+              const uint64_t dataSize,
+              uint64_t &readSize,
+              std::string &errorMessage);
+
+private:
+    struct Block
+    {
+        std::vector<uint8_t> data;
+        uint64_t dataSize = 0;
+    };
+
+    uint64_t m_blockSize = 0;
+    std::vector<Block> m_blocks;
+    int m_fileDescriptor = -1;
+    CompressionType m_compression = NO_COMPRESSION;
+    std::string m_filePath = "";
+
+    // block, which is read at the moment by the consumer
+    Block* m_currentBlock = nullptr;
+    uint64_t m_currentPosition = 0;
+
+    std::deque<Block*> m_freeBlocks;
+    std::deque<Block*> m_filledBlocks;
+    bool m_endOfData = false;
+    std::string m_threadError = "";
+
+    std::thread* m_thread = nullptr;
+    std::mutex m_lock;
+    std::condition_variable m_condition;
+    bool m_stopThread = false;
+
+    void run();
+    bool decompressGzip();
+    bool decompressZstd();
+    bool readInput(std::vector<uint8_t> &input,
+                   uint64_t &inputSize);
+    Block* getFreeBlock();
+    void pushBlock(Block* block);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // DECOMPRESSOR_H
@@ -0,0 +1,577 @@
+/**
+ *  @file    directory_walker.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel walk over directory-trees for internal usage
+ *
+ *  @detail Directories are read with getdents64 in big blocks and the type of the entries is
+ *          taken from the directory-entries, so no stat-call is necessary, except the
+ *          filesystem doesn't provide the type. Subdirectories are opened with openat relative
+ *          to the descriptor of their parent. Each thread has its own queue of directories,
+ *          which it processes depth-first, and idle threads steal the oldest directories from
+ *          the queues of the other threads, which are normally the biggest subtrees.
+ */
+
+#include "directory_walker.h"
+
+#include <algorithm>
+#include <thread>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+// layout of the entries, which are returned by getdents64
+struct LinuxDirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    uint16_t d_reclen;
+    uint8_t d_type;
+    char d_name[1];
+};
+
+/**
+ * @brief read all entries of an open directory
+ *
+ * @param directoryDescriptor descriptor of the directory
+ * @param buffer buffer for the raw directory-entries
+ * @param processEntry callback for each entry, except "." and "..". It gets the name, the type
+ *                     as DT_*-value and the inode and returns false to stop the reading.
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if reading failed, else true
+ */
+bool
+readDirectory(const int directoryDescriptor,
+              std::vector<uint8_t> &buffer,
+              const std::function<bool(const std::string_view &name,
+                                       const uint8_t type,
+                                       const uint64_t inode)> &processEntry,
+              std::string &errorMessage)
+{
+    while(true)
+    {
+        const long ret = syscall(SYS_getdents64,
+                                 directoryDescriptor,
+                                 buffer.data(),
+                                 buffer.size());
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            errorMessage = strerror(errno);
+            return false;
+        }
+
+        if(ret == 0) {
+            return true;
+        }
+
+        long position = 0;
+        while(position < ret)
+        {
+            const LinuxDirent64* entry =
+                    reinterpret_cast<const LinuxDirent64*>(&buffer[static_cast<uint64_t>(position)]);
+            position += entry->d_reclen;
+
+            const char* name = entry->d_name;
+            if(name[0] == '.'
+                    && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+                continue;
+            }
+
+            if(processEntry(std::string_view(name), entry->d_type, entry->d_ino) == false) {
+                return true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief create the path of an entry of a directory
+ *
+ * @param directoryPath path of the directory (empty for the current working-directory)
+ * @param name name of the entry
+ *
+ * @return path of the entry
+ */
+const std::string
+getEntryPath(const std::string_view &directoryPath,
+             const std::string_view &name)
+{
+    std::string path;
+    path.reserve(directoryPath.size() + name.size() + 1);
+    path.append(directoryPath);
+    if(path.size() > 0
+            && path.back() != '/')
+    {
+        path.push_back('/');
+    }
+    path.append(name);
+
+    return path;
+}
+
+/**
+ * @brief convert the type of a directory-entry
+ *
+ * @param type type as DT_*-value of dirent.h
+ *
+ * @return type of the entry
+ */
+static EntryType
+convertType(const uint8_t type)
+{
+    switch(type)
+    {
+        case DT_UNKNOWN:
+            return UNKNOWN_ENTRY;
+        case DT_REG:
+            return FILE_ENTRY;
+        case DT_DIR:
+            return DIRECTORY_ENTRY;
+        case DT_LNK:
+            return SYMLINK_ENTRY;
+        default:
+            return OTHER_ENTRY;
+    }
+}
+
+//==================================================================================================
+
+/**
+ * @brief destructor
+ */
+DirectoryWalker::DirectoryHandle::~DirectoryHandle()
+{
+    if(descriptor >= 0) {
+        close(descriptor);
+    }
+}
+
+/**
+ * @brief constructor
+ *
+ * @param numberOfThreads number of threads for the walk (0 to use one thread per cpu-core)
+ */
+DirectoryWalker::DirectoryWalker(const uint32_t numberOfThreads)
+    : m_pendingTasks(0),
+      m_stopWalk(false),
+      m_workVersion(0)
+{
+    m_numberOfThreads = numberOfThreads;
+    if(m_numberOfThreads == 0) {
+        m_numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for(uint32_t i = 0; i < m_numberOfThreads; i++) {
+        m_queues.push_back(new WorkQueue());
+    }
+}
+
+/**
+ * @brief destructor
+ */
+DirectoryWalker::~DirectoryWalker()
+{
+    for(WorkQueue* queue : m_queues) {
+        delete queue;
+    }
+}
+
+/**
+ * @brief walk over all entries of a directory-tree
+ *
+ * @param rootPath path of the directory to walk
+ * @param processEntry callback for each entry, which is called by multiple threads at the same
+ *                     time. It gets each file and directory and returns, if the walk should be
+ *                     continued. Symbolic links to directories are not followed. If the root-path
+ *                     is not a directory, the callback is called only for the root-path.
+ * @param errorMessage reference for error-message output
+ * @param withSubdirs false to walk only over the entries of the root-directory
+ *
+ * @return false, if the root-directory could not be read or reading of any subdirectory failed,
+ *         else true. Failed subdirectories are skipped and the walk continues.
+ */
+bool
+DirectoryWalker::walk(const std::string &rootPath,
+                      const FileEntryCallback &processEntry,
+                      std::string &errorMessage,
+                      const bool withSubdirs)
+{
+    // remove tailing slashes, so the paths of all entries have the same form
+    std::string path = rootPath;
+    while(path.size() > 1
+          && path.back() == '/')
+    {
+        path.pop_back();
+    }
+
+    struct stat pathStat;
+    if(stat(path.c_str(), &pathStat) != 0)
+    {
+        errorMessage = "failed to read path \"" + path + "\": " + strerror(errno);
+        return false;
+    }
+
+    if(S_ISDIR(pathStat.st_mode) == false) {
+        return processRootFile(path, pathStat, processEntry, errorMessage);
+    }
+
+    m_processEntry = &processEntry;
+    m_withSubdirs = withSubdirs;
+    m_stopWalk = false;
+    m_errorMessage = "";
+
+    Task root;
+    root.name = path;
+    root.path = path;
+    m_pendingTasks = 1;
+
+    // the root-directory is read by the calling thread and further threads are only created,
+    // if there are subdirectories
+    std::vector<uint8_t> buffer(128 * 1024);
+    processDirectory(root, 0, buffer);
+    m_pendingTasks--;
+
+    if(m_pendingTasks > 0
+            && m_stopWalk == false)
+    {
+        std::vector<std::thread> threads;
+        for(uint32_t i = 1; i < m_numberOfThreads; i++) {
+            threads.push_back(std::thread(&DirectoryWalker::runWorker, this, i));
+        }
+
+        runWorker(0);
+
+        for(std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // drop remaining tasks of a stopped walk
+    for(WorkQueue* queue : m_queues) {
+        queue->tasks.clear();
+    }
+    m_pendingTasks = 0;
+    m_processEntry = nullptr;
+
+    if(m_errorMessage.size() > 0)
+    {
+        errorMessage = m_errorMessage;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the number of threads, which are used for the walk. The thread-ids of the entries
+ *        are smaller than this number.
+ *
+ * @return number of threads
+ */
+uint32_t
+DirectoryWalker::getNumberOfThreads() const
+{
+    return m_numberOfThreads;
+}
+
+/**
+ * @brief process directories, until all directories are processed or the walk was stopped.
+ *        Without available directories the thread waits, until new ones are added.
+ *
+ * @param threadId id of the thread
+ */
+void
+DirectoryWalker::runWorker(const uint32_t threadId)
+{
+    std::vector<uint8_t> buffer(128 * 1024);
+
+    while(m_stopWalk == false)
+    {
+        // read before searching a task, so a task, which is added in the meantime, is not missed
+        const uint64_t workVersion = m_workVersion;
+
+        Task task;
+        if(takeTask(threadId, task))
+        {
+            processDirectory(task, threadId, buffer);
+            if(--m_pendingTasks == 0) {
+                notifyWorkers();
+            }
+            continue;
+        }
+
+        // no task available, but other threads can still add new directories
+        std::unique_lock<std::mutex> lock(m_idleLock);
+        m_idleCondition.wait(lock, [this, workVersion] {
+            return m_workVersion != workVersion
+                   || m_pendingTasks == 0
+                   || m_stopWalk;
+        });
+        if(m_pendingTasks == 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief get the next directory from the own queue or steal one from another thread
+ *
+ * @param threadId id of the thread
+ * @param task reference for the directory to process
+ *
+ * @return false, if no directory is available at the moment, else true
+ */
+bool
+DirectoryWalker::takeTask(const uint32_t threadId,
+                          Task &task)
+{
+    // newest directory of the own queue to keep the queue small
+    {
+        WorkQueue* queue = m_queues[threadId];
+        std::unique_lock<std::mutex> lock(queue->lock);
+        if(queue->tasks.size() > 0)
+        {
+            task = std::move(queue->tasks.back());
+            queue->tasks.pop_back();
+            return true;
+        }
+    }
+
+    // oldest directory of another queue
+    for(uint32_t i = 1; i < m_numberOfThreads; i++)
+    {
+        WorkQueue* queue = m_queues[(threadId + i) % m_numberOfThreads];
+        std::unique_lock<std::mutex> lock(queue->lock);
+        if(queue->tasks.size() > 0)
+        {
+            task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief call the callback for a root-path, which is not a directory
+ *
+ * @param path path of the file
+ * @param pathStat already read metadata of the file
+ * @param processEntry callback for the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the parent-directory could not be opened, else true
+ */
+bool
+DirectoryWalker::processRootFile(const std::string &path,
+                                 const struct stat &pathStat,
+                                 const FileEntryCallback &processEntry,
+                                 std::string &errorMessage)
+{
+    // a relative path without directory keeps an empty directory-path, so the path of the entry
+    // is the same as the given path
+    const std::size_t slashPos = path.rfind('/');
+    std::string directoryPath = "";
+    std::string_view name = path;
+    if(slashPos != std::string::npos)
+    {
+        directoryPath = path.substr(0, std::max(slashPos, std::size_t(1)));
+        name = std::string_view(path).substr(slashPos + 1);
+    }
+
+    const std::string openPath = directoryPath.size() == 0 ? "." : directoryPath;
+    const int descriptor = open(openPath.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if(descriptor < 0)
+    {
+        errorMessage = "failed to open directory \"" + openPath + "\": " + strerror(errno);
+        return false;
+    }
+
+    FileEntry entry;
+    entry.m_directoryDescriptor = descriptor;
+    entry.m_directoryPath = directoryPath;
+    entry.m_name = name;
+    entry.m_type = convertType(static_cast<uint8_t>(IFTODT(pathStat.st_mode)));
+    entry.m_inode = pathStat.st_ino;
+
+    // the metadata are already known, so the entry doesn't have to fetch them again
+    entry.m_fetchedMask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE | STATX_MTIME;
+    entry.m_mode = pathStat.st_mode;
+    entry.m_size = static_cast<uint64_t>(pathStat.st_size);
+    entry.m_modificationTime = static_cast<int64_t>(pathStat.st_mtim.tv_sec) * 1000000000
+                               + pathStat.st_mtim.tv_nsec;
+
+    processEntry(entry);
+    close(descriptor);
+
+    return true;
+}
+
+/**
+ * @brief read all entries of a directory and add its subdirectories to the queue of the thread
+ *
+ * @param task directory to process
+ * @param threadId id of the thread
+ * @param buffer buffer for the raw directory-entries
+ */
+void
+DirectoryWalker::processDirectory(const Task &task,
+                                  const uint32_t threadId,
+                                  std::vector<uint8_t> &buffer)
+{
+    // subdirectories are opened relative to their parent and never over a symbolic link
+    int descriptor = -1;
+    if(task.parent == nullptr)
+    {
+        descriptor = open(task.name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    else
+    {
+        descriptor = openat(task.parent->descriptor,
+                            task.name.c_str(),
+                            O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    }
+
+    if(descriptor < 0)
+    {
+        // directories, which were deleted while the walk, are ignored
+        if(errno != ENOENT || task.parent == nullptr) {
+            addError("failed to open directory \"" + task.path + "\": " + strerror(errno));
+        }
+        return;
+    }
+
+    std::shared_ptr<DirectoryHandle> handle = std::make_shared<DirectoryHandle>();
+    handle->descriptor = descriptor;
+    handle->path = task.path;
+
+    std::vector<Task> newTasks;
+    std::string readError = "";
+
+    auto processEntry = [&](const std::string_view &name,
+                            const uint8_t type,
+                            const uint64_t inode)
+    {
+        FileEntry entry;
+        entry.m_directoryDescriptor = descriptor;
+        entry.m_directoryPath = handle->path;
+        entry.m_name = name;
+        entry.m_type = convertType(type);
+        entry.m_inode = inode;
+        entry.m_threadId = threadId;
+
+        // not all filesystems provide the type within the directory-entries
+        if(entry.m_type == UNKNOWN_ENTRY)
+        {
+            struct stat entryStat;
+            if(fstatat(descriptor, name.data(), &entryStat, AT_SYMLINK_NOFOLLOW) == 0) {
+                entry.m_type = convertType(static_cast<uint8_t>(IFTODT(entryStat.st_mode)));
+            }
+        }
+
+        // the callback is allowed to correct the type of the entry
+        const WalkAction action = (*m_processEntry)(entry);
+        if(action == STOP_WALK)
+        {
+            m_stopWalk = true;
+            notifyWorkers();
+            return false;
+        }
+
+        if(entry.m_type == DIRECTORY_ENTRY
+                && m_withSubdirs
+                && action == CONTINUE_WALK)
+        {
+            Task newTask;
+            newTask.parent = handle;
+            newTask.name = std::string(name);
+            newTask.path = getEntryPath(handle->path, name);
+            newTasks.push_back(std::move(newTask));
+
+            // publish the found directories early, so idle threads can steal them
+            if(newTasks.size() >= 16)
+            {
+                m_pendingTasks += newTasks.size();
+                {
+                    WorkQueue* queue = m_queues[threadId];
+                    std::unique_lock<std::mutex> lock(queue->lock);
+                    for(Task &pendingTask : newTasks) {
+                        queue->tasks.push_back(std::move(pendingTask));
+                    }
+                }
+                newTasks.clear();
+                notifyWorkers();
+            }
+        }
+
+        return m_stopWalk == false;
+    };
+
+    if(readDirectory(descriptor, buffer, processEntry, readError) == false) {
+        addError("failed to read directory \"" + task.path + "\": " + readError);
+    }
+
+    if(newTasks.size() > 0)
+    {
+        m_pendingTasks += newTasks.size();
+        {
+            WorkQueue* queue = m_queues[threadId];
+            std::unique_lock<std::mutex> lock(queue->lock);
+            for(Task &pendingTask : newTasks) {
+                queue->tasks.push_back(std::move(pendingTask));
+            }
+        }
+        notifyWorkers();
+    }
+}
+
+/**
+ * @brief wake up all waiting threads, because new directories were added or the walk ended
+ */
+void
+DirectoryWalker::notifyWorkers()
+{
+    m_workVersion++;
+
+    // the lock ensures, that no thread is between checking the condition and starting to wait
+    {
+        std::unique_lock<std::mutex> lock(m_idleLock);
+    }
+    m_idleCondition.notify_all();
+}
+
+/**
+ * @brief remember the first error of the walk
+ *
+ * @param errorMessage error-message
+ */
+void
+DirectoryWalker::addError(const std::string &errorMessage)
+{
+    std::unique_lock<std::mutex> lock(m_errorLock);
+    if(m_errorMessage.size() == 0) {
+        m_errorMessage = errorMessage;
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,112 @@
+/**
+ *  @file    directory_walker.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel walk over directory-trees for internal usage
+ */
+
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <sys/stat.h>
+
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+bool readDirectory(const int directoryDescriptor,
+                   std::vector<uint8_t> &buffer,
+                   const std::function<bool(const std::string_view &name,
+                                            const uint8_t type,
+                                            const uint64_t inode)> &processEntry,
+                   std::string &errorMessage);
+const std::string getEntryPath(const std::string_view &directoryPath,
+                               const std::string_view &name);
+
+//==================================================================================================
+
+class DirectoryWalker
+{
+public:
+    DirectoryWalker(const uint32_t numberOfThreads = 0);
+    ~DirectoryWalker();
+
+    bool walk(const std::string &rootPath,
+              const FileEntryCallback &processEntry,
+              std::string &errorMessage,
+              const bool withSubdirs = true);
+
+    uint32_t getNumberOfThreads() const;
+
+private:
+    struct DirectoryHandle
+    {
+        int descriptor = -1;
+        std::string path = "";
+
+        ~DirectoryHandle();
+    };
+
+    struct Task
+    {
+        // parent stays open, until all of its subdirectories are opened
+        std::shared_ptr<DirectoryHandle> parent;
+        std::string name = "";
+        std::string path = "";
+    };
+
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    uint32_t m_numberOfThreads = 0;
+    std::vector<WorkQueue*> m_queues;
+
+    const FileEntryCallback* m_processEntry = nullptr;
+    bool m_withSubdirs = true;
+    std::atomic<uint64_t> m_pendingTasks;
+    std::atomic<bool> m_stopWalk;
+
+    // idle threads wait for new tasks or the end of the walk
+    std::mutex m_idleLock;
+    std::condition_variable m_idleCondition;
+    std::atomic<uint64_t> m_workVersion;
+
+    std::mutex m_errorLock;
+    std::string m_errorMessage = "";
+
+    void runWorker(const uint32_t threadId);
+    bool takeTask(const uint32_t threadId,
+                  Task &task);
+    bool processRootFile(const std::string &path,
+                         const struct stat &pathStat,
+                         const FileEntryCallback &processEntry,
+                         std::string &errorMessage);
+    void processDirectory(const Task &task,
+                          const uint32_t threadId,
+                          std::vector<uint8_t> &buffer);
+    void notifyWorkers();
+    void addError(const std::string &errorMessage);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // DIRECTORY_WALKER_H
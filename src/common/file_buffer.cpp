@@ -0,0 +1,147 @@
+/**
+ *  @file    file_buffer.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief helper for buffered sequential reads, preallocated writes and numbered names of
+ *         binary-files for internal usage
+ */
+
+#include "file_buffer.h"
+
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include <algorithm>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief make sure, that a byte-range of a file is loaded into a buffer. If the range is not
+ *        already completely within the buffer, the buffer is refilled beginning at the requested
+ *        position with at least the read-ahead-size.
+ *
+ * @param file file to read from
+ * @param buffer buffer, which holds the already read part of the file
+ * @param bufferFilePosition position within the file of the first byte of the buffer
+ * @param bufferSize number of valid bytes within the buffer
+ * @param position position within the file of the requested range
+ * @param numberOfBytes size of the requested range
+ * @param endPosition position within the file, where the valid data end
+ * @param readAheadSize minimum number of bytes to read, when the buffer has to be refilled
+ *
+ * @return false, if range is behind the end-position or read failed, else true
+ */
+bool
+bufferFileRange(BinaryFile &file,
+                std::vector<uint8_t> &buffer,
+                uint64_t &bufferFilePosition,
+                uint64_t &bufferSize,
+                const uint64_t position,
+                const uint64_t numberOfBytes,
+                const uint64_t endPosition,
+                const uint64_t readAheadSize)
+{
+    if(position + numberOfBytes > endPosition) {
+        return false;
+    }
+
+    // check if range is already in the buffer
+    if(position >= bufferFilePosition
+            && position + numberOfBytes <= bufferFilePosition + bufferSize)
+    {
+        return true;
+    }
+
+    // refill buffer
+    const uint64_t readSize = std::min(std::max(numberOfBytes, readAheadSize),
+                                       endPosition - position);
+    if(buffer.size() < readSize) {
+        buffer.resize(readSize);
+    }
+
+    bufferFilePosition = position;
+    bufferSize = 0;
+    if(file.readDataFromFile(buffer.data(), position, readSize) == false) {
+        return false;
+    }
+    bufferSize = readSize;
+
+    return true;
+}
+
+/**
+ * @brief make sure, that a binary-file has at least a specific size by allocating storage in
+ *        big steps, to avoid an allocation for each write
+ *
+ * @param file file to check
+ * @param requiredSize required size in bytes
+ * @param allocationStep number of bytes, which are allocated at once
+ *
+ * @return true, if successful, else false
+ */
+bool
+ensureFileSize(BinaryFile &file,
+               const uint64_t requiredSize,
+               const uint64_t allocationStep)
+{
+    if(requiredSize <= file.m_totalFileSize) {
+        return true;
+    }
+
+    const uint64_t missing = requiredSize - file.m_totalFileSize;
+    const uint64_t numberOfSteps = (missing + allocationStep - 1) / allocationStep;
+
+    return file.allocateStorage(numberOfSteps, static_cast<uint32_t>(allocationStep));
+}
+
+/**
+ * @brief get the id of a file, whose name was created with the pattern "%020lu" and an extension
+ *
+ * @param filePath path of the file
+ * @param extension expected extension of the file with leading dot
+ * @param fileId reference for the resulting id
+ *
+ * @return false, if the name of the file doesn't match the pattern, else true
+ */
+bool
+parseFileId(const std::string &filePath,
+            const std::string &extension,
+            uint64_t &fileId)
+{
+    const bfs::path path(filePath);
+    if(path.extension() != extension) {
+        return false;
+    }
+
+    const std::string stem = path.stem().string();
+    if(stem.size() != 20) {
+        return false;
+    }
+
+    uint64_t id = 0;
+    for(const char c : stem)
+    {
+        if(c < '0' || c > '9') {
+            return false;
+        }
+
+        const uint64_t digit = static_cast<uint64_t>(c - '0');
+        if(id > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        id = id * 10 + digit;
+    }
+
+    fileId = id;
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,43 @@
+/**
+ *  @file    file_buffer.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief helper for buffered sequential reads, preallocated writes and numbered names of
+ *         binary-files for internal usage
+ */
+
+#ifndef FILE_BUFFER_H
+#define FILE_BUFFER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+class BinaryFile;
+
+bool bufferFileRange(BinaryFile &file,
+                     std::vector<uint8_t> &buffer,
+                     uint64_t &bufferFilePosition,
+                     uint64_t &bufferSize,
+                     const uint64_t position,
+                     const uint64_t numberOfBytes,
+                     const uint64_t endPosition,
+                     const uint64_t readAheadSize);
+bool ensureFileSize(BinaryFile &file,
+                    const uint64_t requiredSize,
+                    const uint64_t allocationStep);
+bool parseFileId(const std::string &filePath,
+                 const std::string &extension,
+                 uint64_t &fileId);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_BUFFER_H
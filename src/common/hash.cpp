@@ -0,0 +1,144 @@
+/**
+ *  @file    hash.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief non-cryptographic hash-functions for internal usage
+ *
+ *  @detail The 128-bit hash is based on MurmurHash3 (x64, 128-bit variant) of Austin Appleby,
+ *          which is in the public domain. It processes two independent 64-bit lanes per block,
+ *          which the compiler can schedule in parallel.
+ */
+
+#include "hash.h"
+
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief rotate 64-bit value to the left
+ */
+static inline uint64_t
+rotl64(const uint64_t value,
+       const int8_t shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+/**
+ * @brief finalization mix to force all bits of a hash block to avalanche
+ */
+static inline uint64_t
+fmix64(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return value;
+}
+
+/**
+ * @brief calculate 128-bit hash of a data-block
+ *
+ * @param data pointer to the data
+ * @param dataSize number of bytes
+ * @param low reference for the lower 64 bits of the hash
+ * @param high reference for the upper 64 bits of the hash
+ * @param seed seed of the hash
+ */
+void
+calcHash128(const void* data,
+            const uint64_t dataSize,
+            uint64_t &low,
+            uint64_t &high,
+            const uint64_t seed)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint64_t numberOfBlocks = dataSize / 16;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    // body
+    for(uint64_t i = 0; i < numberOfBlocks; i++)
+    {
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+        memcpy(&k1, &bytes[i * 16], sizeof(uint64_t));
+        memcpy(&k2, &bytes[i * 16 + 8], sizeof(uint64_t));
+
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    // tail
+    const uint8_t* tail = &bytes[numberOfBlocks * 16];
+    const uint64_t tailSize = dataSize & 15;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    for(uint64_t i = tailSize; i > 8; i--) {
+        k2 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 9) * 8);
+    }
+    if(tailSize > 8)
+    {
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+
+    for(uint64_t i = tailSize > 8 ? 8 : tailSize; i > 0; i--) {
+        k1 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 1) * 8);
+    }
+    if(tailSize > 0)
+    {
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    // finalization
+    h1 ^= dataSize;
+    h2 ^= dataSize;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    low = h1;
+    high = h2;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,30 @@
+/**
+ *  @file    hash.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief non-cryptographic hash-functions for internal usage
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+void calcHash128(const void* data,
+                 const uint64_t dataSize,
+                 uint64_t &low,
+                 uint64_t &high,
+                 const uint64_t seed = 0);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // HASH_H
@@ -0,0 +1,241 @@
+/**
+ *  @file    temp_file.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief temporary files to replace files atomically for internal usage
+ */
+
+#include "temp_file.h"
+
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief create a temporary file in the directory of a target-file, which can later replace the
+ *        target-file. An unnamed file is used, if the file-system supports this, so nothing is
+ *        left, if the process crashes. Else a hidden temporary file is created. The unnamed file
+ *        is linked via /proc, so the hidden file is also used, if /proc is not mounted.
+ *
+ * @param tempFile reference for the new temporary file
+ * @param filePath path of the target-file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+openTempFile(TempFile &tempFile,
+             const std::string &filePath,
+             std::string &errorMessage)
+{
+    const bfs::path path(filePath);
+    tempFile.filePath = filePath;
+    tempFile.directoryPath = path.parent_path().string();
+    if(tempFile.directoryPath.size() == 0) {
+        tempFile.directoryPath = ".";
+    }
+    tempFile.fileName = path.filename().string();
+
+    // open parent-directory and create it, if necessary
+    const char* directoryPath = tempFile.directoryPath.c_str();
+    tempFile.directory = open(directoryPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(tempFile.directory < 0
+            && errno == ENOENT
+            && createDirectory(tempFile.directoryPath, errorMessage))
+    {
+        tempFile.directory = open(directoryPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if(tempFile.directory < 0)
+    {
+        errorMessage = "failed to open directory \"" + tempFile.directoryPath + "\": "
+                       + strerror(errno);
+        return false;
+    }
+
+    // keep the access-rights of an existing file
+    mode_t mode = 0666;
+    bool existing = false;
+    struct stat fileStat;
+    if(fstatat(tempFile.directory, tempFile.fileName.c_str(), &fileStat, 0) == 0)
+    {
+        if(S_ISDIR(fileStat.st_mode))
+        {
+            errorMessage = "failed to write destination of path \""
+                           + filePath +
+                           "\", because it already exist and it is a directory, "
+                           "but must be a file or not existing";
+            discardTempFile(tempFile);
+            return false;
+        }
+        mode = fileStat.st_mode & 07777;
+        existing = true;
+    }
+
+    // create temporary file
+    static std::atomic<uint64_t> tempCounter(0);
+    tempFile.tempName = "." + tempFile.fileName + ".tmp." + std::to_string(getpid())
+                        + "." + std::to_string(tempCounter++);
+    tempFile.named = false;
+    tempFile.file = -1;
+    if(access("/proc/self/fd", X_OK) == 0) {
+        tempFile.file = openat(tempFile.directory, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+    }
+    if(tempFile.file < 0)
+    {
+        tempFile.named = true;
+        tempFile.file = openat(tempFile.directory,
+                               tempFile.tempName.c_str(),
+                               O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC,
+                               mode);
+    }
+    if(tempFile.file < 0)
+    {
+        errorMessage = "failed to create temporary file in \"" + tempFile.directoryPath + "\": "
+                       + strerror(errno);
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    // the mode of the open-call is reduced by the umask
+    if(existing) {
+        fchmod(tempFile.file, mode);
+    }
+
+    return true;
+}
+
+/**
+ * @brief sync the temporary file and rename it over the target-file. If only the sync of the
+ *        directory failed, the target-file is already replaced, but the rename is maybe not
+ *        persistent. This case is marked by the committed-flag of the temporary file.
+ *
+ * @param tempFile temporary file, which is closed afterwards
+ * @param syncDirectory true to also sync the directory, so the rename itself is persistent
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+commitTempFile(TempFile &tempFile,
+               const bool syncDirectory,
+               std::string &errorMessage)
+{
+    bool success = fdatasync(tempFile.file) == 0;
+
+    // give the unnamed file a name, to be able to rename it over the target
+    if(success && tempFile.named == false)
+    {
+        const std::string procPath = "/proc/self/fd/" + std::to_string(tempFile.file);
+        success = linkat(AT_FDCWD,
+                         procPath.c_str(),
+                         tempFile.directory,
+                         tempFile.tempName.c_str(),
+                         AT_SYMLINK_FOLLOW) == 0;
+        tempFile.named = success;
+    }
+
+    if(success)
+    {
+        success = renameat(tempFile.directory,
+                           tempFile.tempName.c_str(),
+                           tempFile.directory,
+                           tempFile.fileName.c_str()) == 0;
+    }
+
+    if(success == false)
+    {
+        errorMessage = "failed to write file \"" + tempFile.filePath + "\": " + strerror(errno);
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    // the temporary name doesn't exist anymore after the rename
+    tempFile.named = false;
+    tempFile.committed = true;
+
+    if(syncDirectory
+            && fsync(tempFile.directory) != 0)
+    {
+        errorMessage = "file \"" + tempFile.filePath + "\" was replaced, but failed to sync "
+                       "directory \"" + tempFile.directoryPath + "\": " + strerror(errno);
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    discardTempFile(tempFile);
+
+    return true;
+}
+
+/**
+ * @brief close and delete a temporary file without touching the target-file
+ *
+ * @param tempFile temporary file to discard
+ */
+void
+discardTempFile(TempFile &tempFile)
+{
+    if(tempFile.file >= 0)
+    {
+        close(tempFile.file);
+        tempFile.file = -1;
+
+        if(tempFile.named) {
+            unlinkat(tempFile.directory, tempFile.tempName.c_str(), 0);
+        }
+    }
+
+    if(tempFile.directory >= 0)
+    {
+        close(tempFile.directory);
+        tempFile.directory = -1;
+    }
+}
+
+/**
+ * @brief write a complete memory-region into a file-descriptor
+ *
+ * @param fileDescriptor target file-descriptor
+ * @param data pointer to the data
+ * @param dataSize number of bytes to write
+ *
+ * @return false, if writing failed, else true
+ */
+bool
+writeAll(const int fileDescriptor,
+         const void* data,
+         const uint64_t dataSize)
+{
+    const char* bytes = static_cast<const char*>(data);
+    uint64_t writtenSize = 0;
+    while(writtenSize < dataSize)
+    {
+        const ssize_t ret = write(fileDescriptor, bytes + writtenSize, dataSize - writtenSize);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        writtenSize += static_cast<uint64_t>(ret);
+    }
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,51 @@
+/**
+ *  @file    temp_file.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief temporary files to replace files atomically for internal usage
+ */
+
+#ifndef TEMP_FILE_H
+#define TEMP_FILE_H
+
+#include <string>
+#include <stdint.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+struct TempFile
+{
+    std::string filePath = "";
+    std::string directoryPath = "";
+    std::string fileName = "";
+    std::string tempName = "";
+    int directory = -1;
+    int file = -1;
+    // true, if the temporary file has a name in the directory
+    bool named = false;
+    // true, if the temporary file was already renamed over the target-file
+    bool committed = false;
+};
+
+bool openTempFile(TempFile &tempFile,
+                  const std::string &filePath,
+                  std::string &errorMessage);
+bool commitTempFile(TempFile &tempFile,
+                    const bool syncDirectory,
+                    std::string &errorMessage);
+void discardTempFile(TempFile &tempFile);
+
+bool writeAll(const int fileDescriptor,
+              const void* data,
+              const uint64_t dataSize);
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TEMP_FILE_H
@@ -0,0 +1,336 @@
+/**
+ *  @file    append_writer.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief writer, which keeps a file open to append text to it
+ *
+ *  @detail The appended text is collected in a buffer, which is written into the file, when it
+ *          is full or regularly by a background-thread. Multiple threads can append at the same
+ *          time and a sync can be requested for each append. Concurrent sync-requests are
+ *          grouped, so a single fdatasync covers the text of all threads, which waited for it.
+ */
+
+#include <libKitsunemimiPersistence/files/append_writer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief constructor
+ *
+ * @param bufferSize number of bytes, which are collected before they are written into the file
+ * @param flushInterval time in milliseconds, after which buffered text is written into the
+ *                      file (0 to disable the background-thread)
+ */
+AppendWriter::AppendWriter(const uint64_t bufferSize,
+                           const uint32_t flushInterval)
+{
+    m_bufferSize = bufferSize;
+    m_flushInterval = flushInterval;
+}
+
+/**
+ * @brief destructor
+ */
+AppendWriter::~AppendWriter()
+{
+    closeFile();
+}
+
+/**
+ * @brief open or create a file to append text
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+AppendWriter::openFile(const std::string &filePath,
+                       std::string &errorMessage)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if(m_fileDescriptor >= 0)
+        {
+            errorMessage = "file \"" + m_filePath + "\" is already open";
+            return false;
+        }
+
+        const int fileDescriptor = open(filePath.c_str(),
+                                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                                        0666);
+        if(fileDescriptor < 0)
+        {
+            errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+            return false;
+        }
+
+        m_fileDescriptor = fileDescriptor;
+        m_filePath = filePath;
+        m_buffer.clear();
+        m_buffer.reserve(m_bufferSize);
+        m_appendedSize = 0;
+        m_syncedSize = 0;
+    }
+
+    // start background-flush
+    if(m_flushInterval > 0)
+    {
+        m_stopThread = false;
+        m_flushThread = new std::thread(&AppendWriter::runFlushThread, this);
+    }
+
+    return true;
+}
+
+/**
+ * @brief write all buffered text into the file and close it
+ *
+ * @return false, if no file was open or writing the buffer failed, else true
+ */
+bool
+AppendWriter::closeFile()
+{
+    // stop background-flush
+    if(m_flushThread != nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> threadGuard(m_threadLock);
+            m_stopThread = true;
+        }
+        m_threadCondition.notify_all();
+        m_flushThread->join();
+        delete m_flushThread;
+        m_flushThread = nullptr;
+    }
+
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    // the descriptor must not be closed, while another thread syncs it
+    while(m_syncInProgress) {
+        m_syncCondition.wait(guard);
+    }
+
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    const bool result = writeBuffer();
+    close(m_fileDescriptor);
+    m_fileDescriptor = -1;
+    m_filePath = "";
+    m_buffer.clear();
+
+    return result;
+}
+
+/**
+ * @brief append text to the file
+ *
+ * @param newText text which should be append to the file
+ * @param sync true to wait until the text is synced to the storage
+ *
+ * @return false, if no file is open or writing failed, else true
+ */
+bool
+AppendWriter::appendText(const std::string &newText,
+                         const bool sync)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if(m_fileDescriptor < 0) {
+            return false;
+        }
+
+        if(m_buffer.size() + newText.size() > m_bufferSize
+                && writeBuffer() == false)
+        {
+            return false;
+        }
+
+        // text, which doesn't fit into the buffer, is written directly
+        if(newText.size() >= m_bufferSize)
+        {
+            uint64_t writtenSize = 0;
+            if(writeIntoFile(newText.c_str(), newText.size(), writtenSize) == false) {
+                return false;
+            }
+        }
+        else
+        {
+            m_buffer.append(newText);
+        }
+
+        m_appendedSize += newText.size();
+    }
+
+    if(sync) {
+        return syncFile();
+    }
+
+    return true;
+}
+
+/**
+ * @brief write all buffered text into the file
+ *
+ * @return false, if no file is open or writing failed, else true
+ */
+bool
+AppendWriter::flush()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    return writeBuffer();
+}
+
+/**
+ * @brief write all buffered text into the file and sync it to the storage. The sync itself
+ *        runs without holding the lock, so other threads can still append in the meantime.
+ *        Only one thread syncs at a time and threads, which waited for it, don't sync again,
+ *        if the other sync already covered their text.
+ *
+ * @return false, if no file is open or writing or syncing failed, else true
+ */
+bool
+AppendWriter::syncFile()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    // all text, which was appended until now, has to be synced
+    const uint64_t requiredSize = m_appendedSize;
+
+    while(m_syncedSize < requiredSize)
+    {
+        if(m_syncInProgress)
+        {
+            m_syncCondition.wait(guard);
+            continue;
+        }
+
+        if(m_fileDescriptor < 0
+                || writeBuffer() == false)
+        {
+            return false;
+        }
+
+        const uint64_t syncSize = m_appendedSize;
+        const int fileDescriptor = m_fileDescriptor;
+        m_syncInProgress = true;
+
+        guard.unlock();
+        const bool success = fdatasync(fileDescriptor) == 0;
+        guard.lock();
+
+        m_syncInProgress = false;
+        if(success && syncSize > m_syncedSize) {
+            m_syncedSize = syncSize;
+        }
+        m_syncCondition.notify_all();
+
+        if(success == false) {
+            return false;
+        }
+    }
+
+    return m_fileDescriptor >= 0;
+}
+
+/**
+ * @brief write the buffer into the file. The lock must be hold by the caller. If writing
+ *        failed, the already written part is removed from the buffer, so it is not written
+ *        twice by the next try.
+ *
+ * @return false, if writing failed, else true
+ */
+bool
+AppendWriter::writeBuffer()
+{
+    if(m_buffer.size() == 0) {
+        return true;
+    }
+
+    uint64_t writtenSize = 0;
+    const bool result = writeIntoFile(m_buffer.c_str(), m_buffer.size(), writtenSize);
+    m_buffer.erase(0, writtenSize);
+
+    return result;
+}
+
+/**
+ * @brief append data to the end of the file
+ *
+ * @param data pointer to the data
+ * @param dataSize number of bytes to write
+ * @param writtenSize reference for the number of bytes, which were written, even if writing
+ *                    failed afterwards
+ *
+ * @return false, if writing failed, else true
+ */
+bool
+AppendWriter::writeIntoFile(const char* data,
+                            const uint64_t dataSize,
+                            uint64_t &writtenSize)
+{
+    writtenSize = 0;
+    while(writtenSize < dataSize)
+    {
+        const ssize_t ret = write(m_fileDescriptor,
+                                  data + writtenSize,
+                                  dataSize - writtenSize);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        writtenSize += static_cast<uint64_t>(ret);
+    }
+
+    return true;
+}
+
+/**
+ * @brief loop of the background-thread, which regularly writes the buffer into the file
+ */
+void
+AppendWriter::runFlushThread()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> threadGuard(m_threadLock);
+            m_threadCondition.wait_for(threadGuard,
+                                       std::chrono::milliseconds(m_flushInterval),
+                                       [this] { return m_stopThread; });
+            if(m_stopThread) {
+                return;
+            }
+        }
+
+        flush();
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
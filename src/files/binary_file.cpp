@@ -337,6 +337,160 @@ BinaryFile::writeSegment(DataBuffer &buffer,
     return true;
 }
 
+/**
+ * @brief read a byte-range of the file into a memory-region without changing the file-position
+ *
+ * @param data pointer to the target-memory, which must be at least numberOfBytes big
+ * @param startBytePosition position within the file, where to start the read
+ * @param numberOfBytes number of bytes to read
+ *
+ * @return true, if successful, else false
+ */
+bool
+BinaryFile::readDataFromFile(void* data,
+                             const uint64_t startBytePosition,
+                             const uint64_t numberOfBytes)
+{
+    // precheck
+    if(numberOfBytes == 0
+            || data == nullptr
+            || startBytePosition + numberOfBytes > m_totalFileSize
+            || m_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    // direct-io requires the position and the size to be aligned to the block-size
+    if(m_directIO
+            && (startBytePosition % 512 != 0
+                || numberOfBytes % 512 != 0))
+    {
+        return false;
+    }
+
+    // read data with pread, which can return less than requested, so loop until all is read
+    uint8_t* target = static_cast<uint8_t*>(data);
+    uint64_t readBytes = 0;
+    while(readBytes < numberOfBytes)
+    {
+        const ssize_t ret = pread(m_fileDescriptor,
+                                  target + readBytes,
+                                  numberOfBytes - readBytes,
+                                  static_cast<long>(startBytePosition + readBytes));
+        if(ret == -1
+                && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(ret <= 0) {
+            return false;
+        }
+
+        readBytes += static_cast<uint64_t>(ret);
+    }
+
+    return true;
+}
+
+/**
+ * @brief write a memory-region into a byte-range of the file without changing the file-position
+ *        and without syncing the file
+ *
+ * @param data pointer to the source-memory
+ * @param startBytePosition position within the file, where to start the write
+ * @param numberOfBytes number of bytes to write
+ *
+ * @return true, if successful, else false
+ */
+bool
+BinaryFile::writeDataIntoFile(const void* data,
+                              const uint64_t startBytePosition,
+                              const uint64_t numberOfBytes)
+{
+    // precheck
+    if(numberOfBytes == 0
+            || data == nullptr
+            || startBytePosition + numberOfBytes > m_totalFileSize
+            || m_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    // direct-io requires the position and the size to be aligned to the block-size
+    if(m_directIO
+            && (startBytePosition % 512 != 0
+                || numberOfBytes % 512 != 0))
+    {
+        return false;
+    }
+
+    // write data with pwrite, which can write less than requested, so loop until all is written
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    uint64_t writtenBytes = 0;
+    while(writtenBytes < numberOfBytes)
+    {
+        const ssize_t ret = pwrite(m_fileDescriptor,
+                                   source + writtenBytes,
+                                   numberOfBytes - writtenBytes,
+                                   static_cast<long>(startBytePosition + writtenBytes));
+        if(ret == -1
+                && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(ret <= 0) {
+            return false;
+        }
+
+        writtenBytes += static_cast<uint64_t>(ret);
+    }
+
+    return true;
+}
+
+/**
+ * @brief cut the file to a specific size
+ *
+ * @param numberOfBytes new size of the file in bytes
+ *
+ * @return true, if successful, else false
+ */
+bool
+BinaryFile::truncateFile(const uint64_t numberOfBytes)
+{
+    // precheck
+    if(m_fileDescriptor < 0
+            || numberOfBytes > m_totalFileSize)
+    {
+        return false;
+    }
+
+    if(ftruncate(m_fileDescriptor, static_cast<long>(numberOfBytes)) != 0) {
+        return false;
+    }
+
+    m_totalFileSize = numberOfBytes;
+
+    return true;
+}
+
+/**
+ * @brief sync all written data of the file to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+BinaryFile::syncFile()
+{
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    return fdatasync(m_fileDescriptor) == 0;
+}
+
 /**
  * @brief close the cluser-file
  *
@@ -0,0 +1,1021 @@
+/**
+ *  @file    change_tracker.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include <libKitsunemimiPersistence/files/change_tracker.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+#include "../common/directory_walker.h"
+#include "../common/checksum.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define CHANGE_MANIFEST_MAGIC 0x4B4348414E4745ULL
+#define ENTRY_BUFFER_SIZE (64 * 1024)
+#define EVENT_BUFFER_SIZE (64 * 1024)
+
+// directories, which were modified shortly before the scan, can be modified again within the
+// same timestamp, so their modification-time is not trusted at the next scan
+#define RACY_TIME_WINDOW 2000000000LL
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY \
+                    | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF \
+                    | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+#define STRUCTURE_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+                        | IN_DELETE_SELF | IN_MOVE_SELF)
+
+struct ChangeManifestHeader
+{
+    uint64_t magic = CHANGE_MANIFEST_MAGIC;
+    uint64_t numberOfDirectories = 0;
+    uint64_t bodySize = 0;
+    uint32_t checksum = 0;
+    uint8_t padding[4] = {0, 0, 0, 0};
+} __attribute__((packed));
+
+/**
+ * @brief append a value to the body of the manifest
+ */
+template<typename T>
+static void
+appendValue(std::string &buffer,
+            const T &value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief append a string with its length to the body of the manifest
+ */
+static void
+appendString(std::string &buffer,
+             const std::string &value)
+{
+    appendValue(buffer, static_cast<uint32_t>(value.size()));
+    buffer.append(value);
+}
+
+/**
+ * @brief read a value from the body of the manifest
+ *
+ * @return false, if the body is too short, else true
+ */
+template<typename T>
+static bool
+readValue(const std::string &buffer,
+          uint64_t &position,
+          T &value)
+{
+    if(buffer.size() - position < sizeof(T)) {
+        return false;
+    }
+
+    memcpy(&value, &buffer[position], sizeof(T));
+    position += sizeof(T);
+
+    return true;
+}
+
+/**
+ * @brief read a string with its length from the body of the manifest
+ *
+ * @return false, if the body is too short, else true
+ */
+static bool
+readString(const std::string &buffer,
+           uint64_t &position,
+           std::string &value)
+{
+    uint32_t length = 0;
+    if(readValue(buffer, position, length) == false
+            || buffer.size() - position < length)
+    {
+        return false;
+    }
+
+    value.assign(buffer, position, length);
+    position += length;
+
+    return true;
+}
+
+/**
+ * @brief get the modification-time of a stat-result in nanoseconds
+ */
+static int64_t
+getModificationTime(const struct stat &entryStat)
+{
+    return static_cast<int64_t>(entryStat.st_mtim.tv_sec) * 1000000000LL
+           + static_cast<int64_t>(entryStat.st_mtim.tv_nsec);
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param checkFiles true to compare the metadata of all files at a rescan. If false, only files
+ *                   of modified directories are checked, so content-changes of files, which are
+ *                   not registered by the live-mode, are not detected.
+ */
+ChangeTracker::ChangeTracker(const bool checkFiles)
+{
+    m_checkFiles = checkFiles;
+    m_entryBuffer.resize(ENTRY_BUFFER_SIZE);
+}
+
+/**
+ * @brief destructor
+ */
+ChangeTracker::~ChangeTracker()
+{
+    std::string errorMessage = "";
+    closeTracker(errorMessage);
+}
+
+/**
+ * @brief initialize the tracker for a directory-tree and load the manifest of the last run. A
+ *        missing or broken manifest is ignored, so all files are reported as added at the first
+ *        scan.
+ *
+ * @param rootPath path to the root-directory of the tree
+ * @param manifestPath path of the manifest-file, which should be outside of the tree
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if already initialized or the root-path is not a directory, else true
+ */
+bool
+ChangeTracker::initTracker(const std::string &rootPath,
+                           const std::string &manifestPath,
+                           std::string &errorMessage)
+{
+    if(m_isInit)
+    {
+        errorMessage = "tracker is already initialized";
+        return false;
+    }
+
+    std::string root = rootPath;
+    while(root.size() > 1
+          && root.back() == '/')
+    {
+        root.pop_back();
+    }
+
+    struct stat rootStat;
+    if(stat(root.c_str(), &rootStat) != 0)
+    {
+        errorMessage = "failed to read \"" + root + "\": " + strerror(errno);
+        return false;
+    }
+
+    if(S_ISDIR(rootStat.st_mode) == false)
+    {
+        errorMessage = "path \"" + root + "\" is not a directory";
+        return false;
+    }
+
+    m_rootPath = root;
+    m_manifestPath = manifestPath;
+    m_isInit = true;
+
+    if(loadManifest() == false) {
+        m_directories.clear();
+    }
+    m_manifestChanged = false;
+
+    return true;
+}
+
+/**
+ * @brief stop the live-mode, write the manifest, if it has changed, and reset the tracker
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if not initialized or writing the manifest failed, else true
+ */
+bool
+ChangeTracker::closeTracker(std::string &errorMessage)
+{
+    if(m_isInit == false)
+    {
+        errorMessage = "tracker is not initialized";
+        return false;
+    }
+
+    bool result = true;
+    if(m_manifestChanged) {
+        result = saveManifest(errorMessage);
+    }
+
+    if(m_inotifyDescriptor >= 0)
+    {
+        close(m_inotifyDescriptor);
+        m_inotifyDescriptor = -1;
+    }
+
+    m_watches.clear();
+    m_directories.clear();
+    m_rootPath = "";
+    m_manifestPath = "";
+    m_manifestChanged = false;
+    m_isInit = false;
+
+    return result;
+}
+
+/**
+ * @brief compare the tree with the manifest and write the updated manifest afterwards.
+ *        Directories with unchanged inode and modification-time are not read again.
+ *
+ * @param changes reference for the resulting changes
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if not initialized or the scan or writing the manifest failed, else true
+ */
+bool
+ChangeTracker::scanChanges(std::vector<FileChange> &changes,
+                           std::string &errorMessage)
+{
+    changes.clear();
+
+    if(m_isInit == false)
+    {
+        errorMessage = "tracker is not initialized";
+        return false;
+    }
+
+    if(scanTree("", changes, errorMessage) == false) {
+        return false;
+    }
+
+    if(m_manifestChanged) {
+        return saveManifest(errorMessage);
+    }
+
+    return true;
+}
+
+/**
+ * @brief start to watch all directories of the tree with inotify. Call scanChanges afterwards, to
+ *        get the changes since the last scan. New directories are watched automatically.
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if not initialized, already watching or the watches could not be created,
+ *         else true
+ */
+bool
+ChangeTracker::startWatching(std::string &errorMessage)
+{
+    if(m_isInit == false)
+    {
+        errorMessage = "tracker is not initialized";
+        return false;
+    }
+
+    if(m_inotifyDescriptor >= 0)
+    {
+        errorMessage = "tracker is already watching";
+        return false;
+    }
+
+    m_inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_inotifyDescriptor < 0)
+    {
+        errorMessage = std::string("failed to initialize inotify: ") + strerror(errno);
+        return false;
+    }
+
+    // directories, which don't exist anymore, are removed by the next scan
+    for(auto &[relativePath, record] : m_directories)
+    {
+        if(addWatch(relativePath, record, errorMessage) == false
+                && errno != ENOENT
+                && errno != ENOTDIR)
+        {
+            close(m_inotifyDescriptor);
+            m_inotifyDescriptor = -1;
+            m_watches.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief wait for inotify-events and check only the directories and files of these events. If
+ *        the event-queue of the kernel overflowed, the complete tree is scanned again.
+ *
+ * @param changes reference for the resulting changes
+ * @param timeoutMs maximal time in milliseconds to wait for events
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if not watching or the check failed, else true. Also return true without
+ *         changes, if the timeout was reached.
+ */
+bool
+ChangeTracker::waitForChanges(std::vector<FileChange> &changes,
+                              const uint32_t timeoutMs,
+                              std::string &errorMessage)
+{
+    changes.clear();
+
+    if(m_inotifyDescriptor < 0)
+    {
+        errorMessage = "tracker is not watching";
+        return false;
+    }
+
+    struct pollfd pollDescriptor;
+    pollDescriptor.fd = m_inotifyDescriptor;
+    pollDescriptor.events = POLLIN;
+    pollDescriptor.revents = 0;
+
+    int ret = poll(&pollDescriptor, 1, static_cast<int>(timeoutMs));
+    while(ret < 0 && errno == EINTR) {
+        ret = poll(&pollDescriptor, 1, static_cast<int>(timeoutMs));
+    }
+    if(ret < 0)
+    {
+        errorMessage = std::string("failed to wait for inotify-events: ") + strerror(errno);
+        return false;
+    }
+    if(ret == 0) {
+        return true;
+    }
+
+    // collect all pending events, so each directory is checked only once
+    std::unordered_map<std::string, DirtyDirectory> dirtyDirectories;
+    bool overflow = false;
+    alignas(struct inotify_event) char eventBuffer[EVENT_BUFFER_SIZE];
+    while(true)
+    {
+        const ssize_t length = read(m_inotifyDescriptor, eventBuffer, EVENT_BUFFER_SIZE);
+        if(length < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EAGAIN) {
+                break;
+            }
+
+            errorMessage = std::string("failed to read inotify-events: ") + strerror(errno);
+            return false;
+        }
+
+        ssize_t position = 0;
+        while(position < length)
+        {
+            const struct inotify_event* event =
+                    reinterpret_cast<const struct inotify_event*>(&eventBuffer[position]);
+            position += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            const auto watchIt = m_watches.find(event->wd);
+            if(watchIt == m_watches.end()) {
+                continue;
+            }
+
+            // the watch was removed by the kernel, because the directory is gone
+            if(event->mask & IN_IGNORED)
+            {
+                const auto recordIt = m_directories.find(watchIt->second);
+                if(recordIt != m_directories.end()) {
+                    recordIt->second.watchDescriptor = -1;
+                }
+                dirtyDirectories[watchIt->second].structureChanged = true;
+                m_watches.erase(watchIt);
+                continue;
+            }
+
+            DirtyDirectory &dirty = dirtyDirectories[watchIt->second];
+            if((event->mask & STRUCTURE_MASK)
+                    || (event->mask & IN_ISDIR)
+                    || event->len == 0)
+            {
+                dirty.structureChanged = true;
+            }
+            else
+            {
+                dirty.fileNames.insert(std::string(event->name));
+            }
+        }
+    }
+
+    if(overflow) {
+        return scanTree("", changes, errorMessage);
+    }
+
+    // check the directories from the top to the bottom, so removed subtrees are handled by their
+    // parent and only the new directories are scanned completely
+    std::vector<std::string> dirtyPaths;
+    for(const auto &[relativePath, dirty] : dirtyDirectories) {
+        dirtyPaths.push_back(relativePath);
+    }
+    std::sort(dirtyPaths.begin(), dirtyPaths.end());
+
+    std::vector<std::string> newDirectories;
+    for(const std::string &relativePath : dirtyPaths)
+    {
+        if(m_directories.find(relativePath) == m_directories.end()) {
+            continue;
+        }
+
+        DirtyDirectory &dirty = dirtyDirectories[relativePath];
+        if(dirty.structureChanged == false) {
+            checkFiles(relativePath, dirty.fileNames, dirty, changes);
+        }
+
+        if(dirty.structureChanged)
+        {
+            std::vector<std::string> subdirectories;
+            if(scanDirectory(relativePath,
+                             true,
+                             changes,
+                             subdirectories,
+                             newDirectories,
+                             errorMessage) == false)
+            {
+                return false;
+            }
+        }
+    }
+
+    for(const std::string &relativePath : newDirectories)
+    {
+        if(scanTree(relativePath, changes, errorMessage) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief write the manifest atomically into the manifest-file
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if not initialized or writing failed, else true
+ */
+bool
+ChangeTracker::saveManifest(std::string &errorMessage)
+{
+    if(m_isInit == false)
+    {
+        errorMessage = "tracker is not initialized";
+        return false;
+    }
+
+    std::string body;
+    for(const auto &[relativePath, record] : m_directories)
+    {
+        appendString(body, relativePath);
+        appendValue(body, record.inode);
+        appendValue(body, record.modificationTime);
+
+        appendValue(body, static_cast<uint64_t>(record.subdirectories.size()));
+        for(const std::string &name : record.subdirectories) {
+            appendString(body, name);
+        }
+
+        appendValue(body, static_cast<uint64_t>(record.files.size()));
+        for(const auto &[name, file] : record.files)
+        {
+            appendString(body, name);
+            appendValue(body, file.inode);
+            appendValue(body, file.size);
+            appendValue(body, file.modificationTime);
+        }
+    }
+
+    ChangeManifestHeader header;
+    header.numberOfDirectories = m_directories.size();
+    header.bodySize = body.size();
+    header.checksum = calcCrc32c(body.c_str(), body.size());
+
+    std::string content;
+    content.reserve(sizeof(ChangeManifestHeader) + body.size());
+    appendValue(content, header);
+    content.append(body);
+
+    if(writeFileAtomic(m_manifestPath, content, errorMessage) == false) {
+        return false;
+    }
+
+    m_manifestChanged = false;
+
+    return true;
+}
+
+/**
+ * @brief get the number of tracked files
+ *
+ * @return number of files
+ */
+uint64_t
+ChangeTracker::getNumberOfFiles() const
+{
+    uint64_t numberOfFiles = 0;
+    for(const auto &[relativePath, record] : m_directories) {
+        numberOfFiles += record.files.size();
+    }
+
+    return numberOfFiles;
+}
+
+/**
+ * @brief load the manifest-file
+ *
+ * @return false, if the manifest doesn't exist or is broken, else true
+ */
+bool
+ChangeTracker::loadManifest()
+{
+    std::string content = "";
+    std::string errorMessage = "";
+    if(readFile(content, m_manifestPath, errorMessage) == false
+            || content.size() < sizeof(ChangeManifestHeader))
+    {
+        return false;
+    }
+
+    ChangeManifestHeader header;
+    memcpy(&header, content.c_str(), sizeof(ChangeManifestHeader));
+    if(header.magic != CHANGE_MANIFEST_MAGIC
+            || header.bodySize != content.size() - sizeof(ChangeManifestHeader))
+    {
+        return false;
+    }
+
+    const std::string body = content.substr(sizeof(ChangeManifestHeader));
+    if(calcCrc32c(body.c_str(), body.size()) != header.checksum) {
+        return false;
+    }
+
+    uint64_t position = 0;
+    for(uint64_t i = 0; i < header.numberOfDirectories; i++)
+    {
+        std::string relativePath = "";
+        DirectoryRecord record;
+        uint64_t numberOfSubdirectories = 0;
+        uint64_t numberOfFiles = 0;
+
+        if(readString(body, position, relativePath) == false
+                || readValue(body, position, record.inode) == false
+                || readValue(body, position, record.modificationTime) == false
+                || readValue(body, position, numberOfSubdirectories) == false)
+        {
+            return false;
+        }
+
+        for(uint64_t s = 0; s < numberOfSubdirectories; s++)
+        {
+            std::string name = "";
+            if(readString(body, position, name) == false) {
+                return false;
+            }
+            record.subdirectories.push_back(name);
+        }
+
+        if(readValue(body, position, numberOfFiles) == false) {
+            return false;
+        }
+
+        for(uint64_t f = 0; f < numberOfFiles; f++)
+        {
+            std::string name = "";
+            FileRecord file;
+            if(readString(body, position, name) == false
+                    || readValue(body, position, file.inode) == false
+                    || readValue(body, position, file.size) == false
+                    || readValue(body, position, file.modificationTime) == false)
+            {
+                return false;
+            }
+            record.files.emplace(name, file);
+        }
+
+        m_directories.emplace(relativePath, std::move(record));
+    }
+
+    return position == body.size();
+}
+
+/**
+ * @brief scan a directory and all of its subdirectories
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ * @param changes reference for the resulting changes
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if a directory could not be read, else true
+ */
+bool
+ChangeTracker::scanTree(const std::string &relativePath,
+                        std::vector<FileChange> &changes,
+                        std::string &errorMessage)
+{
+    std::vector<std::string> pendingDirectories;
+    pendingDirectories.push_back(relativePath);
+
+    std::vector<std::string> subdirectories;
+    std::vector<std::string> newSubdirectories;
+    while(pendingDirectories.size() > 0)
+    {
+        const std::string currentPath = pendingDirectories.back();
+        pendingDirectories.pop_back();
+
+        subdirectories.clear();
+        newSubdirectories.clear();
+        if(scanDirectory(currentPath,
+                         false,
+                         changes,
+                         subdirectories,
+                         newSubdirectories,
+                         errorMessage) == false)
+        {
+            return false;
+        }
+
+        for(const std::string &name : subdirectories) {
+            pendingDirectories.push_back(getEntryPath(currentPath, name));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief compare a single directory with its record. If inode and modification-time of the
+ *        directory are unchanged, its entries are taken from the record.
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ * @param forceRead true to read the entries of the directory in any case
+ * @param changes reference for the resulting changes
+ * @param subdirectories reference for the names of all subdirectories of the directory
+ * @param newSubdirectories reference for the relative paths of the new subdirectories
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the directory could not be read, else true. Also return true, if the
+ *         directory doesn't exist anymore.
+ */
+bool
+ChangeTracker::scanDirectory(const std::string &relativePath,
+                             const bool forceRead,
+                             std::vector<FileChange> &changes,
+                             std::vector<std::string> &subdirectories,
+                             std::vector<std::string> &newSubdirectories,
+                             std::string &errorMessage)
+{
+    const std::string path = getFullPath(relativePath);
+    const int directoryDescriptor = open(path.c_str(),
+                                         O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if(directoryDescriptor < 0)
+    {
+        if(errno == ENOENT
+                || errno == ENOTDIR
+                || errno == ELOOP)
+        {
+            removeDirectory(relativePath, changes);
+            return true;
+        }
+
+        errorMessage = "failed to open directory \"" + path + "\": " + strerror(errno);
+        return false;
+    }
+
+    struct stat directoryStat;
+    if(fstat(directoryDescriptor, &directoryStat) != 0)
+    {
+        errorMessage = "failed to read directory \"" + path + "\": " + strerror(errno);
+        close(directoryDescriptor);
+        return false;
+    }
+
+    const bool isKnown = m_directories.find(relativePath) != m_directories.end();
+    DirectoryRecord &record = m_directories[relativePath];
+
+    // the watch has to exist before the directory is read, so no change between both gets lost
+    if(m_inotifyDescriptor >= 0
+            && record.watchDescriptor < 0
+            && addWatch(relativePath, record, errorMessage) == false)
+    {
+        close(directoryDescriptor);
+        return false;
+    }
+
+    const int64_t modificationTime = getModificationTime(directoryStat);
+    if(isKnown
+            && forceRead == false
+            && record.inode == directoryStat.st_ino
+            && record.modificationTime == modificationTime)
+    {
+        DirtyDirectory dirty;
+        if(m_checkFiles)
+        {
+            std::unordered_set<std::string> fileNames;
+            for(const auto &[name, file] : record.files) {
+                fileNames.insert(name);
+            }
+            checkFiles(relativePath, fileNames, dirty, changes);
+        }
+
+        if(dirty.structureChanged == false)
+        {
+            subdirectories = record.subdirectories;
+            close(directoryDescriptor);
+            return true;
+        }
+    }
+
+    // read the entries of the directory
+    std::unordered_map<std::string, FileRecord> files;
+    bool statFailed = false;
+    auto processEntry = [&](const std::string_view &entryName,
+                            const uint8_t entryType,
+                            const uint64_t)
+    {
+        const std::string name(entryName);
+        struct stat entryStat;
+        if(fstatat(directoryDescriptor, name.c_str(), &entryStat, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            // the entry was deleted in the meantime
+            if(errno == ENOENT) {
+                return true;
+            }
+
+            errorMessage = "failed to read \"" + getEntryPath(path, name) + "\": "
+                           + strerror(errno);
+            statFailed = true;
+            return false;
+        }
+
+        if(entryType == DT_DIR
+                || S_ISDIR(entryStat.st_mode))
+        {
+            subdirectories.push_back(name);
+            return true;
+        }
+
+        FileRecord file;
+        file.inode = entryStat.st_ino;
+        file.size = static_cast<uint64_t>(entryStat.st_size);
+        file.modificationTime = getModificationTime(entryStat);
+        files.emplace(name, file);
+
+        return true;
+    };
+
+    std::string readError = "";
+    if(readDirectory(directoryDescriptor, m_entryBuffer, processEntry, readError) == false)
+    {
+        errorMessage = "failed to read directory \"" + path + "\": " + readError;
+        close(directoryDescriptor);
+        return false;
+    }
+    close(directoryDescriptor);
+
+    if(statFailed) {
+        return false;
+    }
+
+    // compare the files with the record
+    for(const auto &[name, file] : files)
+    {
+        const auto oldIt = record.files.find(name);
+        if(oldIt == record.files.end())
+        {
+            changes.push_back(FileChange{FILE_ADDED, getEntryPath(path, name)});
+        }
+        else if(oldIt->second.inode != file.inode
+                || oldIt->second.size != file.size
+                || oldIt->second.modificationTime != file.modificationTime)
+        {
+            changes.push_back(FileChange{FILE_MODIFIED, getEntryPath(path, name)});
+        }
+    }
+    for(const auto &[name, file] : record.files)
+    {
+        if(files.find(name) == files.end()) {
+            changes.push_back(FileChange{FILE_REMOVED, getEntryPath(path, name)});
+        }
+    }
+
+    // compare the subdirectories with the record
+    std::unordered_set<std::string> currentSubdirectories(subdirectories.begin(),
+                                                          subdirectories.end());
+    std::vector<std::string> removedSubdirectories;
+    for(const std::string &name : record.subdirectories)
+    {
+        if(currentSubdirectories.erase(name) == 0) {
+            removedSubdirectories.push_back(name);
+        }
+    }
+    for(const std::string &name : subdirectories)
+    {
+        if(currentSubdirectories.count(name) > 0) {
+            newSubdirectories.push_back(getEntryPath(relativePath, name));
+        }
+    }
+
+    record.inode = directoryStat.st_ino;
+    record.files = std::move(files);
+    record.subdirectories = subdirectories;
+
+    // the directory could be changed again within the same timestamp, after it was read
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const int64_t currentTime = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    if(currentTime - modificationTime < RACY_TIME_WINDOW) {
+        record.modificationTime = -1;
+    } else {
+        record.modificationTime = modificationTime;
+    }
+
+    // the record-reference stays valid, because only other elements are erased
+    for(const std::string &name : removedSubdirectories) {
+        removeDirectory(getEntryPath(relativePath, name), changes);
+    }
+
+    m_manifestChanged = true;
+
+    return true;
+}
+
+/**
+ * @brief compare specific files of a directory with the record, without reading the directory.
+ *        If a file was replaced by a directory, the directory is marked for a full check.
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ * @param fileNames names of the files to check
+ * @param dirty reference to the state of the directory
+ * @param changes reference for the resulting changes
+ */
+void
+ChangeTracker::checkFiles(const std::string &relativePath,
+                          const std::unordered_set<std::string> &fileNames,
+                          DirtyDirectory &dirty,
+                          std::vector<FileChange> &changes)
+{
+    DirectoryRecord &record = m_directories[relativePath];
+    const std::string path = getFullPath(relativePath);
+
+    for(const std::string &name : fileNames)
+    {
+        const std::string filePath = getEntryPath(path, name);
+        const auto fileIt = record.files.find(name);
+
+        struct stat fileStat;
+        if(lstat(filePath.c_str(), &fileStat) != 0
+                || S_ISDIR(fileStat.st_mode)
+                || fileIt == record.files.end())
+        {
+            // the structure of the directory differs from the record
+            dirty.structureChanged = true;
+            continue;
+        }
+
+        FileRecord &file = fileIt->second;
+        const int64_t modificationTime = getModificationTime(fileStat);
+        if(file.inode != fileStat.st_ino
+                || file.size != static_cast<uint64_t>(fileStat.st_size)
+                || file.modificationTime != modificationTime)
+        {
+            file.inode = fileStat.st_ino;
+            file.size = static_cast<uint64_t>(fileStat.st_size);
+            file.modificationTime = modificationTime;
+            changes.push_back(FileChange{FILE_MODIFIED, filePath});
+            m_manifestChanged = true;
+        }
+    }
+}
+
+/**
+ * @brief remove a directory and all of its subdirectories from the manifest and report all of
+ *        their files as removed
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ * @param changes reference for the resulting changes
+ */
+void
+ChangeTracker::removeDirectory(const std::string &relativePath,
+                               std::vector<FileChange> &changes)
+{
+    std::vector<std::string> pendingDirectories;
+    pendingDirectories.push_back(relativePath);
+
+    while(pendingDirectories.size() > 0)
+    {
+        const std::string currentPath = pendingDirectories.back();
+        pendingDirectories.pop_back();
+
+        const auto recordIt = m_directories.find(currentPath);
+        if(recordIt == m_directories.end()) {
+            continue;
+        }
+
+        DirectoryRecord &record = recordIt->second;
+        const std::string path = getFullPath(currentPath);
+        for(const auto &[name, file] : record.files) {
+            changes.push_back(FileChange{FILE_REMOVED, getEntryPath(path, name)});
+        }
+        for(const std::string &name : record.subdirectories) {
+            pendingDirectories.push_back(getEntryPath(currentPath, name));
+        }
+
+        if(record.watchDescriptor >= 0)
+        {
+            inotify_rm_watch(m_inotifyDescriptor, record.watchDescriptor);
+            m_watches.erase(record.watchDescriptor);
+        }
+
+        m_directories.erase(recordIt);
+        m_manifestChanged = true;
+    }
+}
+
+/**
+ * @brief watch a directory with inotify
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ * @param record record of the directory
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the watch could not be created, else true
+ */
+bool
+ChangeTracker::addWatch(const std::string &relativePath,
+                        DirectoryRecord &record,
+                        std::string &errorMessage)
+{
+    const std::string path = getFullPath(relativePath);
+    const int watchDescriptor = inotify_add_watch(m_inotifyDescriptor, path.c_str(), WATCH_MASK);
+    if(watchDescriptor < 0)
+    {
+        errorMessage = "failed to watch directory \"" + path + "\": " + strerror(errno);
+        return false;
+    }
+
+    // a directory, which was moved within the tree, keeps its watch
+    const auto oldIt = m_watches.find(watchDescriptor);
+    if(oldIt != m_watches.end()
+            && oldIt->second != relativePath)
+    {
+        const auto oldRecordIt = m_directories.find(oldIt->second);
+        if(oldRecordIt != m_directories.end()) {
+            oldRecordIt->second.watchDescriptor = -1;
+        }
+    }
+
+    record.watchDescriptor = watchDescriptor;
+    m_watches[watchDescriptor] = relativePath;
+
+    return true;
+}
+
+/**
+ * @brief get the full path of a directory of the tree
+ *
+ * @param relativePath path of the directory relative to the root (empty for the root)
+ *
+ * @return full path of the directory
+ */
+const std::string
+ChangeTracker::getFullPath(const std::string &relativePath) const
+{
+    if(relativePath.size() == 0) {
+        return m_rootPath;
+    }
+
+    return getEntryPath(m_rootPath, relativePath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
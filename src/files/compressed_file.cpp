@@ -0,0 +1,612 @@
+/**
+ *  @file    compressed_file.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief read and write gzip- and zstd-compressed text-files
+ *
+ *  @detail The compression of a file is detected by the magic bytes at its beginning, so
+ *          compressed and uncompressed files can be read with the same functions. The
+ *          decompression runs in a separate thread, which fills a small ring of blocks, while
+ *          the caller consumes the already decompressed data. The LineReader uses the same
+ *          mechanism to read the lines of compressed files. Zstd is only available, if the
+ *          library was build with the config-option "with_zstd".
+ */
+
+#include <libKitsunemimiPersistence/files/compressed_file.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+#include "../common/decompressor.h"
+#include "../common/temp_file.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief detect the compression of a file by the magic bytes at its beginning
+ *
+ * @param compression reference for the detected compression
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+detectCompression(CompressionType &compression,
+                  const std::string &filePath,
+                  std::string &errorMessage)
+{
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    const bool result = detectCompression(compression, fileDescriptor, filePath, errorMessage);
+    close(fileDescriptor);
+
+    return result;
+}
+
+/**
+ * @brief read the complete content of a compressed or uncompressed text-file
+ *
+ * @param content reference for the decompressed content of the file
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+readCompressedFile(std::string &content,
+                   const std::string &filePath,
+                   std::string &errorMessage)
+{
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    CompressionType compression = NO_COMPRESSION;
+    if(detectCompression(compression, fileDescriptor, filePath, errorMessage) == false)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    if(compression == NO_COMPRESSION)
+    {
+        close(fileDescriptor);
+        return readFile(content, filePath, errorMessage);
+    }
+
+    // the file is read only once from begin to end
+    posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    const uint64_t blockSize = 256 * 1024;
+    Decompressor decompressor(blockSize);
+    if(decompressor.start(fileDescriptor, compression, filePath, errorMessage) == false)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    std::string result;
+    uint64_t resultSize = 0;
+    bool success = true;
+    while(true)
+    {
+        result.resize(resultSize + blockSize);
+        uint64_t readSize = 0;
+        if(decompressor.read(reinterpret_cast<uint8_t*>(&result[resultSize]),
+                             blockSize,
+                             readSize,
+                             errorMessage) == false)
+        {
+            success = false;
+            break;
+        }
+
+        resultSize += readSize;
+        if(readSize == 0) {
+            break;
+        }
+    }
+
+    decompressor.stop();
+    close(fileDescriptor);
+
+    if(success == false) {
+        return false;
+    }
+
+    result.resize(resultSize);
+    content = std::move(result);
+
+    return true;
+}
+
+/**
+ * @brief write a text into a new compressed file. An existing file is replaced atomically.
+ *
+ * @param filePath path to the file
+ * @param content text to compress
+ * @param compression compression of the file
+ * @param errorMessage reference for error-message output
+ * @param compressionLevel compression-level of the codec or 0 for the default-level
+ *
+ * @return true, if successful, else false
+ */
+bool
+writeCompressedFile(const std::string &filePath,
+                    const std::string &content,
+                    const CompressionType compression,
+                    std::string &errorMessage,
+                    const int compressionLevel)
+{
+    CompressedWriter writer(compression, compressionLevel);
+    if(writer.openFile(filePath, errorMessage) == false) {
+        return false;
+    }
+
+    // a failed write already discarded the file
+    if(writer.writeText(content, errorMessage) == false) {
+        return false;
+    }
+
+    return writer.closeFile(errorMessage);
+}
+
+/**
+ * @brief append a text as new gzip-member or zstd-frame to a compressed file. The file is
+ *        created, if it doesn't exist.
+ *
+ * @param filePath path to the file
+ * @param newText text to compress and append
+ * @param compression compression of the file
+ * @param errorMessage reference for error-message output
+ * @param compressionLevel compression-level of the codec or 0 for the default-level
+ *
+ * @return true, if successful, else false
+ */
+bool
+appendCompressedText(const std::string &filePath,
+                     const std::string &newText,
+                     const CompressionType compression,
+                     std::string &errorMessage,
+                     const int compressionLevel)
+{
+    CompressedWriter writer(compression, compressionLevel);
+    if(writer.openFile(filePath, errorMessage, true) == false) {
+        return false;
+    }
+
+    // a failed write already discarded the file
+    if(writer.writeText(newText, errorMessage) == false) {
+        return false;
+    }
+
+    return writer.closeFile(errorMessage);
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param compression compression of the written files
+ * @param compressionLevel compression-level of the codec or 0 for the default-level
+ * @param bufferSize size of the buffer for the compressed data
+ */
+CompressedWriter::CompressedWriter(const CompressionType compression,
+                                   const int compressionLevel,
+                                   const uint64_t bufferSize)
+{
+    m_compression = compression;
+    m_compressionLevel = compressionLevel;
+    m_outputBuffer.resize(bufferSize == 0 ? 1 : bufferSize);
+}
+
+/**
+ * @brief destructor, which discards a file, which was not closed before
+ */
+CompressedWriter::~CompressedWriter()
+{
+    if(m_fileDescriptor >= 0) {
+        discardFile();
+    }
+    clearStream();
+}
+
+/**
+ * @brief open a file for writing compressed text
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ * @param append true to append a new gzip-member or zstd-frame to an existing file, false to
+ *               write a new file, which replaces an existing file atomically while closing
+ *
+ * @return true, if successful, else false
+ */
+bool
+CompressedWriter::openFile(const std::string &filePath,
+                           std::string &errorMessage,
+                           const bool append)
+{
+    if(m_fileDescriptor >= 0)
+    {
+        errorMessage = "file \"" + m_filePath + "\" is already open";
+        return false;
+    }
+
+#ifndef WITH_ZSTD
+    if(m_compression == ZSTD_COMPRESSION)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": "
+                       "library was build without zstd-support";
+        return false;
+    }
+#endif
+
+    // a new file is written as temporary file and replaces the target-file while closing
+    if(append == false)
+    {
+        TempFile* tempFile = new TempFile();
+        if(openTempFile(*tempFile, filePath, errorMessage) == false)
+        {
+            delete tempFile;
+            return false;
+        }
+
+        m_tempFile = tempFile;
+        m_fileDescriptor = tempFile->file;
+        m_filePath = filePath;
+
+        return true;
+    }
+
+    const int fileDescriptor = open(filePath.c_str(),
+                                    O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                                    0666);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    // remember the old end of the file, to remove the new member again, if writing failed
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        errorMessage = "failed to get state of file \"" + filePath + "\": " + strerror(errno);
+        close(fileDescriptor);
+        return false;
+    }
+
+    m_fileDescriptor = fileDescriptor;
+    m_filePath = filePath;
+    m_appendPosition = static_cast<uint64_t>(fileStat.st_size);
+
+    return true;
+}
+
+/**
+ * @brief finish the compressed stream and close the file. A new written file replaces the
+ *        target-file at this point. This is the only way to commit the written text.
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if no file was open or finishing the stream failed, else true
+ */
+bool
+CompressedWriter::closeFile(std::string &errorMessage)
+{
+    if(m_fileDescriptor < 0)
+    {
+        errorMessage = "no file is open";
+        return false;
+    }
+
+    if(compress(nullptr, 0, true, errorMessage) == false)
+    {
+        discardFile();
+        return false;
+    }
+
+    bool result = true;
+    if(m_tempFile != nullptr)
+    {
+        result = commitTempFile(*m_tempFile, false, errorMessage);
+        delete m_tempFile;
+        m_tempFile = nullptr;
+    }
+    else if(close(m_fileDescriptor) != 0)
+    {
+        errorMessage = "failed to close file \"" + m_filePath + "\": " + strerror(errno);
+        result = false;
+    }
+
+    m_fileDescriptor = -1;
+
+    return result;
+}
+
+/**
+ * @brief compress a text and write it into the file. If this fails, the file is discarded and
+ *        the target-file stays unchanged.
+ *
+ * @param newText text to write
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+CompressedWriter::writeText(const std::string &newText,
+                            std::string &errorMessage)
+{
+    if(m_fileDescriptor < 0)
+    {
+        errorMessage = "no file is open";
+        return false;
+    }
+
+    if(compress(reinterpret_cast<const uint8_t*>(newText.c_str()),
+                newText.size(),
+                false,
+                errorMessage) == false)
+    {
+        discardFile();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief close the file without finishing the compressed stream. A temporary file is deleted
+ *        and the partial member of an appended file is cut off again.
+ */
+void
+CompressedWriter::discardFile()
+{
+    clearStream();
+
+    if(m_tempFile != nullptr)
+    {
+        discardTempFile(*m_tempFile);
+        delete m_tempFile;
+        m_tempFile = nullptr;
+    }
+    else
+    {
+        // a failed truncate can not be handled here, because the file is discarded anyway
+        const int ret = ftruncate(m_fileDescriptor, static_cast<off_t>(m_appendPosition));
+        (void)ret;
+        close(m_fileDescriptor);
+    }
+
+    m_fileDescriptor = -1;
+}
+
+/**
+ * @brief compress data and write the compressed output into the file
+ *
+ * @param data data to compress
+ * @param dataSize number of bytes to compress
+ * @param finish true to finish the current gzip-member or zstd-frame
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+CompressedWriter::compress(const uint8_t* data,
+                           const uint64_t dataSize,
+                           const bool finish,
+                           std::string &errorMessage)
+{
+    if(m_compression == NO_COMPRESSION)
+    {
+        if(dataSize > 0
+                && writeAll(m_fileDescriptor, data, dataSize) == false)
+        {
+            errorMessage = "failed to write file \"" + m_filePath + "\": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    if(m_compression == GZIP_COMPRESSION)
+    {
+        // stream is created lazy, so finishing a file without data creates an empty member
+        if(m_stream == nullptr)
+        {
+            z_stream* stream = new z_stream;
+            memset(stream, 0, sizeof(z_stream));
+            const int level = m_compressionLevel == 0 ? Z_DEFAULT_COMPRESSION : m_compressionLevel;
+
+            // 16 to write a gzip-header instead of a zlib-header
+            if(deflateInit2(stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                delete stream;
+                errorMessage = "failed to initialize gzip-compression for file \""
+                               + m_filePath + "\"";
+                return false;
+            }
+            m_stream = stream;
+        }
+
+        z_stream* stream = static_cast<z_stream*>(m_stream);
+        uint64_t position = 0;
+
+        // zlib takes only 32-bit sizes, so big inputs are split
+        do
+        {
+            const uint64_t partSize = std::min(dataSize - position, uint64_t(1024 * 1024 * 1024));
+            const bool lastPart = position + partSize == dataSize;
+            stream->next_in = const_cast<uint8_t*>(data + position);
+            stream->avail_in = static_cast<uInt>(partSize);
+            position += partSize;
+
+            const int flush = finish && lastPart ? Z_FINISH : Z_NO_FLUSH;
+            int ret = Z_OK;
+            do
+            {
+                stream->next_out = m_outputBuffer.data();
+                stream->avail_out = static_cast<uInt>(m_outputBuffer.size());
+                ret = deflate(stream, flush);
+                if(ret == Z_STREAM_ERROR)
+                {
+                    errorMessage = "failed to compress data for file \"" + m_filePath + "\"";
+                    return false;
+                }
+
+                if(writeOutput(m_outputBuffer.size() - stream->avail_out, errorMessage) == false) {
+                    return false;
+                }
+            }
+            while(stream->avail_out == 0);
+        }
+        while(position < dataSize);
+
+        if(finish) {
+            clearStream();
+        }
+
+        return true;
+    }
+
+#ifdef WITH_ZSTD
+    if(m_compression == ZSTD_COMPRESSION)
+    {
+        if(m_stream == nullptr)
+        {
+            ZSTD_CStream* stream = ZSTD_createCStream();
+            if(stream == nullptr
+                    || ZSTD_isError(ZSTD_initCStream(stream, m_compressionLevel)))
+            {
+                ZSTD_freeCStream(stream);
+                errorMessage = "failed to initialize zstd-compression for file \""
+                               + m_filePath + "\"";
+                return false;
+            }
+            m_stream = stream;
+        }
+
+        ZSTD_CStream* stream = static_cast<ZSTD_CStream*>(m_stream);
+        ZSTD_inBuffer inBuffer = {data, dataSize, 0};
+        while(inBuffer.pos < inBuffer.size)
+        {
+            ZSTD_outBuffer outBuffer = {m_outputBuffer.data(), m_outputBuffer.size(), 0};
+            const size_t ret = ZSTD_compressStream(stream, &outBuffer, &inBuffer);
+            if(ZSTD_isError(ret))
+            {
+                errorMessage = "failed to compress data for file \"" + m_filePath + "\": "
+                               + std::string(ZSTD_getErrorName(ret));
+                return false;
+            }
+
+            if(writeOutput(outBuffer.pos, errorMessage) == false) {
+                return false;
+            }
+        }
+
+        if(finish)
+        {
+            // returns the number of bytes, which are still to flush
+            size_t remaining = 0;
+            do
+            {
+                ZSTD_outBuffer outBuffer = {m_outputBuffer.data(), m_outputBuffer.size(), 0};
+                remaining = ZSTD_endStream(stream, &outBuffer);
+                if(ZSTD_isError(remaining))
+                {
+                    errorMessage = "failed to compress data for file \"" + m_filePath + "\": "
+                                   + std::string(ZSTD_getErrorName(remaining));
+                    return false;
+                }
+
+                if(writeOutput(outBuffer.pos, errorMessage) == false) {
+                    return false;
+                }
+            }
+            while(remaining > 0);
+
+            clearStream();
+        }
+
+        return true;
+    }
+#endif
+
+    errorMessage = "unsupported compression for file \"" + m_filePath + "\"";
+    return false;
+}
+
+/**
+ * @brief write the compressed data of the output-buffer into the file
+ *
+ * @param outputSize number of bytes in the output-buffer
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+CompressedWriter::writeOutput(const uint64_t outputSize,
+                              std::string &errorMessage)
+{
+    if(outputSize > 0
+            && writeAll(m_fileDescriptor, m_outputBuffer.data(), outputSize) == false)
+    {
+        errorMessage = "failed to write file \"" + m_filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief delete the compression-stream
+ */
+void
+CompressedWriter::clearStream()
+{
+    if(m_stream == nullptr) {
+        return;
+    }
+
+    if(m_compression == GZIP_COMPRESSION)
+    {
+        z_stream* stream = static_cast<z_stream*>(m_stream);
+        deflateEnd(stream);
+        delete stream;
+    }
+#ifdef WITH_ZSTD
+    if(m_compression == ZSTD_COMPRESSION) {
+        ZSTD_freeCStream(static_cast<ZSTD_CStream*>(m_stream));
+    }
+#endif
+
+    m_stream = nullptr;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,492 @@
+/**
+ *  @file    delimited_file_reader.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief tokenizer for text-files with delimited fields, like csv- or tsv-files
+ *
+ *  @detail The file is mapped into the memory and the fields are returned as views into the
+ *          mapped file, so no field is copied. Delimiters, quotes and line-breaks are searched
+ *          with vectorized compares. Quoted fields can contain delimiters, line-breaks and
+ *          doubled quotes. The views of quoted fields are without the surrounding quotes, but
+ *          still contain the doubled quotes, which can be removed with unescapeField. For big
+ *          files all records can be parsed in parallel into column-oriented offsets.
+ */
+
+#include <libKitsunemimiPersistence/files/delimited_file_reader.h>
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+
+#include "../common/byte_search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief parse a single record
+ *
+ * @param data pointer to the content of the file
+ * @param dataSize size of the content
+ * @param position start-position of the record
+ * @param delimiter delimiter between the fields
+ * @param quote quote-character
+ * @param fields reference for the positions of the fields of the record
+ *
+ * @return position behind the line-break at the end of the record
+ */
+static uint64_t
+parseRecord(const char* data,
+            const uint64_t dataSize,
+            const uint64_t position,
+            const char delimiter,
+            const char quote,
+            std::vector<FieldPosition> &fields)
+{
+    const char* end = data + dataSize;
+    const char* pos = data + position;
+    fields.clear();
+
+    while(true)
+    {
+        FieldPosition field;
+        bool quoted = false;
+
+        if(pos < end
+                && *pos == quote)
+        {
+            // quoted field, which ends at the first quote, which is not doubled
+            const char* fieldStart = pos + 1;
+            const char* quoteEnd = findNextByte(fieldStart, end, quote);
+            while(quoteEnd + 1 < end
+                  && quoteEnd[1] == quote)
+            {
+                quoteEnd = findNextByte(quoteEnd + 2, end, quote);
+            }
+
+            field.offset = static_cast<uint64_t>(fieldStart - data);
+            field.length = static_cast<uint64_t>(quoteEnd - fieldStart);
+            quoted = true;
+
+            // characters between the closing quote and the next delimiter are ignored
+            pos = quoteEnd == end ? end : quoteEnd + 1;
+            pos = findNextOfTwoBytes(pos, end, delimiter, '\n');
+        }
+        else
+        {
+            const char* fieldEnd = findNextOfTwoBytes(pos, end, delimiter, '\n');
+            field.offset = static_cast<uint64_t>(pos - data);
+            field.length = static_cast<uint64_t>(fieldEnd - pos);
+            pos = fieldEnd;
+        }
+
+        if(pos == end
+                || *pos == '\n')
+        {
+            // remove the carriage-return of a windows line-break
+            if(quoted == false
+                    && field.length > 0
+                    && data[field.offset + field.length - 1] == '\r')
+            {
+                field.length--;
+            }
+
+            fields.push_back(field);
+            return pos == end ? dataSize : static_cast<uint64_t>(pos - data) + 1;
+        }
+
+        fields.push_back(field);
+        pos++;
+    }
+}
+
+/**
+ * @brief search the start of the first record behind a position, when it is known, if the
+ *        position is within a quoted field
+ *
+ * @param data pointer to the content of the file
+ * @param dataSize size of the content
+ * @param position position to start the search
+ * @param insideQuote true, if the position is within a quoted field
+ * @param quote quote-character
+ *
+ * @return start of the next record or the size of the data, if there is no further record
+ */
+static uint64_t
+findRecordStart(const char* data,
+                const uint64_t dataSize,
+                const uint64_t position,
+                bool insideQuote,
+                const char quote)
+{
+    const char* end = data + dataSize;
+    const char* pos = data + position;
+
+    while(pos < end)
+    {
+        pos = findNextOfTwoBytes(pos, end, quote, '\n');
+        if(pos == end) {
+            break;
+        }
+
+        if(*pos == quote) {
+            insideQuote = !insideQuote;
+        } else if(insideQuote == false) {
+            return static_cast<uint64_t>(pos - data) + 1;
+        }
+        pos++;
+    }
+
+    return dataSize;
+}
+
+/**
+ * @brief add the fields of a record to column-oriented offsets
+ *
+ * @param columns columns to extend
+ * @param fields fields of the record
+ */
+static void
+addRecord(DelimitedColumns &columns,
+          const std::vector<FieldPosition> &fields)
+{
+    // new columns get empty fields for all previous records
+    if(fields.size() > columns.columns.size()) {
+        columns.columns.resize(fields.size(),
+                               std::vector<FieldPosition>(columns.numberOfRecords));
+    }
+
+    for(uint64_t i = 0; i < columns.columns.size(); i++)
+    {
+        if(i < fields.size()) {
+            columns.columns[i].push_back(fields[i]);
+        } else {
+            columns.columns[i].push_back(FieldPosition());
+        }
+    }
+
+    columns.numberOfRecords++;
+}
+
+/**
+ * @brief append the columns of a chunk to the columns of the previous chunks
+ *
+ * @param columns columns of the previous chunks
+ * @param chunkColumns columns of the next chunk
+ */
+static void
+appendColumns(DelimitedColumns &columns,
+              const DelimitedColumns &chunkColumns)
+{
+    if(chunkColumns.columns.size() > columns.columns.size()) {
+        columns.columns.resize(chunkColumns.columns.size(),
+                               std::vector<FieldPosition>(columns.numberOfRecords));
+    }
+
+    for(uint64_t i = 0; i < columns.columns.size(); i++)
+    {
+        std::vector<FieldPosition> &column = columns.columns[i];
+        if(i < chunkColumns.columns.size())
+        {
+            column.insert(column.end(),
+                          chunkColumns.columns[i].begin(),
+                          chunkColumns.columns[i].end());
+        }
+        else
+        {
+            column.resize(column.size() + chunkColumns.numberOfRecords);
+        }
+    }
+
+    columns.numberOfRecords += chunkColumns.numberOfRecords;
+}
+
+/**
+ * @brief remove the doubled quotes of a quoted field
+ *
+ * @param field field to unescape
+ * @param quote quote-character
+ *
+ * @return field without doubled quotes
+ */
+std::string
+unescapeField(const std::string_view &field,
+              const char quote)
+{
+    std::string result;
+    result.reserve(field.size());
+
+    const char* pos = field.data();
+    const char* end = pos + field.size();
+    while(pos < end)
+    {
+        const char* quotePos = findNextByte(pos, end, quote);
+        if(quotePos == end)
+        {
+            result.append(pos, static_cast<uint64_t>(end - pos));
+            break;
+        }
+
+        // keep the first quote of the pair and skip the second one
+        result.append(pos, static_cast<uint64_t>(quotePos - pos) + 1);
+        pos = quotePos + 1;
+        if(pos < end
+                && *pos == quote)
+        {
+            pos++;
+        }
+    }
+
+    return result;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param delimiter delimiter between the fields, for example ',' for csv or '\t' for tsv
+ * @param quote quote-character of quoted fields
+ */
+DelimitedFileReader::DelimitedFileReader(const char delimiter,
+                                         const char quote)
+{
+    m_delimiter = delimiter;
+    m_quote = quote;
+    m_file = new MappedFile();
+}
+
+/**
+ * @brief destructor
+ */
+DelimitedFileReader::~DelimitedFileReader()
+{
+    closeFile();
+    delete m_file;
+}
+
+/**
+ * @brief open a file to read its records
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+DelimitedFileReader::openFile(const std::string &filePath,
+                              std::string &errorMessage)
+{
+    if(m_isOpen)
+    {
+        errorMessage = "file \"" + m_filePath + "\" is already open";
+        return false;
+    }
+
+    if(m_file->openFile(filePath, errorMessage, true) == false) {
+        return false;
+    }
+
+    m_isOpen = true;
+    m_filePath = filePath;
+    m_position = 0;
+    m_recordNumber = 0;
+
+    return true;
+}
+
+/**
+ * @brief close the file. All views of fields become invalid.
+ *
+ * @return false, if no file was open, else true
+ */
+bool
+DelimitedFileReader::closeFile()
+{
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    m_file->closeFile();
+    m_isOpen = false;
+    m_filePath = "";
+    m_position = 0;
+
+    return true;
+}
+
+/**
+ * @brief get the fields of the next record of the file
+ *
+ * @param fields reference for the fields of the record. The views stay valid, until the file
+ *               is closed.
+ *
+ * @return false, if the end of the file was reached, else true
+ */
+bool
+DelimitedFileReader::nextRecord(std::vector<std::string_view> &fields)
+{
+    fields.clear();
+
+    if(m_isOpen == false
+            || m_position >= m_file->m_size)
+    {
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(m_file->m_data);
+    m_position = parseRecord(data, m_file->m_size, m_position, m_delimiter, m_quote, m_fields);
+
+    for(const FieldPosition &field : m_fields) {
+        fields.push_back(std::string_view(data + field.offset, field.length));
+    }
+    m_recordNumber++;
+
+    return true;
+}
+
+/**
+ * @brief parse all records of the file in parallel into column-oriented offsets. The file is
+ *        split into chunks and the quotes of all chunks are counted first, to know for each
+ *        chunk, if it starts within a quoted field. So it requires, that quotes only appear
+ *        at the borders of quoted fields or doubled within them, like defined by RFC 4180.
+ *        The result is independent of the position of the sequential reader.
+ *
+ * @param columns reference for the positions of the fields of all records
+ * @param errorMessage reference for error-message output
+ * @param numberOfThreads number of worker-threads (0 to use one thread per cpu-core)
+ * @param chunkSize size of the chunks, which are parsed by the threads
+ *
+ * @return false, if no file is open, else true
+ */
+bool
+DelimitedFileReader::readColumns(DelimitedColumns &columns,
+                                 std::string &errorMessage,
+                                 const uint32_t numberOfThreads,
+                                 const uint64_t chunkSize)
+{
+    columns.columns.clear();
+    columns.numberOfRecords = 0;
+
+    if(m_isOpen == false)
+    {
+        errorMessage = "no file is open";
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(m_file->m_data);
+    const uint64_t dataSize = m_file->m_size;
+    const uint64_t usedChunkSize = std::max(chunkSize, static_cast<uint64_t>(1));
+    const uint64_t numberOfChunks = (dataSize + usedChunkSize - 1) / usedChunkSize;
+    if(numberOfChunks == 0) {
+        return true;
+    }
+
+    uint64_t threadCounter = numberOfThreads;
+    if(threadCounter == 0) {
+        threadCounter = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCounter = std::min(threadCounter, numberOfChunks);
+
+    // run a function for all chunks with multiple threads
+    auto runParallel = [&](const std::function<void(const uint64_t chunkId)> &function)
+    {
+        std::atomic<uint64_t> nextChunk(0);
+        std::vector<std::thread> threads;
+        for(uint64_t t = 0; t < threadCounter; t++)
+        {
+            threads.push_back(std::thread([&]() {
+                uint64_t chunkId = nextChunk++;
+                while(chunkId < numberOfChunks)
+                {
+                    function(chunkId);
+                    chunkId = nextChunk++;
+                }
+            }));
+        }
+
+        for(std::thread &thread : threads) {
+            thread.join();
+        }
+    };
+
+    // first pass: count the quotes of each chunk
+    std::vector<uint64_t> quoteCounts(numberOfChunks, 0);
+    runParallel([&](const uint64_t chunkId)
+    {
+        const uint64_t begin = chunkId * usedChunkSize;
+        const uint64_t end = std::min(begin + usedChunkSize, dataSize);
+        quoteCounts[chunkId] = countByte(data + begin, data + end, m_quote);
+    });
+
+    // an odd number of quotes before a chunk means, that the chunk begins in a quoted field
+    std::vector<bool> insideQuote(numberOfChunks, false);
+    uint64_t quoteSum = 0;
+    for(uint64_t i = 0; i < numberOfChunks; i++)
+    {
+        insideQuote[i] = quoteSum % 2 == 1;
+        quoteSum += quoteCounts[i];
+    }
+
+    // second pass: each chunk parses all records, which begin within the chunk
+    std::vector<DelimitedColumns> chunkColumns(numberOfChunks);
+    runParallel([&](const uint64_t chunkId)
+    {
+        const uint64_t begin = chunkId * usedChunkSize;
+        uint64_t position = 0;
+        if(chunkId > 0
+                && (data[begin - 1] != '\n' || insideQuote[chunkId]))
+        {
+            // the record, which is split by the border, belongs to the previous chunk
+            position = findRecordStart(data, dataSize, begin, insideQuote[chunkId], m_quote);
+        }
+        else
+        {
+            position = begin;
+        }
+
+        const uint64_t end = std::min(begin + usedChunkSize, dataSize);
+        std::vector<FieldPosition> fields;
+        while(position < end)
+        {
+            position = parseRecord(data, dataSize, position, m_delimiter, m_quote, fields);
+            addRecord(chunkColumns[chunkId], fields);
+        }
+    });
+
+    for(const DelimitedColumns &chunk : chunkColumns) {
+        appendColumns(columns, chunk);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the content of a field of the column-oriented offsets
+ *
+ * @param position position of the field
+ *
+ * @return view of the field, which stays valid, until the file is closed
+ */
+std::string_view
+DelimitedFileReader::getField(const FieldPosition &position) const
+{
+    if(m_isOpen == false
+            || position.offset + position.length > m_file->m_size)
+    {
+        return std::string_view();
+    }
+
+    return std::string_view(reinterpret_cast<const char*>(m_file->m_data) + position.offset,
+                            position.length);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,286 @@
+/**
+ *  @file    file_cache.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief cache for the content of text-files
+ *
+ *  @detail The content of read files is kept in memory and returned as shared immutable buffer.
+ *          Before an entry is used, it is validated with a single stat-call against device,
+ *          inode, size and modification-time of the file, so changed files are read again. When
+ *          the cache exceeds its size-limit, the least recently used files are removed.
+ *          Besides own instances, a process-wide cache can be used with the free functions.
+ */
+
+#include <libKitsunemimiPersistence/files/file_cache.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+static FileCache processFileCache;
+
+/**
+ * @brief read a text-file with the process-wide cache
+ *
+ * @param content reference for the shared content of the file
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+readCachedFile(std::shared_ptr<const std::string> &content,
+               const std::string &filePath,
+               std::string &errorMessage)
+{
+    return processFileCache.readFile(content, filePath, errorMessage);
+}
+
+/**
+ * @brief set size-limit of the process-wide cache
+ *
+ * @param maxCacheSize maximum number of bytes of all cached files
+ */
+void
+setFileCacheSize(const uint64_t maxCacheSize)
+{
+    processFileCache.setMaxCacheSize(maxCacheSize);
+}
+
+/**
+ * @brief remove all files from the process-wide cache
+ */
+void
+clearFileCache()
+{
+    processFileCache.clear();
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param maxCacheSize maximum number of bytes of all cached files
+ */
+FileCache::FileCache(const uint64_t maxCacheSize)
+{
+    m_maxCacheSize = maxCacheSize;
+}
+
+/**
+ * @brief destructor
+ */
+FileCache::~FileCache() {}
+
+/**
+ * @brief get the content of a text-file from the cache or read it, if it is not cached or was
+ *        changed since it was cached
+ *
+ * @param content reference for the shared content of the file. It stays valid, even if the
+ *                file is removed from the cache.
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+FileCache::readFile(std::shared_ptr<const std::string> &content,
+                    const std::string &filePath,
+                    std::string &errorMessage)
+{
+    FileState stateBefore;
+    const bool validState = getFileState(filePath, stateBefore);
+
+    if(validState)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        const auto it = m_entries.find(filePath);
+        if(it != m_entries.end())
+        {
+            if(it->second.state == stateBefore)
+            {
+                m_lruList.splice(m_lruList.begin(), m_lruList, it->second.lruPosition);
+                content = it->second.content;
+                return true;
+            }
+
+            removeEntry(it);
+        }
+    }
+
+    // read without lock, so other files can be served in the meantime
+    std::string* newContent = new std::string();
+    if(Kitsunemimi::Persistence::readFile(*newContent, filePath, errorMessage) == false)
+    {
+        delete newContent;
+        return false;
+    }
+    content = std::shared_ptr<const std::string>(newContent);
+
+    // only cache the content, if the file was not changed while reading
+    FileState stateAfter;
+    if(validState == false
+            || getFileState(filePath, stateAfter) == false
+            || (stateAfter == stateBefore) == false)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(content->size() > m_maxCacheSize) {
+        return true;
+    }
+
+    // another thread could have cached the file in the meantime
+    const auto it = m_entries.find(filePath);
+    if(it != m_entries.end()) {
+        removeEntry(it);
+    }
+
+    m_lruList.push_front(filePath);
+    CacheEntry entry;
+    entry.state = stateAfter;
+    entry.content = content;
+    entry.lruPosition = m_lruList.begin();
+    m_entries.emplace(filePath, entry);
+    m_cacheSize += content->size();
+
+    evict();
+
+    return true;
+}
+
+/**
+ * @brief remove a file from the cache
+ *
+ * @param filePath path to the file
+ */
+void
+FileCache::removeFile(const std::string &filePath)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const auto it = m_entries.find(filePath);
+    if(it != m_entries.end()) {
+        removeEntry(it);
+    }
+}
+
+/**
+ * @brief remove all files from the cache
+ */
+void
+FileCache::clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_entries.clear();
+    m_lruList.clear();
+    m_cacheSize = 0;
+}
+
+/**
+ * @brief set size-limit of the cache and remove files, which exceed the new limit
+ *
+ * @param maxCacheSize maximum number of bytes of all cached files
+ */
+void
+FileCache::setMaxCacheSize(const uint64_t maxCacheSize)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_maxCacheSize = maxCacheSize;
+    evict();
+}
+
+/**
+ * @brief get number of bytes of all cached files
+ *
+ * @return number of bytes
+ */
+uint64_t
+FileCache::getCacheSize()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_cacheSize;
+}
+
+/**
+ * @brief get number of cached files
+ *
+ * @return number of files
+ */
+uint64_t
+FileCache::getNumberOfFiles()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_entries.size();
+}
+
+/**
+ * @brief get the values of a file, which are used to check if it was changed
+ *
+ * @param filePath path to the file
+ * @param state reference for the result
+ *
+ * @return false, if stat failed, else true
+ */
+bool
+FileCache::getFileState(const std::string &filePath,
+                        FileState &state)
+{
+    struct stat fileStat;
+    if(stat(filePath.c_str(), &fileStat) != 0) {
+        return false;
+    }
+
+    state.device = static_cast<uint64_t>(fileStat.st_dev);
+    state.inode = static_cast<uint64_t>(fileStat.st_ino);
+    state.size = static_cast<uint64_t>(fileStat.st_size);
+    state.modifyTime = static_cast<uint64_t>(fileStat.st_mtim.tv_sec) * 1000000000ULL
+                       + static_cast<uint64_t>(fileStat.st_mtim.tv_nsec);
+    state.changeTime = static_cast<uint64_t>(fileStat.st_ctim.tv_sec) * 1000000000ULL
+                       + static_cast<uint64_t>(fileStat.st_ctim.tv_nsec);
+
+    return true;
+}
+
+/**
+ * @brief remove an entry from the cache. The lock must be hold by the caller.
+ *
+ * @param it iterator to the entry
+ */
+void
+FileCache::removeEntry(const std::unordered_map<std::string, CacheEntry>::iterator &it)
+{
+    m_cacheSize -= it->second.content->size();
+    m_lruList.erase(it->second.lruPosition);
+    m_entries.erase(it);
+}
+
+/**
+ * @brief remove least recently used files, until the cache fits into its size-limit. The lock
+ *        must be hold by the caller.
+ */
+void
+FileCache::evict()
+{
+    while(m_cacheSize > m_maxCacheSize
+          && m_lruList.size() > 0)
+    {
+        removeEntry(m_entries.find(m_lruList.back()));
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
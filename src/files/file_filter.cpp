@@ -0,0 +1,525 @@
+/**
+ *  @file    file_filter.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include <libKitsunemimiPersistence/files/file_filter.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief find the end of a bracket-expression like [a-z] or [!0-9]
+ *
+ * @param pattern glob-pattern
+ * @param position position of the opening bracket
+ *
+ * @return position of the closing bracket or std::string::npos, if there is none
+ */
+static uint64_t
+findBracketEnd(const std::string_view &pattern,
+               const uint64_t position)
+{
+    uint64_t pos = position + 1;
+    if(pos < pattern.size()
+            && (pattern[pos] == '!' || pattern[pos] == '^'))
+    {
+        pos++;
+    }
+
+    // a closing bracket directly at the start belongs to the set
+    if(pos < pattern.size()
+            && pattern[pos] == ']')
+    {
+        pos++;
+    }
+
+    while(pos < pattern.size())
+    {
+        if(pattern[pos] == ']') {
+            return pos;
+        }
+        pos++;
+    }
+
+    return std::string::npos;
+}
+
+/**
+ * @brief check if a bracket-expression matches a character
+ *
+ * @param pattern glob-pattern
+ * @param position position of the opening bracket
+ * @param end position of the closing bracket
+ * @param character character to check
+ *
+ * @return true, if the character is in the set
+ */
+static bool
+matchBracket(const std::string_view &pattern,
+             const uint64_t position,
+             const uint64_t end,
+             const char character)
+{
+    uint64_t pos = position + 1;
+    bool negate = false;
+    if(pattern[pos] == '!'
+            || pattern[pos] == '^')
+    {
+        negate = true;
+        pos++;
+    }
+
+    bool found = false;
+    bool first = true;
+    while(pos < end
+          && (pattern[pos] != ']' || first))
+    {
+        first = false;
+
+        // range like a-z
+        if(pos + 2 < end
+                && pattern[pos + 1] == '-')
+        {
+            if(character >= pattern[pos]
+                    && character <= pattern[pos + 2])
+            {
+                found = true;
+            }
+            pos += 3;
+            continue;
+        }
+
+        if(character == pattern[pos]) {
+            found = true;
+        }
+        pos++;
+    }
+
+    return found != negate;
+}
+
+/**
+ * @brief check if a glob-pattern matches a name. The pattern supports '*' for any number of
+ *        characters, '?' for a single character, bracket-expressions like [a-z] or [!0-9] and
+ *        '\' to escape the next character. The pattern must be valid.
+ *
+ * @param pattern glob-pattern
+ * @param name name to check
+ *
+ * @return true, if the pattern matches the complete name
+ */
+bool
+matchGlob(const std::string_view &pattern,
+          const std::string_view &name)
+{
+    uint64_t patternPos = 0;
+    uint64_t namePos = 0;
+
+    // position of the last star and the name-position, where it was tried, to go back there,
+    // if the rest doesn't match
+    uint64_t starPos = std::string::npos;
+    uint64_t starNamePos = 0;
+
+    while(namePos < name.size())
+    {
+        if(patternPos < pattern.size())
+        {
+            const char current = pattern[patternPos];
+            if(current == '*')
+            {
+                starPos = patternPos;
+                starNamePos = namePos;
+                patternPos++;
+                continue;
+            }
+
+            if(current == '?')
+            {
+                patternPos++;
+                namePos++;
+                continue;
+            }
+
+            if(current == '[')
+            {
+                const uint64_t end = findBracketEnd(pattern, patternPos);
+                if(matchBracket(pattern, patternPos, end, name[namePos]))
+                {
+                    patternPos = end + 1;
+                    namePos++;
+                    continue;
+                }
+            }
+            else
+            {
+                uint64_t literalPos = patternPos;
+                if(current == '\\'
+                        && literalPos + 1 < pattern.size())
+                {
+                    literalPos++;
+                }
+
+                if(pattern[literalPos] == name[namePos])
+                {
+                    patternPos = literalPos + 1;
+                    namePos++;
+                    continue;
+                }
+            }
+        }
+
+        // mismatch, so let the last star consume one more character
+        if(starPos == std::string::npos) {
+            return false;
+        }
+        patternPos = starPos + 1;
+        starNamePos++;
+        namePos = starNamePos;
+    }
+
+    while(patternPos < pattern.size()
+          && pattern[patternPos] == '*')
+    {
+        patternPos++;
+    }
+
+    return patternPos == pattern.size();
+}
+
+/**
+ * @brief check if a pattern contains any wildcards
+ *
+ * @param pattern glob-pattern
+ *
+ * @return true, if the pattern has a wildcard or an escaped character
+ */
+static bool
+hasWildcard(const std::string_view &pattern)
+{
+    return pattern.find_first_of("*?[\\") != std::string::npos;
+}
+
+//==================================================================================================
+
+/**
+ * @brief check if there are no rules
+ *
+ * @return true, if no rule was added
+ */
+bool
+FileFilter::NameRules::isEmpty() const
+{
+    return names.size() == 0
+           && suffixes.size() == 0
+           && globs.size() == 0;
+}
+
+/**
+ * @brief check if any rule matches a name
+ *
+ * @param name name of the file or directory
+ *
+ * @return true, if any rule matches
+ */
+bool
+FileFilter::NameRules::match(const std::string_view &name) const
+{
+    if(names.size() > 0
+            && names.find(name) != names.end())
+    {
+        return true;
+    }
+
+    // all suffixes start with a dot, so only the parts behind dots have to be looked up
+    if(suffixes.size() > 0)
+    {
+        uint64_t pos = name.find('.');
+        while(pos != std::string::npos)
+        {
+            if(suffixes.find(name.substr(pos)) != suffixes.end()) {
+                return true;
+            }
+            pos = name.find('.', pos + 1);
+        }
+    }
+
+    for(const std::string &glob : globs)
+    {
+        if(matchGlob(glob, name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+FileFilter::FileFilter() {}
+
+/**
+ * @brief destructor
+ */
+FileFilter::~FileFilter() {}
+
+/**
+ * @brief add a pattern for files, which should be included. If there are any include-rules,
+ *        only files, which match at least one of them, are accepted.
+ *
+ * @param pattern glob-pattern for the name of the files
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the pattern is invalid, else true
+ */
+bool
+FileFilter::addIncludePattern(const std::string &pattern,
+                              std::string &errorMessage)
+{
+    return addPattern(m_includedFiles, pattern, errorMessage);
+}
+
+/**
+ * @brief add a pattern for files, which should be excluded
+ *
+ * @param pattern glob-pattern for the name of the files
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the pattern is invalid, else true
+ */
+bool
+FileFilter::addExcludePattern(const std::string &pattern,
+                              std::string &errorMessage)
+{
+    return addPattern(m_excludedFiles, pattern, errorMessage);
+}
+
+/**
+ * @brief add a pattern for directories, which should be skipped together with their content
+ *
+ * @param pattern glob-pattern for the name of the directories
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the pattern is invalid, else true
+ */
+bool
+FileFilter::addExcludedDirectory(const std::string &pattern,
+                                 std::string &errorMessage)
+{
+    return addPattern(m_excludedDirectories, pattern, errorMessage);
+}
+
+/**
+ * @brief add an extension of files, which should be included
+ *
+ * @param extension extension with or without leading dot, for example "txt" or ".tar.gz"
+ */
+void
+FileFilter::addIncludeExtension(const std::string &extension)
+{
+    addExtension(m_includedFiles, extension);
+}
+
+/**
+ * @brief add an extension of files, which should be excluded
+ *
+ * @param extension extension with or without leading dot, for example "txt" or ".tar.gz"
+ */
+void
+FileFilter::addExcludeExtension(const std::string &extension)
+{
+    addExtension(m_excludedFiles, extension);
+}
+
+/**
+ * @brief accept only files with a size within a range
+ *
+ * @param minSize minimal size in bytes
+ * @param maxSize maximal size in bytes
+ */
+void
+FileFilter::setSizeRange(const uint64_t minSize,
+                         const uint64_t maxSize)
+{
+    m_checkSize = true;
+    m_minSize = minSize;
+    m_maxSize = maxSize;
+}
+
+/**
+ * @brief accept only files with a modification-time within a range
+ *
+ * @param minTime earliest modification-time in nanoseconds since epoch
+ * @param maxTime latest modification-time in nanoseconds since epoch
+ */
+void
+FileFilter::setModificationTimeRange(const int64_t minTime,
+                                     const int64_t maxTime)
+{
+    m_checkTime = true;
+    m_minTime = minTime;
+    m_maxTime = maxTime;
+}
+
+/**
+ * @brief check if a file is accepted by the filter. Size and modification-time are only read,
+ *        if the name was accepted and a range for them was set.
+ *
+ * @param entry entry of the file
+ *
+ * @return true, if the file is accepted
+ */
+bool
+FileFilter::matchFile(FileEntry &entry) const
+{
+    if(m_excludedFiles.match(entry.m_name)) {
+        return false;
+    }
+
+    if(m_includedFiles.isEmpty() == false
+            && m_includedFiles.match(entry.m_name) == false)
+    {
+        return false;
+    }
+
+    if(m_checkSize)
+    {
+        uint64_t size = 0;
+        if(entry.getSize(size) == false
+                || size < m_minSize
+                || size > m_maxSize)
+        {
+            return false;
+        }
+    }
+
+    if(m_checkTime)
+    {
+        int64_t modificationTime = 0;
+        if(entry.getModificationTime(modificationTime) == false
+                || modificationTime < m_minTime
+                || modificationTime > m_maxTime)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief check if a directory should be entered
+ *
+ * @param entry entry of the directory
+ *
+ * @return false, if the directory is excluded, else true
+ */
+bool
+FileFilter::matchDirectory(const FileEntry &entry) const
+{
+    return m_excludedDirectories.match(entry.m_name) == false;
+}
+
+/**
+ * @brief compile a pattern into a set of rules
+ *
+ * @param rules rules, where the pattern should be added
+ * @param pattern glob-pattern
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the pattern is invalid, else true
+ */
+bool
+FileFilter::addPattern(NameRules &rules,
+                       const std::string &pattern,
+                       std::string &errorMessage)
+{
+    if(pattern.size() == 0)
+    {
+        errorMessage = "pattern is empty";
+        return false;
+    }
+
+    if(pattern.find('/') != std::string::npos)
+    {
+        errorMessage = "pattern \"" + pattern + "\" contains a slash, but only names are matched";
+        return false;
+    }
+
+    // check brackets, so the matching doesn't have to validate the pattern again
+    for(uint64_t i = 0; i < pattern.size(); i++)
+    {
+        if(pattern[i] == '\\')
+        {
+            i++;
+            continue;
+        }
+
+        if(pattern[i] == '[')
+        {
+            const uint64_t end = findBracketEnd(pattern, i);
+            if(end == std::string::npos)
+            {
+                errorMessage = "pattern \"" + pattern + "\" has an unclosed bracket";
+                return false;
+            }
+            i = end;
+        }
+    }
+
+    const std::string_view suffix = std::string_view(pattern).substr(1);
+    if(hasWildcard(pattern) == false)
+    {
+        m_literals.push_back(pattern);
+        rules.names.insert(m_literals.back());
+    }
+    else if(pattern[0] == '*'
+            && suffix.size() > 1
+            && suffix[0] == '.'
+            && hasWildcard(suffix) == false)
+    {
+        m_literals.push_back(std::string(suffix));
+        rules.suffixes.insert(m_literals.back());
+    }
+    else
+    {
+        rules.globs.push_back(pattern);
+    }
+
+    return true;
+}
+
+/**
+ * @brief add an extension to a set of rules
+ *
+ * @param rules rules, where the extension should be added
+ * @param extension extension with or without leading dot
+ */
+void
+FileFilter::addExtension(NameRules &rules,
+                         const std::string &extension)
+{
+    if(extension.size() == 0
+            || extension == ".")
+    {
+        return;
+    }
+
+    if(extension[0] == '.') {
+        m_literals.push_back(extension);
+    } else {
+        m_literals.push_back("." + extension);
+    }
+    rules.suffixes.insert(m_literals.back());
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
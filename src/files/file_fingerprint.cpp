@@ -0,0 +1,809 @@
+/**
+ *  @file    file_fingerprint.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include <libKitsunemimiPersistence/files/file_fingerprint.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+#include "../common/directory_walker.h"
+#include "../common/checksum.h"
+#include "../common/hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+// number of bytes at the beginning of a file, which are hashed to filter the candidates
+static const uint64_t FIRST_BLOCK_SIZE = 64 * 1024;
+// size of the blocks, in which complete files are read and hashed
+static const uint64_t READ_BLOCK_SIZE = 1024 * 1024;
+// files, which were modified shortly before they were read, can be modified again within the
+// same timestamp, so their fingerprints are not cached
+static const int64_t RACY_TIME_WINDOW = 2000000000LL;
+
+static const uint64_t FINGERPRINT_CACHE_MAGIC = 0x4B465052494E54ULL;
+
+struct FingerprintCacheHeader
+{
+    uint64_t magic = FINGERPRINT_CACHE_MAGIC;
+    uint64_t numberOfEntries = 0;
+    uint32_t checksum = 0;
+    uint8_t padding[4] = {0, 0, 0, 0};
+} __attribute__((packed));
+
+struct FingerprintCacheEntry
+{
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    uint64_t firstBlockLow = 0;
+    uint64_t firstBlockHigh = 0;
+    uint64_t contentLow = 0;
+    uint64_t contentHigh = 0;
+    uint8_t hasContent = 0;
+    uint8_t padding[7] = {0, 0, 0, 0, 0, 0, 0};
+} __attribute__((packed));
+
+/**
+ * @brief remember the first error of the parallel processing
+ *
+ * @param errorLock lock for the error-message
+ * @param errorMessage reference for the first error-message
+ * @param newError new error-message
+ */
+static void
+addError(std::mutex &errorLock,
+         std::string &errorMessage,
+         const std::string &newError)
+{
+    std::unique_lock<std::mutex> lock(errorLock);
+    if(errorMessage.size() == 0) {
+        errorMessage = newError;
+    }
+}
+
+/**
+ * @brief get the modification-time of a stat-result in nanoseconds
+ */
+static int64_t
+getModificationTime(const struct stat &fileStat)
+{
+    return static_cast<int64_t>(fileStat.st_mtim.tv_sec) * 1000000000LL
+           + static_cast<int64_t>(fileStat.st_mtim.tv_nsec);
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param numberOfThreads number of threads to read and hash files (0 to use one thread per
+ *                        cpu-core)
+ */
+FingerprintEngine::FingerprintEngine(const uint32_t numberOfThreads)
+{
+    m_numberOfThreads = numberOfThreads;
+    if(m_numberOfThreads == 0) {
+        m_numberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+}
+
+/**
+ * @brief destructor
+ */
+FingerprintEngine::~FingerprintEngine() {}
+
+/**
+ * @brief get the fingerprint of the complete content of a single file
+ *
+ * @param fingerprint reference for the resulting fingerprint
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the path is not a regular file, the file could not be read or was changed
+ *         while it was read, else true
+ */
+bool
+FingerprintEngine::getFingerprint(FileFingerprint &fingerprint,
+                                  const std::string &filePath,
+                                  std::string &errorMessage)
+{
+    m_readBytes = 0;
+
+    std::vector<FileInfo> files;
+    if(readFileInfos(files, std::vector<std::string>{filePath}, errorMessage) == false) {
+        return false;
+    }
+
+    FileInfo &file = files[0];
+    if(file.isValid == false)
+    {
+        errorMessage = "path \"" + filePath + "\" is not a regular file";
+        return false;
+    }
+
+    readCache(file);
+    if(file.hasContent == false
+            && hashFiles(files, std::vector<uint64_t>{0}, true, errorMessage) == false)
+    {
+        return false;
+    }
+
+    if(file.isValid == false)
+    {
+        errorMessage = "file \"" + filePath + "\" was changed while it was read";
+        return false;
+    }
+
+    updateCache(files);
+    fingerprint = file.content;
+
+    return true;
+}
+
+/**
+ * @brief find files with identical content. Only files with equal size are compared and only
+ *        files with equal size and equal first block are read completely. Files, which don't
+ *        exist or are not regular files, are ignored.
+ *
+ * @param groups reference for the resulting groups of identical files, sorted by file-size from
+ *               the biggest to the smallest one
+ * @param filePaths list with the paths of all files to compare, for example from listFiles
+ * @param errorMessage reference for error-message output
+ * @param minimalSize files smaller than this size are ignored (Default: 1 to ignore empty files)
+ *
+ * @return false, if a file could not be read, else true
+ */
+bool
+FingerprintEngine::findDuplicates(std::vector<DuplicateGroup> &groups,
+                                  const std::vector<std::string> &filePaths,
+                                  std::string &errorMessage,
+                                  const uint64_t minimalSize)
+{
+    groups.clear();
+    m_readBytes = 0;
+
+    std::vector<FileInfo> files;
+    if(readFileInfos(files, filePaths, errorMessage) == false) {
+        return false;
+    }
+
+    // files with a unique size can not have a duplicate
+    std::vector<uint64_t> candidates;
+    {
+        std::unordered_map<uint64_t, uint64_t> sizeCounter;
+        for(const FileInfo &file : files)
+        {
+            if(file.isValid
+                    && file.size >= minimalSize)
+            {
+                sizeCounter[file.size]++;
+            }
+        }
+
+        for(uint64_t i = 0; i < files.size(); i++)
+        {
+            if(files[i].isValid
+                    && files[i].size >= minimalSize
+                    && sizeCounter[files[i].size] > 1)
+            {
+                readCache(files[i]);
+                candidates.push_back(i);
+            }
+        }
+    }
+
+    // hash the first block of the candidates, which are not in the cache. Small files are hashed
+    // completely with this step.
+    std::vector<uint64_t> hashIndexes;
+    for(const uint64_t index : candidates)
+    {
+        if(files[index].hasFirstBlock == false) {
+            hashIndexes.push_back(index);
+        }
+    }
+    if(hashFiles(files, hashIndexes, false, errorMessage) == false) {
+        return false;
+    }
+
+    // hash the complete content of all files with equal size and equal first block
+    hashIndexes.clear();
+    std::vector<uint64_t> contentCandidates;
+    for(const uint64_t index : candidates)
+    {
+        if(files[index].isValid) {
+            contentCandidates.push_back(index);
+        }
+    }
+    for(const std::vector<uint64_t> &group : groupFiles(files, contentCandidates, false))
+    {
+        for(const uint64_t index : group)
+        {
+            if(files[index].hasContent == false) {
+                hashIndexes.push_back(index);
+            }
+        }
+    }
+    if(hashFiles(files, hashIndexes, true, errorMessage) == false) {
+        return false;
+    }
+
+    // group the files with identical content
+    contentCandidates.clear();
+    for(const uint64_t index : candidates)
+    {
+        if(files[index].isValid
+                && files[index].hasContent)
+        {
+            contentCandidates.push_back(index);
+        }
+    }
+    for(const std::vector<uint64_t> &group : groupFiles(files, contentCandidates, true))
+    {
+        DuplicateGroup duplicates;
+        duplicates.fileSize = files[group[0]].size;
+        duplicates.fingerprint = files[group[0]].content;
+        for(const uint64_t index : group) {
+            duplicates.paths.push_back(files[index].path);
+        }
+        groups.push_back(duplicates);
+    }
+
+    updateCache(files);
+
+    return true;
+}
+
+/**
+ * @brief find files with identical content within a directory-tree. The tree is walked in
+ *        parallel and symbolic links are not followed.
+ *
+ * @param groups reference for the resulting groups of identical files, sorted by file-size from
+ *               the biggest to the smallest one
+ * @param rootPath path to the root-directory of the tree
+ * @param errorMessage reference for error-message output
+ * @param minimalSize files smaller than this size are ignored (Default: 1 to ignore empty files)
+ *
+ * @return false, if the tree or a file could not be read, else true
+ */
+bool
+FingerprintEngine::findDuplicates(std::vector<DuplicateGroup> &groups,
+                                  const std::string &rootPath,
+                                  std::string &errorMessage,
+                                  const uint64_t minimalSize)
+{
+    groups.clear();
+
+    // the walker knows the types of the entries from the directory, so only files are collected
+    // and their metadata are read later by the fingerprint-threads
+    DirectoryWalker walker(m_numberOfThreads);
+    std::vector<std::vector<std::string>> threadPaths(walker.getNumberOfThreads());
+    auto collectFile = [&](FileEntry &entry)
+    {
+        if(entry.m_type == FILE_ENTRY) {
+            threadPaths[entry.m_threadId].push_back(entry.getPath());
+        }
+        return CONTINUE_WALK;
+    };
+
+    if(walker.walk(rootPath, collectFile, errorMessage) == false) {
+        return false;
+    }
+
+    std::vector<std::string> filePaths;
+    for(std::vector<std::string> &paths : threadPaths)
+    {
+        filePaths.insert(filePaths.end(),
+                         std::make_move_iterator(paths.begin()),
+                         std::make_move_iterator(paths.end()));
+    }
+
+    return findDuplicates(groups, filePaths, errorMessage, minimalSize);
+}
+
+/**
+ * @brief load fingerprints from a cache-file into the cache
+ *
+ * @param cachePath path to the cache-file
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the cache-file is broken, else true. Also return true, if the cache-file
+ *         doesn't exist.
+ */
+bool
+FingerprintEngine::loadCache(const std::string &cachePath,
+                             std::string &errorMessage)
+{
+    struct stat cacheStat;
+    if(stat(cachePath.c_str(), &cacheStat) != 0
+            && errno == ENOENT)
+    {
+        return true;
+    }
+
+    std::string content = "";
+    if(readFile(content, cachePath, errorMessage) == false) {
+        return false;
+    }
+
+    FingerprintCacheHeader header;
+    if(content.size() < sizeof(FingerprintCacheHeader))
+    {
+        errorMessage = "fingerprint-cache \"" + cachePath + "\" is broken";
+        return false;
+    }
+    memcpy(&header, content.c_str(), sizeof(FingerprintCacheHeader));
+
+    const uint64_t bodySize = content.size() - sizeof(FingerprintCacheHeader);
+    const char* body = &content[sizeof(FingerprintCacheHeader)];
+    if(header.magic != FINGERPRINT_CACHE_MAGIC
+            || bodySize != header.numberOfEntries * sizeof(FingerprintCacheEntry)
+            || calcCrc32c(body, bodySize) != header.checksum)
+    {
+        errorMessage = "fingerprint-cache \"" + cachePath + "\" is broken";
+        return false;
+    }
+
+    for(uint64_t i = 0; i < header.numberOfEntries; i++)
+    {
+        FingerprintCacheEntry entry;
+        memcpy(&entry, &body[i * sizeof(FingerprintCacheEntry)], sizeof(FingerprintCacheEntry));
+
+        CacheKey key;
+        key.device = entry.device;
+        key.inode = entry.inode;
+
+        CacheEntry &cacheEntry = m_cache[key];
+        cacheEntry.size = entry.size;
+        cacheEntry.modificationTime = entry.modificationTime;
+        cacheEntry.firstBlock.low = entry.firstBlockLow;
+        cacheEntry.firstBlock.high = entry.firstBlockHigh;
+        cacheEntry.content.low = entry.contentLow;
+        cacheEntry.content.high = entry.contentHigh;
+        cacheEntry.hasContent = entry.hasContent != 0;
+    }
+
+    return true;
+}
+
+/**
+ * @brief write all cached fingerprints atomically into a cache-file
+ *
+ * @param cachePath path to the cache-file
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if writing failed, else true
+ */
+bool
+FingerprintEngine::saveCache(const std::string &cachePath,
+                             std::string &errorMessage)
+{
+    std::string content(sizeof(FingerprintCacheHeader)
+                        + m_cache.size() * sizeof(FingerprintCacheEntry), '\0');
+
+    uint64_t position = sizeof(FingerprintCacheHeader);
+    for(const auto &[key, cacheEntry] : m_cache)
+    {
+        FingerprintCacheEntry entry;
+        entry.device = key.device;
+        entry.inode = key.inode;
+        entry.size = cacheEntry.size;
+        entry.modificationTime = cacheEntry.modificationTime;
+        entry.firstBlockLow = cacheEntry.firstBlock.low;
+        entry.firstBlockHigh = cacheEntry.firstBlock.high;
+        entry.contentLow = cacheEntry.content.low;
+        entry.contentHigh = cacheEntry.content.high;
+        entry.hasContent = cacheEntry.hasContent;
+
+        memcpy(&content[position], &entry, sizeof(FingerprintCacheEntry));
+        position += sizeof(FingerprintCacheEntry);
+    }
+
+    FingerprintCacheHeader header;
+    header.numberOfEntries = m_cache.size();
+    header.checksum = calcCrc32c(&content[sizeof(FingerprintCacheHeader)],
+                                 content.size() - sizeof(FingerprintCacheHeader));
+    memcpy(&content[0], &header, sizeof(FingerprintCacheHeader));
+
+    return writeFileAtomic(cachePath, content, errorMessage);
+}
+
+/**
+ * @brief get the number of files within the cache
+ *
+ * @return number of cached files
+ */
+uint64_t
+FingerprintEngine::getNumberOfCachedFiles() const
+{
+    return m_cache.size();
+}
+
+/**
+ * @brief read the metadata of files in parallel
+ *
+ * @param files reference for the resulting file-infos
+ * @param filePaths paths of the files
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the metadata of a file could not be read, else true
+ */
+bool
+FingerprintEngine::readFileInfos(std::vector<FileInfo> &files,
+                                 const std::vector<std::string> &filePaths,
+                                 std::string &errorMessage)
+{
+    files.clear();
+    files.resize(filePaths.size());
+
+    std::mutex errorLock;
+    std::string statError = "";
+
+    runParallel(filePaths.size(), [&](const uint64_t index, std::vector<uint8_t> &)
+    {
+        FileInfo &file = files[index];
+        file.path = filePaths[index];
+
+        struct stat fileStat;
+        if(stat(file.path.c_str(), &fileStat) != 0)
+        {
+            if(errno != ENOENT)
+            {
+                addError(errorLock,
+                         statError,
+                         "failed to read \"" + file.path + "\": " + strerror(errno));
+            }
+            return;
+        }
+
+        if(S_ISREG(fileStat.st_mode) == false) {
+            return;
+        }
+
+        file.key.device = fileStat.st_dev;
+        file.key.inode = fileStat.st_ino;
+        file.size = static_cast<uint64_t>(fileStat.st_size);
+        file.modificationTime = getModificationTime(fileStat);
+        file.isValid = true;
+    });
+
+    if(statError.size() > 0)
+    {
+        errorMessage = statError;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief hash the first block or the complete content of files in parallel, beginning with the
+ *        biggest files. Files, which are not bigger than the first block, get both fingerprints
+ *        with a single read. Files, which were changed while they were read, are marked as
+ *        invalid.
+ *
+ * @param files list with all files
+ * @param indexes indexes of the files, which should be hashed
+ * @param completeFile true to hash the complete content, false to hash only the first block
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if a file could not be read, else true
+ */
+bool
+FingerprintEngine::hashFiles(std::vector<FileInfo> &files,
+                             const std::vector<uint64_t> &indexes,
+                             const bool completeFile,
+                             std::string &errorMessage)
+{
+    std::vector<uint64_t> sortedIndexes = indexes;
+    std::sort(sortedIndexes.begin(),
+              sortedIndexes.end(),
+              [&](const uint64_t a, const uint64_t b) { return files[a].size > files[b].size; });
+
+    std::mutex errorLock;
+    std::string hashError = "";
+    std::atomic<uint64_t> readBytes(0);
+
+    runParallel(sortedIndexes.size(), [&](const uint64_t task, std::vector<uint8_t> &buffer)
+    {
+        FileInfo &file = files[sortedIndexes[task]];
+
+        const int fileDescriptor = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fileDescriptor < 0)
+        {
+            if(errno == ENOENT) {
+                file.isValid = false;
+            } else {
+                addError(errorLock,
+                         hashError,
+                         "failed to open file \"" + file.path + "\": " + strerror(errno));
+            }
+            return;
+        }
+
+        // the file must still be the same, which was found before
+        struct stat fileStat;
+        if(fstat(fileDescriptor, &fileStat) != 0
+                || fileStat.st_ino != file.key.inode
+                || static_cast<uint64_t>(fileStat.st_size) != file.size
+                || getModificationTime(fileStat) != file.modificationTime)
+        {
+            file.isValid = false;
+            close(fileDescriptor);
+            return;
+        }
+
+        uint64_t length = file.size;
+        if(completeFile == false) {
+            length = std::min(length, FIRST_BLOCK_SIZE);
+        }
+        if(length > READ_BLOCK_SIZE) {
+            posix_fadvise(fileDescriptor, 0, static_cast<off_t>(length), POSIX_FADV_SEQUENTIAL);
+        }
+
+        // the blocks are chained over the seed, which starts with the size of the file
+        FileFingerprint fingerprint;
+        uint64_t seed = file.size;
+        uint64_t position = 0;
+        while(position < length)
+        {
+            const uint64_t blockSize = std::min(length - position, READ_BLOCK_SIZE);
+            uint64_t blockPosition = 0;
+            while(blockPosition < blockSize)
+            {
+                const ssize_t ret = pread(fileDescriptor,
+                                          &buffer[blockPosition],
+                                          blockSize - blockPosition,
+                                          static_cast<off_t>(position + blockPosition));
+                if(ret < 0 && errno == EINTR) {
+                    continue;
+                }
+                if(ret < 0)
+                {
+                    addError(errorLock,
+                             hashError,
+                             "failed to read file \"" + file.path + "\": " + strerror(errno));
+                    close(fileDescriptor);
+                    return;
+                }
+
+                // the file was truncated in the meantime
+                if(ret == 0)
+                {
+                    file.isValid = false;
+                    close(fileDescriptor);
+                    return;
+                }
+
+                blockPosition += static_cast<uint64_t>(ret);
+            }
+
+            // the first block is taken from the buffer, if the complete file is hashed
+            if(position == 0
+                    && file.hasFirstBlock == false
+                    && file.size > FIRST_BLOCK_SIZE
+                    && blockSize >= FIRST_BLOCK_SIZE)
+            {
+                calcHash128(buffer.data(),
+                            FIRST_BLOCK_SIZE,
+                            file.firstBlock.low,
+                            file.firstBlock.high,
+                            file.size);
+                file.hasFirstBlock = true;
+            }
+
+            calcHash128(buffer.data(), blockSize, fingerprint.low, fingerprint.high, seed);
+            seed = fingerprint.low ^ fingerprint.high;
+            position += blockSize;
+        }
+
+        // the file could have been written, while it was read
+        if(fstat(fileDescriptor, &fileStat) != 0
+                || getModificationTime(fileStat) != file.modificationTime)
+        {
+            file.isValid = false;
+        }
+        close(fileDescriptor);
+        readBytes += length;
+
+        if(length == file.size)
+        {
+            file.content = fingerprint;
+            file.hasContent = true;
+            if(file.size > FIRST_BLOCK_SIZE) {
+                return;
+            }
+        }
+
+        file.firstBlock = fingerprint;
+        file.hasFirstBlock = true;
+    });
+
+    m_readBytes += readBytes;
+
+    if(hashError.size() > 0)
+    {
+        errorMessage = hashError;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief split files into groups of equal size and equal fingerprint. Groups with only a single
+ *        file are dropped.
+ *
+ * @param files list with all files
+ * @param indexes indexes of the files, which should be grouped
+ * @param byContent true to group by the fingerprint of the complete content, false to group by
+ *                  the fingerprint of the first block
+ *
+ * @return list of groups with the indexes of their files
+ */
+std::vector<std::vector<uint64_t>>
+FingerprintEngine::groupFiles(const std::vector<FileInfo> &files,
+                              std::vector<uint64_t> indexes,
+                              const bool byContent) const
+{
+    auto getFingerprint = [&](const uint64_t index) -> const FileFingerprint&
+    {
+        if(byContent) {
+            return files[index].content;
+        }
+        return files[index].firstBlock;
+    };
+
+    std::sort(indexes.begin(),
+              indexes.end(),
+              [&](const uint64_t a, const uint64_t b)
+    {
+        if(files[a].size != files[b].size) {
+            return files[a].size > files[b].size;
+        }
+        if(getFingerprint(a).low != getFingerprint(b).low) {
+            return getFingerprint(a).low < getFingerprint(b).low;
+        }
+        if(getFingerprint(a).high != getFingerprint(b).high) {
+            return getFingerprint(a).high < getFingerprint(b).high;
+        }
+        return files[a].path < files[b].path;
+    });
+
+    std::vector<std::vector<uint64_t>> groups;
+    uint64_t start = 0;
+    while(start < indexes.size())
+    {
+        uint64_t end = start + 1;
+        while(end < indexes.size()
+              && files[indexes[end]].size == files[indexes[start]].size
+              && getFingerprint(indexes[end]) == getFingerprint(indexes[start]))
+        {
+            end++;
+        }
+
+        if(end - start > 1) {
+            groups.push_back(std::vector<uint64_t>(indexes.begin() + start, indexes.begin() + end));
+        }
+        start = end;
+    }
+
+    return groups;
+}
+
+/**
+ * @brief process tasks with multiple threads. Each thread has its own read-buffer.
+ *
+ * @param numberOfTasks number of tasks
+ * @param processTask function to process a single task
+ */
+void
+FingerprintEngine::runParallel(const uint64_t numberOfTasks,
+                               const std::function<void(const uint64_t task,
+                                                        std::vector<uint8_t> &buffer)> &processTask)
+{
+    std::atomic<uint64_t> nextTask(0);
+
+    auto processTasks = [&]()
+    {
+        std::vector<uint8_t> buffer;
+        while(true)
+        {
+            const uint64_t task = nextTask++;
+            if(task >= numberOfTasks) {
+                return;
+            }
+
+            if(buffer.size() == 0) {
+                buffer.resize(READ_BLOCK_SIZE);
+            }
+            processTask(task, buffer);
+        }
+    };
+
+    const uint64_t threadCount = std::min(static_cast<uint64_t>(m_numberOfThreads),
+                                          numberOfTasks);
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < threadCount; i++) {
+        threads.push_back(std::thread(processTasks));
+    }
+
+    processTasks();
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief take the fingerprints of a file from the cache, if the file is unchanged
+ *
+ * @param file file to check
+ */
+void
+FingerprintEngine::readCache(FileInfo &file) const
+{
+    const auto it = m_cache.find(file.key);
+    if(it == m_cache.end()
+            || it->second.size != file.size
+            || it->second.modificationTime != file.modificationTime)
+    {
+        return;
+    }
+
+    file.firstBlock = it->second.firstBlock;
+    file.hasFirstBlock = true;
+    file.content = it->second.content;
+    file.hasContent = it->second.hasContent;
+}
+
+/**
+ * @brief store the fingerprints of hashed files in the cache
+ *
+ * @param files list with all files
+ */
+void
+FingerprintEngine::updateCache(const std::vector<FileInfo> &files)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const int64_t currentTime = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+    for(const FileInfo &file : files)
+    {
+        if(file.isValid == false
+                || file.hasFirstBlock == false
+                || currentTime - file.modificationTime < RACY_TIME_WINDOW)
+        {
+            continue;
+        }
+
+        CacheEntry &entry = m_cache[file.key];
+        entry.size = file.size;
+        entry.modificationTime = file.modificationTime;
+        entry.firstBlock = file.firstBlock;
+        entry.content = file.content;
+        entry.hasContent = file.hasContent;
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
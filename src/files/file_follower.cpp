@@ -0,0 +1,408 @@
+/**
+ *  @file    file_follower.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief follow a growing text-file, which is written by another process
+ *
+ *  @detail The follower remembers its read-position and only reads the new data of the file.
+ *          Incomplete lines at the end of the file are held back, until they are completed.
+ *          A truncated file is read again from the start and if the file was
+ *          replaced by a new file (for example by a log-rotation), the rest of the old file is
+ *          read, before the new file is followed. With inotify the caller can wait for changes
+ *          of the file instead of polling. Without inotify the state of the file is polled.
+ */
+
+#include <libKitsunemimiPersistence/files/file_follower.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/byte_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <thread>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// interval in milliseconds to check the state of the file, if inotify is not available
+#define POLL_INTERVAL 50
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief constructor
+ *
+ * @param readBufferSize number of bytes, which are read from the file at once
+ */
+FileFollower::FileFollower(const uint64_t readBufferSize)
+{
+    m_readBufferSize = readBufferSize == 0 ? 1 : readBufferSize;
+}
+
+/**
+ * @brief destructor
+ */
+FileFollower::~FileFollower()
+{
+    closeFile();
+}
+
+/**
+ * @brief open a file to follow
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ * @param fromStart true to also read the already existing lines of the file, false to begin at
+ *                  the current end of the file
+ *
+ * @return true, if successful, else false
+ */
+bool
+FileFollower::openFile(const std::string &filePath,
+                       std::string &errorMessage,
+                       const bool fromStart)
+{
+    if(m_fileDescriptor >= 0)
+    {
+        errorMessage = "file \"" + m_filePath + "\" is already open";
+        return false;
+    }
+
+    m_filePath = filePath;
+    m_fileName = bfs::path(filePath).filename().string();
+    if(switchToNewFile(errorMessage) == false) {
+        return false;
+    }
+
+    if(fromStart == false)
+    {
+        struct stat fileStat;
+        if(fstat(m_fileDescriptor, &fileStat) == 0) {
+            m_position = static_cast<uint64_t>(fileStat.st_size);
+        }
+    }
+
+    // watch the directory instead of the file, to also get informed about a new file
+    // with the same name. Without inotify the follower still works, but can not wait.
+    m_inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_inotifyDescriptor >= 0)
+    {
+        std::string directoryPath = bfs::path(filePath).parent_path().string();
+        if(directoryPath.size() == 0) {
+            directoryPath = ".";
+        }
+
+        m_watchDescriptor = inotify_add_watch(m_inotifyDescriptor,
+                                              directoryPath.c_str(),
+                                              IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_MOVED_TO);
+    }
+
+    return true;
+}
+
+/**
+ * @brief close the file and stop watching it
+ *
+ * @return false, if no file was open, else true
+ */
+bool
+FileFollower::closeFile()
+{
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    close(m_fileDescriptor);
+    m_fileDescriptor = -1;
+
+    if(m_inotifyDescriptor >= 0)
+    {
+        close(m_inotifyDescriptor);
+        m_inotifyDescriptor = -1;
+        m_watchDescriptor = -1;
+    }
+
+    m_position = 0;
+    m_incompleteLine.clear();
+
+    return true;
+}
+
+/**
+ * @brief read all complete lines, which were added to the file since the last call
+ *
+ * @param lines reference for the new lines without line-break
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+FileFollower::readNewLines(std::vector<std::string> &lines,
+                           std::string &errorMessage)
+{
+    lines.clear();
+
+    if(m_fileDescriptor < 0)
+    {
+        errorMessage = "no file is open";
+        return false;
+    }
+
+    // file was truncated, so it is read again from the start
+    struct stat fileStat;
+    if(fstat(m_fileDescriptor, &fileStat) == 0
+            && static_cast<uint64_t>(fileStat.st_size) < m_position)
+    {
+        m_position = 0;
+        m_incompleteLine.clear();
+    }
+
+    if(readUntilEnd(lines, errorMessage) == false) {
+        return false;
+    }
+
+    // file was replaced by a new file with the same name. If it doesn't exist at the moment,
+    // the old file is still followed.
+    if(stat(m_filePath.c_str(), &fileStat) == 0
+            && (static_cast<uint64_t>(fileStat.st_dev) != m_device
+                || static_cast<uint64_t>(fileStat.st_ino) != m_inode))
+    {
+        // the old file will not be continued anymore
+        if(m_incompleteLine.size() > 0)
+        {
+            lines.push_back(m_incompleteLine);
+            m_incompleteLine.clear();
+        }
+
+        if(switchToNewFile(errorMessage) == false
+                || readUntilEnd(lines, errorMessage) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief wait until the file was changed. Events of other files within the same directory are
+ *        skipped and the wait is continued with the remaining time.
+ *
+ * @param timeout maximum time to wait in milliseconds
+ *
+ * @return true, if the file was changed, false if the timeout was reached or waiting failed
+ */
+bool
+FileFollower::waitForChange(const uint32_t timeout)
+{
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+                                                           + std::chrono::milliseconds(timeout);
+
+    // without inotify the state of the file is checked regularly until the deadline
+    if(m_watchDescriptor < 0)
+    {
+        while(true)
+        {
+            if(hasUnreadChanges()) {
+                return true;
+            }
+
+            const int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          deadline - std::chrono::steady_clock::now()).count();
+            if(remaining <= 0) {
+                return false;
+            }
+
+            const int64_t interval = std::min(remaining, static_cast<int64_t>(POLL_INTERVAL));
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        }
+    }
+
+    while(true)
+    {
+        const int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      deadline - std::chrono::steady_clock::now()).count();
+
+        struct pollfd pollDescriptor;
+        pollDescriptor.fd = m_inotifyDescriptor;
+        pollDescriptor.events = POLLIN;
+        pollDescriptor.revents = 0;
+        const int ret = poll(&pollDescriptor, 1, static_cast<int>(std::max(remaining, static_cast<int64_t>(0))));
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if(ret == 0) {
+            return false;
+        }
+
+        if(readEvents()) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief check without inotify, if the file has content, which was not read until now, or if
+ *        it was replaced by a new file with the same name
+ *
+ * @return true, if the file was changed since the last read, else false
+ */
+bool
+FileFollower::hasUnreadChanges() const
+{
+    struct stat fileStat;
+    if(m_fileDescriptor < 0
+            || stat(m_filePath.c_str(), &fileStat) != 0)
+    {
+        return false;
+    }
+
+    return static_cast<uint64_t>(fileStat.st_dev) != m_device
+           || static_cast<uint64_t>(fileStat.st_ino) != m_inode
+           || static_cast<uint64_t>(fileStat.st_size) != m_position;
+}
+
+/**
+ * @brief read all available inotify-events
+ *
+ * @return true, if one of the events belongs to the followed file, else false
+ */
+bool
+FileFollower::readEvents()
+{
+    bool changed = false;
+    alignas(struct inotify_event) char buffer[4096];
+    while(true)
+    {
+        const ssize_t ret = read(m_inotifyDescriptor, buffer, sizeof(buffer));
+        if(ret < 0
+                && errno == EINTR)
+        {
+            continue;
+        }
+        if(ret <= 0) {
+            break;
+        }
+
+        ssize_t position = 0;
+        while(position < ret)
+        {
+            const struct inotify_event* event =
+                    reinterpret_cast<const struct inotify_event*>(&buffer[position]);
+            if(event->len > 0
+                    && m_fileName == event->name)
+            {
+                changed = true;
+            }
+            position += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * @brief read all new data of the current file and split them into lines
+ *
+ * @param lines reference for the complete lines
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+FileFollower::readUntilEnd(std::vector<std::string> &lines,
+                           std::string &errorMessage)
+{
+    m_readBuffer.resize(m_readBufferSize);
+
+    while(true)
+    {
+        const ssize_t ret = pread(m_fileDescriptor,
+                                  &m_readBuffer[0],
+                                  m_readBuffer.size(),
+                                  static_cast<off_t>(m_position));
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            errorMessage = "failed to read file \"" + m_filePath + "\": " + strerror(errno);
+            return false;
+        }
+
+        if(ret == 0) {
+            return true;
+        }
+        m_position += static_cast<uint64_t>(ret);
+
+        const char* pos = m_readBuffer.c_str();
+        const char* end = pos + ret;
+        while(pos < end)
+        {
+            const char* lineEnd = findNextByte(pos, end, '\n');
+            m_incompleteLine.append(pos, static_cast<uint64_t>(lineEnd - pos));
+            if(lineEnd == end) {
+                break;
+            }
+
+            lines.push_back(m_incompleteLine);
+            m_incompleteLine.clear();
+            pos = lineEnd + 1;
+        }
+    }
+}
+
+/**
+ * @brief open the file behind the path and start reading it from the beginning
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+FileFollower::switchToNewFile(std::string &errorMessage)
+{
+    const int fileDescriptor = open(m_filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + m_filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        errorMessage = "failed to get state of file \"" + m_filePath + "\": " + strerror(errno);
+        close(fileDescriptor);
+        return false;
+    }
+
+    if(m_fileDescriptor >= 0) {
+        close(m_fileDescriptor);
+    }
+
+    m_fileDescriptor = fileDescriptor;
+    m_device = static_cast<uint64_t>(fileStat.st_dev);
+    m_inode = static_cast<uint64_t>(fileStat.st_ino);
+    m_position = 0;
+    m_incompleteLine.clear();
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
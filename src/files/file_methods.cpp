@@ -7,6 +7,15 @@
  */
 
 #include <libKitsunemimiPersistence/files/file_methods.h>
+#include <libKitsunemimiPersistence/files/file_filter.h>
+#include <libKitsunemimiPersistence/files/tree_copy.h>
+#include <libKitsunemimiPersistence/files/tree_remove.h>
+
+#include "../common/directory_walker.h"
+
+#include <fcntl.h>
+#include <unordered_set>
+#include <sys/stat.h>
 
 namespace Kitsunemimi
 {
@@ -14,61 +23,202 @@ namespace Persistence
 {
 
 /**
- * @brief iterate over a directory and subdirectory to file all containing files
+ * @brief get the complete path of the entry
  *
- * @param fileList resulting string-list with the absolute path of all found files
- * @param directory directory-path where to search
- * @param withSubdirs false, to list only files in the current directory, but not files from
- *                    subdirectories
- * @param exceptions list with directory-names, which should be skipped
+ * @return path of the entry
+ */
+const std::string
+FileEntry::getPath() const
+{
+    return getEntryPath(m_directoryPath, m_name);
+}
+
+/**
+ * @brief get the size of the entry. It is only read at the first request.
+ *
+ * @param size reference for the size in bytes
+ *
+ * @return false, if the entry could not be read, else true
+ */
+bool
+FileEntry::getSize(uint64_t &size)
+{
+    if(fetchMetadata(STATX_SIZE) == false) {
+        return false;
+    }
+
+    size = m_size;
+    return true;
+}
+
+/**
+ * @brief get the time of the last modification of the entry. It is only read at the first
+ *        request.
+ *
+ * @param modificationTime reference for the time in nanoseconds since epoch
+ *
+ * @return false, if the entry could not be read, else true
+ */
+bool
+FileEntry::getModificationTime(int64_t &modificationTime)
+{
+    if(fetchMetadata(STATX_MTIME) == false) {
+        return false;
+    }
+
+    modificationTime = m_modificationTime;
+    return true;
+}
+
+/**
+ * @brief get type and permissions of the entry. They are only read at the first request.
+ *
+ * @param mode reference for the mode like st_mode of stat
+ *
+ * @return false, if the entry could not be read, else true
+ */
+bool
+FileEntry::getMode(uint32_t &mode)
+{
+    if(fetchMetadata(STATX_TYPE | STATX_MODE) == false) {
+        return false;
+    }
+
+    mode = m_mode;
+    return true;
+}
+
+/**
+ * @brief read metadata of the entry, which were not already read before. Only the requested
+ *        metadata are requested from the filesystem, which is cheaper for some filesystems.
+ *
+ * @param mask STATX_*-flags of the requested metadata
+ *
+ * @return false, if the entry could not be read, else true
+ */
+bool
+FileEntry::fetchMetadata(const uint32_t mask)
+{
+    if((m_fetchedMask & mask) == mask) {
+        return true;
+    }
+
+    // the name is a view on the null-terminated name of the directory-entry
+    struct statx entryStat;
+    if(statx(m_directoryDescriptor,
+             m_name.data(),
+             AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+             mask,
+             &entryStat) != 0)
+    {
+        return false;
+    }
+
+    if(entryStat.stx_mask & STATX_SIZE) {
+        m_size = entryStat.stx_size;
+    }
+    if(entryStat.stx_mask & STATX_MTIME)
+    {
+        m_modificationTime = static_cast<int64_t>(entryStat.stx_mtime.tv_sec) * 1000000000
+                             + entryStat.stx_mtime.tv_nsec;
+    }
+    if((entryStat.stx_mask & (STATX_TYPE | STATX_MODE)) == (STATX_TYPE | STATX_MODE)) {
+        m_mode = entryStat.stx_mode;
+    }
+    m_fetchedMask |= entryStat.stx_mask;
+
+    return (m_fetchedMask & mask) == mask;
+}
+
+//==================================================================================================
+
+/**
+ * @brief iterate over all files and directories of a directory-tree without collecting them. The
+ *        entries are given to the callback while the directories are read, so the memory-usage
+ *        doesn't depend on the size of the tree.
+ *
+ * @param path path where to search. If this is a file-path, the callback is only called for
+ *             this path.
+ * @param processEntry callback for each file and directory. It is called by multiple threads at
+ *                     the same time, so it has to be thread-safe. The entry is only valid within
+ *                     the callback. The callback returns SKIP_DIRECTORY to not enter a directory
+ *                     or STOP_WALK to stop the iteration.
+ * @param errorMessage reference for error-message output
+ * @param withSubdirs false, to iterate only over the current directory (Default: true)
+ * @param numberOfThreads number of threads (Default: 0 to use one thread per cpu-core)
+ *
+ * @return false, if path doesn't exist or a directory could not be read, else true
+ */
+bool
+iterateFiles(const std::string &path,
+             const FileEntryCallback &processEntry,
+             std::string &errorMessage,
+             const bool withSubdirs,
+             const uint32_t numberOfThreads)
+{
+    DirectoryWalker walker(numberOfThreads);
+    return walker.walk(path, processEntry, errorMessage, withSubdirs);
+}
+
+/**
+ * @brief iterate over the files of a directory-tree, which are accepted by a filter. Excluded
+ *        directories are not opened at all.
+ *
+ * @param path path where to search. If this is a file-path, the callback is only called for
+ *             this path, if it is accepted by the filter.
+ * @param filter filter for the files and directories
+ * @param processEntry callback for each accepted file. Directories are not given to the
+ *                     callback. It is called by multiple threads at the same time, so it has to
+ *                     be thread-safe. The callback returns STOP_WALK to stop the iteration.
+ * @param errorMessage reference for error-message output
+ * @param withSubdirs false, to iterate only over the current directory (Default: true)
+ * @param numberOfThreads number of threads (Default: 0 to use one thread per cpu-core)
+ *
+ * @return false, if path doesn't exist or a directory could not be read, else true
  */
-void
-getFilesInDir(std::vector<std::string> &fileList,
-              const boost::filesystem::path &directory,
-              const bool withSubdirs,
-              const std::vector<std::string> &exceptions)
-{
-    boost::filesystem::directory_iterator end_itr;
-    for(boost::filesystem::directory_iterator itr(directory);
-        itr != end_itr;
-        ++itr)
+bool
+iterateFiles(const std::string &path,
+             const FileFilter &filter,
+             const FileEntryCallback &processEntry,
+             std::string &errorMessage,
+             const bool withSubdirs,
+             const uint32_t numberOfThreads)
+{
+    auto filterEntry = [&](FileEntry &entry)
     {
-        if(is_directory(itr->path()))
+        if(entry.m_type == DIRECTORY_ENTRY)
         {
-            if(withSubdirs == true)
-            {
-                bool foundInExceptions = false;
-
-                for(uint64_t i = 0; i < exceptions.size(); i++)
-                {
-                    if(itr->path().leaf().string() == exceptions.at(i)) {
-                        foundInExceptions = true;
-                    }
-                }
-
-                if(foundInExceptions == false) {
-                    getFilesInDir(fileList, itr->path(), withSubdirs, exceptions);
-                }
+            if(filter.matchDirectory(entry) == false) {
+                return SKIP_DIRECTORY;
             }
+            return CONTINUE_WALK;
         }
-        else
-        {
-            fileList.push_back(itr->path().string());
+
+        if(filter.matchFile(entry) == false) {
+            return CONTINUE_WALK;
         }
-    }
+
+        return processEntry(entry);
+    };
+
+    DirectoryWalker walker(numberOfThreads);
+    return walker.walk(path, filterEntry, errorMessage, withSubdirs);
 }
 
 /**
- * @brief iterate over a directory and subdirectory to file all containing files
+ * @brief iterate over a directory and subdirectory to file all containing files. The
+ *        directory-tree is read in parallel by multiple threads, so the order of the files
+ *        within the list is not defined.
  *
  * @param fileList resulting string-list with the absolute path of all found files
  * @param path path where to search. This should be a directory. If this is a file-path, this path
  *             is the only one in the resulting list
  * @param withSubdirs false, to list only files in the current directory, but not files from
  *                    subdirectories (Default: true)
- * @param exceptions list with directory-names, which should be skipped (Default: empty list)
+ * @param exceptions list with directory-names, which should be skipped. The names are compared
+ *                   literally. For glob-patterns a FileFilter can be used. (Default: empty list)
  *
- * @return false, if path doesn't exist, else true
+ * @return false, if path doesn't exist or a directory could not be read, else true
  */
 bool
 listFiles(std::vector<std::string> &fileList,
@@ -76,24 +226,90 @@ listFiles(std::vector<std::string> &fileList,
           const bool withSubdirs,
           const std::vector<std::string> &exceptions)
 {
-    boost::filesystem::path pathObj(path);
-    if(boost::filesystem::exists(pathObj) == false) {
-        return false;
-    }
+    const std::unordered_set<std::string> excludedNames(exceptions.begin(), exceptions.end());
+
+    // each thread collects its files in its own list
+    DirectoryWalker walker;
+    std::vector<std::vector<std::string>> threadFileLists(walker.getNumberOfThreads());
+
+    auto processEntry = [&](FileEntry &entry)
+    {
+        if(entry.m_type == DIRECTORY_ENTRY)
+        {
+            if(excludedNames.find(std::string(entry.m_name)) != excludedNames.end()) {
+                return SKIP_DIRECTORY;
+            }
+            return CONTINUE_WALK;
+        }
+
+        threadFileLists[entry.m_threadId].push_back(entry.getPath());
+        return CONTINUE_WALK;
+    };
+
+    std::string errorMessage = "";
+    const bool result = walker.walk(path, processEntry, errorMessage, withSubdirs);
 
-    if(is_directory(pathObj))
+    for(std::vector<std::string> &threadFileList : threadFileLists)
     {
-        getFilesInDir(fileList,
-                      pathObj,
-                      withSubdirs,
-                      exceptions);
+        fileList.insert(fileList.end(),
+                        std::make_move_iterator(threadFileList.begin()),
+                        std::make_move_iterator(threadFileList.end()));
     }
-    else
+
+    return result;
+}
+
+/**
+ * @brief collect all files of a directory-tree, which are accepted by a filter. Excluded
+ *        directories are not opened and for not accepted files no path is created. The order of
+ *        the files within the list is not defined.
+ *
+ * @param fileList resulting string-list with the path of all accepted files
+ * @param path path where to search. If this is a file-path, this path is the only one in the
+ *             resulting list, if it is accepted by the filter.
+ * @param filter filter for the files and directories
+ * @param withSubdirs false, to list only files in the current directory, but not files from
+ *                    subdirectories (Default: true)
+ *
+ * @return false, if path doesn't exist or a directory could not be read, else true
+ */
+bool
+listFiles(std::vector<std::string> &fileList,
+          const std::string &path,
+          const FileFilter &filter,
+          const bool withSubdirs)
+{
+    // each thread collects its files in its own list
+    DirectoryWalker walker;
+    std::vector<std::vector<std::string>> threadFileLists(walker.getNumberOfThreads());
+
+    auto processEntry = [&](FileEntry &entry)
+    {
+        if(entry.m_type == DIRECTORY_ENTRY)
+        {
+            if(filter.matchDirectory(entry) == false) {
+                return SKIP_DIRECTORY;
+            }
+            return CONTINUE_WALK;
+        }
+
+        if(filter.matchFile(entry)) {
+            threadFileLists[entry.m_threadId].push_back(entry.getPath());
+        }
+        return CONTINUE_WALK;
+    };
+
+    std::string errorMessage = "";
+    const bool result = walker.walk(path, processEntry, errorMessage, withSubdirs);
+
+    for(std::vector<std::string> &threadFileList : threadFileLists)
     {
-        fileList.push_back(path);
+        fileList.insert(fileList.end(),
+                        std::make_move_iterator(threadFileList.begin()),
+                        std::make_move_iterator(threadFileList.end()));
     }
 
-    return true;
+    return result;
 }
 
 /**
@@ -148,13 +364,13 @@ renameFileOrDir(const bfs::path &oldPath,
 }
 
 /**
- * @brief copy a file or directory
+ * @brief copy a file or directory-tree in parallel
  *
  * @param sourcePath origial path
  * @param targetPath path of the copy
  * @param errorMessage reference for error-message output
- * @param force true to delete target, if already exist, if something exist at the target-location
- *              (Default: true)
+ * @param force true to overwrite files at the target-location, if they already exist. Existing
+ *              directories are merged with the source. (Default: true)
  *
  * @return true, if successful, else false
  */
@@ -164,25 +380,7 @@ copyPath(const bfs::path &sourcePath,
          std::string &errorMessage,
          const bool force)
 {
-    if(bfs::exists(sourcePath) == false)
-    {
-        errorMessage = "source-path " + sourcePath.string() + " doesn't exist.";
-        return false;
-    }
-
-    boost::system::error_code boostError;
-    if(force) {
-        boost::filesystem::remove_all(targetPath);
-    }
-    boost::filesystem::copy(sourcePath, targetPath, boostError);
-
-    if(boostError.value() != 0)
-    {
-        errorMessage = boostError.message();
-        return false;
-    }
-
-    return true;
+    return copyTree(sourcePath.string(), targetPath.string(), errorMessage, force);
 }
 
 /**
@@ -217,7 +415,7 @@ createDirectory(const bfs::path &path,
 }
 
 /**
- * @brief delete a path
+ * @brief delete a file or directory-tree in parallel
  *
  * @param path path to delete
  * @param errorMessage reference for error-message output
@@ -228,18 +426,7 @@ bool
 deleteFileOrDir(const bfs::path &path,
                 std::string &errorMessage)
 {
-    if(bfs::exists(path) == false) {
-        return true;
-    }
-
-    boost::system::error_code boostError;
-    const bool result = boost::filesystem::remove_all(path, boostError);
-
-    if(result == false) {
-        errorMessage = boostError.message();
-    }
-
-    return result;
+    return removeTree(path.string(), errorMessage);
 }
 
 }
@@ -0,0 +1,637 @@
+/**
+ *  @file    line_index.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief index of the start-positions of all lines of a text-file
+ *
+ *  @detail The positions are stored in a sidecar-file next to the text-file, together with the
+ *          size, inode and modification-time of the text-file. When opened again, the index is
+ *          reused, if the file was not changed, and only the new lines are indexed, if the file
+ *          only grew. To detect a rewrite of the already indexed part, a checksum of its first
+ *          and last block is stored too. With the index each line can be read directly and a
+ *          line can be replaced without rewriting the whole file.
+ */
+
+#include <libKitsunemimiPersistence/files/line_index.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/byte_search.h"
+#include "../common/checksum.h"
+
+#include <algorithm>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define LINE_INDEX_MAGIC 0x4B4C494E4458ULL
+#define LINE_INDEX_SUFFIX ".lidx"
+#define MOVE_BUFFER_SIZE (1024 * 1024)
+#define PREFIX_CHECK_SIZE 4096
+
+struct LineIndexHeader
+{
+    uint64_t magic = LINE_INDEX_MAGIC;
+    uint64_t fileSize = 0;
+    uint64_t inode = 0;
+    uint64_t modifyTime = 0;
+    uint64_t numberOfLines = 0;
+    uint32_t checksum = 0;
+    uint32_t prefixChecksum = 0;
+    uint8_t endsWithLineBreak = 0;
+    uint8_t padding[3] = {0, 0, 0};
+} __attribute__((packed));
+
+/**
+ * @brief constructor
+ */
+LineIndex::LineIndex() {}
+
+/**
+ * @brief destructor
+ */
+LineIndex::~LineIndex()
+{
+    closeIndex();
+}
+
+/**
+ * @brief open the index of a text-file. An existing sidecar-file is reused, if it is still
+ *        valid for the file, else the index is created and written to the sidecar-file.
+ *
+ * @param filePath path to the text-file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::openIndex(const std::string &filePath,
+                     std::string &errorMessage)
+{
+    if(m_file != nullptr)
+    {
+        errorMessage = "index of file \"" + m_filePath + "\" is already open";
+        return false;
+    }
+
+    if(bfs::is_regular_file(filePath) == false)
+    {
+        errorMessage = "failed to open index of file \"" + filePath + "\", "
+                       "because it is not a regular file";
+        return false;
+    }
+
+    m_filePath = filePath;
+    m_indexPath = filePath + LINE_INDEX_SUFFIX;
+    m_file = new BinaryFile(filePath);
+
+    // an invalid or missing sidecar-file is not an error, because it can be rebuild
+    if(loadIndex() == false)
+    {
+        m_lineOffsets.clear();
+        m_fileSize = 0;
+        m_inode = 0;
+        m_modifyTime = 0;
+        m_prefixChecksum = 0;
+        m_endsWithLineBreak = false;
+    }
+
+    if(updateIndex(errorMessage) == false)
+    {
+        closeIndex();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief close the index and the text-file
+ *
+ * @return false, if no index was open, else true
+ */
+bool
+LineIndex::closeIndex()
+{
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    delete m_file;
+    m_file = nullptr;
+    m_lineOffsets.clear();
+    m_fileSize = 0;
+    m_inode = 0;
+    m_modifyTime = 0;
+    m_prefixChecksum = 0;
+    m_endsWithLineBreak = false;
+
+    return true;
+}
+
+/**
+ * @brief bring the index up-to-date with the text-file. If the file only grew and the checksum
+ *        of the indexed part still matches, only the last line and the new lines are indexed,
+ *        else the complete file is indexed again.
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::updateIndex(std::string &errorMessage)
+{
+    if(m_file == nullptr)
+    {
+        errorMessage = "no index is open";
+        return false;
+    }
+
+    uint64_t fileSize = 0;
+    uint64_t inode = 0;
+    uint64_t modifyTime = 0;
+    if(getFileState(fileSize, inode, modifyTime) == false)
+    {
+        errorMessage = "failed to get state of file \"" + m_filePath + "\"";
+        return false;
+    }
+
+    // file was not changed since the last update
+    if(inode == m_inode
+            && fileSize == m_fileSize
+            && modifyTime == m_modifyTime)
+    {
+        return true;
+    }
+
+    // the file was replaced, for example by a rename, so the old descriptor still points to
+    // the old content and the file has to be opened again
+    if(inode != m_inode)
+    {
+        delete m_file;
+        m_file = new BinaryFile(m_filePath);
+    }
+
+    m_file->updateFileSize();
+
+    // the last indexed line is scanned again, because it could have been continued
+    uint64_t startPosition = 0;
+    uint32_t prefixChecksum = 0;
+    if(inode == m_inode
+            && fileSize > m_fileSize
+            && m_lineOffsets.size() > 0
+            && getPrefixChecksum(prefixChecksum)
+            && prefixChecksum == m_prefixChecksum)
+    {
+        startPosition = m_lineOffsets.back();
+        m_lineOffsets.pop_back();
+    }
+    else
+    {
+        m_lineOffsets.clear();
+    }
+
+    if(scanLines(startPosition, fileSize, errorMessage) == false)
+    {
+        m_lineOffsets.clear();
+        m_inode = 0;
+        return false;
+    }
+
+    m_fileSize = fileSize;
+    m_inode = inode;
+    m_modifyTime = modifyTime;
+
+    if(writeIndex() == false)
+    {
+        errorMessage = "failed to write line-index \"" + m_indexPath + "\"";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read a line of the text-file. The index is updated before, if the file was changed.
+ *
+ * @param lineNumber number of the line (beginning with 0)
+ * @param line reference for the content of the line without the line-break
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::readLine(const uint64_t lineNumber,
+                    std::string &line,
+                    std::string &errorMessage)
+{
+    if(m_file == nullptr)
+    {
+        errorMessage = "no index is open";
+        return false;
+    }
+
+    // make sure, that the offsets match the current content of the file
+    if(updateIndex(errorMessage) == false) {
+        return false;
+    }
+
+    if(lineNumber >= m_lineOffsets.size())
+    {
+        errorMessage = "failed to read line from file \"" + m_filePath + "\", "
+                       "because linenumber is too big for the file";
+        return false;
+    }
+
+    const uint64_t lineStart = m_lineOffsets.at(lineNumber);
+    const uint64_t lineSize = getLineEnd(lineNumber) - lineStart;
+
+    line.resize(lineSize);
+    if(lineSize > 0
+            && m_file->readDataFromFile(&line[0], lineStart, lineSize) == false)
+    {
+        errorMessage = "failed to read line from file \"" + m_filePath + "\"";
+        line.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief replace a line inside the text-file. If the new line has the same size, only the line
+ *        itself is overwritten, else the rest of the file behind the line is moved.
+ *        The move is done in-place, so the file is inconsistent, if the process crashes while
+ *        moving the rest of the file.
+ *
+ * @param lineNumber number of the line (beginning with 0)
+ * @param newLineContent new content of the line without line-break
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::replaceLine(const uint64_t lineNumber,
+                       const std::string &newLineContent,
+                       std::string &errorMessage)
+{
+    if(newLineContent.find('\n') != std::string::npos)
+    {
+        errorMessage = "failed to replace line in file \"" + m_filePath + "\", "
+                       "because the new content contains a line-break";
+        return false;
+    }
+
+    // make sure, that the offsets match the current content of the file
+    if(updateIndex(errorMessage) == false) {
+        return false;
+    }
+
+    if(lineNumber >= m_lineOffsets.size())
+    {
+        errorMessage = "failed to replace line in file \"" + m_filePath + "\", "
+                       "because linenumber is too big for the file";
+        return false;
+    }
+
+    const uint64_t lineStart = m_lineOffsets.at(lineNumber);
+    const uint64_t lineEnd = getLineEnd(lineNumber);
+    const int64_t distance = static_cast<int64_t>(newLineContent.size())
+                             - static_cast<int64_t>(lineEnd - lineStart);
+
+    if(distance != 0
+            && moveTail(lineEnd, distance) == false)
+    {
+        errorMessage = "failed to move content behind the line in file \"" + m_filePath + "\"";
+        m_inode = 0;
+        return false;
+    }
+
+    if(newLineContent.size() > 0
+            && m_file->writeDataIntoFile(newLineContent.c_str(),
+                                         lineStart,
+                                         newLineContent.size()) == false)
+    {
+        errorMessage = "failed to write line into file \"" + m_filePath + "\"";
+        m_inode = 0;
+        return false;
+    }
+
+    // update positions of all following lines
+    for(uint64_t i = lineNumber + 1; i < m_lineOffsets.size(); i++) {
+        m_lineOffsets[i] = static_cast<uint64_t>(static_cast<int64_t>(m_lineOffsets[i]) + distance);
+    }
+    m_fileSize = static_cast<uint64_t>(static_cast<int64_t>(m_fileSize) + distance);
+
+    // the own write changed the modification-time of the file
+    uint64_t fileSize = 0;
+    if(getFileState(fileSize, m_inode, m_modifyTime) == false
+            || writeIndex() == false)
+    {
+        errorMessage = "failed to write line-index \"" + m_indexPath + "\"";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get number of lines of the text-file
+ *
+ * @return number of lines
+ */
+uint64_t
+LineIndex::getNumberOfLines() const
+{
+    return m_lineOffsets.size();
+}
+
+/**
+ * @brief get size, inode and modification-time of the text-file
+ *
+ * @param fileSize reference for the size of the file
+ * @param inode reference for the inode of the file
+ * @param modifyTime reference for the modification-time in nanoseconds
+ *
+ * @return false, if stat failed, else true
+ */
+bool
+LineIndex::getFileState(uint64_t &fileSize,
+                        uint64_t &inode,
+                        uint64_t &modifyTime)
+{
+    struct stat fileStat;
+    if(stat(m_filePath.c_str(), &fileStat) != 0) {
+        return false;
+    }
+
+    fileSize = static_cast<uint64_t>(fileStat.st_size);
+    inode = static_cast<uint64_t>(fileStat.st_ino);
+    modifyTime = static_cast<uint64_t>(fileStat.st_mtim.tv_sec) * 1000000000ULL
+                 + static_cast<uint64_t>(fileStat.st_mtim.tv_nsec);
+
+    return true;
+}
+
+/**
+ * @brief search the start-positions of all lines behind a position of the text-file
+ *
+ * @param startPosition position of the first line to index
+ * @param fileSize size of the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::scanLines(const uint64_t startPosition,
+                     const uint64_t fileSize,
+                     std::string &errorMessage)
+{
+    m_endsWithLineBreak = false;
+    if(fileSize == 0) {
+        return true;
+    }
+
+    MappedFile file;
+    if(file.openFile(m_filePath, errorMessage, true) == false) {
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.m_data);
+    const char* end = data + std::min(fileSize, file.m_size);
+    const char* pos = data + startPosition;
+
+    while(pos < end)
+    {
+        m_lineOffsets.push_back(static_cast<uint64_t>(pos - data));
+
+        const char* lineBreak = findNextByte(pos, end, '\n');
+        if(lineBreak == end) {
+            return true;
+        }
+        pos = lineBreak + 1;
+    }
+
+    m_endsWithLineBreak = true;
+
+    return true;
+}
+
+/**
+ * @brief calculate the checksum of the first and the last block of the indexed part of the
+ *        text-file, which is the content in front of the last indexed line
+ *
+ * @param checksum reference for the resulting checksum
+ *
+ * @return false, if reading failed, else true
+ */
+bool
+LineIndex::getPrefixChecksum(uint32_t &checksum)
+{
+    checksum = 0;
+    if(m_lineOffsets.size() == 0) {
+        return true;
+    }
+
+    const uint64_t prefixSize = m_lineOffsets.back();
+    const uint64_t blockSize = std::min(prefixSize, static_cast<uint64_t>(PREFIX_CHECK_SIZE));
+    if(blockSize == 0) {
+        return true;
+    }
+
+    std::vector<uint8_t> buffer(blockSize);
+    if(m_file->readDataFromFile(buffer.data(), 0, blockSize) == false) {
+        return false;
+    }
+    checksum = calcCrc32c(buffer.data(), blockSize);
+
+    if(m_file->readDataFromFile(buffer.data(), prefixSize - blockSize, blockSize) == false) {
+        return false;
+    }
+    checksum = calcCrc32c(buffer.data(), blockSize, checksum);
+
+    return true;
+}
+
+/**
+ * @brief get the end of a line
+ *
+ * @param lineNumber number of the line
+ *
+ * @return position of the line-break of the line, or the end of the file for the last line
+ *         without line-break
+ */
+uint64_t
+LineIndex::getLineEnd(const uint64_t lineNumber) const
+{
+    if(lineNumber + 1 < m_lineOffsets.size()) {
+        return m_lineOffsets.at(lineNumber + 1) - 1;
+    }
+
+    if(m_endsWithLineBreak) {
+        return m_fileSize - 1;
+    }
+
+    return m_fileSize;
+}
+
+/**
+ * @brief move the end of the text-file to another position and resize the file
+ *
+ * @param tailStart first byte of the content to move
+ * @param distance number of bytes to move the content (negative to move it to the front)
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::moveTail(const uint64_t tailStart,
+                    const int64_t distance)
+{
+    const uint64_t tailSize = m_fileSize - tailStart;
+    std::vector<uint8_t> buffer(std::min(tailSize, static_cast<uint64_t>(MOVE_BUFFER_SIZE)));
+
+    if(distance > 0)
+    {
+        const uint64_t offset = static_cast<uint64_t>(distance);
+        if(m_file->allocateStorage(offset, 1) == false) {
+            return false;
+        }
+
+        // move from back to front, to not overwrite content, which is not moved yet
+        uint64_t remaining = tailSize;
+        while(remaining > 0)
+        {
+            const uint64_t blockSize = std::min(remaining, static_cast<uint64_t>(buffer.size()));
+            const uint64_t position = tailStart + remaining - blockSize;
+            if(m_file->readDataFromFile(buffer.data(), position, blockSize) == false
+                    || m_file->writeDataIntoFile(buffer.data(),
+                                                 position + offset,
+                                                 blockSize) == false)
+            {
+                return false;
+            }
+            remaining -= blockSize;
+        }
+
+        return true;
+    }
+
+    const uint64_t offset = static_cast<uint64_t>(-distance);
+
+    // move from front to back, to not overwrite content, which is not moved yet
+    uint64_t moved = 0;
+    while(moved < tailSize)
+    {
+        const uint64_t blockSize = std::min(tailSize - moved, static_cast<uint64_t>(buffer.size()));
+        const uint64_t position = tailStart + moved;
+        if(m_file->readDataFromFile(buffer.data(), position, blockSize) == false
+                || m_file->writeDataIntoFile(buffer.data(),
+                                             position - offset,
+                                             blockSize) == false)
+        {
+            return false;
+        }
+        moved += blockSize;
+    }
+
+    return m_file->truncateFile(m_fileSize - offset);
+}
+
+/**
+ * @brief load the index from the sidecar-file
+ *
+ * @return false, if the sidecar-file doesn't exist or is broken, else true
+ */
+bool
+LineIndex::loadIndex()
+{
+    if(bfs::exists(m_indexPath) == false) {
+        return false;
+    }
+
+    BinaryFile file(m_indexPath);
+    LineIndexHeader header;
+    if(file.m_totalFileSize < sizeof(LineIndexHeader)
+            || file.readDataFromFile(&header, 0, sizeof(LineIndexHeader)) == false
+            || header.magic != LINE_INDEX_MAGIC
+            || file.m_totalFileSize != sizeof(LineIndexHeader)
+                                       + header.numberOfLines * sizeof(uint64_t))
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> lineOffsets(header.numberOfLines);
+    if(header.numberOfLines > 0
+            && file.readDataFromFile(lineOffsets.data(),
+                                     sizeof(LineIndexHeader),
+                                     lineOffsets.size() * sizeof(uint64_t)) == false)
+    {
+        return false;
+    }
+    if(calcCrc32c(lineOffsets.data(), lineOffsets.size() * sizeof(uint64_t)) != header.checksum) {
+        return false;
+    }
+
+    m_lineOffsets.swap(lineOffsets);
+    m_fileSize = header.fileSize;
+    m_inode = header.inode;
+    m_modifyTime = header.modifyTime;
+    m_prefixChecksum = header.prefixChecksum;
+    m_endsWithLineBreak = header.endsWithLineBreak != 0;
+
+    return true;
+}
+
+/**
+ * @brief write the index into a temporary file and replace the old sidecar-file with it
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineIndex::writeIndex()
+{
+    const uint64_t bodySize = m_lineOffsets.size() * sizeof(uint64_t);
+    if(getPrefixChecksum(m_prefixChecksum) == false) {
+        return false;
+    }
+
+    LineIndexHeader header;
+    header.fileSize = m_fileSize;
+    header.inode = m_inode;
+    header.modifyTime = m_modifyTime;
+    header.numberOfLines = m_lineOffsets.size();
+    header.checksum = calcCrc32c(m_lineOffsets.data(), bodySize);
+    header.prefixChecksum = m_prefixChecksum;
+    header.endsWithLineBreak = m_endsWithLineBreak;
+
+    // write temporary file
+    const std::string tempPath = m_indexPath + ".tmp";
+    bfs::remove(tempPath);
+    {
+        BinaryFile file(tempPath);
+        if(file.allocateStorage(sizeof(LineIndexHeader) + bodySize, 1) == false
+                || file.writeDataIntoFile(&header, 0, sizeof(LineIndexHeader)) == false
+                || (bodySize > 0
+                    && file.writeDataIntoFile(m_lineOffsets.data(),
+                                              sizeof(LineIndexHeader),
+                                              bodySize) == false))
+        {
+            return false;
+        }
+    }
+
+    // replace old sidecar-file
+    std::string errorMessage = "";
+    return renameFileOrDir(tempPath, m_indexPath, errorMessage);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,268 @@
+/**
+ *  @file    line_reader.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief streaming reader for the lines of a text-file
+ *
+ *  @detail The file is read block-wise into an aligned buffer and the lines are returned as
+ *          views into this buffer, so the memory-consumption is independent of the file-size
+ *          and no line is copied. The buffer only grows, if a single line is bigger than the
+ *          buffer. Gzip- and zstd-compressed files are detected by their magic bytes and
+ *          decompressed in a separate thread.
+ */
+
+#include <libKitsunemimiPersistence/files/line_reader.h>
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include "../common/byte_search.h"
+#include "../common/decompressor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief constructor
+ *
+ * @param bufferSize initial size of the read-buffer in bytes
+ */
+LineReader::LineReader(const uint64_t bufferSize)
+{
+    const uint32_t numberOfBlocks = static_cast<uint32_t>((bufferSize + 4095) / 4096);
+    m_buffer = new DataBuffer(numberOfBlocks == 0 ? 1 : numberOfBlocks, 4096);
+}
+
+/**
+ * @brief destructor
+ */
+LineReader::~LineReader()
+{
+    closeFile();
+    delete m_buffer;
+}
+
+/**
+ * @brief open a text-file for reading its lines
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+LineReader::openFile(const std::string &filePath,
+                     std::string &errorMessage)
+{
+    if(m_fileDescriptor >= 0)
+    {
+        errorMessage = "file \"" + m_filePath + "\" is already open";
+        return false;
+    }
+
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    // the file is read only once from begin to end
+    posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    CompressionType compression = NO_COMPRESSION;
+    if(detectCompression(compression, fileDescriptor, filePath, errorMessage) == false)
+    {
+        close(fileDescriptor);
+        return false;
+    }
+
+    if(compression != NO_COMPRESSION)
+    {
+        m_decompressor = new Decompressor();
+        if(m_decompressor->start(fileDescriptor, compression, filePath, errorMessage) == false)
+        {
+            delete m_decompressor;
+            m_decompressor = nullptr;
+            close(fileDescriptor);
+            return false;
+        }
+    }
+
+    m_fileDescriptor = fileDescriptor;
+    m_filePath = filePath;
+    m_errorMessage = "";
+    m_lineNumber = 0;
+    m_lineStart = 0;
+    m_searchPosition = 0;
+    m_endOfFile = false;
+    m_buffer->bufferPosition = 0;
+
+    return true;
+}
+
+/**
+ * @brief close the file. All views of the last returned line become invalid.
+ *
+ * @return false, if no file was open, else true
+ */
+bool
+LineReader::closeFile()
+{
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    // the decompression-thread has to be stopped before its file is closed
+    if(m_decompressor != nullptr)
+    {
+        delete m_decompressor;
+        m_decompressor = nullptr;
+    }
+
+    close(m_fileDescriptor);
+    m_fileDescriptor = -1;
+    m_filePath = "";
+    m_buffer->bufferPosition = 0;
+
+    return true;
+}
+
+/**
+ * @brief get the next line of the file
+ *
+ * @param line reference for the resulting line without the line-break. It stays valid until
+ *             the next call of this method.
+ *
+ * @return false, if the end of the file was reached or reading failed, else true. In case of
+ *         an error, m_errorMessage is not empty.
+ */
+bool
+LineReader::next(std::string_view &line)
+{
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    while(true)
+    {
+        const char* data = reinterpret_cast<const char*>(m_buffer->data);
+        const char* end = data + m_buffer->bufferPosition;
+        const char* lineBreak = findNextByte(data + m_searchPosition, end, '\n');
+
+        if(lineBreak != end)
+        {
+            const uint64_t lineEnd = static_cast<uint64_t>(lineBreak - data);
+            line = std::string_view(data + m_lineStart, lineEnd - m_lineStart);
+            m_lineStart = lineEnd + 1;
+            m_searchPosition = m_lineStart;
+            m_lineNumber++;
+            return true;
+        }
+
+        // all data of the buffer are already searched
+        m_searchPosition = m_buffer->bufferPosition;
+
+        if(m_endOfFile)
+        {
+            // last line of the file without line-break
+            if(m_lineStart < m_buffer->bufferPosition)
+            {
+                line = std::string_view(data + m_lineStart,
+                                        m_buffer->bufferPosition - m_lineStart);
+                m_lineStart = m_buffer->bufferPosition;
+                m_lineNumber++;
+                return true;
+            }
+
+            return false;
+        }
+
+        if(fillBuffer() == false) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief move the unfinished line to the start of the buffer and fill the rest of the buffer
+ *        with new data from the file or the decompressor
+ *
+ * @return false, if reading failed, else true
+ */
+bool
+LineReader::fillBuffer()
+{
+    // move the beginning of the current line to the start of the buffer
+    const uint64_t remainingSize = m_buffer->bufferPosition - m_lineStart;
+    if(m_lineStart > 0)
+    {
+        memmove(m_buffer->data, m_buffer->data + m_lineStart, remainingSize);
+        m_buffer->bufferPosition = remainingSize;
+        m_searchPosition -= m_lineStart;
+        m_lineStart = 0;
+    }
+
+    // double the buffer, if a single line doesn't fit into it
+    if(m_buffer->bufferPosition == m_buffer->totalBufferSize)
+    {
+        if(allocateBlocks_DataBuffer(*m_buffer, m_buffer->numberOfBlocks) == false)
+        {
+            m_errorMessage = "failed to allocate memory for line of file \"" + m_filePath + "\"";
+            return false;
+        }
+    }
+
+    if(m_decompressor != nullptr)
+    {
+        uint64_t readSize = 0;
+        if(m_decompressor->read(m_buffer->data + m_buffer->bufferPosition,
+                                m_buffer->totalBufferSize - m_buffer->bufferPosition,
+                                readSize,
+                                m_errorMessage) == false)
+        {
+            return false;
+        }
+
+        if(readSize == 0) {
+            m_endOfFile = true;
+        }
+        m_buffer->bufferPosition += readSize;
+
+        return true;
+    }
+
+    while(true)
+    {
+        const ssize_t ret = read(m_fileDescriptor,
+                                 m_buffer->data + m_buffer->bufferPosition,
+                                 m_buffer->totalBufferSize - m_buffer->bufferPosition);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            m_errorMessage = "failed to read file \"" + m_filePath + "\": " + strerror(errno);
+            return false;
+        }
+
+        if(ret == 0) {
+            m_endOfFile = true;
+        }
+        m_buffer->bufferPosition += static_cast<uint64_t>(ret);
+
+        return true;
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,154 @@
+/**
+ *  @file    mapped_file.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief read-only memory-mapping of a file
+ *
+ *  @detail The content of the file is mapped into the memory and accessed without copy. The
+ *          kernel loads the pages on demand, so even very big files don't have to fit into the
+ *          memory. The content is only valid as long as the file stays mapped.
+ */
+
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief constructor
+ */
+MappedFile::MappedFile() {}
+
+/**
+ * @brief destructor
+ */
+MappedFile::~MappedFile()
+{
+    closeFile();
+}
+
+/**
+ * @brief map a file read-only into the memory
+ *
+ * @param filePath path to the file
+ * @param errorMessage reference for error-message output
+ * @param sequentialAccess true to tell the kernel, that the file is read from begin to end, so
+ *                         it reads ahead more aggressively
+ *
+ * @return true, if successful, else false
+ */
+bool
+MappedFile::openFile(const std::string &filePath,
+                     std::string &errorMessage,
+                     const bool sequentialAccess)
+{
+    if(m_fileDescriptor >= 0)
+    {
+        errorMessage = "file \"" + m_filePath + "\" is already mapped";
+        return false;
+    }
+
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        errorMessage = "failed to get size of file \"" + filePath + "\": " + strerror(errno);
+        close(fileDescriptor);
+        return false;
+    }
+
+    if(S_ISREG(fileStat.st_mode) == false)
+    {
+        errorMessage = "failed to map \"" + filePath + "\", because it is not a regular file";
+        close(fileDescriptor);
+        return false;
+    }
+
+    // empty files can not be mapped, but are valid
+    const uint64_t size = static_cast<uint64_t>(fileStat.st_size);
+    if(size > 0)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if(mapping == MAP_FAILED)
+        {
+            errorMessage = "failed to map file \"" + filePath + "\": " + strerror(errno);
+            close(fileDescriptor);
+            return false;
+        }
+
+        if(sequentialAccess) {
+            madvise(mapping, size, MADV_SEQUENTIAL);
+        }
+
+        m_mapping = mapping;
+        m_data = static_cast<const uint8_t*>(mapping);
+    }
+
+    m_fileDescriptor = fileDescriptor;
+    m_size = size;
+    m_filePath = filePath;
+
+    return true;
+}
+
+/**
+ * @brief unmap and close the file. All pointer to the content become invalid.
+ *
+ * @return false, if no file was mapped, else true
+ */
+bool
+MappedFile::closeFile()
+{
+    if(m_fileDescriptor < 0) {
+        return false;
+    }
+
+    if(m_mapping != nullptr) {
+        munmap(m_mapping, m_size);
+    }
+    close(m_fileDescriptor);
+
+    m_fileDescriptor = -1;
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_filePath = "";
+
+    return true;
+}
+
+/**
+ * @brief get content of the mapped file without copy
+ *
+ * @return view on the content, which is empty if no file is mapped
+ */
+std::string_view
+MappedFile::getContent() const
+{
+    if(m_data == nullptr) {
+        return std::string_view();
+    }
+
+    return std::string_view(reinterpret_cast<const char*>(m_data), m_size);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,196 @@
+/**
+ *  @file    text_chunk_processor.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief parallel processing of the content of a text-file
+ *
+ *  @detail The file is mapped into the memory and split into chunks of nearly the same size.
+ *          The borders of the chunks are moved behind the next line-break, so no line is split
+ *          over two chunks. The chunks are processed by multiple threads and each chunk has its
+ *          own result, so the results can be combined in the order of the file.
+ */
+
+#include <libKitsunemimiPersistence/files/text_chunk_processor.h>
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+
+#include "../common/byte_search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief split a content into chunks, which end directly behind a line-break
+ *
+ * @param content content to split
+ * @param chunkSize minimal size of a chunk. Chunks are bigger by the rest of their last line.
+ * @param chunks reference for the resulting chunks
+ */
+static void
+splitIntoChunks(const std::string_view &content,
+                const uint64_t chunkSize,
+                std::vector<TextChunk> &chunks)
+{
+    const char* begin = content.data();
+    const char* end = begin + content.size();
+    const char* pos = begin;
+
+    while(pos < end)
+    {
+        const char* chunkEnd = end;
+        if(static_cast<uint64_t>(end - pos) > chunkSize)
+        {
+            chunkEnd = findNextByte(pos + chunkSize - 1, end, '\n');
+            if(chunkEnd != end) {
+                chunkEnd++;
+            }
+        }
+
+        TextChunk chunk;
+        chunk.chunkId = chunks.size();
+        chunk.offset = static_cast<uint64_t>(pos - begin);
+        chunk.content = std::string_view(pos, static_cast<uint64_t>(chunkEnd - pos));
+        chunks.push_back(chunk);
+
+        pos = chunkEnd;
+    }
+}
+
+/**
+ * @brief process all chunks of a text-file in parallel
+ *
+ * @param filePath path to the file
+ * @param processChunk callback, which is called for each chunk. It gets the chunk and a
+ *                     reference to the result of this chunk and must return false to stop the
+ *                     processing. It is called from multiple threads at the same time.
+ * @param results reference for the results of all chunks in the order of the file
+ * @param errorMessage reference for error-message output
+ * @param numberOfThreads number of worker-threads (0 to use one thread per cpu-core)
+ * @param chunkSize minimal size of a chunk in bytes
+ *
+ * @return false, if the file could not be read or a callback returned false, else true
+ */
+bool
+processTextChunks(const std::string &filePath,
+                  const std::function<bool(const TextChunk &chunk,
+                                           std::string &result)> &processChunk,
+                  std::vector<std::string> &results,
+                  std::string &errorMessage,
+                  const uint32_t numberOfThreads,
+                  const uint64_t chunkSize)
+{
+    results.clear();
+
+    MappedFile file;
+    if(file.openFile(filePath, errorMessage) == false) {
+        return false;
+    }
+
+    std::vector<TextChunk> chunks;
+    splitIntoChunks(file.getContent(), std::max(chunkSize, static_cast<uint64_t>(1)), chunks);
+    results.resize(chunks.size());
+
+    uint64_t threadCounter = numberOfThreads;
+    if(threadCounter == 0) {
+        threadCounter = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCounter = std::min(threadCounter, static_cast<uint64_t>(chunks.size()));
+
+    std::atomic<uint64_t> nextChunk(0);
+    std::atomic<uint64_t> failedChunk(chunks.size());
+
+    // each thread takes the next chunk, until all chunks are processed or one failed
+    std::vector<std::thread> threads;
+    for(uint64_t t = 0; t < threadCounter; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            uint64_t pos = nextChunk++;
+            while(pos < chunks.size()
+                  && failedChunk == chunks.size())
+            {
+                if(processChunk(chunks.at(pos), results[pos]) == false)
+                {
+                    uint64_t expected = chunks.size();
+                    failedChunk.compare_exchange_strong(expected, pos);
+                }
+                pos = nextChunk++;
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    if(failedChunk != chunks.size())
+    {
+        errorMessage = "processing of chunk " + std::to_string(failedChunk)
+                       + " of file \"" + filePath + "\" failed";
+        results.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief process all lines of a text-file in parallel
+ *
+ * @param filePath path to the file
+ * @param processLine callback, which is called for each line without the line-break. It gets
+ *                    the line and a reference to the result of the chunk of the line and must
+ *                    return false to stop the processing. Lines of the same chunk are processed
+ *                    in order by the same thread, but different chunks at the same time.
+ * @param results reference for the results of all chunks in the order of the file
+ * @param errorMessage reference for error-message output
+ * @param numberOfThreads number of worker-threads (0 to use one thread per cpu-core)
+ * @param chunkSize minimal size of a chunk in bytes
+ *
+ * @return false, if the file could not be read or a callback returned false, else true
+ */
+bool
+processTextLines(const std::string &filePath,
+                 const std::function<bool(const std::string_view &line,
+                                          std::string &result)> &processLine,
+                 std::vector<std::string> &results,
+                 std::string &errorMessage,
+                 const uint32_t numberOfThreads,
+                 const uint64_t chunkSize)
+{
+    auto processChunk = [&](const TextChunk &chunk, std::string &result)
+    {
+        const char* pos = chunk.content.data();
+        const char* end = pos + chunk.content.size();
+
+        while(pos < end)
+        {
+            const char* lineEnd = findNextByte(pos, end, '\n');
+            const std::string_view line(pos, static_cast<uint64_t>(lineEnd - pos));
+            if(processLine(line, result) == false) {
+                return false;
+            }
+
+            pos = lineEnd + 1;
+        }
+
+        return true;
+    };
+
+    return processTextChunks(filePath,
+                             processChunk,
+                             results,
+                             errorMessage,
+                             numberOfThreads,
+                             chunkSize);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -14,11 +14,26 @@
 #include <libKitsunemimiCommon/common_methods/string_methods.h>
 #include <libKitsunemimiPersistence/files/file_methods.h>
 
+#include "../common/byte_search.h"
+#include "../common/temp_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
 namespace Kitsunemimi
 {
 namespace Persistence
 {
 
+#define READ_FILE_MIN_BUFFER_SIZE 4096
+#define REPLACE_CHUNK_SIZE (1024 * 1024)
+
 /**
  * @brief read text from a text-file
  *
@@ -34,36 +49,127 @@ readFile(std::string &readContent,
          std::string &errorMessage)
 {
     // check if exist
-    if(bfs::exists(filePath))
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
     {
-        // check for directory
-        if(bfs::is_directory(filePath))
-        {
-            errorMessage = "failed to read destination of path \""
-                           + filePath +
-                           "\", because it already exist and it is a directory, "
-                           "but must be a file or not existing";
-            return false;
+        if(errno == ENOENT) {
+            errorMessage = "destination of path \"" + filePath + "\", doesn't exist";
+        } else {
+            errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
         }
+        return false;
+    }
+
+    // size the target-string once and read directly into it
+    struct stat fileStat;
+    if(fstat(fileDescriptor, &fileStat) != 0)
+    {
+        errorMessage = "failed to get size of file \"" + filePath + "\": " + strerror(errno);
+        close(fileDescriptor);
+        return false;
     }
-    else
+
+    // check for directory
+    if(S_ISDIR(fileStat.st_mode))
     {
-        errorMessage = "destination of path \"" + filePath + "\", doesn't exist";
+        errorMessage = "failed to read destination of path \""
+                       + filePath +
+                       "\", because it already exist and it is a directory, "
+                       "but must be a file or not existing";
+        close(fileDescriptor);
         return false;
     }
 
-    std::ifstream inFile;
-    inFile.open(filePath);
+    // one additional byte to detect the end of the file without resizing. Files like the ones
+    // in /proc have no size, so the string is grown while reading.
+    const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size) + 1;
+    readContent.resize(std::max(fileSize, static_cast<uint64_t>(READ_FILE_MIN_BUFFER_SIZE)));
 
-    std::stringstream strStream;
-    strStream << inFile.rdbuf();
-    readContent = strStream.str();
+    uint64_t readSize = 0;
+    while(true)
+    {
+        if(readSize == readContent.size()) {
+            readContent.resize(readContent.size() * 2);
+        }
+
+        const ssize_t ret = read(fileDescriptor,
+                                 &readContent[readSize],
+                                 readContent.size() - readSize);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
 
-    inFile.close();
+            errorMessage = "failed to read file \"" + filePath + "\": " + strerror(errno);
+            close(fileDescriptor);
+            readContent.clear();
+            return false;
+        }
+
+        if(ret == 0) {
+            break;
+        }
+        readSize += static_cast<uint64_t>(ret);
+    }
+
+    close(fileDescriptor);
+    readContent.resize(readSize);
 
     return true;
 }
 
+/**
+ * @brief read multiple text-files in parallel. The files are read by multiple threads at the
+ *        same time, so the latencies of the storage overlap.
+ *
+ * @param results reference for the results in the same order as the file-paths. Each result
+ *                contains the content of the file or the error-message, if reading failed.
+ * @param filePaths list of paths of the files
+ * @param numberOfThreads number of threads, which read at the same time
+ *
+ * @return false, if at least one file could not be read, else true
+ */
+bool
+readFiles(std::vector<ReadFileResult> &results,
+          const std::vector<std::string> &filePaths,
+          const uint32_t numberOfThreads)
+{
+    results.clear();
+    results.resize(filePaths.size());
+
+    std::atomic<uint64_t> nextFile(0);
+    std::atomic<bool> success(true);
+
+    // each thread takes the next file, until all files are read
+    std::vector<std::thread> threads;
+    const uint64_t threadCounter = std::min(static_cast<uint64_t>(std::max(numberOfThreads, 1u)),
+                                            static_cast<uint64_t>(filePaths.size()));
+    for(uint64_t t = 0; t < threadCounter; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            uint64_t pos = nextFile++;
+            while(pos < filePaths.size())
+            {
+                ReadFileResult &result = results[pos];
+                result.success = readFile(result.content,
+                                          filePaths.at(pos),
+                                          result.errorMessage);
+                if(result.success == false) {
+                    success = false;
+                }
+                pos = nextFile++;
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return success;
+}
+
 /**
  * @brief write text into a file
  *
@@ -131,6 +237,42 @@ writeFile(const std::string &filePath,
     return true;
 }
 
+/**
+ * @brief write text atomically into a file. The text is written into an unnamed temporary file
+ *        in the same directory, which is synced and then renamed over the target, so readers
+ *        see either the old or the complete new content, even after a crash. If the file
+ *        system doesn't support unnamed temporary files or /proc is not mounted, a hidden
+ *        temporary file is used. If only the sync of the directory failed, false is returned,
+ *        but the file already has the new content, which is maybe lost after a crash.
+ *
+ * @param filePath path to the file
+ * @param content text which should be written into the file
+ * @param errorMessage reference for error-message output
+ * @param syncDirectory true to also sync the directory, so the rename itself is persistent
+ *
+ * @return true, if successful, else false
+ */
+bool
+writeFileAtomic(const std::string &filePath,
+                const std::string &content,
+                std::string &errorMessage,
+                const bool syncDirectory)
+{
+    TempFile tempFile;
+    if(openTempFile(tempFile, filePath, errorMessage) == false) {
+        return false;
+    }
+
+    if(writeAll(tempFile.file, content.c_str(), content.size()) == false)
+    {
+        errorMessage = "failed to write file \"" + filePath + "\": " + strerror(errno);
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    return commitTempFile(tempFile, syncDirectory, errorMessage);
+}
+
 /**
  * @brief append text to a existing text-file
  *
@@ -219,7 +361,10 @@ replaceLine(const std::string &filePath,
 }
 
 /**
- * @brief replace a substring inside the file with another string
+ * @brief replace a substring inside the file with another string. The file is processed in
+ *        chunks with constant memory-consumption and the result is written into a temporary
+ *        file, which replaces the original file at the end. If the substring was not found,
+ *        the file stays untouched.
  *
  * @param filePath path the to file
  * @param oldContent substring which should be replaced
@@ -234,28 +379,129 @@ replaceContent(const std::string &filePath,
                const std::string &newContent,
                std::string &errorMessage)
 {
-    // read file
-    std::string fileContent = "";
-    bool result = readFile(fileContent, filePath, errorMessage);
-    if(result == false) {
+    if(oldContent.size() == 0)
+    {
+        errorMessage = "failed to replace content in file \""
+                       + filePath +
+                       "\", because the content to replace is empty";
         return false;
     }
 
-    // replace content
-    std::string::size_type pos = 0u;
-    while((pos = fileContent.find(oldContent, pos)) != std::string::npos)
+    const int inputFile = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(inputFile < 0)
     {
-        fileContent.replace(pos, oldContent.length(), newContent);
-        pos += newContent.length();
+        errorMessage = "failed to open file \"" + filePath + "\": " + strerror(errno);
+        return false;
     }
 
-    // write file back the new content
-    const bool writeResult = writeFile(filePath,
-                                       fileContent,
-                                       errorMessage,
-                                       true);
+    posix_fadvise(inputFile, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    return writeResult;
+    // temporary file in the same directory, so it can be renamed over the original file
+    TempFile tempFile;
+    if(openTempFile(tempFile, filePath, errorMessage) == false)
+    {
+        close(inputFile);
+        return false;
+    }
+
+    const uint64_t patternSize = oldContent.size();
+    const char* pattern = oldContent.c_str();
+    const uint64_t chunkSize = std::max(static_cast<uint64_t>(REPLACE_CHUNK_SIZE), patternSize);
+
+    // the window contains the not processed end of the last chunk and the next chunk
+    std::vector<char> window(chunkSize + patternSize);
+    uint64_t windowSize = 0;
+    std::string output;
+    output.reserve(chunkSize + newContent.size());
+
+    uint64_t numberOfMatches = 0;
+    bool endOfFile = false;
+    bool success = true;
+
+    while(endOfFile == false)
+    {
+        // fill the window
+        const ssize_t ret = read(inputFile, &window[windowSize], chunkSize);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            errorMessage = "failed to read file \"" + filePath + "\": " + strerror(errno);
+            success = false;
+            break;
+        }
+        endOfFile = ret == 0;
+        windowSize += static_cast<uint64_t>(ret);
+
+        // matches must fit completely into the window. The others are searched again, when
+        // the window is filled with the next chunk.
+        const char* begin = window.data();
+        const char* windowEnd = begin + windowSize;
+        const char* searchEnd = begin;
+        if(windowSize >= patternSize) {
+            searchEnd = windowEnd - patternSize + 1;
+        }
+
+        // search first byte vectorized and compare the rest only for candidates
+        const char* processed = begin;
+        const char* pos = begin;
+        while(pos < searchEnd)
+        {
+            pos = findNextByte(pos, searchEnd, pattern[0]);
+            if(pos == searchEnd) {
+                break;
+            }
+
+            if(memcmp(pos, pattern, patternSize) == 0)
+            {
+                output.append(processed, static_cast<uint64_t>(pos - processed));
+                output.append(newContent);
+                numberOfMatches++;
+                pos += patternSize;
+                processed = pos;
+            }
+            else
+            {
+                pos++;
+            }
+        }
+
+        // keep the bytes, which could be the begin of a match crossing the chunk-border
+        const char* keepFrom = windowEnd;
+        if(endOfFile == false) {
+            keepFrom = std::max(processed, searchEnd);
+        }
+        output.append(processed, static_cast<uint64_t>(keepFrom - processed));
+
+        const uint64_t keptSize = static_cast<uint64_t>(windowEnd - keepFrom);
+        memmove(window.data(), keepFrom, keptSize);
+        windowSize = keptSize;
+
+        if(output.size() >= chunkSize || endOfFile)
+        {
+            if(writeAll(tempFile.file, output.c_str(), output.size()) == false)
+            {
+                errorMessage = "failed to write temporary file for \"" + filePath + "\": "
+                               + strerror(errno);
+                success = false;
+                break;
+            }
+            output.clear();
+        }
+    }
+
+    close(inputFile);
+
+    // replace the original file only, if something has changed
+    if(success == false
+            || numberOfMatches == 0)
+    {
+        discardTempFile(tempFile);
+        return success;
+    }
+
+    return commitTempFile(tempFile, false, errorMessage);
 }
 
 } // namespace Persistence
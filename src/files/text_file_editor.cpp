@@ -0,0 +1,331 @@
+/**
+ *  @file    text_file_editor.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief collect multiple changes of a text-file and apply them together
+ *
+ *  @detail Line-replacements, inserts, deletes and substring-replacements are only registered
+ *          and applied by the commit in a single pass over the file. The result is written into
+ *          a temporary file, which replaces the original file atomically. Line-numbers always
+ *          refer to the lines of the original file, independent of other registered changes.
+ *          Substring-replacements are applied line by line in the order of registration and
+ *          only to content, which was registered before.
+ */
+
+#include <libKitsunemimiPersistence/files/text_file_editor.h>
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+
+#include "../common/byte_search.h"
+#include "../common/temp_file.h"
+
+#include <errno.h>
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define EDITOR_WRITE_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * @brief constructor
+ *
+ * @param filePath path to the file, which should be edited
+ */
+TextFileEditor::TextFileEditor(const std::string &filePath)
+{
+    m_filePath = filePath;
+}
+
+/**
+ * @brief destructor
+ */
+TextFileEditor::~TextFileEditor() {}
+
+/**
+ * @brief register the replacement of a line
+ *
+ * @param lineNumber number of the line in the original file (beginning with 0)
+ * @param newLineContent new content of the line
+ */
+void
+TextFileEditor::replaceLine(const uint64_t lineNumber,
+                            const std::string &newLineContent)
+{
+    LineContent line;
+    line.changeId = m_nextChangeId++;
+    line.content = newLineContent;
+
+    m_replacedLines[lineNumber] = line;
+    m_deletedLines.erase(lineNumber);
+}
+
+/**
+ * @brief register a new line
+ *
+ * @param lineNumber number of the line in the original file, before which the new line should
+ *                   be inserted. The number of lines of the file appends the new line at the end.
+ * @param newLineContent content of the new line
+ */
+void
+TextFileEditor::insertLine(const uint64_t lineNumber,
+                           const std::string &newLineContent)
+{
+    LineContent line;
+    line.changeId = m_nextChangeId++;
+    line.content = newLineContent;
+
+    m_insertedLines[lineNumber].push_back(line);
+}
+
+/**
+ * @brief register the deletion of a line
+ *
+ * @param lineNumber number of the line in the original file (beginning with 0)
+ */
+void
+TextFileEditor::deleteLine(const uint64_t lineNumber)
+{
+    m_nextChangeId++;
+    m_deletedLines[lineNumber] = true;
+    m_replacedLines.erase(lineNumber);
+}
+
+/**
+ * @brief register the replacement of a substring. It is applied to all lines of the original
+ *        file and to all lines, which were replaced or inserted before this call.
+ *
+ * @param oldContent substring which should be replaced. It must not be empty and must not
+ *                   contain a line-break.
+ * @param newContent new string for the replacement
+ */
+void
+TextFileEditor::replaceContent(const std::string &oldContent,
+                               const std::string &newContent)
+{
+    ContentReplacement replacement;
+    replacement.changeId = m_nextChangeId++;
+    replacement.oldContent = oldContent;
+    replacement.newContent = newContent;
+
+    m_contentReplacements.push_back(replacement);
+}
+
+/**
+ * @brief apply all registered changes to the file and remove them from the editor. The file is
+ *        only changed, if all changes are valid. If only the sync of the directory failed, the
+ *        file is already changed and the changes are removed from the editor anyway.
+ *
+ * @param errorMessage reference for error-message output
+ * @param syncDirectory true to also sync the directory, so the replacement of the file is
+ *                      persistent
+ *
+ * @return true, if successful, else false
+ */
+bool
+TextFileEditor::commit(std::string &errorMessage,
+                       const bool syncDirectory)
+{
+    for(const ContentReplacement &replacement : m_contentReplacements)
+    {
+        if(replacement.oldContent.size() == 0
+                || replacement.oldContent.find('\n') != std::string::npos)
+        {
+            errorMessage = "failed to edit file \"" + m_filePath + "\", because the content to "
+                           "replace \"" + replacement.oldContent + "\" is empty or contains "
+                           "a line-break";
+            return false;
+        }
+    }
+
+    MappedFile file;
+    if(file.openFile(m_filePath, errorMessage, true) == false) {
+        return false;
+    }
+
+    TempFile tempFile;
+    if(openTempFile(tempFile, m_filePath, errorMessage) == false) {
+        return false;
+    }
+
+    const char* pos = reinterpret_cast<const char*>(file.m_data);
+    const char* end = pos + file.m_size;
+    const bool endsWithLineBreak = file.m_size > 0 && *(end - 1) == '\n';
+
+    std::string output;
+    output.reserve(EDITOR_WRITE_BUFFER_SIZE);
+    bool firstLine = true;
+    uint64_t lineNumber = 0;
+
+    while(pos < end)
+    {
+        const char* lineEnd = findNextByte(pos, end, '\n');
+        const std::string_view originalLine(pos, static_cast<uint64_t>(lineEnd - pos));
+
+        const auto inserted = m_insertedLines.find(lineNumber);
+        if(inserted != m_insertedLines.end())
+        {
+            for(const LineContent &line : inserted->second) {
+                appendLine(output, line.content, line.changeId, firstLine);
+            }
+        }
+
+        if(m_deletedLines.find(lineNumber) == m_deletedLines.end())
+        {
+            const auto replaced = m_replacedLines.find(lineNumber);
+            if(replaced != m_replacedLines.end()) {
+                appendLine(output, replaced->second.content, replaced->second.changeId, firstLine);
+            } else {
+                appendLine(output, originalLine, 0, firstLine);
+            }
+        }
+
+        if(output.size() >= EDITOR_WRITE_BUFFER_SIZE)
+        {
+            if(writeAll(tempFile.file, output.c_str(), output.size()) == false)
+            {
+                errorMessage = "failed to write temporary file for \"" + m_filePath + "\": "
+                               + strerror(errno);
+                discardTempFile(tempFile);
+                return false;
+            }
+            output.clear();
+        }
+
+        lineNumber++;
+        pos = lineEnd + 1;
+    }
+
+    // lines, which are appended at the end of the file
+    const auto inserted = m_insertedLines.find(lineNumber);
+    if(inserted != m_insertedLines.end())
+    {
+        for(const LineContent &line : inserted->second) {
+            appendLine(output, line.content, line.changeId, firstLine);
+        }
+    }
+
+    if(endsWithLineBreak
+            && firstLine == false)
+    {
+        output.push_back('\n');
+    }
+
+    // check that all changes are inside of the original file
+    const uint64_t numberOfLines = lineNumber;
+    if((m_replacedLines.size() > 0 && m_replacedLines.rbegin()->first >= numberOfLines)
+            || (m_deletedLines.size() > 0 && m_deletedLines.rbegin()->first >= numberOfLines)
+            || (m_insertedLines.size() > 0 && m_insertedLines.rbegin()->first > numberOfLines))
+    {
+        errorMessage = "failed to edit file \"" + m_filePath + "\", "
+                       "because a linenumber is too big for the file";
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    if(writeAll(tempFile.file, output.c_str(), output.size()) == false)
+    {
+        errorMessage = "failed to write temporary file for \"" + m_filePath + "\": "
+                       + strerror(errno);
+        discardTempFile(tempFile);
+        return false;
+    }
+
+    // the changes are dropped, when the file was already replaced and only the sync of the
+    // directory failed, so they are not applied twice by another commit
+    if(commitTempFile(tempFile, syncDirectory, errorMessage) == false)
+    {
+        if(tempFile.committed) {
+            clear();
+        }
+        return false;
+    }
+
+    clear();
+
+    return true;
+}
+
+/**
+ * @brief remove all registered changes
+ */
+void
+TextFileEditor::clear()
+{
+    m_nextChangeId = 1;
+    m_replacedLines.clear();
+    m_insertedLines.clear();
+    m_deletedLines.clear();
+    m_contentReplacements.clear();
+}
+
+/**
+ * @brief get number of registered changes
+ *
+ * @return number of changes
+ */
+uint64_t
+TextFileEditor::getNumberOfChanges() const
+{
+    return m_nextChangeId - 1;
+}
+
+/**
+ * @brief apply the substring-replacements to a line and append it to the output
+ *
+ * @param output reference for the output
+ * @param line line to append
+ * @param changeId id of the change, which registered the content of the line
+ * @param firstLine reference to the flag, if the line is the first line of the output
+ */
+void
+TextFileEditor::appendLine(std::string &output,
+                           const std::string_view &line,
+                           const uint64_t changeId,
+                           bool &firstLine) const
+{
+    if(firstLine == false) {
+        output.push_back('\n');
+    }
+    firstLine = false;
+
+    std::string_view current = line;
+    std::string replaced;
+    std::string result;
+
+    for(const ContentReplacement &replacement : m_contentReplacements)
+    {
+        // replacement was registered before the content of the line
+        if(replacement.changeId < changeId) {
+            continue;
+        }
+
+        std::string::size_type found = current.find(replacement.oldContent);
+        if(found == std::string::npos) {
+            continue;
+        }
+
+        result.clear();
+        std::string::size_type processed = 0;
+        while(found != std::string::npos)
+        {
+            result.append(current.substr(processed, found - processed));
+            result.append(replacement.newContent);
+            processed = found + replacement.oldContent.size();
+            found = current.find(replacement.oldContent, processed);
+        }
+        result.append(current.substr(processed));
+
+        replaced.swap(result);
+        current = replaced;
+    }
+
+    output.append(current);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
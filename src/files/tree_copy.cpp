@@ -0,0 +1,891 @@
+/**
+ *  @file    tree_copy.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include <libKitsunemimiPersistence/files/tree_copy.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/directory_walker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+// size of the parts, in which the files are copied, to update the progress in between
+static const uint64_t COPY_PART_SIZE = 16 * 1024 * 1024;
+// minimal time between two calls of the progress-callback
+static const std::chrono::milliseconds PROGRESS_INTERVAL(100);
+
+struct CopyTask
+{
+    std::string sourcePath = "";
+    std::string targetPath = "";
+    uint64_t size = 0;
+};
+
+struct CreatedDirectory
+{
+    std::string path = "";
+    uint32_t mode = 0;
+};
+
+struct CopyState
+{
+    std::vector<CopyTask> tasks;
+    std::atomic<uint64_t> nextTask;
+    bool force = true;
+
+    // the first failure of a method disables it for all following files
+    std::atomic<bool> cloneSupported;
+    std::atomic<bool> copyRangeSupported;
+    std::atomic<bool> sendfileSupported;
+
+    std::atomic<bool> abort;
+    std::mutex errorLock;
+    std::string errorMessage = "";
+
+    const CopyProgressCallback* progressCallback = nullptr;
+    std::mutex progressLock;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastReport;
+    uint64_t numberOfFiles = 0;
+    uint64_t numberOfBytes = 0;
+    std::atomic<uint64_t> copiedFiles;
+    std::atomic<uint64_t> copiedBytes;
+
+    CopyState()
+        : nextTask(0),
+          cloneSupported(true),
+          copyRangeSupported(true),
+          sendfileSupported(true),
+          abort(false),
+          copiedFiles(0),
+          copiedBytes(0) {}
+};
+
+/**
+ * @brief remember the first error of the copy and stop all threads
+ *
+ * @param state state of the copy-process
+ * @param errorMessage error-message
+ */
+static void
+setError(CopyState &state,
+         const std::string &errorMessage)
+{
+    std::unique_lock<std::mutex> lock(state.errorLock);
+    if(state.errorMessage.size() == 0) {
+        state.errorMessage = errorMessage;
+    }
+    state.abort = true;
+}
+
+/**
+ * @brief call the progress-callback, if the last call is long enough in the past
+ *
+ * @param state state of the copy-process
+ * @param finished true to call the callback in any case
+ */
+static void
+reportProgress(CopyState &state,
+               const bool finished)
+{
+    if(state.progressCallback == nullptr
+            || *state.progressCallback == nullptr)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(state.progressLock);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(finished == false
+            && now - state.lastReport < PROGRESS_INTERVAL)
+    {
+        return;
+    }
+    state.lastReport = now;
+
+    CopyProgress progress;
+    progress.numberOfFiles = state.numberOfFiles;
+    progress.copiedFiles = state.copiedFiles;
+    progress.numberOfBytes = state.numberOfBytes;
+    progress.copiedBytes = state.copiedBytes;
+
+    const double seconds = std::chrono::duration<double>(now - state.startTime).count();
+    if(seconds > 0.0) {
+        progress.bytesPerSecond = static_cast<double>(progress.copiedBytes) / seconds;
+    }
+
+    (*state.progressCallback)(progress);
+}
+
+/**
+ * @brief check if an error of a copy-method means, that the method is not possible for the files
+ *
+ * @param error errno of the failed call
+ *
+ * @return true, if another method should be used
+ */
+static bool
+isUnsupported(const int error)
+{
+    return error == EXDEV
+           || error == ENOSYS
+           || error == EINVAL
+           || error == EOPNOTSUPP
+           || error == ENOTTY;
+}
+
+/**
+ * @brief copy a range of a file
+ *
+ * @param state state of the copy-process
+ * @param sourceDescriptor descriptor of the source-file
+ * @param targetDescriptor descriptor of the target-file
+ * @param start start of the range
+ * @param end end of the range
+ * @param buffer buffer for the copy over the user-space
+ * @param copiedBytes reference, where the number of copied bytes is added
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if copy failed, else true
+ */
+static bool
+copyRange(CopyState &state,
+          const int sourceDescriptor,
+          const int targetDescriptor,
+          const uint64_t start,
+          const uint64_t end,
+          std::vector<uint8_t> &buffer,
+          uint64_t &copiedBytes,
+          std::string &errorMessage)
+{
+    uint64_t offset = start;
+    while(offset < end
+          && state.abort == false)
+    {
+        const uint64_t partSize = std::min(end - offset, COPY_PART_SIZE);
+        ssize_t copied = -1;
+        errno = 0;
+
+        // in-kernel copy between two files, which is offloaded by some filesystems
+        if(state.copyRangeSupported)
+        {
+            loff_t sourceOffset = static_cast<loff_t>(offset);
+            loff_t targetOffset = static_cast<loff_t>(offset);
+            copied = copy_file_range(sourceDescriptor,
+                                     &sourceOffset,
+                                     targetDescriptor,
+                                     &targetOffset,
+                                     partSize,
+                                     0);
+            if(copied < 0
+                    && isUnsupported(errno))
+            {
+                state.copyRangeSupported = false;
+            }
+        }
+
+        // in-kernel copy, which writes at the position of the target-descriptor
+        if(copied < 0
+                && (errno == 0 || isUnsupported(errno))
+                && state.sendfileSupported)
+        {
+            off_t sourceOffset = static_cast<off_t>(offset);
+            if(lseek(targetDescriptor, static_cast<off_t>(offset), SEEK_SET) >= 0)
+            {
+                copied = sendfile(targetDescriptor, sourceDescriptor, &sourceOffset, partSize);
+                if(copied < 0
+                        && isUnsupported(errno))
+                {
+                    state.sendfileSupported = false;
+                }
+            }
+        }
+
+        // copy over the user-space as last option
+        if(copied < 0
+                && (errno == 0 || isUnsupported(errno)))
+        {
+            const uint64_t readSize = std::min(partSize, static_cast<uint64_t>(buffer.size()));
+            copied = pread(sourceDescriptor, buffer.data(), readSize, static_cast<off_t>(offset));
+            if(copied > 0)
+            {
+                uint64_t written = 0;
+                while(written < static_cast<uint64_t>(copied))
+                {
+                    const ssize_t ret = pwrite(targetDescriptor,
+                                               &buffer[written],
+                                               static_cast<uint64_t>(copied) - written,
+                                               static_cast<off_t>(offset + written));
+                    if(ret < 0)
+                    {
+                        if(errno == EINTR) {
+                            continue;
+                        }
+                        copied = -1;
+                        break;
+                    }
+                    written += static_cast<uint64_t>(ret);
+                }
+            }
+        }
+
+        if(copied < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            errorMessage = strerror(errno);
+            return false;
+        }
+
+        // source-file was truncated while copying
+        if(copied == 0)
+        {
+            if(ftruncate(targetDescriptor, static_cast<off_t>(offset)) != 0)
+            {
+                errorMessage = strerror(errno);
+                return false;
+            }
+            return true;
+        }
+
+        offset += static_cast<uint64_t>(copied);
+        copiedBytes += static_cast<uint64_t>(copied);
+        state.copiedBytes += static_cast<uint64_t>(copied);
+        reportProgress(state, false);
+    }
+
+    return true;
+}
+
+/**
+ * @brief copy the content of a file into another file
+ *
+ * @param state state of the copy-process
+ * @param sourceDescriptor descriptor of the source-file
+ * @param targetDescriptor descriptor of the empty target-file
+ * @param sourceStat metadata of the source-file
+ * @param buffer buffer for the copy over the user-space
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if copy failed, else true
+ */
+static bool
+copyContent(CopyState &state,
+            const int sourceDescriptor,
+            const int targetDescriptor,
+            const struct stat &sourceStat,
+            std::vector<uint8_t> &buffer,
+            std::string &errorMessage)
+{
+    const uint64_t size = static_cast<uint64_t>(sourceStat.st_size);
+
+    // reflink, which shares the data-blocks of both files until one of them is changed
+    if(state.cloneSupported
+            && size > 0)
+    {
+        if(ioctl(targetDescriptor, FICLONE, sourceDescriptor) == 0)
+        {
+            state.copiedBytes += size;
+            reportProgress(state, false);
+            return true;
+        }
+
+        if(isUnsupported(errno)) {
+            state.cloneSupported = false;
+        }
+    }
+
+    // set the size at first, so all not written ranges stay holes
+    if(ftruncate(targetDescriptor, static_cast<off_t>(size)) != 0)
+    {
+        errorMessage = strerror(errno);
+        return false;
+    }
+
+    uint64_t copiedBytes = 0;
+    const bool isSparse = static_cast<uint64_t>(sourceStat.st_blocks) * 512 < size;
+
+    if(isSparse)
+    {
+        // copy only the data-ranges between the holes
+        uint64_t position = 0;
+        while(position < size)
+        {
+            const off_t dataStart = lseek(sourceDescriptor,
+                                          static_cast<off_t>(position),
+                                          SEEK_DATA);
+            if(dataStart < 0)
+            {
+                // no more data behind the position
+                if(errno == ENXIO) {
+                    break;
+                }
+
+                // filesystem doesn't support the search for holes
+                if(copyRange(state,
+                             sourceDescriptor,
+                             targetDescriptor,
+                             position,
+                             size,
+                             buffer,
+                             copiedBytes,
+                             errorMessage) == false)
+                {
+                    return false;
+                }
+                break;
+            }
+
+            off_t dataEnd = lseek(sourceDescriptor, dataStart, SEEK_HOLE);
+            if(dataEnd < 0) {
+                dataEnd = static_cast<off_t>(size);
+            }
+
+            if(copyRange(state,
+                         sourceDescriptor,
+                         targetDescriptor,
+                         static_cast<uint64_t>(dataStart),
+                         std::min(static_cast<uint64_t>(dataEnd), size),
+                         buffer,
+                         copiedBytes,
+                         errorMessage) == false)
+            {
+                return false;
+            }
+            position = static_cast<uint64_t>(dataEnd);
+        }
+    }
+    else
+    {
+        if(copyRange(state,
+                     sourceDescriptor,
+                     targetDescriptor,
+                     0,
+                     size,
+                     buffer,
+                     copiedBytes,
+                     errorMessage) == false)
+        {
+            return false;
+        }
+    }
+
+    // skipped holes count as copied for the progress
+    if(copiedBytes < size) {
+        state.copiedBytes += size - copiedBytes;
+    }
+
+    return true;
+}
+
+/**
+ * @brief open the target-file for the copy
+ *
+ * @param state state of the copy-process
+ * @param targetPath path of the target-file
+ * @param mode mode of the new file
+ *
+ * @return file-descriptor or -1, if failed
+ */
+static int
+openTargetFile(CopyState &state,
+               const std::string &targetPath,
+               const mode_t mode)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC;
+    if(state.force == false) {
+        flags |= O_EXCL;
+    }
+
+    int descriptor = open(targetPath.c_str(), flags, mode);
+
+    // existing directories or symbolic links at the target-location are replaced
+    if(descriptor < 0
+            && state.force
+            && (errno == EISDIR || errno == ELOOP))
+    {
+        std::string errorMessage = "";
+        if(deleteFileOrDir(targetPath, errorMessage)) {
+            descriptor = open(targetPath.c_str(), flags, mode);
+        }
+    }
+
+    return descriptor;
+}
+
+/**
+ * @brief copy a single file
+ *
+ * @param state state of the copy-process
+ * @param task file to copy
+ * @param buffer buffer for the copy over the user-space
+ *
+ * @return false, if copy failed, else true
+ */
+static bool
+copyFile(CopyState &state,
+         const CopyTask &task,
+         std::vector<uint8_t> &buffer)
+{
+    const int sourceDescriptor = open(task.sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(sourceDescriptor < 0)
+    {
+        setError(state, "failed to open file \"" + task.sourcePath + "\": " + strerror(errno));
+        return false;
+    }
+
+    struct stat sourceStat;
+    if(fstat(sourceDescriptor, &sourceStat) != 0)
+    {
+        setError(state, "failed to read file \"" + task.sourcePath + "\": " + strerror(errno));
+        close(sourceDescriptor);
+        return false;
+    }
+
+    const mode_t mode = sourceStat.st_mode & 07777;
+    const int targetDescriptor = openTargetFile(state, task.targetPath, mode);
+    if(targetDescriptor < 0)
+    {
+        setError(state, "failed to create file \"" + task.targetPath + "\": " + strerror(errno));
+        close(sourceDescriptor);
+        return false;
+    }
+
+    std::string errorMessage = "";
+    bool result = copyContent(state,
+                              sourceDescriptor,
+                              targetDescriptor,
+                              sourceStat,
+                              buffer,
+                              errorMessage);
+
+    // the mode of overwritten files has to be updated and umask has to be ignored
+    if(result
+            && fchmod(targetDescriptor, mode) != 0)
+    {
+        errorMessage = strerror(errno);
+        result = false;
+    }
+
+    close(sourceDescriptor);
+    close(targetDescriptor);
+
+    if(result == false)
+    {
+        setError(state, "failed to copy file \"" + task.sourcePath
+                        + "\" to \"" + task.targetPath + "\": " + errorMessage);
+        return false;
+    }
+
+    state.copiedFiles++;
+    reportProgress(state, false);
+
+    return true;
+}
+
+/**
+ * @brief copy files, until all files are copied or the copy was aborted
+ *
+ * @param state state of the copy-process
+ */
+static void
+runCopyWorker(CopyState &state)
+{
+    std::vector<uint8_t> buffer(1024 * 1024);
+
+    while(state.abort == false)
+    {
+        const uint64_t taskId = state.nextTask++;
+        if(taskId >= state.tasks.size()) {
+            return;
+        }
+
+        copyFile(state, state.tasks[taskId], buffer);
+    }
+}
+
+/**
+ * @brief create a directory of the target-tree
+ *
+ * @param state state of the copy-process
+ * @param path path of the new directory
+ *
+ * @return false, if the directory could not be created, else true
+ */
+static bool
+createTargetDirectory(CopyState &state,
+                      const std::string &path)
+{
+    // created with write-permissions, so read-only directories can be filled, and the real mode
+    // is set after all files are copied
+    if(mkdir(path.c_str(), 0700) == 0) {
+        return true;
+    }
+
+    if(errno != EEXIST)
+    {
+        setError(state, "failed to create directory \"" + path + "\": " + strerror(errno));
+        return false;
+    }
+
+    struct stat targetStat;
+    if(lstat(path.c_str(), &targetStat) == 0
+            && S_ISDIR(targetStat.st_mode))
+    {
+        return true;
+    }
+
+    // replace other entries at the target-location
+    std::string errorMessage = "";
+    if(state.force == false
+            || deleteFileOrDir(path, errorMessage) == false
+            || mkdir(path.c_str(), 0700) != 0)
+    {
+        setError(state, "failed to create directory \"" + path + "\": target already exist");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief create a symbolic link of the target-tree
+ *
+ * @param state state of the copy-process
+ * @param sourcePath path of the symbolic link in the source-tree
+ * @param path path of the new symbolic link
+ *
+ * @return false, if the link could not be created, else true
+ */
+static bool
+createTargetLink(CopyState &state,
+                 const std::string &sourcePath,
+                 const std::string &path)
+{
+    std::vector<char> linkTarget(4096);
+    const ssize_t linkSize = readlink(sourcePath.c_str(), linkTarget.data(), linkTarget.size());
+    if(linkSize < 0
+            || static_cast<uint64_t>(linkSize) >= linkTarget.size())
+    {
+        setError(state, "failed to read symbolic link \"" + sourcePath + "\"");
+        return false;
+    }
+    linkTarget[static_cast<uint64_t>(linkSize)] = '\0';
+
+    if(symlink(linkTarget.data(), path.c_str()) == 0) {
+        return true;
+    }
+
+    std::string errorMessage = "";
+    if(errno != EEXIST
+            || state.force == false
+            || deleteFileOrDir(path, errorMessage) == false
+            || symlink(linkTarget.data(), path.c_str()) != 0)
+    {
+        setError(state, "failed to create symbolic link \"" + path + "\": " + strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief check if the target is the source itself or inside of the source-directory. Both paths
+ *        are compared in their canonical form, so relative paths, "..", or symbolic links within
+ *        the paths can not hide an overlap.
+ *
+ * @param source path of the source
+ * @param sourceStat metadata of the source, which was read without following symbolic links
+ * @param target path of the target
+ *
+ * @return true, if the target is the source or inside of it, else false
+ */
+static bool
+isInsideOfSource(const std::string &source,
+                 const struct stat &sourceStat,
+                 const std::string &target)
+{
+    boost::system::error_code error;
+
+    // a symbolic link is copied as link, so only its own path is relevant
+    std::string canonicalSource = source;
+    if(S_ISLNK(sourceStat.st_mode))
+    {
+        const bfs::path sourcePath(source);
+        const bfs::path parentPath = bfs::weakly_canonical(bfs::absolute(sourcePath.parent_path()),
+                                                           error);
+        if(error.failed() == false) {
+            canonicalSource = (parentPath / sourcePath.filename()).string();
+        }
+    }
+    else
+    {
+        const bfs::path sourcePath = bfs::weakly_canonical(bfs::absolute(source), error);
+        if(error.failed() == false) {
+            canonicalSource = sourcePath.string();
+        }
+    }
+
+    std::string canonicalTarget = target;
+    const bfs::path targetPath = bfs::weakly_canonical(bfs::absolute(target), error);
+    if(error.failed() == false) {
+        canonicalTarget = targetPath.string();
+    }
+
+    if(canonicalTarget == canonicalSource) {
+        return true;
+    }
+
+    if(S_ISDIR(sourceStat.st_mode) == false) {
+        return false;
+    }
+
+    std::string prefix = canonicalSource;
+    if(prefix.back() != '/') {
+        prefix += "/";
+    }
+
+    return canonicalTarget.compare(0, prefix.size(), prefix) == 0;
+}
+
+/**
+ * @brief copy a file or directory-tree in parallel. Files are cloned or copied inside of the
+ *        kernel, if possible, and holes of sparse files are preserved. The permissions of files
+ *        and directories are copied, symbolic links are copied as links.
+ *
+ * @param sourcePath path of the file or directory to copy
+ * @param targetPath path of the copy
+ * @param errorMessage reference for error-message output
+ * @param force true to overwrite existing files at the target-location. Existing directories
+ *              are merged with the source-tree. (Default: true)
+ * @param progressCallback optional callback for the progress of the copy. It is called by the
+ *                         copying threads, but never at the same time, and always once at the end.
+ * @param numberOfThreads number of threads (Default: 0 to use one thread per cpu-core)
+ *
+ * @return false, if copy failed, else true
+ */
+bool
+copyTree(const std::string &sourcePath,
+         const std::string &targetPath,
+         std::string &errorMessage,
+         const bool force,
+         const CopyProgressCallback &progressCallback,
+         const uint32_t numberOfThreads)
+{
+    // remove tailing slashes like the directory-walker
+    std::string source = sourcePath;
+    while(source.size() > 1
+          && source.back() == '/')
+    {
+        source.pop_back();
+    }
+    std::string target = targetPath;
+    while(target.size() > 1
+          && target.back() == '/')
+    {
+        target.pop_back();
+    }
+
+    struct stat sourceStat;
+    if(lstat(source.c_str(), &sourceStat) != 0)
+    {
+        errorMessage = "source-path " + source + " doesn't exist.";
+        return false;
+    }
+
+    struct stat targetStat;
+    if(force == false
+            && lstat(target.c_str(), &targetStat) == 0)
+    {
+        errorMessage = "target-path " + target + " already exist.";
+        return false;
+    }
+
+    if(isInsideOfSource(source, sourceStat, target))
+    {
+        errorMessage = "target-path " + target + " is inside of the source-path " + source;
+        return false;
+    }
+
+    CopyState state;
+    state.force = force;
+    state.progressCallback = &progressCallback;
+    state.startTime = std::chrono::steady_clock::now();
+    state.lastReport = state.startTime;
+
+    DirectoryWalker walker(numberOfThreads);
+    std::vector<CreatedDirectory> directories;
+
+    if(S_ISDIR(sourceStat.st_mode))
+    {
+        if(createTargetDirectory(state, target) == false)
+        {
+            errorMessage = state.errorMessage;
+            return false;
+        }
+
+        CreatedDirectory root;
+        root.path = target;
+        root.mode = sourceStat.st_mode & 07777;
+        directories.push_back(root);
+
+        // each thread collects its files and directories in its own lists
+        std::vector<std::vector<CopyTask>> threadTasks(walker.getNumberOfThreads());
+        std::vector<std::vector<CreatedDirectory>> threadDirectories(walker.getNumberOfThreads());
+        const uint64_t rootLength = source == "/" ? 0 : source.size();
+
+        auto processEntry = [&](FileEntry &entry)
+        {
+            std::string entryTarget = target;
+            entryTarget.append(entry.m_directoryPath.substr(rootLength));
+            entryTarget.push_back('/');
+            entryTarget.append(entry.m_name);
+
+            uint32_t mode = 0;
+            if(entry.getMode(mode) == false)
+            {
+                setError(state, "failed to read \"" + entry.getPath() + "\"");
+                return STOP_WALK;
+            }
+
+            if(S_ISDIR(mode))
+            {
+                // the directory is created, before the walker reads its content
+                if(createTargetDirectory(state, entryTarget) == false) {
+                    return STOP_WALK;
+                }
+
+                CreatedDirectory directory;
+                directory.path = entryTarget;
+                directory.mode = mode & 07777;
+                threadDirectories[entry.m_threadId].push_back(directory);
+            }
+            else if(S_ISREG(mode))
+            {
+                CopyTask task;
+                task.sourcePath = entry.getPath();
+                task.targetPath = entryTarget;
+                entry.getSize(task.size);
+                threadTasks[entry.m_threadId].push_back(task);
+            }
+            else if(S_ISLNK(mode))
+            {
+                if(createTargetLink(state, entry.getPath(), entryTarget) == false) {
+                    return STOP_WALK;
+                }
+            }
+            else
+            {
+                setError(state, "can not copy special file \"" + entry.getPath() + "\"");
+                return STOP_WALK;
+            }
+
+            return CONTINUE_WALK;
+        };
+
+        std::string walkError = "";
+        if(walker.walk(source, processEntry, walkError) == false) {
+            setError(state, walkError);
+        }
+
+        for(uint32_t i = 0; i < walker.getNumberOfThreads(); i++)
+        {
+            state.tasks.insert(state.tasks.end(),
+                               std::make_move_iterator(threadTasks[i].begin()),
+                               std::make_move_iterator(threadTasks[i].end()));
+            directories.insert(directories.end(),
+                               std::make_move_iterator(threadDirectories[i].begin()),
+                               std::make_move_iterator(threadDirectories[i].end()));
+        }
+    }
+    else if(S_ISREG(sourceStat.st_mode))
+    {
+        CopyTask task;
+        task.sourcePath = source;
+        task.targetPath = target;
+        task.size = static_cast<uint64_t>(sourceStat.st_size);
+        state.tasks.push_back(task);
+    }
+    else if(S_ISLNK(sourceStat.st_mode))
+    {
+        createTargetLink(state, source, target);
+    }
+    else
+    {
+        errorMessage = "can not copy special file \"" + source + "\"";
+        return false;
+    }
+
+    // copy the biggest files at first, so the threads have a similar workload at the end
+    std::sort(state.tasks.begin(),
+              state.tasks.end(),
+              [](const CopyTask &a, const CopyTask &b) { return a.size > b.size; });
+
+    state.numberOfFiles = state.tasks.size();
+    for(const CopyTask &task : state.tasks) {
+        state.numberOfBytes += task.size;
+    }
+
+    if(state.abort == false)
+    {
+        const uint64_t threadCount = std::min(static_cast<uint64_t>(walker.getNumberOfThreads()),
+                                              static_cast<uint64_t>(state.tasks.size()));
+        std::vector<std::thread> threads;
+        for(uint64_t i = 1; i < threadCount; i++) {
+            threads.push_back(std::thread(runCopyWorker, std::ref(state)));
+        }
+
+        runCopyWorker(state);
+
+        for(std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // set the real modes of the directories, after all of their content was created
+    for(const CreatedDirectory &directory : directories)
+    {
+        if(chmod(directory.path.c_str(), directory.mode) != 0)
+        {
+            setError(state, "failed to set mode of directory \""
+                            + directory.path + "\": " + strerror(errno));
+        }
+    }
+
+    reportProgress(state, true);
+
+    if(state.errorMessage.size() > 0)
+    {
+        errorMessage = state.errorMessage;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
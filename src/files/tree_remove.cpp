@@ -0,0 +1,456 @@
+/**
+ *  @file    tree_remove.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include <libKitsunemimiPersistence/files/tree_remove.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/directory_walker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+// minimal number of directories of a level, to remove them with multiple threads
+static const uint64_t PARALLEL_LEVEL_SIZE = 64;
+
+struct FoundDirectory
+{
+    std::string path = "";
+    uint32_t depth = 0;
+};
+
+/**
+ * @brief remember the first error of the deletion
+ *
+ * @param errorLock lock for the error-message
+ * @param errorMessage reference for the first error-message
+ * @param newError new error-message
+ */
+static void
+addError(std::mutex &errorLock,
+         std::string &errorMessage,
+         const std::string &newError)
+{
+    std::unique_lock<std::mutex> lock(errorLock);
+    if(errorMessage.size() == 0) {
+        errorMessage = newError;
+    }
+}
+
+/**
+ * @brief remove empty directories of the same depth
+ *
+ * @param directories list with all found directories, sorted by depth
+ * @param start index of the first directory of the level
+ * @param end index behind the last directory of the level
+ * @param numberOfThreads maximal number of threads
+ * @param errorLock lock for the error-message
+ * @param errorMessage reference for error-message output
+ */
+static void
+removeLevel(const std::vector<FoundDirectory> &directories,
+            const uint64_t start,
+            const uint64_t end,
+            const uint32_t numberOfThreads,
+            std::mutex &errorLock,
+            std::string &errorMessage)
+{
+    std::atomic<uint64_t> nextDirectory(start);
+
+    auto removeDirectories = [&]()
+    {
+        while(true)
+        {
+            const uint64_t index = nextDirectory++;
+            if(index >= end) {
+                return;
+            }
+
+            const std::string &path = directories[index].path;
+            if(rmdir(path.c_str()) != 0
+                    && errno != ENOENT)
+            {
+                addError(errorLock,
+                         errorMessage,
+                         "failed to remove directory \"" + path + "\": " + strerror(errno));
+            }
+        }
+    };
+
+    // most levels are too small to be worth the threads
+    uint64_t threadCount = 1;
+    if(end - start >= PARALLEL_LEVEL_SIZE) {
+        threadCount = std::min(static_cast<uint64_t>(numberOfThreads), end - start);
+    }
+
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < threadCount; i++) {
+        threads.push_back(std::thread(removeDirectories));
+    }
+
+    removeDirectories();
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief delete a file or a directory-tree in parallel. Symbolic links are removed, but not
+ *        followed.
+ *
+ * @param path path to delete
+ * @param errorMessage reference for error-message output
+ * @param numberOfThreads number of threads (Default: 0 to use one thread per cpu-core)
+ *
+ * @return false, if any file or directory could not be removed, else true. Also return true,
+ *         if the path doesn't exist.
+ */
+bool
+removeTree(const std::string &path,
+           std::string &errorMessage,
+           const uint32_t numberOfThreads)
+{
+    std::string rootPath = path;
+    while(rootPath.size() > 1
+          && rootPath.back() == '/')
+    {
+        rootPath.pop_back();
+    }
+
+    struct stat rootStat;
+    if(lstat(rootPath.c_str(), &rootStat) != 0)
+    {
+        if(errno == ENOENT) {
+            return true;
+        }
+
+        errorMessage = "failed to read \"" + rootPath + "\": " + strerror(errno);
+        return false;
+    }
+
+    if(S_ISDIR(rootStat.st_mode) == false)
+    {
+        if(unlink(rootPath.c_str()) != 0
+                && errno != ENOENT)
+        {
+            errorMessage = "failed to remove \"" + rootPath + "\": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    DirectoryWalker walker(numberOfThreads);
+    std::vector<std::vector<FoundDirectory>> threadDirectories(walker.getNumberOfThreads());
+    std::mutex errorLock;
+    std::string removeError = "";
+
+    // files are unlinked relative to their directory, while the directory is read, and the
+    // directories are only collected
+    auto processEntry = [&](FileEntry &entry)
+    {
+        if(entry.m_type != DIRECTORY_ENTRY)
+        {
+            // the name is a view on the null-terminated name of the directory-entry
+            if(unlinkat(entry.m_directoryDescriptor, entry.m_name.data(), 0) == 0
+                    || errno == ENOENT)
+            {
+                return CONTINUE_WALK;
+            }
+
+            if(errno != EISDIR)
+            {
+                addError(errorLock,
+                         removeError,
+                         "failed to remove \"" + entry.getPath() + "\": " + strerror(errno));
+                return CONTINUE_WALK;
+            }
+
+            // the type of the entry was unknown, so the walker has to enter the directory
+            entry.m_type = DIRECTORY_ENTRY;
+        }
+
+        FoundDirectory directory;
+        directory.path = entry.getPath();
+        directory.depth = static_cast<uint32_t>(std::count(directory.path.begin(),
+                                                           directory.path.end(),
+                                                           '/'));
+        threadDirectories[entry.m_threadId].push_back(directory);
+
+        return CONTINUE_WALK;
+    };
+
+    std::string walkError = "";
+    if(walker.walk(rootPath, processEntry, walkError) == false) {
+        addError(errorLock, removeError, walkError);
+    }
+
+    // remove the directories beginning with the deepest level
+    std::vector<FoundDirectory> directories;
+    for(std::vector<FoundDirectory> &threadList : threadDirectories)
+    {
+        directories.insert(directories.end(),
+                           std::make_move_iterator(threadList.begin()),
+                           std::make_move_iterator(threadList.end()));
+    }
+    std::sort(directories.begin(),
+              directories.end(),
+              [](const FoundDirectory &a, const FoundDirectory &b) { return a.depth > b.depth; });
+
+    uint64_t levelStart = 0;
+    while(levelStart < directories.size())
+    {
+        uint64_t levelEnd = levelStart;
+        while(levelEnd < directories.size()
+              && directories[levelEnd].depth == directories[levelStart].depth)
+        {
+            levelEnd++;
+        }
+
+        removeLevel(directories,
+                    levelStart,
+                    levelEnd,
+                    walker.getNumberOfThreads(),
+                    errorLock,
+                    removeError);
+        levelStart = levelEnd;
+    }
+
+    if(rmdir(rootPath.c_str()) != 0
+            && errno != ENOENT)
+    {
+        addError(errorLock,
+                 removeError,
+                 "failed to remove directory \"" + rootPath + "\": " + strerror(errno));
+    }
+
+    if(removeError.size() > 0)
+    {
+        errorMessage = removeError;
+        return false;
+    }
+
+    return true;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param numberOfThreads number of threads for each deletion (0 to use one thread per cpu-core)
+ */
+TreeRemover::TreeRemover(const uint32_t numberOfThreads)
+{
+    m_numberOfThreads = numberOfThreads;
+}
+
+/**
+ * @brief destructor, which waits until all pending trees are deleted
+ */
+TreeRemover::~TreeRemover()
+{
+    if(m_removeThread != nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> threadGuard(m_threadLock);
+            m_stopThread = true;
+        }
+        m_threadCondition.notify_all();
+        m_removeThread->join();
+        delete m_removeThread;
+        m_removeThread = nullptr;
+    }
+}
+
+/**
+ * @brief create the trash-directory and start the background-thread. Entries, which are still in
+ *        the trash, for example after a crash, are deleted too.
+ *
+ * @param trashPath path of the trash-directory. It must be on the same filesystem like the paths,
+ *                  which should be deleted.
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if already initialized or the trash-directory could not be created, else true
+ */
+bool
+TreeRemover::initTrash(const std::string &trashPath,
+                       std::string &errorMessage)
+{
+    if(m_removeThread != nullptr)
+    {
+        errorMessage = "trash is already initialized";
+        return false;
+    }
+
+    // the trash can already exist from a previous run
+    struct stat trashStat;
+    if(stat(trashPath.c_str(), &trashStat) == 0)
+    {
+        if(S_ISDIR(trashStat.st_mode) == false)
+        {
+            errorMessage = "trash-path " + trashPath + " is not a directory";
+            return false;
+        }
+    }
+    else if(createDirectory(trashPath, errorMessage) == false)
+    {
+        return false;
+    }
+
+    // old entries of the trash
+    std::vector<std::string> leftovers;
+    auto collectEntry = [&](FileEntry &entry)
+    {
+        leftovers.push_back(entry.getPath());
+        return SKIP_DIRECTORY;
+    };
+    if(iterateFiles(trashPath, collectEntry, errorMessage, false, 1) == false) {
+        return false;
+    }
+
+    m_trashPath = trashPath;
+    m_pendingPaths.insert(m_pendingPaths.end(), leftovers.begin(), leftovers.end());
+    m_stopThread = false;
+    m_removeThread = new std::thread(&TreeRemover::runRemoveThread, this);
+
+    return true;
+}
+
+/**
+ * @brief move a file or directory-tree into the trash and delete it in the background. If the
+ *        path is on another filesystem than the trash, it is deleted directly.
+ *
+ * @param path path to delete
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the path could not be moved into the trash or the direct deletion failed,
+ *         else true. Also return true, if the path doesn't exist.
+ */
+bool
+TreeRemover::removeAsync(const std::string &path,
+                         std::string &errorMessage)
+{
+    if(m_removeThread == nullptr)
+    {
+        errorMessage = "trash is not initialized";
+        return false;
+    }
+
+    // unique name within the trash
+    std::string trashEntry = "";
+    {
+        std::lock_guard<std::mutex> threadGuard(m_threadLock);
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        trashEntry = m_trashPath + "/" + std::to_string(now)
+                     + "-" + std::to_string(getpid())
+                     + "-" + std::to_string(m_entryCounter++);
+    }
+
+    if(rename(path.c_str(), trashEntry.c_str()) != 0)
+    {
+        if(errno == ENOENT) {
+            return true;
+        }
+
+        // a rename between two filesystems is not possible
+        if(errno == EXDEV) {
+            return removeTree(path, errorMessage, m_numberOfThreads);
+        }
+
+        errorMessage = "failed to move \"" + path + "\" into the trash: " + strerror(errno);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> threadGuard(m_threadLock);
+        m_pendingPaths.push_back(trashEntry);
+    }
+    m_threadCondition.notify_all();
+
+    return true;
+}
+
+/**
+ * @brief wait until all trees of the trash are deleted
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if any deletion failed since the last call, else true
+ */
+bool
+TreeRemover::waitUntilEmpty(std::string &errorMessage)
+{
+    std::unique_lock<std::mutex> threadGuard(m_threadLock);
+    m_emptyCondition.wait(threadGuard, [this] {
+        return m_pendingPaths.size() == 0 && m_isRemoving == false;
+    });
+
+    if(m_errorMessage.size() > 0)
+    {
+        errorMessage = m_errorMessage;
+        m_errorMessage = "";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief delete the trees of the trash, until the remover is destroyed and the trash is empty
+ */
+void
+TreeRemover::runRemoveThread()
+{
+    while(true)
+    {
+        std::string path = "";
+        {
+            std::unique_lock<std::mutex> threadGuard(m_threadLock);
+            m_threadCondition.wait(threadGuard, [this] {
+                return m_stopThread || m_pendingPaths.size() > 0;
+            });
+            if(m_pendingPaths.size() == 0) {
+                return;
+            }
+
+            path = m_pendingPaths.front();
+            m_pendingPaths.pop_front();
+            m_isRemoving = true;
+        }
+
+        std::string errorMessage = "";
+        const bool result = removeTree(path, errorMessage, m_numberOfThreads);
+
+        {
+            std::lock_guard<std::mutex> threadGuard(m_threadLock);
+            if(result == false
+                    && m_errorMessage.size() == 0)
+            {
+                m_errorMessage = errorMessage;
+            }
+            m_isRemoving = false;
+        }
+        m_emptyCondition.notify_all();
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
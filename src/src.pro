@@ -2,7 +2,7 @@ QT       -= qt core gui
 
 TARGET = KitsunemimiPersistence
 TEMPLATE = lib
-CONFIG += c++14
+CONFIG += c++17
 VERSION = 0.10.2
 
 LIBS += -L../../libKitsunemimiCommon/src -lKitsunemimiCommon
@@ -10,12 +10,17 @@ LIBS += -L../../libKitsunemimiCommon/src/debug -lKitsunemimiCommon
 LIBS += -L../../libKitsunemimiCommon/src/release -lKitsunemimiCommon
 INCLUDEPATH += ../../libKitsunemimiCommon/include
 
-LIBS +=  -lboost_filesystem -lboost_system
+LIBS +=  -lboost_filesystem -lboost_system -lpthread -lz
 
 with_sqlite {
     LIBS += -lsqlite3
 }
 
+with_zstd {
+    DEFINES += WITH_ZSTD
+    LIBS += -lzstd
+}
+
 INCLUDEPATH += $$PWD \
                $$PWD/../include
 
@@ -23,7 +28,34 @@ SOURCES += \
     files/binary_file.cpp \
     files/text_file.cpp \
     logger/logger.cpp \
-    files/file_methods.cpp
+    files/file_methods.cpp \
+    common/checksum.cpp \
+    storage/record_log.cpp \
+    common/file_buffer.cpp \
+    storage/key_value_store.cpp \
+    storage/b_plus_tree.cpp \
+    storage/persistent_queue.cpp \
+    common/hash.cpp \
+    storage/chunk_store.cpp \
+    files/mapped_file.cpp \
+    common/byte_search.cpp \
+    files/line_reader.cpp \
+    files/text_chunk_processor.cpp \
+    files/line_index.cpp \
+    files/append_writer.cpp \
+    common/temp_file.cpp \
+    files/text_file_editor.cpp \
+    files/file_cache.cpp \
+    files/file_follower.cpp \
+    files/compressed_file.cpp \
+    common/decompressor.cpp \
+    files/delimited_file_reader.cpp \
+    common/directory_walker.cpp \
+    files/file_filter.cpp \
+    files/tree_copy.cpp \
+    files/tree_remove.cpp \
+    files/change_tracker.cpp \
+    files/file_fingerprint.cpp
 
 with_sqlite {
     SOURCES += database/sqlite.cpp
@@ -33,7 +65,34 @@ HEADERS += \
     ../include/libKitsunemimiPersistence/files/binary_file.h \
     ../include/libKitsunemimiPersistence/files/text_file.h \
     ../include/libKitsunemimiPersistence/logger/logger.h \
-    ../include/libKitsunemimiPersistence/files/file_methods.h
+    ../include/libKitsunemimiPersistence/files/file_methods.h \
+    common/checksum.h \
+    ../include/libKitsunemimiPersistence/storage/record_log.h \
+    common/file_buffer.h \
+    ../include/libKitsunemimiPersistence/storage/key_value_store.h \
+    ../include/libKitsunemimiPersistence/storage/b_plus_tree.h \
+    ../include/libKitsunemimiPersistence/storage/persistent_queue.h \
+    common/hash.h \
+    ../include/libKitsunemimiPersistence/storage/chunk_store.h \
+    ../include/libKitsunemimiPersistence/files/mapped_file.h \
+    common/byte_search.h \
+    ../include/libKitsunemimiPersistence/files/line_reader.h \
+    ../include/libKitsunemimiPersistence/files/text_chunk_processor.h \
+    ../include/libKitsunemimiPersistence/files/line_index.h \
+    ../include/libKitsunemimiPersistence/files/append_writer.h \
+    common/temp_file.h \
+    ../include/libKitsunemimiPersistence/files/text_file_editor.h \
+    ../include/libKitsunemimiPersistence/files/file_cache.h \
+    ../include/libKitsunemimiPersistence/files/file_follower.h \
+    ../include/libKitsunemimiPersistence/files/compressed_file.h \
+    common/decompressor.h \
+    ../include/libKitsunemimiPersistence/files/delimited_file_reader.h \
+    common/directory_walker.h \
+    ../include/libKitsunemimiPersistence/files/file_filter.h \
+    ../include/libKitsunemimiPersistence/files/tree_copy.h \
+    ../include/libKitsunemimiPersistence/files/tree_remove.h \
+    ../include/libKitsunemimiPersistence/files/change_tracker.h \
+    ../include/libKitsunemimiPersistence/files/file_fingerprint.h
 
 with_sqlite {
     HEADERS += ../include/libKitsunemimiPersistence/database/sqlite.h 
@@ -0,0 +1,1272 @@
+/**
+ *  @file    b_plus_tree.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief page-based b+tree within a binary-file for ordered key-value-data
+ *
+ *  @detail All nodes are stored in pages of fixed size, which is a multiple of the block-size
+ *          of direct-io. The keys within a page are stored with prefix-compression. Leafs are
+ *          linked, so ordered range-scans only have to follow these links. Lookups and iterators
+ *          can run in parallel, while modifications are exclusive. Decoded pages are held in an
+ *          lru-cache. Removing keys doesn't merge pages, so pages can become underfull. The
+ *          meta-page is only rewritten by a modification, when the root or the number of pages
+ *          changed. The number of keys is persisted by flush and closeTree.
+ */
+
+#include <libKitsunemimiPersistence/storage/b_plus_tree.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiCommon/buffer/data_buffer.h>
+
+#include "../common/checksum.h"
+
+#include <algorithm>
+#include <string.h>
+
+using Kitsunemimi::DataBuffer;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define B_PLUS_TREE_MAGIC 0x4B53425054524545ULL
+#define B_PLUS_TREE_ALLOCATION_PAGES 64
+#define B_PLUS_TREE_NO_PAGE 0
+#define B_PLUS_TREE_BLOCK_SIZE 512
+
+struct MetaPage
+{
+    uint64_t magic = B_PLUS_TREE_MAGIC;
+    uint32_t pageSize = 0;
+    uint32_t checksum = 0;
+    uint64_t rootPage = 0;
+    uint64_t numberOfPages = 0;
+    uint64_t numberOfKeys = 0;
+    uint64_t height = 0;
+} __attribute__((packed));
+
+struct PageHeader
+{
+    uint32_t checksum = 0;
+    uint16_t numberOfKeys = 0;
+    uint16_t prefixSize = 0;
+    uint8_t isLeaf = 0;
+    uint8_t padding[7] = {0, 0, 0, 0, 0, 0, 0};
+    uint64_t nextLeaf = 0;
+} __attribute__((packed));
+
+/**
+ * @brief get length of the common prefix of two strings
+ */
+static uint64_t
+getCommonPrefixLength(const std::string &first,
+                      const std::string &second)
+{
+    const uint64_t maxLength = std::min(first.size(), second.size());
+    uint64_t length = 0;
+    while(length < maxLength
+          && first[length] == second[length])
+    {
+        length++;
+    }
+
+    return length;
+}
+
+/**
+ * @brief get the shortest string, which is bigger than the left key and not bigger than the
+ *        right key, to keep the keys within the inner nodes as short as possible
+ *
+ * @param left last key of the left node
+ * @param right first key of the right node
+ *
+ * @return separator between the two nodes
+ */
+static const std::string
+getShortestSeparator(const std::string &left,
+                     const std::string &right)
+{
+    return right.substr(0, getCommonPrefixLength(left, right) + 1);
+}
+
+/**
+ * @brief constructor
+ *
+ * @param pageSize size of a single page in bytes. Must be a multiple of 512.
+ * @param cacheSize maximum number of decoded pages within the cache
+ * @param directIO true to bypass the page-cache of the kernel
+ */
+BPlusTree::BPlusTree(const uint32_t pageSize,
+                     const uint64_t cacheSize,
+                     const bool directIO)
+{
+    m_pageSize = pageSize;
+    m_cacheSize = cacheSize;
+    m_directIO = directIO;
+}
+
+/**
+ * @brief destructor
+ */
+BPlusTree::~BPlusTree()
+{
+    closeTree();
+}
+
+/**
+ * @brief open an existing tree-file or create a new one
+ *
+ * @param filePath path to the file of the tree
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+BPlusTree::initTree(const std::string &filePath,
+                    std::string &errorMessage)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file != nullptr)
+    {
+        errorMessage = "b+tree is already initialized";
+        return false;
+    }
+
+    if(m_pageSize < 512
+            || m_pageSize % 512 != 0
+            || m_pageSize > 0xFFFF)
+    {
+        errorMessage = "page-size of the b+tree must be a multiple of 512 and less than 64KiB";
+        return false;
+    }
+
+    m_file = new BinaryFile(filePath, m_directIO);
+    if(m_file->updateFileSize() == false)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\"";
+        delete m_file;
+        m_file = nullptr;
+        return false;
+    }
+
+    // create new tree with an empty leaf as root
+    if(m_file->m_totalFileSize == 0)
+    {
+        m_numberOfPages = 1;
+        m_numberOfKeys = 0;
+        m_height = 1;
+
+        Node root;
+        root.pageId = allocatePage();
+        m_rootPage = root.pageId;
+        if(root.pageId == B_PLUS_TREE_NO_PAGE
+                || writeNode(root) == false
+                || writeMeta() == false)
+        {
+            errorMessage = "failed to initialize new b+tree in file \"" + filePath + "\"";
+            delete m_file;
+            m_file = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    if(readMeta() == false)
+    {
+        errorMessage = "file \"" + filePath + "\" is not a valid b+tree with a page-size of "
+                       + std::to_string(m_pageSize);
+        delete m_file;
+        m_file = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief close the tree
+ *
+ * @return false, if tree was not open, else true
+ */
+bool
+BPlusTree::closeTree()
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    if(m_metaChanged) {
+        writeMeta();
+    }
+    m_file->syncFile();
+    delete m_file;
+    m_file = nullptr;
+    clearCache();
+
+    return true;
+}
+
+/**
+ * @brief insert a new key or update the value of an existing key
+ *
+ * @param key key to insert
+ * @param value value of the key
+ *
+ * @return false, if key and value are too big or write failed, else true
+ */
+bool
+BPlusTree::insert(const std::string &key,
+                  const std::string &value)
+{
+    if(key.size() + value.size() > getMaxEntrySize()) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    // find leaf and remember path from the root
+    std::vector<std::pair<NodePtr, uint64_t>> path;
+    NodePtr node = loadNode(m_rootPage);
+    while(node != nullptr
+          && node->isLeaf == false)
+    {
+        const uint64_t pos = std::upper_bound(node->keys.begin(), node->keys.end(), key)
+                             - node->keys.begin();
+        path.push_back(std::make_pair(node, pos));
+        node = loadNode(node->children.at(pos));
+    }
+
+    if(node == nullptr) {
+        return false;
+    }
+
+    // insert into copy of the leaf
+    Node current = *node;
+    const uint64_t pos = std::lower_bound(current.keys.begin(), current.keys.end(), key)
+                         - current.keys.begin();
+    const bool newKey = pos >= current.keys.size()
+                        || current.keys.at(pos) != key;
+    if(newKey)
+    {
+        current.keys.insert(current.keys.begin() + pos, key);
+        current.values.insert(current.values.begin() + pos, value);
+    }
+    else
+    {
+        current.values[pos] = value;
+    }
+
+    // write nodes and split them up to the root, if necessary
+    while(true)
+    {
+        if(fitsIntoPage(current))
+        {
+            if(writeNode(current) == false) {
+                return false;
+            }
+            break;
+        }
+
+        Node right;
+        std::string separator;
+        splitNode(current, right, separator);
+        if(right.pageId == B_PLUS_TREE_NO_PAGE
+                || writeNode(right) == false
+                || writeNode(current) == false)
+        {
+            return false;
+        }
+
+        // create new root
+        if(path.size() == 0)
+        {
+            Node root;
+            root.pageId = allocatePage();
+            root.isLeaf = false;
+            root.keys.push_back(separator);
+            root.children.push_back(current.pageId);
+            root.children.push_back(right.pageId);
+            if(root.pageId == B_PLUS_TREE_NO_PAGE
+                    || writeNode(root) == false)
+            {
+                return false;
+            }
+
+            m_rootPage = root.pageId;
+            m_height++;
+            break;
+        }
+
+        // add separator to the parent
+        const uint64_t childPos = path.back().second;
+        current = *path.back().first;
+        path.pop_back();
+        current.keys.insert(current.keys.begin() + childPos, separator);
+        current.children.insert(current.children.begin() + childPos + 1, right.pageId);
+    }
+
+    if(newKey) {
+        m_numberOfKeys++;
+    }
+
+    return updateMeta();
+}
+
+/**
+ * @brief get the value of a key
+ *
+ * @param key requested key
+ * @param value reference for the resulting value
+ *
+ * @return false, if key doesn't exist, else true
+ */
+bool
+BPlusTree::get(const std::string &key,
+               std::string &value)
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    const NodePtr leaf = findLeaf(key);
+    if(leaf == nullptr) {
+        return false;
+    }
+
+    const auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
+    if(it == leaf->keys.end()
+            || *it != key)
+    {
+        return false;
+    }
+
+    value = leaf->values.at(it - leaf->keys.begin());
+
+    return true;
+}
+
+/**
+ * @brief remove a key from the tree
+ *
+ * @param key key to remove
+ *
+ * @return false, if key doesn't exist or write failed, else true
+ */
+bool
+BPlusTree::remove(const std::string &key)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    const NodePtr leaf = findLeaf(key);
+    if(leaf == nullptr) {
+        return false;
+    }
+
+    const auto it = std::lower_bound(leaf->keys.begin(), leaf->keys.end(), key);
+    if(it == leaf->keys.end()
+            || *it != key)
+    {
+        return false;
+    }
+
+    Node current = *leaf;
+    const uint64_t pos = it - leaf->keys.begin();
+    current.keys.erase(current.keys.begin() + pos);
+    current.values.erase(current.values.begin() + pos);
+    if(writeNode(current) == false) {
+        return false;
+    }
+    m_numberOfKeys--;
+
+    return updateMeta();
+}
+
+/**
+ * @brief fill an empty tree with sorted entries. The pages are written bottom-up and filled
+ *        nearly completely, which is much faster than inserting the entries one by one.
+ *
+ * @param sortedEntries list of key-value-pairs, which must be sorted by key without duplicates
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+BPlusTree::bulkLoad(const std::vector<std::pair<std::string, std::string>> &sortedEntries,
+                    std::string &errorMessage)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr)
+    {
+        errorMessage = "b+tree is not initialized";
+        return false;
+    }
+
+    if(m_numberOfKeys != 0)
+    {
+        errorMessage = "bulk-load is only possible into an empty b+tree";
+        return false;
+    }
+
+    // validate input
+    for(uint64_t i = 0; i < sortedEntries.size(); i++)
+    {
+        const std::pair<std::string, std::string> &entry = sortedEntries.at(i);
+        if(entry.first.size() + entry.second.size() > getMaxEntrySize())
+        {
+            errorMessage = "entry " + std::to_string(i) + " is too big for the page-size";
+            return false;
+        }
+
+        if(i > 0
+                && sortedEntries.at(i - 1).first >= entry.first)
+        {
+            errorMessage = "entries for bulk-load are not sorted or contain duplicates";
+            return false;
+        }
+    }
+
+    // tree is empty, so all old pages can be reused
+    clearCache();
+    m_numberOfPages = 1;
+    m_height = 1;
+
+    const uint64_t fillLimit = (m_pageSize * 9) / 10;
+
+    // write leafs, which get consecutive page-ids, so the link to the next leaf is known
+    // before the next leaf is written. Each page of a level is stored together with the
+    // separator, which has to be placed in front of it within the parent.
+    std::vector<std::pair<uint64_t, std::string>> level;
+    std::string separator = "";
+    Node leaf;
+    leaf.pageId = allocatePage();
+    uint64_t leafSize = sizeof(PageHeader);
+    for(const std::pair<std::string, std::string> &entry : sortedEntries)
+    {
+        const uint64_t entrySize = 2 * sizeof(uint16_t) + entry.first.size() + entry.second.size();
+        if(leaf.keys.size() > 0
+                && leafSize + entrySize > fillLimit)
+        {
+            leaf.nextLeaf = leaf.pageId + 1;
+            if(leaf.pageId == B_PLUS_TREE_NO_PAGE
+                    || writeNode(leaf) == false)
+            {
+                errorMessage = "failed to write page";
+                return false;
+            }
+
+            level.push_back(std::make_pair(leaf.pageId, separator));
+            separator = getShortestSeparator(leaf.keys.back(), entry.first);
+
+            leaf = Node();
+            leaf.pageId = allocatePage();
+            leafSize = sizeof(PageHeader);
+        }
+
+        leaf.keys.push_back(entry.first);
+        leaf.values.push_back(entry.second);
+        leafSize += entrySize;
+    }
+
+    if(leaf.pageId == B_PLUS_TREE_NO_PAGE
+            || writeNode(leaf) == false)
+    {
+        errorMessage = "failed to write page";
+        return false;
+    }
+    level.push_back(std::make_pair(leaf.pageId, separator));
+
+    // write inner levels bottom-up until only the root is left
+    while(level.size() > 1)
+    {
+        std::vector<std::pair<uint64_t, std::string>> upperLevel;
+        Node node;
+        uint64_t nodeSize = 0;
+        std::string nodeSeparator = "";
+
+        for(uint64_t i = 0; i < level.size(); i++)
+        {
+            const std::pair<uint64_t, std::string> &child = level.at(i);
+            const uint64_t entrySize = sizeof(uint16_t) + child.second.size() + sizeof(uint64_t);
+
+            // finish current node and start a new one
+            if(node.children.size() > 0
+                    && nodeSize + entrySize > fillLimit)
+            {
+                if(writeNode(node) == false)
+                {
+                    errorMessage = "failed to write page";
+                    return false;
+                }
+                upperLevel.push_back(std::make_pair(node.pageId, nodeSeparator));
+                node = Node();
+            }
+
+            // first child of a node has no separator within the node
+            if(node.children.size() == 0)
+            {
+                node.pageId = allocatePage();
+                node.isLeaf = false;
+                node.children.push_back(child.first);
+                nodeSeparator = child.second;
+                nodeSize = sizeof(PageHeader) + sizeof(uint64_t);
+                if(node.pageId == B_PLUS_TREE_NO_PAGE)
+                {
+                    errorMessage = "failed to allocate page";
+                    return false;
+                }
+                continue;
+            }
+
+            node.keys.push_back(child.second);
+            node.children.push_back(child.first);
+            nodeSize += entrySize;
+        }
+
+        if(writeNode(node) == false)
+        {
+            errorMessage = "failed to write page";
+            return false;
+        }
+        upperLevel.push_back(std::make_pair(node.pageId, nodeSeparator));
+
+        level.swap(upperLevel);
+        m_height++;
+    }
+
+    m_rootPage = level.front().first;
+    m_numberOfKeys = sortedEntries.size();
+
+    if(writeMeta() == false)
+    {
+        errorMessage = "failed to write meta-page";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief sync all changes to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+BPlusTree::flush()
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_treeLock);
+
+    if(m_file == nullptr) {
+        return false;
+    }
+
+    return (m_metaChanged == false || writeMeta())
+           && m_file->syncFile();
+}
+
+/**
+ * @brief get number of keys within the tree
+ */
+uint64_t
+BPlusTree::getNumberOfKeys()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_treeLock);
+    return m_numberOfKeys;
+}
+
+/**
+ * @brief get maximum number of bytes of key and value together. It is limited to a quarter of a
+ *        page, so a split always creates two valid pages.
+ */
+uint64_t
+BPlusTree::getMaxEntrySize() const
+{
+    return (m_pageSize - sizeof(PageHeader)) / 4 - 2 * sizeof(uint16_t) - sizeof(uint64_t);
+}
+
+/**
+ * @brief get a node from the cache or read it from the file
+ *
+ * @param pageId id of the page of the node
+ *
+ * @return pointer to the node, or nullptr if reading failed or the page is broken
+ */
+BPlusTree::NodePtr
+BPlusTree::loadNode(const uint64_t pageId)
+{
+    // check cache
+    {
+        std::lock_guard<std::mutex> guard(m_cacheLock);
+
+        const auto it = m_cacheMap.find(pageId);
+        if(it != m_cacheMap.end())
+        {
+            m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
+            return *it->second;
+        }
+    }
+
+    if(pageId == B_PLUS_TREE_NO_PAGE
+            || pageId >= m_numberOfPages)
+    {
+        return nullptr;
+    }
+
+    DataBuffer buffer(m_pageSize / B_PLUS_TREE_BLOCK_SIZE, B_PLUS_TREE_BLOCK_SIZE);
+    if(m_file->readDataFromFile(buffer.data, pageId * m_pageSize, m_pageSize) == false) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Node> node = std::make_shared<Node>();
+    if(deserializeNode(buffer.data, pageId, *node) == false) {
+        return nullptr;
+    }
+
+    addToCache(node);
+
+    return node;
+}
+
+/**
+ * @brief write a node into its page and update the cache
+ *
+ * @param node node to write
+ *
+ * @return false, if the node doesn't fit into a page or write failed, else true
+ */
+bool
+BPlusTree::writeNode(const Node &node)
+{
+    DataBuffer buffer(m_pageSize / B_PLUS_TREE_BLOCK_SIZE, B_PLUS_TREE_BLOCK_SIZE);
+    if(serializeNode(node, buffer.data) == false) {
+        return false;
+    }
+
+    if(m_file->writeDataIntoFile(buffer.data, node.pageId * m_pageSize, m_pageSize) == false) {
+        return false;
+    }
+
+    addToCache(std::make_shared<const Node>(node));
+
+    return true;
+}
+
+/**
+ * @brief get a new page at the end of the file and allocate storage for it, if necessary
+ *
+ * @return id of the new page, or 0 if allocation failed
+ */
+uint64_t
+BPlusTree::allocatePage()
+{
+    const uint64_t pageId = m_numberOfPages;
+    if((pageId + 1) * m_pageSize > m_file->m_totalFileSize)
+    {
+        if(m_file->allocateStorage(B_PLUS_TREE_ALLOCATION_PAGES, m_pageSize) == false) {
+            return B_PLUS_TREE_NO_PAGE;
+        }
+    }
+
+    m_numberOfPages++;
+
+    return pageId;
+}
+
+/**
+ * @brief read and validate the meta-page at the beginning of the file
+ *
+ * @return false, if meta-page is invalid or doesn't match the page-size, else true
+ */
+bool
+BPlusTree::readMeta()
+{
+    if(m_file->m_totalFileSize < m_pageSize) {
+        return false;
+    }
+
+    DataBuffer buffer(m_pageSize / B_PLUS_TREE_BLOCK_SIZE, B_PLUS_TREE_BLOCK_SIZE);
+    if(m_file->readDataFromFile(buffer.data, 0, m_pageSize) == false) {
+        return false;
+    }
+
+    MetaPage meta;
+    memcpy(&meta, buffer.data, sizeof(MetaPage));
+    const uint32_t checksum = meta.checksum;
+    meta.checksum = 0;
+
+    if(meta.magic != B_PLUS_TREE_MAGIC
+            || meta.pageSize != m_pageSize
+            || checksum != calcCrc32c(&meta, sizeof(MetaPage))
+            || meta.numberOfPages * m_pageSize > m_file->m_totalFileSize
+            || meta.rootPage == B_PLUS_TREE_NO_PAGE
+            || meta.rootPage >= meta.numberOfPages)
+    {
+        return false;
+    }
+
+    m_rootPage = meta.rootPage;
+    m_numberOfPages = meta.numberOfPages;
+    m_numberOfKeys = meta.numberOfKeys;
+    m_height = meta.height;
+    m_persistedRootPage = meta.rootPage;
+    m_persistedNumberOfPages = meta.numberOfPages;
+    m_metaChanged = false;
+
+    return true;
+}
+
+/**
+ * @brief write the meta-page at the beginning of the file
+ *
+ * @return true, if successful, else false
+ */
+bool
+BPlusTree::writeMeta()
+{
+    MetaPage meta;
+    meta.pageSize = m_pageSize;
+    meta.rootPage = m_rootPage;
+    meta.numberOfPages = m_numberOfPages;
+    meta.numberOfKeys = m_numberOfKeys;
+    meta.height = m_height;
+    meta.checksum = calcCrc32c(&meta, sizeof(MetaPage));
+
+    DataBuffer buffer(m_pageSize / B_PLUS_TREE_BLOCK_SIZE, B_PLUS_TREE_BLOCK_SIZE);
+    memset(buffer.data, 0, m_pageSize);
+    memcpy(buffer.data, &meta, sizeof(MetaPage));
+
+    if(m_file->writeDataIntoFile(buffer.data, 0, m_pageSize) == false) {
+        return false;
+    }
+
+    m_persistedRootPage = m_rootPage;
+    m_persistedNumberOfPages = m_numberOfPages;
+    m_metaChanged = false;
+
+    return true;
+}
+
+/**
+ * @brief write the meta-page after a modification only if the root or the number of pages
+ *        changed, because both are necessary to read the tree. Other changes are only marked
+ *        and written by the next flush.
+ *
+ * @return true, if successful, else false
+ */
+bool
+BPlusTree::updateMeta()
+{
+    if(m_rootPage != m_persistedRootPage
+            || m_numberOfPages != m_persistedNumberOfPages)
+    {
+        return writeMeta();
+    }
+
+    m_metaChanged = true;
+
+    return true;
+}
+
+/**
+ * @brief check if a node fits into a single page, to decide if it has to be split
+ *
+ * @param node node to check
+ *
+ * @return true, if the serialized node is not bigger than a page, else false
+ */
+bool
+BPlusTree::fitsIntoPage(const Node &node) const
+{
+    if(node.keys.size() > 0xFFFF) {
+        return false;
+    }
+
+    uint64_t prefixSize = 0;
+    if(node.keys.size() > 1)
+    {
+        prefixSize = getCommonPrefixLength(node.keys.front(), node.keys.back());
+        prefixSize = std::min(prefixSize, static_cast<uint64_t>(0xFFFF));
+    }
+
+    uint64_t size = sizeof(PageHeader) + prefixSize;
+    if(node.isLeaf == false) {
+        size += node.children.size() * sizeof(uint64_t);
+    }
+
+    for(uint64_t i = 0; i < node.keys.size(); i++)
+    {
+        size += sizeof(uint16_t) + node.keys.at(i).size() - prefixSize;
+        if(node.isLeaf) {
+            size += sizeof(uint16_t) + node.values.at(i).size();
+        }
+    }
+
+    return size <= m_pageSize;
+}
+
+/**
+ * @brief convert a node into a page. The common prefix of all keys is stored only once.
+ *
+ * @param node node to convert
+ * @param page pointer to the page-buffer with the size of a page
+ *
+ * @return false, if the node doesn't fit into the page, else true
+ */
+bool
+BPlusTree::serializeNode(const Node &node,
+                         uint8_t* page) const
+{
+    if(node.keys.size() > 0xFFFF) {
+        return false;
+    }
+
+    uint64_t prefixSize = 0;
+    if(node.keys.size() > 1)
+    {
+        prefixSize = getCommonPrefixLength(node.keys.front(), node.keys.back());
+        prefixSize = std::min(prefixSize, static_cast<uint64_t>(0xFFFF));
+    }
+
+    memset(page, 0, m_pageSize);
+
+    PageHeader header;
+    header.numberOfKeys = static_cast<uint16_t>(node.keys.size());
+    header.prefixSize = static_cast<uint16_t>(prefixSize);
+    header.isLeaf = node.isLeaf;
+    header.nextLeaf = node.nextLeaf;
+
+    uint64_t position = sizeof(PageHeader);
+
+    // prefix
+    if(position + prefixSize > m_pageSize) {
+        return false;
+    }
+    if(prefixSize > 0) {
+        memcpy(&page[position], node.keys.front().c_str(), prefixSize);
+    }
+    position += prefixSize;
+
+    // children
+    if(node.isLeaf == false)
+    {
+        const uint64_t childrenSize = node.children.size() * sizeof(uint64_t);
+        if(node.children.size() != node.keys.size() + 1
+                || position + childrenSize > m_pageSize)
+        {
+            return false;
+        }
+        memcpy(&page[position], node.children.data(), childrenSize);
+        position += childrenSize;
+    }
+
+    // entries
+    for(uint64_t i = 0; i < node.keys.size(); i++)
+    {
+        const uint64_t suffixSize = node.keys.at(i).size() - prefixSize;
+        if(suffixSize > 0xFFFF
+                || position + sizeof(uint16_t) + suffixSize > m_pageSize)
+        {
+            return false;
+        }
+
+        const uint16_t suffixSize16 = static_cast<uint16_t>(suffixSize);
+        memcpy(&page[position], &suffixSize16, sizeof(uint16_t));
+        position += sizeof(uint16_t);
+        memcpy(&page[position], node.keys.at(i).c_str() + prefixSize, suffixSize);
+        position += suffixSize;
+
+        if(node.isLeaf)
+        {
+            const uint64_t valueSize = node.values.at(i).size();
+            if(valueSize > 0xFFFF
+                    || position + sizeof(uint16_t) + valueSize > m_pageSize)
+            {
+                return false;
+            }
+
+            const uint16_t valueSize16 = static_cast<uint16_t>(valueSize);
+            memcpy(&page[position], &valueSize16, sizeof(uint16_t));
+            position += sizeof(uint16_t);
+            memcpy(&page[position], node.values.at(i).c_str(), valueSize);
+            position += valueSize;
+        }
+    }
+
+    memcpy(page, &header, sizeof(PageHeader));
+    header.checksum = calcCrc32c(&page[sizeof(uint32_t)], m_pageSize - sizeof(uint32_t));
+    memcpy(page, &header.checksum, sizeof(uint32_t));
+
+    return true;
+}
+
+/**
+ * @brief convert a page back into a node
+ *
+ * @param page pointer to the page-buffer
+ * @param pageId id of the page
+ * @param node reference for the resulting node
+ *
+ * @return false, if the page is broken, else true
+ */
+bool
+BPlusTree::deserializeNode(const uint8_t* page,
+                           const uint64_t pageId,
+                           Node &node) const
+{
+    PageHeader header;
+    memcpy(&header, page, sizeof(PageHeader));
+    if(header.checksum != calcCrc32c(&page[sizeof(uint32_t)], m_pageSize - sizeof(uint32_t))) {
+        return false;
+    }
+
+    node.pageId = pageId;
+    node.isLeaf = header.isLeaf != 0;
+    node.nextLeaf = header.nextLeaf;
+
+    uint64_t position = sizeof(PageHeader);
+
+    // prefix
+    if(position + header.prefixSize > m_pageSize) {
+        return false;
+    }
+    const std::string prefix(reinterpret_cast<const char*>(&page[position]), header.prefixSize);
+    position += header.prefixSize;
+
+    // children
+    if(node.isLeaf == false)
+    {
+        const uint64_t numberOfChildren = header.numberOfKeys + 1;
+        if(position + numberOfChildren * sizeof(uint64_t) > m_pageSize) {
+            return false;
+        }
+        node.children.resize(numberOfChildren);
+        memcpy(node.children.data(), &page[position], numberOfChildren * sizeof(uint64_t));
+        position += numberOfChildren * sizeof(uint64_t);
+    }
+
+    // entries
+    node.keys.reserve(header.numberOfKeys);
+    for(uint64_t i = 0; i < header.numberOfKeys; i++)
+    {
+        uint16_t suffixSize = 0;
+        if(position + sizeof(uint16_t) > m_pageSize) {
+            return false;
+        }
+        memcpy(&suffixSize, &page[position], sizeof(uint16_t));
+        position += sizeof(uint16_t);
+        if(position + suffixSize > m_pageSize) {
+            return false;
+        }
+        node.keys.push_back(prefix);
+        node.keys.back().append(reinterpret_cast<const char*>(&page[position]), suffixSize);
+        position += suffixSize;
+
+        if(node.isLeaf)
+        {
+            uint16_t valueSize = 0;
+            if(position + sizeof(uint16_t) > m_pageSize) {
+                return false;
+            }
+            memcpy(&valueSize, &page[position], sizeof(uint16_t));
+            position += sizeof(uint16_t);
+            if(position + valueSize > m_pageSize) {
+                return false;
+            }
+            node.values.push_back(std::string(reinterpret_cast<const char*>(&page[position]),
+                                              valueSize));
+            position += valueSize;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the size of a range of entries of a node without prefix-compression
+ *
+ * @param node node with the entries
+ * @param begin index of the first entry
+ * @param end index behind the last entry
+ *
+ * @return number of bytes of the entries
+ */
+uint64_t
+BPlusTree::getSerializedSize(const Node &node,
+                             const uint64_t begin,
+                             const uint64_t end) const
+{
+    uint64_t size = 0;
+    for(uint64_t i = begin; i < end; i++)
+    {
+        size += sizeof(uint16_t) + node.keys.at(i).size();
+        if(node.isLeaf) {
+            size += sizeof(uint16_t) + node.values.at(i).size();
+        } else {
+            size += sizeof(uint64_t);
+        }
+    }
+
+    return size;
+}
+
+/**
+ * @brief split an overfull node into two halfs of nearly the same size in bytes
+ *
+ * @param left overfull node, which keeps the lower half
+ * @param right reference for the new node with the upper half
+ * @param separator reference for the key, which has to be added to the parent
+ */
+void
+BPlusTree::splitNode(Node &left,
+                     Node &right,
+                     std::string &separator)
+{
+    const uint64_t numberOfKeys = left.keys.size();
+    const uint64_t totalSize = getSerializedSize(left, 0, numberOfKeys);
+
+    // find position, where the first half of the bytes is reached
+    uint64_t splitPos = 0;
+    uint64_t size = 0;
+    while(splitPos < numberOfKeys
+          && size < totalSize / 2)
+    {
+        size += getSerializedSize(left, splitPos, splitPos + 1);
+        splitPos++;
+    }
+
+    right = Node();
+    right.pageId = allocatePage();
+    right.isLeaf = left.isLeaf;
+
+    if(left.isLeaf)
+    {
+        splitPos = std::max(splitPos, static_cast<uint64_t>(1));
+        splitPos = std::min(splitPos, numberOfKeys - 1);
+
+        right.keys.assign(left.keys.begin() + splitPos, left.keys.end());
+        right.values.assign(left.values.begin() + splitPos, left.values.end());
+        left.keys.resize(splitPos);
+        left.values.resize(splitPos);
+
+        right.nextLeaf = left.nextLeaf;
+        left.nextLeaf = right.pageId;
+
+        separator = getShortestSeparator(left.keys.back(), right.keys.front());
+    }
+    else
+    {
+        // the middle key moves into the parent
+        splitPos = std::max(splitPos, static_cast<uint64_t>(1));
+        splitPos = std::min(splitPos, numberOfKeys - 2);
+
+        separator = left.keys.at(splitPos);
+        right.keys.assign(left.keys.begin() + splitPos + 1, left.keys.end());
+        right.children.assign(left.children.begin() + splitPos + 1, left.children.end());
+        left.keys.resize(splitPos);
+        left.children.resize(splitPos + 1);
+    }
+}
+
+/**
+ * @brief search the leaf, which should contain a specific key
+ *
+ * @param key requested key
+ *
+ * @return pointer to the leaf, or nullptr if reading failed
+ */
+BPlusTree::NodePtr
+BPlusTree::findLeaf(const std::string &key)
+{
+    NodePtr node = loadNode(m_rootPage);
+    while(node != nullptr
+          && node->isLeaf == false)
+    {
+        const uint64_t pos = std::upper_bound(node->keys.begin(), node->keys.end(), key)
+                             - node->keys.begin();
+        node = loadNode(node->children.at(pos));
+    }
+
+    return node;
+}
+
+/**
+ * @brief add a node to the front of the lru-cache and remove the oldest ones, if full
+ *
+ * @param node node to add
+ */
+void
+BPlusTree::addToCache(const NodePtr &node)
+{
+    std::lock_guard<std::mutex> guard(m_cacheLock);
+
+    if(m_cacheSize == 0) {
+        return;
+    }
+
+    const auto it = m_cacheMap.find(node->pageId);
+    if(it != m_cacheMap.end())
+    {
+        *it->second = node;
+        m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
+        return;
+    }
+
+    m_cacheList.push_front(node);
+    m_cacheMap[node->pageId] = m_cacheList.begin();
+
+    while(m_cacheList.size() > m_cacheSize)
+    {
+        m_cacheMap.erase(m_cacheList.back()->pageId);
+        m_cacheList.pop_back();
+    }
+}
+
+/**
+ * @brief remove all nodes from the cache
+ */
+void
+BPlusTree::clearCache()
+{
+    std::lock_guard<std::mutex> guard(m_cacheLock);
+    m_cacheList.clear();
+    m_cacheMap.clear();
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param tree tree to iterate over
+ */
+BPlusTreeIterator::BPlusTreeIterator(BPlusTree &tree)
+{
+    m_tree = &tree;
+}
+
+/**
+ * @brief set iterator to the first key of the tree
+ *
+ * @return false, if tree is not open or reading failed, else true
+ */
+bool
+BPlusTreeIterator::seekToFirst()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_tree->m_treeLock);
+
+    m_leaf = nullptr;
+    m_position = 0;
+
+    if(m_tree->m_file == nullptr) {
+        return false;
+    }
+
+    BPlusTree::NodePtr node = m_tree->loadNode(m_tree->m_rootPage);
+    while(node != nullptr
+          && node->isLeaf == false)
+    {
+        node = m_tree->loadNode(node->children.front());
+    }
+
+    m_leaf = node;
+
+    return m_leaf != nullptr;
+}
+
+/**
+ * @brief set iterator to the first key, which is equal or bigger than the given key
+ *
+ * @param key key to search
+ *
+ * @return false, if tree is not open or reading failed, else true
+ */
+bool
+BPlusTreeIterator::seek(const std::string &key)
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_tree->m_treeLock);
+
+    m_leaf = nullptr;
+    m_position = 0;
+
+    if(m_tree->m_file == nullptr) {
+        return false;
+    }
+
+    m_leaf = m_tree->findLeaf(key);
+    if(m_leaf == nullptr) {
+        return false;
+    }
+
+    m_position = std::lower_bound(m_leaf->keys.begin(), m_leaf->keys.end(), key)
+                 - m_leaf->keys.begin();
+
+    return true;
+}
+
+/**
+ * @brief get the next key-value-pair in ascending order of the keys. If no seek was done
+ *        before, the iteration starts at the first key.
+ *
+ * @param key reference for the resulting key
+ * @param value reference for the resulting value
+ *
+ * @return false, if there are no more keys, else true
+ */
+bool
+BPlusTreeIterator::next(std::string &key,
+                        std::string &value)
+{
+    if(m_leaf == nullptr)
+    {
+        if(seekToFirst() == false) {
+            return false;
+        }
+    }
+
+    // go to next leaf with entries
+    while(m_position >= m_leaf->keys.size())
+    {
+        if(m_leaf->nextLeaf == B_PLUS_TREE_NO_PAGE) {
+            return false;
+        }
+
+        std::shared_lock<std::shared_timed_mutex> guard(m_tree->m_treeLock);
+        if(m_tree->m_file == nullptr) {
+            return false;
+        }
+
+        BPlusTree::NodePtr nextLeaf = m_tree->loadNode(m_leaf->nextLeaf);
+        if(nextLeaf == nullptr) {
+            return false;
+        }
+
+        m_leaf = nextLeaf;
+        m_position = 0;
+    }
+
+    key = m_leaf->keys.at(m_position);
+    value = m_leaf->values.at(m_position);
+    m_position++;
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
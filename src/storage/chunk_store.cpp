@@ -0,0 +1,1164 @@
+/**
+ *  @file    chunk_store.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief content-addressed store, which saves identical chunks of data only once
+ *
+ *  @detail Data are split with content-defined chunking (FastCDC with a gear-hash), so an
+ *          insertion into a file only changes the chunks around the insertion. Each chunk is
+ *          identified by a 128-bit hash of its content and appended only once to pack-files.
+ *          Stored data are described by a recipe, which is the list of the hashes of their
+ *          chunks. When a pack-file is full, it is sealed and an index-file with all its chunks
+ *          is written next to it, so only the active pack-file has to be scanned on startup.
+ */
+
+#include <libKitsunemimiPersistence/storage/chunk_store.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/checksum.h"
+#include "../common/file_buffer.h"
+#include "../common/hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define CHUNK_PACK_INDEX_MAGIC 0x4B5343484B4958ULL
+#define CHUNK_ALLOCATION_STEP (1024 * 1024)
+#define CHUNK_SCAN_SIZE (1024 * 1024)
+#define CHUNK_IO_BLOCK_SIZE (4 * 1024 * 1024)
+
+struct PackIndexHeader
+{
+    uint64_t magic = CHUNK_PACK_INDEX_MAGIC;
+    uint64_t numberOfEntries = 0;
+    uint64_t dataSize = 0;
+    uint32_t checksum = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+struct PackIndexEntry
+{
+    uint64_t hashLow = 0;
+    uint64_t hashHigh = 0;
+    uint64_t position = 0;
+    uint64_t dataSize = 0;
+} __attribute__((packed));
+
+/**
+ * @brief get table with a random 64-bit value for each byte-value for the gear-hash. The values
+ *        are generated with splitmix64 and a fixed seed, so chunk-boundaries are the same in
+ *        each run.
+ */
+static const uint64_t*
+getGearTable()
+{
+    static uint64_t table[256];
+    static const bool initialized = [](uint64_t* values) {
+        uint64_t state = 0x4B6974737573756EULL;
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t value = state;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            values[i] = value ^ (value >> 31);
+        }
+        return true;
+    }(table);
+    (void)initialized;
+
+    return table;
+}
+
+/**
+ * @brief create mask for the gear-hash with a number of bits set at the top, because the upper
+ *        bits of the gear-hash depend on more of the previous bytes than the lower ones
+ */
+static uint64_t
+createGearMask(const uint32_t numberOfBits)
+{
+    if(numberOfBits == 0) {
+        return 0;
+    }
+
+    return ~0ULL << (64 - numberOfBits);
+}
+
+/**
+ * @brief calculate checksum of a chunk
+ *
+ * @param dataSize size of the chunk
+ * @param hashLow lower 64 bits of the hash of the chunk
+ * @param hashHigh upper 64 bits of the hash of the chunk
+ * @param data pointer to the data of the chunk
+ *
+ * @return crc32c-checksum over size, hash and data
+ */
+static uint32_t
+calcChunkChecksum(const uint32_t dataSize,
+                  const uint64_t hashLow,
+                  const uint64_t hashHigh,
+                  const void* data)
+{
+    uint32_t crc = calcCrc32c(&dataSize, sizeof(uint32_t));
+    crc = calcCrc32c(&hashLow, sizeof(uint64_t), crc);
+    crc = calcCrc32c(&hashHigh, sizeof(uint64_t), crc);
+    return calcCrc32c(data, dataSize, crc);
+}
+
+/**
+ * @brief constructor
+ *
+ * @param averageChunkSize targeted average size of the chunks in bytes, which is rounded down
+ *                         to a power of two. Chunks are between a quarter and eight times of
+ *                         this size.
+ * @param maxPackSize maximum size of a single pack-file in bytes
+ * @param numberOfThreads number of threads for storing and restoring multiple files
+ */
+ChunkStore::ChunkStore(const uint32_t averageChunkSize,
+                       const uint64_t maxPackSize,
+                       const uint32_t numberOfThreads)
+{
+    uint32_t numberOfBits = 6;
+    while(numberOfBits < 24
+          && (1U << (numberOfBits + 1)) <= averageChunkSize)
+    {
+        numberOfBits++;
+    }
+
+    m_averageChunkSize = 1U << numberOfBits;
+    m_minChunkSize = m_averageChunkSize / 4;
+    m_maxChunkSize = m_averageChunkSize * 8;
+
+    // normalized chunking: harder condition before and easier condition after the average size
+    m_maskSmall = createGearMask(numberOfBits + 1);
+    m_maskLarge = createGearMask(numberOfBits - 1);
+
+    m_maxPackSize = maxPackSize;
+    m_numberOfThreads = std::max(numberOfThreads, 1U);
+}
+
+/**
+ * @brief destructor
+ */
+ChunkStore::~ChunkStore()
+{
+    closeStore();
+}
+
+/**
+ * @brief open an existing chunk-store or create a new one
+ *
+ * @param directoryPath path to the directory of the store
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::initStore(const std::string &directoryPath,
+                      std::string &errorMessage)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen)
+    {
+        errorMessage = "chunk-store is already initialized";
+        return false;
+    }
+
+    m_directoryPath = directoryPath;
+
+    // create directory, if necessary
+    if(bfs::exists(m_directoryPath) == false)
+    {
+        if(createDirectory(m_directoryPath, errorMessage) == false) {
+            return false;
+        }
+    }
+    else if(bfs::is_directory(m_directoryPath) == false)
+    {
+        errorMessage = "path \"" + m_directoryPath + "\" exist, but is not a directory";
+        return false;
+    }
+
+    // collect ids of all existing pack-files
+    std::vector<std::string> fileList;
+    listFiles(fileList, m_directoryPath, false);
+    std::vector<uint64_t> packIds;
+    for(const std::string &file : fileList)
+    {
+        // files, which don't match the naming of the packs, are ignored
+        uint64_t packId = 0;
+        if(parseFileId(file, ".pack", packId)) {
+            packIds.push_back(packId);
+        }
+    }
+    std::sort(packIds.begin(), packIds.end());
+
+    // load existing packs
+    for(uint64_t i = 0; i < packIds.size(); i++)
+    {
+        const bool lastPack = i == packIds.size() - 1;
+        if(loadPack(packIds.at(i), lastPack) == false)
+        {
+            errorMessage = "failed to read pack-file \"" + getPackPath(packIds.at(i)) + "\"";
+            clearStore();
+            return false;
+        }
+    }
+
+    // empty store
+    if(packIds.size() == 0
+            && createPack(0) == false)
+    {
+        errorMessage = "failed to create pack-file in \"" + m_directoryPath + "\"";
+        clearStore();
+        return false;
+    }
+
+    m_isOpen = true;
+
+    return true;
+}
+
+/**
+ * @brief close the store
+ *
+ * @return false, if store was not open, else true
+ */
+bool
+ChunkStore::closeStore()
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    // remove preallocated but unused storage
+    Pack &active = m_packs[m_activePackId];
+    if(active.file->m_totalFileSize > active.dataSize) {
+        active.file->truncateFile(active.dataSize);
+    }
+    active.file->syncFile();
+
+    clearStore();
+
+    return true;
+}
+
+/**
+ * @brief split data into chunks and store all chunks, which are not already in the store
+ *
+ * @param data pointer to the data
+ * @param dataSize number of bytes
+ * @param recipe reference for the resulting list of chunk-hashes to restore the data
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::storeData(const void* data,
+                      const uint64_t dataSize,
+                      std::vector<ChunkHash> &recipe)
+{
+    recipe.clear();
+
+    uint64_t processedSize = 0;
+    return ingestBlock(static_cast<const uint8_t*>(data), dataSize, true, recipe, processedSize);
+}
+
+/**
+ * @brief restore data from their recipe
+ *
+ * @param recipe list of chunk-hashes of the data
+ * @param data reference for the restored data
+ *
+ * @return false, if a chunk is missing or broken, else true
+ */
+bool
+ChunkStore::restoreData(const std::vector<ChunkHash> &recipe,
+                        std::string &data)
+{
+    data.clear();
+
+    std::vector<uint8_t> buffer;
+    for(const ChunkHash &hash : recipe)
+    {
+        if(readChunk(hash, buffer) == false) {
+            return false;
+        }
+
+        data.append(reinterpret_cast<const char*>(&buffer[sizeof(ChunkHeader)]),
+                    buffer.size() - sizeof(ChunkHeader));
+    }
+
+    return true;
+}
+
+/**
+ * @brief store the content of a file. The file is read in big blocks, so files of any size can
+ *        be stored.
+ *
+ * @param filePath path of the file
+ * @param recipe reference for the resulting list of chunk-hashes to restore the file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::storeFile(const std::string &filePath,
+                      std::vector<ChunkHash> &recipe,
+                      std::string &errorMessage)
+{
+    recipe.clear();
+
+    std::ifstream inputFile(filePath, std::ios_base::in | std::ios_base::binary);
+    if(bfs::is_regular_file(filePath) == false
+            || inputFile.is_open() == false)
+    {
+        errorMessage = "failed to open file \"" + filePath + "\"";
+        return false;
+    }
+
+    // the buffer keeps the unprocessed rest of the previous block, which is smaller than the
+    // maximum chunk-size
+    std::vector<uint8_t> buffer(CHUNK_IO_BLOCK_SIZE + m_maxChunkSize);
+    uint64_t bufferSize = 0;
+    bool lastBlock = false;
+    while(lastBlock == false)
+    {
+        inputFile.read(reinterpret_cast<char*>(&buffer[bufferSize]),
+                       static_cast<std::streamsize>(buffer.size() - bufferSize));
+        bufferSize += static_cast<uint64_t>(inputFile.gcount());
+        if(inputFile.bad())
+        {
+            errorMessage = "failed to read file \"" + filePath + "\"";
+            return false;
+        }
+        lastBlock = inputFile.eof();
+
+        uint64_t processedSize = 0;
+        if(ingestBlock(buffer.data(), bufferSize, lastBlock, recipe, processedSize) == false)
+        {
+            errorMessage = "failed to store chunks of file \"" + filePath + "\"";
+            return false;
+        }
+
+        memmove(buffer.data(), &buffer[processedSize], bufferSize - processedSize);
+        bufferSize -= processedSize;
+    }
+
+    return true;
+}
+
+/**
+ * @brief restore a file from its recipe. An existing file is overwritten.
+ *
+ * @param recipe list of chunk-hashes of the file
+ * @param targetPath path of the restored file
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if a chunk is missing or broken or write failed, else true
+ */
+bool
+ChunkStore::restoreFile(const std::vector<ChunkHash> &recipe,
+                        const std::string &targetPath,
+                        std::string &errorMessage)
+{
+    // get total size to allocate the complete file at once
+    uint64_t totalSize = 0;
+    {
+        std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+        for(const ChunkHash &hash : recipe)
+        {
+            const auto it = m_index.find(hash);
+            if(it == m_index.end())
+            {
+                errorMessage = "chunk of file \"" + targetPath + "\" is missing in the store";
+                return false;
+            }
+            totalSize += it->second.dataSize;
+        }
+    }
+
+    BinaryFile targetFile(targetPath);
+    if(targetFile.updateFileSize() == false
+            || (targetFile.m_totalFileSize > 0
+                && targetFile.truncateFile(0) == false)
+            || (totalSize > 0
+                && targetFile.allocateStorage(totalSize, 1) == false))
+    {
+        errorMessage = "failed to create file \"" + targetPath + "\"";
+        return false;
+    }
+
+    // collect chunks and write them in big blocks
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> output;
+    output.reserve(CHUNK_IO_BLOCK_SIZE + m_maxChunkSize);
+    uint64_t filePosition = 0;
+    for(uint64_t i = 0; i < recipe.size(); i++)
+    {
+        if(readChunk(recipe.at(i), chunk) == false)
+        {
+            errorMessage = "chunk of file \"" + targetPath + "\" is broken";
+            return false;
+        }
+        output.insert(output.end(), chunk.begin() + sizeof(ChunkHeader), chunk.end());
+
+        if(output.size() >= CHUNK_IO_BLOCK_SIZE
+                || i == recipe.size() - 1)
+        {
+            if(targetFile.writeDataIntoFile(output.data(), filePosition, output.size()) == false)
+            {
+                errorMessage = "failed to write file \"" + targetPath + "\"";
+                return false;
+            }
+            filePosition += output.size();
+            output.clear();
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief store multiple files in parallel
+ *
+ * @param filePaths list of paths of the files
+ * @param recipes reference for the resulting recipes in the same order as the file-paths
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if at least one file could not be stored, else true
+ */
+bool
+ChunkStore::storeFiles(const std::vector<std::string> &filePaths,
+                       std::vector<std::vector<ChunkHash>> &recipes,
+                       std::string &errorMessage)
+{
+    recipes.clear();
+    recipes.resize(filePaths.size());
+
+    std::atomic<uint64_t> nextFile(0);
+    std::atomic<bool> success(true);
+    std::mutex errorLock;
+
+    // each thread takes the next file, until all files are processed
+    std::vector<std::thread> threads;
+    const uint64_t numberOfThreads = std::min(static_cast<uint64_t>(m_numberOfThreads),
+                                              static_cast<uint64_t>(filePaths.size()));
+    for(uint64_t t = 0; t < numberOfThreads; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            uint64_t pos = nextFile++;
+            while(pos < filePaths.size())
+            {
+                std::string threadError = "";
+                if(storeFile(filePaths.at(pos), recipes[pos], threadError) == false)
+                {
+                    std::lock_guard<std::mutex> guard(errorLock);
+                    errorMessage = threadError;
+                    success = false;
+                }
+                pos = nextFile++;
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return success;
+}
+
+/**
+ * @brief restore multiple files in parallel
+ *
+ * @param recipes list of recipes of the files
+ * @param targetPaths list of the target-paths in the same order as the recipes
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if at least one file could not be restored, else true
+ */
+bool
+ChunkStore::restoreFiles(const std::vector<std::vector<ChunkHash>> &recipes,
+                         const std::vector<std::string> &targetPaths,
+                         std::string &errorMessage)
+{
+    if(recipes.size() != targetPaths.size())
+    {
+        errorMessage = "number of recipes and target-paths doesn't match";
+        return false;
+    }
+
+    std::atomic<uint64_t> nextFile(0);
+    std::atomic<bool> success(true);
+    std::mutex errorLock;
+
+    // each thread takes the next file, until all files are processed
+    std::vector<std::thread> threads;
+    const uint64_t numberOfThreads = std::min(static_cast<uint64_t>(m_numberOfThreads),
+                                              static_cast<uint64_t>(recipes.size()));
+    for(uint64_t t = 0; t < numberOfThreads; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            uint64_t pos = nextFile++;
+            while(pos < recipes.size())
+            {
+                std::string threadError = "";
+                if(restoreFile(recipes.at(pos), targetPaths.at(pos), threadError) == false)
+                {
+                    std::lock_guard<std::mutex> guard(errorLock);
+                    errorMessage = threadError;
+                    success = false;
+                }
+                pos = nextFile++;
+            }
+        }));
+    }
+
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return success;
+}
+
+/**
+ * @brief sync all stored chunks to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::flush()
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    return m_packs[m_activePackId].file->syncFile();
+}
+
+/**
+ * @brief get number of unique chunks within the store
+ */
+uint64_t
+ChunkStore::getNumberOfChunks()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+    return m_index.size();
+}
+
+/**
+ * @brief get number of bytes of all unique chunks within the store without headers
+ */
+uint64_t
+ChunkStore::getStoredSize()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+    return m_storedSize;
+}
+
+/**
+ * @brief search the end of the next chunk with the gear-hash
+ *
+ * @param data pointer to the beginning of the chunk
+ * @param dataSize number of available bytes
+ *
+ * @return size of the chunk
+ */
+uint64_t
+ChunkStore::findChunkBoundary(const uint8_t* data,
+                              const uint64_t dataSize) const
+{
+    if(dataSize <= m_minChunkSize) {
+        return dataSize;
+    }
+
+    const uint64_t* gearTable = getGearTable();
+    const uint64_t end = std::min(dataSize, static_cast<uint64_t>(m_maxChunkSize));
+    const uint64_t normalEnd = std::min(end, static_cast<uint64_t>(m_averageChunkSize));
+    uint64_t hash = 0;
+    uint64_t pos = m_minChunkSize;
+
+    for(; pos < normalEnd; pos++)
+    {
+        hash = (hash << 1) + gearTable[data[pos]];
+        if((hash & m_maskSmall) == 0) {
+            return pos + 1;
+        }
+    }
+
+    for(; pos < end; pos++)
+    {
+        hash = (hash << 1) + gearTable[data[pos]];
+        if((hash & m_maskLarge) == 0) {
+            return pos + 1;
+        }
+    }
+
+    return end;
+}
+
+/**
+ * @brief split a block of data into chunks, hash them and add them to the store
+ *
+ * @param data pointer to the block
+ * @param dataSize size of the block
+ * @param lastBlock true, if no more data follow. If false, a rest smaller than the maximum
+ *                  chunk-size is not processed, because its chunk-boundary is not known yet.
+ * @param recipe list of chunk-hashes, where the new hashes are appended
+ * @param processedSize reference for the number of processed bytes
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::ingestBlock(const uint8_t* data,
+                        const uint64_t dataSize,
+                        const bool lastBlock,
+                        std::vector<ChunkHash> &recipe,
+                        uint64_t &processedSize)
+{
+    std::vector<uint32_t> chunkSizes;
+    std::vector<ChunkHash> hashes;
+
+    // chunking and hashing is done without lock
+    processedSize = 0;
+    while(processedSize < dataSize)
+    {
+        const uint64_t remaining = dataSize - processedSize;
+        if(lastBlock == false
+                && remaining < m_maxChunkSize)
+        {
+            break;
+        }
+
+        const uint64_t chunkSize = findChunkBoundary(&data[processedSize], remaining);
+        ChunkHash hash;
+        calcHash128(&data[processedSize], chunkSize, hash.low, hash.high);
+        chunkSizes.push_back(static_cast<uint32_t>(chunkSize));
+        hashes.push_back(hash);
+        processedSize += chunkSize;
+    }
+
+    if(addChunks(data, chunkSizes, hashes) == false) {
+        return false;
+    }
+
+    recipe.insert(recipe.end(), hashes.begin(), hashes.end());
+
+    return true;
+}
+
+/**
+ * @brief append all chunks, which are not already in the store, with a single write-call to the
+ *        active pack-file
+ *
+ * @param data pointer to the data of the chunks
+ * @param chunkSizes sizes of the consecutive chunks within the data
+ * @param hashes hashes of the chunks
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::addChunks(const uint8_t* data,
+                      const std::vector<uint32_t> &chunkSizes,
+                      const std::vector<ChunkHash> &hashes)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    std::vector<uint8_t> writeBuffer;
+    std::vector<ChunkHash> addedHashes;
+    uint64_t dataPosition = 0;
+
+    for(uint64_t i = 0; i < chunkSizes.size(); i++)
+    {
+        const uint8_t* chunkData = &data[dataPosition];
+        const uint32_t chunkSize = chunkSizes.at(i);
+        const ChunkHash &hash = hashes.at(i);
+        dataPosition += chunkSize;
+
+        if(m_index.find(hash) != m_index.end()) {
+            continue;
+        }
+
+        // switch to a new pack, if the active one is full
+        const uint64_t entrySize = sizeof(ChunkHeader) + chunkSize;
+        const uint64_t packSize = m_packs[m_activePackId].dataSize + writeBuffer.size();
+        if(packSize > 0
+                && packSize + entrySize > m_maxPackSize)
+        {
+            if(writeToActivePack(writeBuffer, addedHashes) == false
+                    || sealActivePack() == false
+                    || createPack(m_activePackId + 1) == false)
+            {
+                return false;
+            }
+        }
+
+        ChunkHeader header;
+        header.dataSize = chunkSize;
+        header.hashLow = hash.low;
+        header.hashHigh = hash.high;
+        header.checksum = calcChunkChecksum(chunkSize, hash.low, hash.high, chunkData);
+
+        Location location;
+        location.packId = m_activePackId;
+        location.position = m_packs[m_activePackId].dataSize + writeBuffer.size();
+        location.dataSize = chunkSize;
+        m_index[hash] = location;
+        m_activeChunks.push_back(std::make_pair(hash, location));
+        m_storedSize += chunkSize;
+        addedHashes.push_back(hash);
+
+        const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+        writeBuffer.insert(writeBuffer.end(), headerBytes, headerBytes + sizeof(ChunkHeader));
+        writeBuffer.insert(writeBuffer.end(), chunkData, chunkData + chunkSize);
+    }
+
+    return writeToActivePack(writeBuffer, addedHashes);
+}
+
+/**
+ * @brief write buffered chunks to the end of the active pack-file. If the write fails, the
+ *        chunks are removed from the index again.
+ *
+ * @param writeBuffer buffer with the serialized chunks, which is cleared afterwards
+ * @param addedHashes hashes of the chunks within the buffer, which is cleared afterwards
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::writeToActivePack(std::vector<uint8_t> &writeBuffer,
+                              std::vector<ChunkHash> &addedHashes)
+{
+    if(writeBuffer.size() == 0) {
+        return true;
+    }
+
+    Pack &active = m_packs[m_activePackId];
+    const bool success = ensureFileSize(*active.file,
+                                        active.dataSize + writeBuffer.size(),
+                                        CHUNK_ALLOCATION_STEP)
+                         && active.file->writeDataIntoFile(writeBuffer.data(),
+                                                           active.dataSize,
+                                                           writeBuffer.size());
+    if(success)
+    {
+        active.dataSize += writeBuffer.size();
+    }
+    else
+    {
+        for(const ChunkHash &hash : addedHashes)
+        {
+            m_storedSize -= m_index[hash].dataSize;
+            m_index.erase(hash);
+        }
+        m_activeChunks.resize(m_activeChunks.size() - addedHashes.size());
+    }
+
+    writeBuffer.clear();
+    addedHashes.clear();
+
+    return success;
+}
+
+/**
+ * @brief read a chunk from its pack-file and validate it
+ *
+ * @param hash hash of the chunk
+ * @param buffer reference for the chunk with header and data
+ *
+ * @return false, if chunk doesn't exist or is broken, else true
+ */
+bool
+ChunkStore::readChunk(const ChunkHash &hash,
+                      std::vector<uint8_t> &buffer)
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    const auto it = m_index.find(hash);
+    if(it == m_index.end()) {
+        return false;
+    }
+
+    const Location &location = it->second;
+    buffer.resize(sizeof(ChunkHeader) + location.dataSize);
+    BinaryFile* file = m_packs.at(location.packId).file;
+    if(file->readDataFromFile(buffer.data(), location.position, buffer.size()) == false) {
+        return false;
+    }
+
+    ChunkHeader header;
+    memcpy(&header, buffer.data(), sizeof(ChunkHeader));
+    const uint8_t* data = &buffer[sizeof(ChunkHeader)];
+
+    return header.dataSize == location.dataSize
+           && header.hashLow == hash.low
+           && header.hashHigh == hash.high
+           && calcChunkChecksum(header.dataSize, header.hashLow, header.hashHigh, data)
+              == header.checksum;
+}
+
+/**
+ * @brief load an existing pack-file. Sealed packs are loaded from their index-file, if possible.
+ *        The last pack is always scanned and becomes the active pack.
+ *
+ * @param packId id of the pack
+ * @param lastPack true, if the pack is the newest one
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::loadPack(const uint64_t packId,
+                     const bool lastPack)
+{
+    Pack pack;
+    pack.file = new BinaryFile(getPackPath(packId));
+    pack.sealed = lastPack == false;
+    m_packs[packId] = pack;
+
+    if(lastPack == false
+            && loadPackIndex(packId))
+    {
+        return true;
+    }
+
+    std::vector<std::pair<ChunkHash, Location>> chunks;
+    if(scanPack(packId, chunks) == false) {
+        return false;
+    }
+    addToIndex(chunks);
+
+    if(lastPack)
+    {
+        m_activePackId = packId;
+        m_activeChunks = chunks;
+        return true;
+    }
+
+    // restore missing index-file of sealed pack
+    m_packs[packId].file->syncFile();
+
+    return writePackIndex(packId, chunks);
+}
+
+/**
+ * @brief read all chunks of a pack-file and check their checksums. Everything behind the last
+ *        valid chunk is cut off.
+ *
+ * @param packId id of the pack
+ * @param chunks reference for the found chunks
+ *
+ * @return false, if file could not be read, else true
+ */
+bool
+ChunkStore::scanPack(const uint64_t packId,
+                     std::vector<std::pair<ChunkHash, Location>> &chunks)
+{
+    Pack &pack = m_packs[packId];
+    if(pack.file->updateFileSize() == false) {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    uint64_t bufferFilePosition = 0;
+    uint64_t bufferSize = 0;
+    uint64_t position = 0;
+    const uint64_t fileSize = pack.file->m_totalFileSize;
+
+    while(bufferFileRange(*pack.file,
+                          buffer,
+                          bufferFilePosition,
+                          bufferSize,
+                          position,
+                          sizeof(ChunkHeader),
+                          fileSize,
+                          CHUNK_SCAN_SIZE))
+    {
+        ChunkHeader header;
+        memcpy(&header, &buffer[position - bufferFilePosition], sizeof(ChunkHeader));
+        const uint64_t entrySize = sizeof(ChunkHeader) + header.dataSize;
+        if(bufferFileRange(*pack.file,
+                           buffer,
+                           bufferFilePosition,
+                           bufferSize,
+                           position,
+                           entrySize,
+                           fileSize,
+                           CHUNK_SCAN_SIZE) == false)
+        {
+            break;
+        }
+
+        // validate chunk
+        const uint8_t* data = &buffer[position - bufferFilePosition + sizeof(ChunkHeader)];
+        if(header.dataSize == 0
+                || calcChunkChecksum(header.dataSize, header.hashLow, header.hashHigh, data)
+                   != header.checksum)
+        {
+            break;
+        }
+
+        ChunkHash hash;
+        hash.low = header.hashLow;
+        hash.high = header.hashHigh;
+        Location location;
+        location.packId = packId;
+        location.position = position;
+        location.dataSize = header.dataSize;
+        chunks.push_back(std::make_pair(hash, location));
+
+        position += entrySize;
+    }
+
+    pack.dataSize = position;
+
+    // cut off everything behind the last valid chunk
+    if(fileSize > position) {
+        return pack.file->truncateFile(position);
+    }
+
+    return true;
+}
+
+/**
+ * @brief load the index-file of a sealed pack and add its chunks to the index
+ *
+ * @param packId id of the pack
+ *
+ * @return false, if index-file doesn't exist, is broken or doesn't match the pack-file,
+ *         else true
+ */
+bool
+ChunkStore::loadPackIndex(const uint64_t packId)
+{
+    const std::string indexPath = getPackIndexPath(packId);
+    if(bfs::exists(indexPath) == false) {
+        return false;
+    }
+
+    BinaryFile indexFile(indexPath);
+    PackIndexHeader header;
+    Pack &pack = m_packs[packId];
+    if(indexFile.m_totalFileSize < sizeof(PackIndexHeader)
+            || indexFile.readDataFromFile(&header, 0, sizeof(PackIndexHeader)) == false
+            || header.magic != CHUNK_PACK_INDEX_MAGIC
+            || header.dataSize != pack.file->m_totalFileSize
+            || indexFile.m_totalFileSize != sizeof(PackIndexHeader)
+                                            + header.numberOfEntries * sizeof(PackIndexEntry))
+    {
+        return false;
+    }
+
+    std::vector<PackIndexEntry> entries(header.numberOfEntries);
+    const uint64_t entriesSize = entries.size() * sizeof(PackIndexEntry);
+    if(entriesSize > 0
+            && indexFile.readDataFromFile(entries.data(),
+                                          sizeof(PackIndexHeader),
+                                          entriesSize) == false)
+    {
+        return false;
+    }
+    if(calcCrc32c(entries.data(), entriesSize) != header.checksum) {
+        return false;
+    }
+
+    std::vector<std::pair<ChunkHash, Location>> chunks;
+    chunks.reserve(entries.size());
+    for(const PackIndexEntry &entry : entries)
+    {
+        ChunkHash hash;
+        hash.low = entry.hashLow;
+        hash.high = entry.hashHigh;
+        Location location;
+        location.packId = packId;
+        location.position = entry.position;
+        location.dataSize = static_cast<uint32_t>(entry.dataSize);
+        chunks.push_back(std::make_pair(hash, location));
+    }
+
+    pack.dataSize = header.dataSize;
+    addToIndex(chunks);
+
+    return true;
+}
+
+/**
+ * @brief write the index-file of a sealed pack
+ *
+ * @param packId id of the pack
+ * @param chunks all chunks within the pack
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::writePackIndex(const uint64_t packId,
+                           const std::vector<std::pair<ChunkHash, Location>> &chunks)
+{
+    std::vector<PackIndexEntry> entries;
+    entries.reserve(chunks.size());
+    for(const std::pair<ChunkHash, Location> &chunk : chunks)
+    {
+        PackIndexEntry entry;
+        entry.hashLow = chunk.first.low;
+        entry.hashHigh = chunk.first.high;
+        entry.position = chunk.second.position;
+        entry.dataSize = chunk.second.dataSize;
+        entries.push_back(entry);
+    }
+
+    const uint64_t entriesSize = entries.size() * sizeof(PackIndexEntry);
+    PackIndexHeader header;
+    header.numberOfEntries = entries.size();
+    header.dataSize = m_packs[packId].dataSize;
+    header.checksum = calcCrc32c(entries.data(), entriesSize);
+
+    const std::string indexPath = getPackIndexPath(packId);
+    bfs::remove(indexPath);
+    BinaryFile indexFile(indexPath);
+
+    return indexFile.allocateStorage(sizeof(PackIndexHeader) + entriesSize, 1)
+           && indexFile.writeDataIntoFile(&header, 0, sizeof(PackIndexHeader))
+           && (entriesSize == 0
+               || indexFile.writeDataIntoFile(entries.data(),
+                                              sizeof(PackIndexHeader),
+                                              entriesSize))
+           && indexFile.syncFile();
+}
+
+/**
+ * @brief add chunks to the index. Chunks, which are already known, are ignored.
+ *
+ * @param chunks list of chunks
+ */
+void
+ChunkStore::addToIndex(const std::vector<std::pair<ChunkHash, Location>> &chunks)
+{
+    for(const std::pair<ChunkHash, Location> &chunk : chunks)
+    {
+        if(m_index.insert(chunk).second) {
+            m_storedSize += chunk.second.dataSize;
+        }
+    }
+}
+
+/**
+ * @brief create a new pack-file and make it to the active one
+ *
+ * @param packId id of the new pack
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::createPack(const uint64_t packId)
+{
+    Pack pack;
+    pack.file = new BinaryFile(getPackPath(packId));
+    if(pack.file->updateFileSize() == false)
+    {
+        delete pack.file;
+        return false;
+    }
+
+    // remove old content, which can exist after a crash while sealing the previous pack
+    if(pack.file->m_totalFileSize > 0) {
+        pack.file->truncateFile(0);
+    }
+
+    m_packs[packId] = pack;
+    m_activePackId = packId;
+    m_activeChunks.clear();
+
+    return true;
+}
+
+/**
+ * @brief seal the active pack, so it is never written again and write its index-file
+ *
+ * @return true, if successful, else false
+ */
+bool
+ChunkStore::sealActivePack()
+{
+    Pack &active = m_packs[m_activePackId];
+
+    // remove preallocated but unused storage
+    if(active.file->m_totalFileSize > active.dataSize
+            && active.file->truncateFile(active.dataSize) == false)
+    {
+        return false;
+    }
+
+    if(active.file->syncFile() == false) {
+        return false;
+    }
+
+    active.sealed = true;
+
+    return writePackIndex(m_activePackId, m_activeChunks);
+}
+
+/**
+ * @brief close all pack-files and remove all chunks from the memory
+ */
+void
+ChunkStore::clearStore()
+{
+    for(auto &it : m_packs) {
+        delete it.second.file;
+    }
+
+    m_packs.clear();
+    m_index.clear();
+    m_activeChunks.clear();
+    m_activePackId = 0;
+    m_storedSize = 0;
+    m_isOpen = false;
+}
+
+/**
+ * @brief get file-path of a pack-file
+ */
+const std::string
+ChunkStore::getPackPath(const uint64_t packId) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%020lu.pack", packId);
+    return m_directoryPath + "/" + std::string(name);
+}
+
+/**
+ * @brief get file-path of the index-file of a pack
+ */
+const std::string
+ChunkStore::getPackIndexPath(const uint64_t packId) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%020lu.pidx", packId);
+    return m_directoryPath + "/" + std::string(name);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,1237 @@
+/**
+ *  @file    key_value_store.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief persistent key-value-store with a hash-index and a value-log
+ *
+ *  @detail All values are appended to value-log-files. A hash-index in memory maps each key to
+ *          the position of its newest entry within the value-log, so each lookup is a single
+ *          read-call. The index is persisted as snapshot-file when closing the store and after
+ *          each compaction. While opening the store, the snapshot is loaded and only the part of
+ *          the value-log, which was written after the snapshot, is replayed. Entries carry a
+ *          sequence-number, so the newest entry of a key always wins, even if the snapshot is
+ *          missing or broken. A background-thread compacts the sealed value-log-files, when too
+ *          much of their content is outdated. Before the old files of a compaction are deleted,
+ *          a marker with their ids is written, so after a crash the outdated files are removed
+ *          while opening the store instead of being replayed together with their copies.
+ */
+
+#include <libKitsunemimiPersistence/storage/key_value_store.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/checksum.h"
+#include "../common/file_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define KV_SNAPSHOT_MAGIC 0x4B5653534E4150ULL
+#define KV_SNAPSHOT_NAME "index.snapshot"
+#define KV_MARKER_MAGIC 0x4B56434F4D504354ULL
+#define KV_MARKER_NAME "compaction.marker"
+#define KV_ALLOCATION_STEP (1024 * 1024)
+#define KV_SCAN_SIZE (1024 * 1024)
+
+struct SnapshotHeader
+{
+    uint64_t magic = KV_SNAPSHOT_MAGIC;
+    uint64_t maxSequence = 0;
+    uint64_t numberOfFiles = 0;
+    uint64_t numberOfEntries = 0;
+    uint64_t bodySize = 0;
+    uint32_t checksum = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+struct SnapshotFile
+{
+    uint64_t fileId = 0;
+    uint64_t coveredSize = 0;
+} __attribute__((packed));
+
+struct MarkerHeader
+{
+    uint64_t magic = KV_MARKER_MAGIC;
+    uint64_t numberOfFiles = 0;
+    uint32_t checksum = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+struct SnapshotEntry
+{
+    uint64_t fileId = 0;
+    uint64_t position = 0;
+    uint64_t entrySize = 0;
+    uint64_t sequence = 0;
+    uint32_t keySize = 0;
+} __attribute__((packed));
+
+/**
+ * @brief calculate checksum of a value-log-entry
+ *
+ * @param header header of the entry, where the checksum-field itself is not part of the checksum
+ * @param key pointer to the key
+ * @param value pointer to the value
+ *
+ * @return crc32c-checksum
+ */
+static uint32_t
+calcEntryChecksum(const void* header,
+                  const void* key,
+                  const uint32_t keySize,
+                  const void* value,
+                  const uint32_t valueSize)
+{
+    const uint8_t* headerBytes = static_cast<const uint8_t*>(header);
+    uint32_t crc = calcCrc32c(headerBytes + sizeof(uint32_t), 20);
+    crc = calcCrc32c(key, keySize, crc);
+    return calcCrc32c(value, valueSize, crc);
+}
+
+/**
+ * @brief constructor
+ *
+ * @param maxFileSize maximum size of a single value-log-file in bytes
+ * @param compactionThreshold ratio of outdated data within the sealed value-log-files, which
+ *                            triggers the background-compaction
+ * @param syncOnWrite true to sync the value-log after each write
+ */
+KeyValueStore::KeyValueStore(const uint64_t maxFileSize,
+                             const float compactionThreshold,
+                             const bool syncOnWrite)
+{
+    m_maxFileSize = maxFileSize;
+    m_compactionThreshold = compactionThreshold;
+    m_syncOnWrite = syncOnWrite;
+}
+
+/**
+ * @brief destructor
+ */
+KeyValueStore::~KeyValueStore()
+{
+    closeStore();
+}
+
+/**
+ * @brief open an existing store or create a new one
+ *
+ * @param directoryPath path to the directory of the store
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::initStore(const std::string &directoryPath,
+                         std::string &errorMessage)
+{
+    {
+        std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+        if(m_isOpen)
+        {
+            errorMessage = "key-value-store is already initialized";
+            return false;
+        }
+
+        m_directoryPath = directoryPath;
+
+        // create directory, if necessary
+        if(bfs::exists(m_directoryPath) == false)
+        {
+            if(createDirectory(m_directoryPath, errorMessage) == false) {
+                return false;
+            }
+        }
+        else if(bfs::is_directory(m_directoryPath) == false)
+        {
+            errorMessage = "path \"" + m_directoryPath + "\" exist, but is not a directory";
+            return false;
+        }
+
+        // finish an interrupted compaction by removing its outdated files
+        if(finishCompaction() == false)
+        {
+            errorMessage = "failed to finish compaction in \"" + m_directoryPath + "\"";
+            return false;
+        }
+
+        // open all existing value-log-files
+        std::vector<std::string> fileList;
+        listFiles(fileList, m_directoryPath, false);
+        m_nextFileId = 0;
+        for(const std::string &file : fileList)
+        {
+            // files, which don't match the naming of the value-log-files, are ignored
+            uint64_t fileId = 0;
+            if(parseFileId(file, ".vlog", fileId) == false) {
+                continue;
+            }
+
+            DataFile dataFile;
+            dataFile.file = new BinaryFile(file);
+            dataFile.dataSize = dataFile.file->m_totalFileSize;
+            dataFile.sealed = true;
+            m_files.insert(std::make_pair(fileId, dataFile));
+            m_nextFileId = std::max(m_nextFileId, fileId + 1);
+        }
+
+        // load snapshot of the index and replay all entries, which are not covered by it
+        std::map<uint64_t, uint64_t> coveredSizes;
+        uint64_t maxSequence = 0;
+        if(loadSnapshot(coveredSizes, maxSequence) == false)
+        {
+            m_index.clear();
+            coveredSizes.clear();
+            maxSequence = 0;
+        }
+
+        std::unordered_map<std::string, uint64_t> deletedKeys;
+        for(auto &it : m_files)
+        {
+            uint64_t startPosition = 0;
+            const auto covered = coveredSizes.find(it.first);
+            if(covered != coveredSizes.end()) {
+                startPosition = covered->second;
+            }
+
+            if(replayFile(it.first, startPosition, deletedKeys, maxSequence) == false)
+            {
+                errorMessage = "failed to read value-log-file \"" + getFilePath(it.first) + "\"";
+                clearStore();
+                return false;
+            }
+        }
+        m_nextSequence = maxSequence + 1;
+
+        // calculate the amount of outdated data within each file
+        for(auto &it : m_files) {
+            it.second.garbageSize = it.second.dataSize;
+        }
+        for(const auto &it : m_index) {
+            m_files[it.second.fileId].garbageSize -= it.second.entrySize;
+        }
+
+        // continue writing into the newest file or create a new one
+        if(m_files.size() > 0
+                && m_files.rbegin()->second.dataSize < m_maxFileSize)
+        {
+            m_activeFileId = m_files.rbegin()->first;
+            m_files.rbegin()->second.sealed = false;
+        }
+        else if(createDataFile(m_nextFileId) == false)
+        {
+            errorMessage = "failed to create value-log-file in \"" + m_directoryPath + "\"";
+            clearStore();
+            return false;
+        }
+
+        m_isOpen = true;
+    }
+
+    // start background-compaction
+    m_stopThread = false;
+    m_compactionThread = new std::thread(&KeyValueStore::runCompactionThread, this);
+
+    return true;
+}
+
+/**
+ * @brief stop the background-compaction, persist the index and close all files
+ *
+ * @return false, if store was not open, else true
+ */
+bool
+KeyValueStore::closeStore()
+{
+    // stop background-compaction
+    if(m_compactionThread != nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> threadGuard(m_threadLock);
+            m_stopThread = true;
+        }
+        m_threadCondition.notify_all();
+        m_compactionThread->join();
+        delete m_compactionThread;
+        m_compactionThread = nullptr;
+    }
+
+    std::lock_guard<std::mutex> compactionGuard(m_compactionLock);
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    m_files[m_activeFileId].file->syncFile();
+    writeSnapshot();
+    clearStore();
+
+    return true;
+}
+
+/**
+ * @brief get the value of a key
+ *
+ * @param key requested key
+ * @param value reference for the resulting value
+ *
+ * @return false, if key doesn't exist or the entry is broken, else true
+ */
+bool
+KeyValueStore::get(const std::string &key,
+                   std::string &value)
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    const auto it = m_index.find(key);
+    if(it == m_index.end()) {
+        return false;
+    }
+
+    // read the complete entry with a single read
+    const Location &location = it->second;
+    std::vector<uint8_t> entry(location.entrySize);
+    BinaryFile* file = m_files[location.fileId].file;
+    if(file->readDataFromFile(entry.data(), location.position, location.entrySize) == false) {
+        return false;
+    }
+
+    // validate entry
+    EntryHeader header;
+    memcpy(&header, entry.data(), sizeof(EntryHeader));
+    const uint8_t* keyPos = entry.data() + sizeof(EntryHeader);
+    const uint8_t* valuePos = keyPos + header.keySize;
+    if(sizeof(EntryHeader) + header.keySize + header.valueSize != location.entrySize
+            || header.keySize != key.size()
+            || calcEntryChecksum(&header, keyPos, header.keySize, valuePos, header.valueSize)
+               != header.checksum
+            || memcmp(keyPos, key.c_str(), key.size()) != 0)
+    {
+        return false;
+    }
+
+    value = std::string(reinterpret_cast<const char*>(valuePos), header.valueSize);
+
+    return true;
+}
+
+/**
+ * @brief set the value of a key
+ *
+ * @param key key to set
+ * @param value new value of the key
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::put(const std::string &key,
+                   const std::string &value)
+{
+    if(key.size() > 0xFFFFFFFF
+            || value.size() > 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    Location location;
+    if(appendEntry(key, value, false, location) == false) {
+        return false;
+    }
+
+    // the old entry of the key is outdated now
+    const auto it = m_index.find(key);
+    if(it != m_index.end())
+    {
+        markAsGarbage(it->second);
+        it->second = location;
+    }
+    else
+    {
+        m_index.insert(std::make_pair(key, location));
+    }
+
+    return true;
+}
+
+/**
+ * @brief remove a key from the store
+ *
+ * @param key key to remove
+ *
+ * @return false, if key doesn't exist or write failed, else true
+ */
+bool
+KeyValueStore::remove(const std::string &key)
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    const auto it = m_index.find(key);
+    if(it == m_index.end()) {
+        return false;
+    }
+
+    // write tombstone, which is already outdated, when it is written
+    Location location;
+    if(appendEntry(key, "", true, location) == false) {
+        return false;
+    }
+    markAsGarbage(location);
+    markAsGarbage(it->second);
+    m_index.erase(it);
+
+    return true;
+}
+
+/**
+ * @brief sync all written entries to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::flush()
+{
+    std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    return m_files[m_activeFileId].file->syncFile();
+}
+
+/**
+ * @brief rewrite all still valid entries of the sealed value-log-files, which contain outdated
+ *        entries, into new files and delete the old ones. Reads and writes are only blocked
+ *        while the index is updated at the end.
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::compact()
+{
+    std::lock_guard<std::mutex> compactionGuard(m_compactionLock);
+
+    struct MovedEntry
+    {
+        std::string key;
+        Location oldLocation;
+        Location newLocation;
+    };
+
+    struct SelectedFile
+    {
+        uint64_t fileId = 0;
+        BinaryFile* file = nullptr;
+        uint64_t dataSize = 0;
+    };
+
+    // select files for compaction
+    std::vector<SelectedFile> selectedFiles;
+    {
+        std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+        if(m_isOpen == false) {
+            return false;
+        }
+
+        for(const auto &it : m_files)
+        {
+            if(it.second.sealed
+                    && it.second.garbageSize > 0)
+            {
+                SelectedFile selected;
+                selected.fileId = it.first;
+                selected.file = it.second.file;
+                selected.dataSize = it.second.dataSize;
+                selectedFiles.push_back(selected);
+            }
+        }
+    }
+
+    if(selectedFiles.size() == 0) {
+        return true;
+    }
+
+    std::vector<MovedEntry> movedEntries;
+    std::map<uint64_t, DataFile> newFiles;
+    BinaryFile* outputFile = nullptr;
+    uint64_t outputFileId = 0;
+    uint64_t outputSize = 0;
+    bool success = true;
+
+    // copy all valid entries into new files
+    for(const SelectedFile &selected : selectedFiles)
+    {
+        // sealed files are never changed and can only be removed by the compaction itself
+        const uint64_t fileId = selected.fileId;
+        BinaryFile* file = selected.file;
+        const uint64_t dataSize = selected.dataSize;
+        std::vector<uint8_t> buffer;
+        uint64_t bufferFilePosition = 0;
+        uint64_t bufferSize = 0;
+        uint64_t position = 0;
+
+        while(success
+              && bufferFileRange(*file,
+                                 buffer,
+                                 bufferFilePosition,
+                                 bufferSize,
+                                 position,
+                                 sizeof(EntryHeader),
+                                 dataSize,
+                                 KV_SCAN_SIZE))
+        {
+            EntryHeader header;
+            memcpy(&header, &buffer[position - bufferFilePosition], sizeof(EntryHeader));
+            const uint64_t entrySize = sizeof(EntryHeader) + header.keySize + header.valueSize;
+            if(bufferFileRange(*file,
+                               buffer,
+                               bufferFilePosition,
+                               bufferSize,
+                               position,
+                               entrySize,
+                               dataSize,
+                               KV_SCAN_SIZE) == false)
+            {
+                break;
+            }
+
+            const uint8_t* entry = &buffer[position - bufferFilePosition];
+            const uint8_t* keyPos = entry + sizeof(EntryHeader);
+            const uint8_t* valuePos = keyPos + header.keySize;
+
+            // a broken entry is never copied and the following entries can not be found anymore,
+            // so the compaction is aborted and the old files are kept
+            if(calcEntryChecksum(&header, keyPos, header.keySize, valuePos, header.valueSize)
+                    != header.checksum)
+            {
+                success = false;
+                break;
+            }
+
+            const std::string key(reinterpret_cast<const char*>(keyPos), header.keySize);
+
+            // check if entry is still the current one of its key
+            bool isValid = false;
+            if(header.deleted == 0)
+            {
+                std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+                const auto it = m_index.find(key);
+                isValid = it != m_index.end()
+                          && it->second.fileId == fileId
+                          && it->second.position == position;
+            }
+
+            if(isValid)
+            {
+                // switch to a new output-file, if necessary
+                if(outputFile == nullptr
+                        || (outputSize > 0 && outputSize + entrySize > m_maxFileSize))
+                {
+                    if(outputFile != nullptr) {
+                        newFiles[outputFileId].dataSize = outputSize;
+                    }
+
+                    {
+                        std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+                        outputFileId = m_nextFileId;
+                        m_nextFileId++;
+                    }
+
+                    outputFile = new BinaryFile(getFilePath(outputFileId));
+                    outputSize = 0;
+                    DataFile dataFile;
+                    dataFile.file = outputFile;
+                    dataFile.sealed = true;
+                    newFiles.insert(std::make_pair(outputFileId, dataFile));
+                }
+
+                // copy entry
+                success = ensureFileSize(*outputFile, outputSize + entrySize, KV_ALLOCATION_STEP)
+                          && outputFile->writeDataIntoFile(entry, outputSize, entrySize);
+
+                MovedEntry moved;
+                moved.key = key;
+                moved.oldLocation.fileId = fileId;
+                moved.oldLocation.position = position;
+                moved.newLocation.fileId = outputFileId;
+                moved.newLocation.position = outputSize;
+                moved.newLocation.entrySize = entrySize;
+                moved.newLocation.sequence = header.sequence;
+                movedEntries.push_back(moved);
+
+                outputSize += entrySize;
+            }
+
+            position += entrySize;
+        }
+    }
+
+    if(outputFile != nullptr) {
+        newFiles[outputFileId].dataSize = outputSize;
+    }
+
+    // finish new files
+    for(auto &it : newFiles)
+    {
+        if(it.second.file->m_totalFileSize > it.second.dataSize) {
+            success = success && it.second.file->truncateFile(it.second.dataSize);
+        }
+        success = success && it.second.file->syncFile();
+    }
+
+    // mark the old files as outdated, before the index is switched to the new ones
+    std::vector<uint64_t> oldFileIds;
+    for(const SelectedFile &selected : selectedFiles) {
+        oldFileIds.push_back(selected.fileId);
+    }
+    success = success && writeCompactionMarker(oldFileIds);
+
+    // remove new files again in case of an error
+    if(success == false)
+    {
+        for(auto &it : newFiles)
+        {
+            delete it.second.file;
+            bfs::remove(getFilePath(it.first));
+        }
+
+        return false;
+    }
+
+    // switch index to the new files
+    {
+        std::unique_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+        for(const MovedEntry &moved : movedEntries)
+        {
+            const auto it = m_index.find(moved.key);
+            if(it != m_index.end()
+                    && it->second.fileId == moved.oldLocation.fileId
+                    && it->second.position == moved.oldLocation.position)
+            {
+                it->second = moved.newLocation;
+            }
+            else
+            {
+                // key was changed while the compaction was running
+                newFiles[moved.newLocation.fileId].garbageSize += moved.newLocation.entrySize;
+            }
+        }
+
+        for(const SelectedFile &selected : selectedFiles)
+        {
+            delete selected.file;
+            m_files.erase(selected.fileId);
+        }
+        m_files.insert(newFiles.begin(), newFiles.end());
+
+        writeSnapshot();
+    }
+
+    // delete old files, which are not referenced anymore
+    return finishCompaction();
+}
+
+/**
+ * @brief get number of keys within the store
+ */
+uint64_t
+KeyValueStore::getNumberOfKeys()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+    return m_index.size();
+}
+
+/**
+ * @brief write a new entry into the active value-log-file
+ *
+ * @param key key of the entry
+ * @param value value of the entry
+ * @param deleted true to write a tombstone
+ * @param location reference for the position of the new entry
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::appendEntry(const std::string &key,
+                           const std::string &value,
+                           const bool deleted,
+                           Location &location)
+{
+    EntryHeader header;
+    header.keySize = static_cast<uint32_t>(key.size());
+    header.valueSize = static_cast<uint32_t>(value.size());
+    header.deleted = deleted;
+    header.sequence = m_nextSequence;
+    header.checksum = calcEntryChecksum(&header,
+                                        key.c_str(),
+                                        header.keySize,
+                                        value.c_str(),
+                                        header.valueSize);
+
+    // serialize entry
+    const uint64_t entrySize = sizeof(EntryHeader) + key.size() + value.size();
+    std::vector<uint8_t> entry(entrySize);
+    memcpy(entry.data(), &header, sizeof(EntryHeader));
+    memcpy(entry.data() + sizeof(EntryHeader), key.c_str(), key.size());
+    memcpy(entry.data() + sizeof(EntryHeader) + key.size(), value.c_str(), value.size());
+
+    // switch to a new file, if the active one is full
+    DataFile* active = &m_files[m_activeFileId];
+    if(active->dataSize > 0
+            && active->dataSize + entrySize > m_maxFileSize)
+    {
+        if(sealActiveFile() == false
+                || createDataFile(m_nextFileId) == false)
+        {
+            return false;
+        }
+        active = &m_files[m_activeFileId];
+    }
+
+    // write entry
+    if(ensureFileSize(*active->file, active->dataSize + entrySize, KV_ALLOCATION_STEP) == false
+            || active->file->writeDataIntoFile(entry.data(), active->dataSize, entrySize) == false)
+    {
+        return false;
+    }
+
+    if(m_syncOnWrite
+            && active->file->syncFile() == false)
+    {
+        return false;
+    }
+
+    location.fileId = m_activeFileId;
+    location.position = active->dataSize;
+    location.entrySize = entrySize;
+    location.sequence = m_nextSequence;
+
+    active->dataSize += entrySize;
+    m_nextSequence++;
+
+    return true;
+}
+
+/**
+ * @brief create a new value-log-file and make it to the active one
+ *
+ * @param fileId id of the new file
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::createDataFile(const uint64_t fileId)
+{
+    DataFile dataFile;
+    dataFile.file = new BinaryFile(getFilePath(fileId));
+    if(dataFile.file->updateFileSize() == false)
+    {
+        delete dataFile.file;
+        return false;
+    }
+
+    m_files[fileId] = dataFile;
+    m_activeFileId = fileId;
+    m_nextFileId = std::max(m_nextFileId, fileId + 1);
+
+    return true;
+}
+
+/**
+ * @brief seal the active value-log-file, so it is never written again
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::sealActiveFile()
+{
+    DataFile &active = m_files[m_activeFileId];
+
+    // remove preallocated but unused storage
+    if(active.file->m_totalFileSize > active.dataSize
+            && active.file->truncateFile(active.dataSize) == false)
+    {
+        return false;
+    }
+
+    if(active.file->syncFile() == false) {
+        return false;
+    }
+
+    active.sealed = true;
+
+    return true;
+}
+
+/**
+ * @brief register an entry as outdated
+ *
+ * @param location position of the outdated entry
+ */
+void
+KeyValueStore::markAsGarbage(const Location &location)
+{
+    const auto it = m_files.find(location.fileId);
+    if(it != m_files.end()) {
+        it->second.garbageSize += location.entrySize;
+    }
+}
+
+/**
+ * @brief load the snapshot of the index
+ *
+ * @param coveredSizes reference for the number of bytes of each value-log-file, which are
+ *                     covered by the snapshot
+ * @param maxSequence reference for the highest sequence-number within the snapshot
+ *
+ * @return false, if snapshot doesn't exist, is broken or doesn't match the value-log-files,
+ *         else true
+ */
+bool
+KeyValueStore::loadSnapshot(std::map<uint64_t, uint64_t> &coveredSizes,
+                            uint64_t &maxSequence)
+{
+    const std::string snapshotPath = m_directoryPath + "/" + KV_SNAPSHOT_NAME;
+    if(bfs::exists(snapshotPath) == false) {
+        return false;
+    }
+
+    BinaryFile file(snapshotPath);
+    SnapshotHeader header;
+    if(file.m_totalFileSize < sizeof(SnapshotHeader)
+            || file.readDataFromFile(&header, 0, sizeof(SnapshotHeader)) == false
+            || header.magic != KV_SNAPSHOT_MAGIC
+            || file.m_totalFileSize != sizeof(SnapshotHeader) + header.bodySize)
+    {
+        return false;
+    }
+
+    // read and validate body
+    std::vector<uint8_t> body(header.bodySize);
+    if(header.bodySize > 0
+            && file.readDataFromFile(body.data(), sizeof(SnapshotHeader), body.size()) == false)
+    {
+        return false;
+    }
+    if(calcCrc32c(body.data(), body.size()) != header.checksum) {
+        return false;
+    }
+
+    // parse covered file-sizes
+    uint64_t position = 0;
+    for(uint64_t i = 0; i < header.numberOfFiles; i++)
+    {
+        if(position + sizeof(SnapshotFile) > body.size()) {
+            return false;
+        }
+
+        SnapshotFile snapshotFile;
+        memcpy(&snapshotFile, &body[position], sizeof(SnapshotFile));
+        position += sizeof(SnapshotFile);
+
+        // snapshot must match the existing files
+        const auto it = m_files.find(snapshotFile.fileId);
+        if(it == m_files.end()
+                || it->second.dataSize < snapshotFile.coveredSize)
+        {
+            return false;
+        }
+
+        coveredSizes[snapshotFile.fileId] = snapshotFile.coveredSize;
+    }
+
+    // parse index-entries
+    for(uint64_t i = 0; i < header.numberOfEntries; i++)
+    {
+        if(position + sizeof(SnapshotEntry) > body.size()) {
+            return false;
+        }
+
+        SnapshotEntry entry;
+        memcpy(&entry, &body[position], sizeof(SnapshotEntry));
+        position += sizeof(SnapshotEntry);
+
+        if(position + entry.keySize > body.size()
+                || coveredSizes.find(entry.fileId) == coveredSizes.end())
+        {
+            return false;
+        }
+
+        const std::string key(reinterpret_cast<const char*>(&body[position]), entry.keySize);
+        position += entry.keySize;
+
+        Location location;
+        location.fileId = entry.fileId;
+        location.position = entry.position;
+        location.entrySize = entry.entrySize;
+        location.sequence = entry.sequence;
+        m_index[key] = location;
+    }
+
+    maxSequence = header.maxSequence;
+
+    return true;
+}
+
+/**
+ * @brief write a snapshot of the index into a temporary file and replace the old snapshot
+ *        with it
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::writeSnapshot()
+{
+    std::vector<uint8_t> body;
+
+    // serialize covered file-sizes
+    for(const auto &it : m_files)
+    {
+        SnapshotFile snapshotFile;
+        snapshotFile.fileId = it.first;
+        snapshotFile.coveredSize = it.second.dataSize;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&snapshotFile);
+        body.insert(body.end(), bytes, bytes + sizeof(SnapshotFile));
+    }
+
+    // serialize index-entries
+    for(const auto &it : m_index)
+    {
+        SnapshotEntry entry;
+        entry.fileId = it.second.fileId;
+        entry.position = it.second.position;
+        entry.entrySize = it.second.entrySize;
+        entry.sequence = it.second.sequence;
+        entry.keySize = static_cast<uint32_t>(it.first.size());
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&entry);
+        body.insert(body.end(), bytes, bytes + sizeof(SnapshotEntry));
+        body.insert(body.end(), it.first.begin(), it.first.end());
+    }
+
+    SnapshotHeader header;
+    header.maxSequence = m_nextSequence - 1;
+    header.numberOfFiles = m_files.size();
+    header.numberOfEntries = m_index.size();
+    header.bodySize = body.size();
+    header.checksum = calcCrc32c(body.data(), body.size());
+
+    // write temporary file
+    const std::string snapshotPath = m_directoryPath + "/" + KV_SNAPSHOT_NAME;
+    const std::string tempPath = snapshotPath + ".tmp";
+    bfs::remove(tempPath);
+    {
+        BinaryFile file(tempPath);
+        const uint64_t totalSize = sizeof(SnapshotHeader) + body.size();
+        if(file.allocateStorage(totalSize, 1) == false
+                || file.writeDataIntoFile(&header, 0, sizeof(SnapshotHeader)) == false
+                || (body.size() > 0
+                    && file.writeDataIntoFile(body.data(),
+                                              sizeof(SnapshotHeader),
+                                              body.size()) == false)
+                || file.syncFile() == false)
+        {
+            return false;
+        }
+    }
+
+    // replace old snapshot
+    std::string errorMessage = "";
+    return renameFileOrDir(tempPath, snapshotPath, errorMessage);
+}
+
+/**
+ * @brief write the marker with the ids of the value-log-files, which were replaced by a
+ *        compaction, into a temporary file and move it into place
+ *
+ * @param fileIds ids of the replaced value-log-files
+ *
+ * @return true, if successful, else false
+ */
+bool
+KeyValueStore::writeCompactionMarker(const std::vector<uint64_t> &fileIds)
+{
+    MarkerHeader header;
+    header.numberOfFiles = fileIds.size();
+    header.checksum = calcCrc32c(fileIds.data(), fileIds.size() * sizeof(uint64_t));
+
+    const std::string markerPath = m_directoryPath + "/" + KV_MARKER_NAME;
+    const std::string tempPath = markerPath + ".tmp";
+    bfs::remove(tempPath);
+    {
+        BinaryFile file(tempPath);
+        const uint64_t bodySize = fileIds.size() * sizeof(uint64_t);
+        if(file.allocateStorage(sizeof(MarkerHeader) + bodySize, 1) == false
+                || file.writeDataIntoFile(&header, 0, sizeof(MarkerHeader)) == false
+                || (bodySize > 0
+                    && file.writeDataIntoFile(fileIds.data(),
+                                              sizeof(MarkerHeader),
+                                              bodySize) == false)
+                || file.syncFile() == false)
+        {
+            bfs::remove(tempPath);
+            return false;
+        }
+    }
+
+    std::string errorMessage = "";
+    return renameFileOrDir(tempPath, markerPath, errorMessage);
+}
+
+/**
+ * @brief delete all value-log-files, which are listed in the compaction-marker, and remove the
+ *        marker afterwards. A marker is only moved into place, when the new files are complete,
+ *        so the listed files are always outdated.
+ *
+ * @return false, if marker is broken or files could not be deleted, else true
+ */
+bool
+KeyValueStore::finishCompaction()
+{
+    const std::string markerPath = m_directoryPath + "/" + KV_MARKER_NAME;
+    bfs::remove(markerPath + ".tmp");
+    if(bfs::exists(markerPath) == false) {
+        return true;
+    }
+
+    std::vector<uint64_t> fileIds;
+    {
+        BinaryFile file(markerPath);
+        MarkerHeader header;
+        if(file.m_totalFileSize < sizeof(MarkerHeader)
+                || file.readDataFromFile(&header, 0, sizeof(MarkerHeader)) == false
+                || header.magic != KV_MARKER_MAGIC
+                || file.m_totalFileSize
+                   != sizeof(MarkerHeader) + header.numberOfFiles * sizeof(uint64_t))
+        {
+            return false;
+        }
+
+        fileIds.resize(header.numberOfFiles);
+        if(header.numberOfFiles > 0
+                && file.readDataFromFile(fileIds.data(),
+                                         sizeof(MarkerHeader),
+                                         fileIds.size() * sizeof(uint64_t)) == false)
+        {
+            return false;
+        }
+        if(calcCrc32c(fileIds.data(), fileIds.size() * sizeof(uint64_t)) != header.checksum) {
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    for(const uint64_t fileId : fileIds)
+    {
+        bfs::remove(getFilePath(fileId), error);
+        if(error) {
+            return false;
+        }
+    }
+
+    return bfs::remove(markerPath, error) && !error;
+}
+
+/**
+ * @brief read all entries of a value-log-file behind a specific position and update the index
+ *        with them. Everything behind the last valid entry is cut off.
+ *
+ * @param fileId id of the file
+ * @param startPosition position within the file, where to start
+ * @param deletedKeys map with the sequence-number of the newest tombstone of each key
+ * @param maxSequence reference to the highest found sequence-number
+ *
+ * @return false, if file could not be read, else true
+ */
+bool
+KeyValueStore::replayFile(const uint64_t fileId,
+                          const uint64_t startPosition,
+                          std::unordered_map<std::string, uint64_t> &deletedKeys,
+                          uint64_t &maxSequence)
+{
+    DataFile &dataFile = m_files[fileId];
+    BinaryFile* file = dataFile.file;
+    if(file->updateFileSize() == false) {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    uint64_t bufferFilePosition = 0;
+    uint64_t bufferSize = 0;
+    uint64_t position = startPosition;
+    const uint64_t fileSize = file->m_totalFileSize;
+
+    while(bufferFileRange(*file,
+                          buffer,
+                          bufferFilePosition,
+                          bufferSize,
+                          position,
+                          sizeof(EntryHeader),
+                          fileSize,
+                          KV_SCAN_SIZE))
+    {
+        EntryHeader header;
+        memcpy(&header, &buffer[position - bufferFilePosition], sizeof(EntryHeader));
+        const uint64_t entrySize = sizeof(EntryHeader) + header.keySize + header.valueSize;
+        if(bufferFileRange(*file,
+                           buffer,
+                           bufferFilePosition,
+                           bufferSize,
+                           position,
+                           entrySize,
+                           fileSize,
+                           KV_SCAN_SIZE) == false)
+        {
+            break;
+        }
+
+        // validate entry
+        const uint8_t* keyPos = &buffer[position - bufferFilePosition + sizeof(EntryHeader)];
+        const uint8_t* valuePos = keyPos + header.keySize;
+        if(calcEntryChecksum(&header, keyPos, header.keySize, valuePos, header.valueSize)
+                != header.checksum)
+        {
+            break;
+        }
+
+        const std::string key(reinterpret_cast<const char*>(keyPos), header.keySize);
+        maxSequence = std::max(maxSequence, header.sequence);
+        const auto it = m_index.find(key);
+
+        if(header.deleted != 0)
+        {
+            // tombstone removes all older entries of the key
+            uint64_t &deletedSequence = deletedKeys[key];
+            deletedSequence = std::max(deletedSequence, header.sequence);
+            if(it != m_index.end()
+                    && it->second.sequence < header.sequence)
+            {
+                m_index.erase(it);
+            }
+        }
+        else
+        {
+            const auto deleted = deletedKeys.find(key);
+            const bool isDeleted = deleted != deletedKeys.end()
+                                   && deleted->second > header.sequence;
+            if(isDeleted == false
+                    && (it == m_index.end() || it->second.sequence < header.sequence))
+            {
+                Location location;
+                location.fileId = fileId;
+                location.position = position;
+                location.entrySize = entrySize;
+                location.sequence = header.sequence;
+                m_index[key] = location;
+            }
+        }
+
+        position += entrySize;
+    }
+
+    // cut off incomplete entries at the end of the file
+    dataFile.dataSize = position;
+    if(fileSize > position) {
+        return file->truncateFile(position);
+    }
+
+    return true;
+}
+
+/**
+ * @brief close all files and remove the index from the memory
+ */
+void
+KeyValueStore::clearStore()
+{
+    for(auto &it : m_files) {
+        delete it.second.file;
+    }
+
+    m_files.clear();
+    m_index.clear();
+    m_isOpen = false;
+}
+
+/**
+ * @brief check if the ratio of outdated data within the sealed files reached the threshold
+ *
+ * @return true, if compaction should run, else false
+ */
+bool
+KeyValueStore::needsCompaction()
+{
+    std::shared_lock<std::shared_timed_mutex> guard(m_indexLock);
+
+    uint64_t totalSize = 0;
+    uint64_t garbageSize = 0;
+    for(const auto &it : m_files)
+    {
+        if(it.second.sealed)
+        {
+            totalSize += it.second.dataSize;
+            garbageSize += it.second.garbageSize;
+        }
+    }
+
+    return garbageSize > 0
+           && static_cast<float>(garbageSize) >= m_compactionThreshold
+                                                 * static_cast<float>(totalSize);
+}
+
+/**
+ * @brief loop of the background-thread, which checks regularly if a compaction is necessary
+ */
+void
+KeyValueStore::runCompactionThread()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> threadGuard(m_threadLock);
+            m_threadCondition.wait_for(threadGuard,
+                                       std::chrono::seconds(1),
+                                       [this] { return m_stopThread; });
+            if(m_stopThread) {
+                return;
+            }
+        }
+
+        if(needsCompaction()) {
+            compact();
+        }
+    }
+}
+
+/**
+ * @brief get file-path of a value-log-file
+ */
+const std::string
+KeyValueStore::getFilePath(const uint64_t fileId) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%020lu.vlog", fileId);
+    return m_directoryPath + "/" + std::string(name);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
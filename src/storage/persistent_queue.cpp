@@ -0,0 +1,529 @@
+/**
+ *  @file    persistent_queue.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief persistent fifo-queue with multiple consumers on top of a record-log
+ *
+ *  @detail Items are appended to a segmented record-log, so the tail of the queue is the end of
+ *          the log. Each registered consumer has its own head, which is the id of the oldest not
+ *          acknowledged item. Dequeued items are delivered again after a restart, until they are
+ *          acknowledged. The heads are stored in a separate file and segments, which were
+ *          acknowledged by all consumers, are deleted.
+ */
+
+#include <libKitsunemimiPersistence/storage/persistent_queue.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/checksum.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define QUEUE_HEADS_MAGIC 0x4B5351484541ULL
+#define QUEUE_HEADS_NAME "consumers.heads"
+
+struct HeadsHeader
+{
+    uint64_t magic = QUEUE_HEADS_MAGIC;
+    uint64_t numberOfConsumers = 0;
+    uint64_t bodySize = 0;
+    uint32_t checksum = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+struct HeadsEntry
+{
+    uint64_t headId = 0;
+    uint32_t nameSize = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+/**
+ * @brief constructor
+ *
+ * @param durability level of durability for enqueued items and acknowledgements
+ * @param maxSegmentSize maximum number of bytes of a segment of the underlying record-log
+ */
+PersistentQueue::PersistentQueue(const QueueDurability durability,
+                                 const uint64_t maxSegmentSize)
+    : m_log(maxSegmentSize, 128, durability == SYNC_DURABILITY)
+{
+    m_durability = durability;
+}
+
+/**
+ * @brief destructor
+ */
+PersistentQueue::~PersistentQueue()
+{
+    closeQueue();
+}
+
+/**
+ * @brief open an existing queue or create a new one
+ *
+ * @param directoryPath path to the directory of the queue
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+PersistentQueue::initQueue(const std::string &directoryPath,
+                           std::string &errorMessage)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    if(m_isOpen)
+    {
+        errorMessage = "queue is already initialized";
+        return false;
+    }
+
+    if(m_log.initLog(directoryPath, errorMessage) == false) {
+        return false;
+    }
+    m_directoryPath = directoryPath;
+
+    // without valid heads all consumers are lost and have to be added again. Nothing is
+    // deleted from the log in this case, so no item gets lost.
+    m_consumers.clear();
+    loadHeads();
+
+    // heads can be outside of the log after a crash
+    const uint64_t firstId = m_log.getFirstRecordId();
+    const uint64_t nextId = m_log.getNextRecordId();
+    for(auto &it : m_consumers)
+    {
+        it.second.headId = std::max(it.second.headId, firstId);
+        it.second.headId = std::min(it.second.headId, nextId);
+        resetReader(it.second);
+    }
+
+    m_isOpen = true;
+
+    return true;
+}
+
+/**
+ * @brief close the queue and write the heads of all consumers
+ *
+ * @return false, if queue was not open, else true
+ */
+bool
+PersistentQueue::closeQueue()
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    writeHeads(true);
+    clearConsumers();
+    m_log.closeLog();
+    m_isOpen = false;
+
+    return true;
+}
+
+/**
+ * @brief register a new consumer. It starts at the oldest item, which is still within the queue.
+ *
+ * @param consumerName name of the new consumer
+ *
+ * @return false, if queue is not open or consumer already exist, else true
+ */
+bool
+PersistentQueue::addConsumer(const std::string &consumerName)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    if(m_isOpen == false
+            || consumerName.size() > 0xFFFFFFFF
+            || m_consumers.find(consumerName) != m_consumers.end())
+    {
+        return false;
+    }
+
+    Consumer consumer;
+    consumer.headId = m_log.getFirstRecordId();
+    resetReader(consumer);
+    m_consumers[consumerName] = consumer;
+
+    return writeHeads(m_durability == SYNC_DURABILITY);
+}
+
+/**
+ * @brief unregister a consumer, so its not acknowledged items don't block the deletion of old
+ *        segments anymore
+ *
+ * @param consumerName name of the consumer
+ *
+ * @return false, if consumer doesn't exist, else true
+ */
+bool
+PersistentQueue::removeConsumer(const std::string &consumerName)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    const auto it = m_consumers.find(consumerName);
+    if(it == m_consumers.end()) {
+        return false;
+    }
+
+    delete it->second.reader;
+    m_consumers.erase(it);
+
+    if(writeHeads(m_durability == SYNC_DURABILITY) == false) {
+        return false;
+    }
+    removeAcknowledgedSegments();
+
+    return true;
+}
+
+/**
+ * @brief add a single item at the end of the queue
+ *
+ * @param data pointer to the data of the item
+ * @param dataSize number of bytes of the item
+ *
+ * @return true, if successful, else false
+ */
+bool
+PersistentQueue::enqueue(const void* data,
+                         const uint64_t dataSize)
+{
+    return m_log.appendRecord(data, dataSize);
+}
+
+/**
+ * @brief add multiple items with a single write-call at the end of the queue
+ *
+ * @param items list of items
+ *
+ * @return true, if successful, else false
+ */
+bool
+PersistentQueue::enqueue(const std::vector<std::string> &items)
+{
+    return m_log.appendRecords(items);
+}
+
+/**
+ * @brief get the next items for a consumer. The items stay in the queue until they are
+ *        acknowledged by the consumer.
+ *
+ * @param consumerName name of the consumer
+ * @param items reference for the resulting items. Is empty, if there are no new items.
+ * @param maxNumberOfItems maximum number of items to get
+ *
+ * @return false, if consumer doesn't exist, else true
+ */
+bool
+PersistentQueue::dequeue(const std::string &consumerName,
+                         std::vector<QueueItem> &items,
+                         const uint64_t maxNumberOfItems)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    items.clear();
+
+    const auto it = m_consumers.find(consumerName);
+    if(it == m_consumers.end()) {
+        return false;
+    }
+
+    Consumer &consumer = it->second;
+    LogRecord record;
+    while(items.size() < maxNumberOfItems
+          && consumer.reader->next(record))
+    {
+        // reader starts at the beginning of the log, if the seek has failed on an empty log
+        if(record.recordId < consumer.readId) {
+            continue;
+        }
+
+        QueueItem item;
+        item.itemId = record.recordId;
+        item.data = std::string(reinterpret_cast<const char*>(record.data), record.dataSize);
+        items.push_back(item);
+        consumer.readId = record.recordId + 1;
+    }
+
+    return true;
+}
+
+/**
+ * @brief acknowledge all items of a consumer up to a specific item, so they are not delivered
+ *        to this consumer again
+ *
+ * @param consumerName name of the consumer
+ * @param itemId id of the newest item, which should be acknowledged
+ *
+ * @return false, if consumer doesn't exist, the item was not delivered yet or writing the heads
+ *         failed, else true
+ */
+bool
+PersistentQueue::acknowledge(const std::string &consumerName,
+                             const uint64_t itemId)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    const auto it = m_consumers.find(consumerName);
+    if(it == m_consumers.end()
+            || itemId >= it->second.readId)
+    {
+        return false;
+    }
+
+    // item was already acknowledged before
+    if(itemId < it->second.headId) {
+        return true;
+    }
+
+    it->second.headId = itemId + 1;
+
+    if(m_durability != NO_DURABILITY
+            && writeHeads(m_durability == SYNC_DURABILITY) == false)
+    {
+        return false;
+    }
+    removeAcknowledgedSegments();
+
+    return true;
+}
+
+/**
+ * @brief deliver all not acknowledged items of a consumer again with the next dequeue-calls
+ *
+ * @param consumerName name of the consumer
+ *
+ * @return false, if consumer doesn't exist, else true
+ */
+bool
+PersistentQueue::rewind(const std::string &consumerName)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    const auto it = m_consumers.find(consumerName);
+    if(it == m_consumers.end()) {
+        return false;
+    }
+
+    resetReader(it->second);
+
+    return true;
+}
+
+/**
+ * @brief sync all enqueued items and the heads of all consumers to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+PersistentQueue::flush()
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    if(m_isOpen == false) {
+        return false;
+    }
+
+    return m_log.flush()
+           && writeHeads(true);
+}
+
+/**
+ * @brief get number of items, which are not acknowledged by a consumer
+ *
+ * @param consumerName name of the consumer
+ *
+ * @return number of items, or 0 if consumer doesn't exist
+ */
+uint64_t
+PersistentQueue::getNumberOfPendingItems(const std::string &consumerName)
+{
+    std::lock_guard<std::mutex> guard(m_consumerLock);
+
+    const auto it = m_consumers.find(consumerName);
+    if(it == m_consumers.end()) {
+        return 0;
+    }
+
+    return m_log.getNextRecordId() - it->second.headId;
+}
+
+/**
+ * @brief read the heads of all consumers from the heads-file
+ *
+ * @return false, if file doesn't exist or is broken, else true
+ */
+bool
+PersistentQueue::loadHeads()
+{
+    const std::string headsPath = m_directoryPath + "/" + QUEUE_HEADS_NAME;
+    if(bfs::exists(headsPath) == false) {
+        return false;
+    }
+
+    BinaryFile file(headsPath);
+    HeadsHeader header;
+    if(file.m_totalFileSize < sizeof(HeadsHeader)
+            || file.readDataFromFile(&header, 0, sizeof(HeadsHeader)) == false
+            || header.magic != QUEUE_HEADS_MAGIC
+            || file.m_totalFileSize != sizeof(HeadsHeader) + header.bodySize)
+    {
+        return false;
+    }
+
+    // read and validate body
+    std::vector<uint8_t> body(header.bodySize);
+    if(header.bodySize > 0
+            && file.readDataFromFile(body.data(), sizeof(HeadsHeader), body.size()) == false)
+    {
+        return false;
+    }
+    if(calcCrc32c(body.data(), body.size()) != header.checksum) {
+        return false;
+    }
+
+    // parse entries
+    std::map<std::string, Consumer> consumers;
+    uint64_t position = 0;
+    for(uint64_t i = 0; i < header.numberOfConsumers; i++)
+    {
+        if(position + sizeof(HeadsEntry) > body.size()) {
+            return false;
+        }
+
+        HeadsEntry entry;
+        memcpy(&entry, &body[position], sizeof(HeadsEntry));
+        position += sizeof(HeadsEntry);
+
+        if(position + entry.nameSize > body.size()) {
+            return false;
+        }
+
+        const std::string name(reinterpret_cast<const char*>(&body[position]), entry.nameSize);
+        position += entry.nameSize;
+
+        Consumer consumer;
+        consumer.headId = entry.headId;
+        consumers[name] = consumer;
+    }
+
+    m_consumers.swap(consumers);
+
+    return true;
+}
+
+/**
+ * @brief write the heads of all consumers into a temporary file and replace the old heads-file
+ *        with it
+ *
+ * @param sync true to sync the file, before it replaces the old one
+ *
+ * @return true, if successful, else false
+ */
+bool
+PersistentQueue::writeHeads(const bool sync)
+{
+    std::vector<uint8_t> body;
+    for(const auto &it : m_consumers)
+    {
+        HeadsEntry entry;
+        entry.headId = it.second.headId;
+        entry.nameSize = static_cast<uint32_t>(it.first.size());
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&entry);
+        body.insert(body.end(), bytes, bytes + sizeof(HeadsEntry));
+        body.insert(body.end(), it.first.begin(), it.first.end());
+    }
+
+    HeadsHeader header;
+    header.numberOfConsumers = m_consumers.size();
+    header.bodySize = body.size();
+    header.checksum = calcCrc32c(body.data(), body.size());
+
+    // write temporary file
+    const std::string headsPath = m_directoryPath + "/" + QUEUE_HEADS_NAME;
+    const std::string tempPath = headsPath + ".tmp";
+    bfs::remove(tempPath);
+    {
+        BinaryFile file(tempPath);
+        const uint64_t totalSize = sizeof(HeadsHeader) + body.size();
+        if(file.allocateStorage(totalSize, 1) == false
+                || file.writeDataIntoFile(&header, 0, sizeof(HeadsHeader)) == false
+                || (body.size() > 0
+                    && file.writeDataIntoFile(body.data(),
+                                              sizeof(HeadsHeader),
+                                              body.size()) == false)
+                || (sync
+                    && file.syncFile() == false))
+        {
+            return false;
+        }
+    }
+
+    // replace old heads-file
+    std::string errorMessage = "";
+    return renameFileOrDir(tempPath, headsPath, errorMessage);
+}
+
+/**
+ * @brief delete all segments of the log, which were acknowledged by all consumers
+ */
+void
+PersistentQueue::removeAcknowledgedSegments()
+{
+    if(m_consumers.size() == 0) {
+        return;
+    }
+
+    uint64_t minHeadId = m_consumers.begin()->second.headId;
+    for(const auto &it : m_consumers) {
+        minHeadId = std::min(minHeadId, it.second.headId);
+    }
+
+    m_log.removeSegmentsBefore(minHeadId);
+}
+
+/**
+ * @brief move the reader of a consumer back to its head
+ *
+ * @param consumer consumer to reset
+ */
+void
+PersistentQueue::resetReader(Consumer &consumer)
+{
+    delete consumer.reader;
+    consumer.reader = new RecordLogReader(m_log);
+    consumer.readId = consumer.headId;
+
+    // fails on an empty log, but then the reader starts at the first record later
+    consumer.reader->seekToRecord(consumer.headId);
+}
+
+/**
+ * @brief delete the readers of all consumers and remove the consumers from the memory
+ */
+void
+PersistentQueue::clearConsumers()
+{
+    for(auto &it : m_consumers) {
+        delete it.second.reader;
+    }
+    m_consumers.clear();
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
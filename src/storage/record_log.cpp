@@ -0,0 +1,1190 @@
+/**
+ *  @file    record_log.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ *
+ *  @brief append-only log for records, which is split into multiple segment-files
+ *
+ *  @detail Each record is written with a length-prefix, a timestamp and a crc32c-checksum. The
+ *          log-directory contains segment-files, which are named by the id of their first record.
+ *          When a segment reached its maximum size, it is sealed and a sparse index-file is
+ *          written next to it. The sparse index is used to seek to a record-id or a timestamp
+ *          without reading the complete log.
+ */
+
+#include <libKitsunemimiPersistence/storage/record_log.h>
+#include <libKitsunemimiPersistence/files/binary_file.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+
+#include "../common/checksum.h"
+#include "../common/file_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+#define RECORD_LOG_INDEX_MAGIC 0x4B5352494458ULL
+#define RECORD_LOG_ALLOCATION_STEP (1024 * 1024)
+#define RECORD_LOG_SCAN_SIZE (1024 * 1024)
+
+struct IndexFileHeader
+{
+    uint64_t magic = RECORD_LOG_INDEX_MAGIC;
+    uint64_t numberOfRecords = 0;
+    uint64_t dataSize = 0;
+    uint64_t lastTimestamp = 0;
+    uint64_t numberOfEntries = 0;
+    uint32_t checksum = 0;
+    uint32_t padding = 0;
+} __attribute__((packed));
+
+/**
+ * @brief calculate checksum of a record
+ *
+ * @param dataSize size of the payload
+ * @param timestamp timestamp of the record
+ * @param data pointer to the payload
+ *
+ * @return crc32c-checksum over size, timestamp and payload
+ */
+static uint32_t
+calcRecordChecksum(const uint32_t dataSize,
+                   const uint64_t timestamp,
+                   const void* data)
+{
+    uint32_t crc = calcCrc32c(&dataSize, sizeof(uint32_t));
+    crc = calcCrc32c(&timestamp, sizeof(uint64_t), crc);
+    return calcCrc32c(data, dataSize, crc);
+}
+
+/**
+ * @brief get current time as nanoseconds since epoch
+ */
+static uint64_t
+getCurrentTimestamp()
+{
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+/**
+ * @brief constructor
+ *
+ * @param maxSegmentSize maximum number of bytes of a segment-file, before a new one is created.
+ *                       Records, which are bigger than this size, get an own segment.
+ * @param indexInterval number of records between two entries of the sparse index
+ * @param syncOnWrite true to sync the segment-file after each append-call
+ */
+RecordLog::RecordLog(const uint64_t maxSegmentSize,
+                     const uint32_t indexInterval,
+                     const bool syncOnWrite)
+{
+    m_maxSegmentSize = maxSegmentSize;
+    m_indexInterval = indexInterval;
+    m_syncOnWrite = syncOnWrite;
+
+    if(m_indexInterval == 0) {
+        m_indexInterval = 1;
+    }
+}
+
+/**
+ * @brief destructor
+ */
+RecordLog::~RecordLog()
+{
+    closeLog();
+}
+
+/**
+ * @brief open an existing log or create a new one. The last segment is scanned to recover from
+ *        an incomplete write, so all records behind the last valid record are cut off.
+ *
+ * @param directoryPath path to the directory of the log
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::initLog(const std::string &directoryPath,
+                   std::string &errorMessage)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_activeFile != nullptr)
+    {
+        errorMessage = "record-log is already initialized";
+        return false;
+    }
+
+    m_directoryPath = directoryPath;
+    m_segments.clear();
+    m_index.clear();
+    m_lastTimestamp = 0;
+
+    // create directory, if necessary
+    if(bfs::exists(m_directoryPath) == false)
+    {
+        if(createDirectory(m_directoryPath, errorMessage) == false) {
+            return false;
+        }
+    }
+    else if(bfs::is_directory(m_directoryPath) == false)
+    {
+        errorMessage = "path \"" + m_directoryPath + "\" exist, but is not a directory";
+        return false;
+    }
+
+    // collect ids of all existing segments
+    std::vector<std::string> fileList;
+    listFiles(fileList, m_directoryPath, false);
+    std::vector<uint64_t> segmentIds;
+    for(const std::string &file : fileList)
+    {
+        // files, which don't match the naming of the segments, are ignored
+        uint64_t segmentId = 0;
+        if(parseFileId(file, ".seg", segmentId)) {
+            segmentIds.push_back(segmentId);
+        }
+    }
+    std::sort(segmentIds.begin(), segmentIds.end());
+
+    // empty log
+    if(segmentIds.size() == 0)
+    {
+        if(openNewSegment(0) == false)
+        {
+            errorMessage = "failed to create first segment in \"" + m_directoryPath + "\"";
+            return false;
+        }
+
+        return true;
+    }
+
+    // load existing segments
+    for(uint64_t i = 0; i < segmentIds.size(); i++)
+    {
+        if(i > 0)
+        {
+            const Segment &prev = m_segments.back();
+            if(prev.firstRecordId + prev.numberOfRecords != segmentIds.at(i))
+            {
+                errorMessage = "record-log in \"" + m_directoryPath + "\" is inconsistent, "
+                               "because records before segment "
+                               + std::to_string(segmentIds.at(i)) + " are missing";
+                clearLog();
+                return false;
+            }
+        }
+
+        const bool lastSegment = i == segmentIds.size() - 1;
+        if(loadSegment(segmentIds.at(i), lastSegment, errorMessage) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief close the log
+ *
+ * @return false, if log was not open, else true
+ */
+bool
+RecordLog::closeLog()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_activeFile == nullptr) {
+        return false;
+    }
+
+    clearLog();
+
+    return true;
+}
+
+/**
+ * @brief close the active segment and remove all segment-information from the memory
+ */
+void
+RecordLog::clearLog()
+{
+    if(m_activeFile != nullptr)
+    {
+        m_activeFile->syncFile();
+        delete m_activeFile;
+        m_activeFile = nullptr;
+    }
+
+    m_segments.clear();
+    m_index.clear();
+}
+
+/**
+ * @brief append a single record to the log
+ *
+ * @param data pointer to the payload of the new record
+ * @param dataSize number of bytes of the payload
+ * @param timestamp timestamp of the record in nanoseconds. If 0, the current time is used. Because
+ *                  timestamps within the log are never decreasing, smaller values than the
+ *                  timestamp of the last record are raised to this value.
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::appendRecord(const void* data,
+                        const uint64_t dataSize,
+                        const uint64_t timestamp)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_activeFile == nullptr
+            || dataSize > 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    addToWriteBuffer(data, dataSize, timestamp);
+
+    return writeBufferToSegment();
+}
+
+/**
+ * @brief append multiple records with a single write-call. If the records don't fit into the
+ *        active segment, the batch is split over multiple segments.
+ *
+ * @param records list with the payloads of the new records
+ * @param timestamp timestamp for all records in nanoseconds. If 0, the current time is used.
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::appendRecords(const std::vector<std::string> &records,
+                         const uint64_t timestamp)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_activeFile == nullptr) {
+        return false;
+    }
+
+    for(const std::string &record : records)
+    {
+        if(record.size() > 0xFFFFFFFF) {
+            return false;
+        }
+    }
+
+    for(const std::string &record : records) {
+        addToWriteBuffer(record.c_str(), record.size(), timestamp);
+    }
+
+    return writeBufferToSegment();
+}
+
+/**
+ * @brief sync all appended records to the storage
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::flush()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_activeFile == nullptr) {
+        return false;
+    }
+
+    return m_activeFile->syncFile();
+}
+
+/**
+ * @brief delete all sealed segments, which contain only records older than a specific record.
+ *        The active segment is never deleted.
+ *
+ * @param recordId id of the oldest record, which has to be kept
+ *
+ * @return number of deleted segments
+ */
+uint64_t
+RecordLog::removeSegmentsBefore(const uint64_t recordId)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    uint64_t numberOfRemoved = 0;
+    while(m_segments.size() > 1)
+    {
+        const Segment &segment = m_segments.front();
+        if(segment.sealed == false
+                || segment.firstRecordId + segment.numberOfRecords > recordId)
+        {
+            break;
+        }
+
+        // without segment-file an orphaned index-file is ignored, so delete segment first
+        bfs::remove(getSegmentPath(segment.firstRecordId));
+        bfs::remove(getIndexPath(segment.firstRecordId));
+
+        const uint64_t segmentId = segment.firstRecordId;
+        m_index.erase(std::remove_if(m_index.begin(),
+                                     m_index.end(),
+                                     [segmentId](const IndexEntry &entry) {
+                                         return entry.segmentId == segmentId;
+                                     }),
+                      m_index.end());
+        m_segments.erase(m_segments.begin());
+        numberOfRemoved++;
+    }
+
+    return numberOfRemoved;
+}
+
+/**
+ * @brief get id of the oldest record within the log
+ */
+uint64_t
+RecordLog::getFirstRecordId()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_segments.size() == 0) {
+        return 0;
+    }
+
+    return m_segments.front().firstRecordId;
+}
+
+/**
+ * @brief get id, which will be given to the next appended record
+ */
+uint64_t
+RecordLog::getNextRecordId()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_segments.size() == 0) {
+        return 0;
+    }
+
+    const Segment &last = m_segments.back();
+    return last.firstRecordId + last.numberOfRecords;
+}
+
+/**
+ * @brief load an existing segment into the log. Sealed segments are loaded from their index-file,
+ *        if possible. The last segment is always scanned and becomes the active segment.
+ *
+ * @param firstRecordId id of the segment
+ * @param lastSegment true, if the segment is the newest one
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::loadSegment(const uint64_t firstRecordId,
+                       const bool lastSegment,
+                       std::string &errorMessage)
+{
+    Segment segment;
+    segment.firstRecordId = firstRecordId;
+
+    // sealed segments with valid index-file don't have to be scanned
+    if(lastSegment == false
+            && loadIndexFile(segment))
+    {
+        m_lastTimestamp = std::max(m_lastTimestamp, segment.lastTimestamp);
+        m_segments.push_back(segment);
+        return true;
+    }
+
+    BinaryFile* file = new BinaryFile(getSegmentPath(firstRecordId));
+    if(scanSegment(*file, segment) == false)
+    {
+        delete file;
+        errorMessage = "failed to read segment \"" + getSegmentPath(firstRecordId) + "\"";
+        clearLog();
+        return false;
+    }
+    m_lastTimestamp = std::max(m_lastTimestamp, segment.lastTimestamp);
+
+    // cut off everything behind the last valid record
+    if(file->m_totalFileSize > segment.dataSize) {
+        file->truncateFile(segment.dataSize);
+    }
+
+    if(lastSegment)
+    {
+        m_segments.push_back(segment);
+        m_activeFile = file;
+        return true;
+    }
+
+    // restore missing index-file of sealed segment
+    segment.sealed = true;
+    m_segments.push_back(segment);
+    file->syncFile();
+    delete file;
+
+    return writeIndexFile(segment);
+}
+
+/**
+ * @brief read all records of a segment-file, check their checksums and add them to the index
+ *
+ * @param file segment-file to scan
+ * @param segment segment-object, which is updated by the result of the scan
+ *
+ * @return false, if file could not be read, else true
+ */
+bool
+RecordLog::scanSegment(BinaryFile &file,
+                       Segment &segment)
+{
+    if(file.updateFileSize() == false) {
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    uint64_t bufferFilePosition = 0;
+    uint64_t bufferSize = 0;
+    uint64_t position = 0;
+    const uint64_t fileSize = file.m_totalFileSize;
+
+    while(bufferFileRange(file,
+                          buffer,
+                          bufferFilePosition,
+                          bufferSize,
+                          position,
+                          sizeof(RecordHeader),
+                          fileSize,
+                          RECORD_LOG_SCAN_SIZE))
+    {
+        RecordHeader header;
+        memcpy(&header, &buffer[position - bufferFilePosition], sizeof(RecordHeader));
+
+        // check if complete record is within the file
+        const uint64_t recordSize = sizeof(RecordHeader) + header.dataSize;
+        if(bufferFileRange(file,
+                           buffer,
+                           bufferFilePosition,
+                           bufferSize,
+                           position,
+                           recordSize,
+                           fileSize,
+                           RECORD_LOG_SCAN_SIZE) == false)
+        {
+            break;
+        }
+
+        // validate record
+        const uint8_t* data = &buffer[position - bufferFilePosition + sizeof(RecordHeader)];
+        if(calcRecordChecksum(header.dataSize, header.timestamp, data) != header.checksum
+                || header.timestamp < segment.lastTimestamp)
+        {
+            break;
+        }
+
+        // register record
+        if(segment.numberOfRecords % m_indexInterval == 0)
+        {
+            IndexEntry entry;
+            entry.recordId = segment.firstRecordId + segment.numberOfRecords;
+            entry.timestamp = header.timestamp;
+            entry.segmentId = segment.firstRecordId;
+            entry.filePosition = position;
+            m_index.push_back(entry);
+        }
+
+        segment.numberOfRecords++;
+        segment.lastTimestamp = header.timestamp;
+        position += recordSize;
+    }
+
+    segment.dataSize = position;
+
+    return true;
+}
+
+/**
+ * @brief load the index-file of a sealed segment
+ *
+ * @param segment segment-object, which is updated by the content of the index-file
+ *
+ * @return false, if index-file doesn't exist or is broken, else true
+ */
+bool
+RecordLog::loadIndexFile(Segment &segment)
+{
+    const std::string indexPath = getIndexPath(segment.firstRecordId);
+    if(bfs::exists(indexPath) == false) {
+        return false;
+    }
+
+    BinaryFile file(indexPath);
+    if(file.m_totalFileSize < sizeof(IndexFileHeader)) {
+        return false;
+    }
+
+    IndexFileHeader header;
+    if(file.readDataFromFile(&header, 0, sizeof(IndexFileHeader)) == false
+            || header.magic != RECORD_LOG_INDEX_MAGIC
+            || file.m_totalFileSize != sizeof(IndexFileHeader)
+                                       + header.numberOfEntries * sizeof(IndexEntry))
+    {
+        return false;
+    }
+
+    std::vector<IndexEntry> entries(header.numberOfEntries);
+    if(header.numberOfEntries > 0
+            && file.readDataFromFile(entries.data(),
+                                     sizeof(IndexFileHeader),
+                                     entries.size() * sizeof(IndexEntry)) == false)
+    {
+        return false;
+    }
+
+    // validate content
+    const uint32_t checksum = calcCrc32c(entries.data(), entries.size() * sizeof(IndexEntry));
+    if(checksum != header.checksum) {
+        return false;
+    }
+
+    // the segment-file must have exactly the size, which was registered in the index
+    boost::system::error_code error;
+    const uint64_t segmentSize = bfs::file_size(getSegmentPath(segment.firstRecordId), error);
+    if(error.value() != 0
+            || segmentSize != header.dataSize)
+    {
+        return false;
+    }
+
+    segment.numberOfRecords = header.numberOfRecords;
+    segment.dataSize = header.dataSize;
+    segment.lastTimestamp = header.lastTimestamp;
+    segment.sealed = true;
+    m_index.insert(m_index.end(), entries.begin(), entries.end());
+
+    return true;
+}
+
+/**
+ * @brief write the sparse index of a segment into its index-file
+ *
+ * @param segment sealed segment
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::writeIndexFile(const Segment &segment)
+{
+    // collect index-entries of the segment
+    std::vector<IndexEntry> entries;
+    for(const IndexEntry &entry : m_index)
+    {
+        if(entry.segmentId == segment.firstRecordId) {
+            entries.push_back(entry);
+        }
+    }
+
+    IndexFileHeader header;
+    header.numberOfRecords = segment.numberOfRecords;
+    header.dataSize = segment.dataSize;
+    header.lastTimestamp = segment.lastTimestamp;
+    header.numberOfEntries = entries.size();
+    header.checksum = calcCrc32c(entries.data(), entries.size() * sizeof(IndexEntry));
+
+    std::vector<uint8_t> content(sizeof(IndexFileHeader) + entries.size() * sizeof(IndexEntry));
+    memcpy(content.data(), &header, sizeof(IndexFileHeader));
+    if(entries.size() > 0) {
+        memcpy(&content[sizeof(IndexFileHeader)], entries.data(), entries.size() * sizeof(IndexEntry));
+    }
+
+    // write index-file
+    BinaryFile file(getIndexPath(segment.firstRecordId));
+    if(file.m_totalFileSize < content.size()
+            && file.allocateStorage(content.size() - file.m_totalFileSize, 1) == false)
+    {
+        return false;
+    }
+
+    if(file.writeDataIntoFile(content.data(), 0, content.size()) == false
+            || file.truncateFile(content.size()) == false)
+    {
+        return false;
+    }
+
+    return file.syncFile();
+}
+
+/**
+ * @brief create a new empty segment and make it to the active segment
+ *
+ * @param firstRecordId id of the first record, which will be written into the new segment
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::openNewSegment(const uint64_t firstRecordId)
+{
+    BinaryFile* file = new BinaryFile(getSegmentPath(firstRecordId));
+    if(file->updateFileSize() == false)
+    {
+        delete file;
+        return false;
+    }
+
+    // remove old content, which can exist after a crash while sealing the previous segment
+    if(file->m_totalFileSize > 0) {
+        file->truncateFile(0);
+    }
+
+    Segment segment;
+    segment.firstRecordId = firstRecordId;
+    segment.lastTimestamp = m_lastTimestamp;
+    m_segments.push_back(segment);
+    m_activeFile = file;
+
+    return true;
+}
+
+/**
+ * @brief seal the active segment, so it is never written again and write its index-file
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::sealActiveSegment()
+{
+    Segment &segment = m_segments.back();
+
+    // remove preallocated but unused storage
+    if(m_activeFile->m_totalFileSize > segment.dataSize) {
+        m_activeFile->truncateFile(segment.dataSize);
+    }
+
+    if(m_activeFile->syncFile() == false) {
+        return false;
+    }
+
+    segment.sealed = true;
+    if(writeIndexFile(segment) == false) {
+        return false;
+    }
+
+    delete m_activeFile;
+    m_activeFile = nullptr;
+
+    return true;
+}
+
+/**
+ * @brief serialize a record into the write-buffer. If the record doesn't fit into the active
+ *        segment anymore, the already buffered records are written and a new segment is opened.
+ *
+ * @param data pointer to the payload
+ * @param dataSize size of the payload
+ * @param timestamp timestamp of the record or 0 for the current time
+ */
+void
+RecordLog::addToWriteBuffer(const void* data,
+                            const uint64_t dataSize,
+                            const uint64_t timestamp)
+{
+    if(m_writeFailed) {
+        return;
+    }
+
+    const uint64_t recordSize = sizeof(RecordHeader) + dataSize;
+
+    // roll segment, if necessary
+    Segment* segment = &m_segments.back();
+    const uint64_t usedSize = segment->dataSize + m_writeBuffer.size();
+    if(usedSize > 0
+            && usedSize + recordSize > m_maxSegmentSize)
+    {
+        const uint64_t nextRecordId = segment->firstRecordId
+                                      + segment->numberOfRecords
+                                      + m_pendingRecords;
+        if(writeBufferToSegment() == false
+                || sealActiveSegment() == false
+                || openNewSegment(nextRecordId) == false)
+        {
+            m_writeFailed = true;
+            return;
+        }
+        segment = &m_segments.back();
+    }
+
+    // prepare header
+    RecordHeader header;
+    header.dataSize = static_cast<uint32_t>(dataSize);
+    header.timestamp = timestamp;
+    if(header.timestamp == 0) {
+        header.timestamp = getCurrentTimestamp();
+    }
+    if(header.timestamp < m_pendingLastTimestamp) {
+        header.timestamp = m_pendingLastTimestamp;
+    }
+    if(header.timestamp < m_lastTimestamp) {
+        header.timestamp = m_lastTimestamp;
+    }
+    header.checksum = calcRecordChecksum(header.dataSize, header.timestamp, data);
+
+    // register record in the sparse index
+    const uint64_t recordNumber = segment->numberOfRecords + m_pendingRecords;
+    if(recordNumber % m_indexInterval == 0)
+    {
+        IndexEntry entry;
+        entry.recordId = segment->firstRecordId + recordNumber;
+        entry.timestamp = header.timestamp;
+        entry.segmentId = segment->firstRecordId;
+        entry.filePosition = segment->dataSize + m_writeBuffer.size();
+        m_pendingIndex.push_back(entry);
+    }
+
+    // serialize record
+    const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+    const uint8_t* dataBytes = static_cast<const uint8_t*>(data);
+    m_writeBuffer.insert(m_writeBuffer.end(), headerBytes, headerBytes + sizeof(RecordHeader));
+    m_writeBuffer.insert(m_writeBuffer.end(), dataBytes, dataBytes + dataSize);
+
+    m_pendingRecords++;
+    m_pendingLastTimestamp = header.timestamp;
+}
+
+/**
+ * @brief write all buffered records with a single write into the active segment and register
+ *        them in the segment-information and index
+ *
+ * @return true, if successful, else false
+ */
+bool
+RecordLog::writeBufferToSegment()
+{
+    bool success = m_writeFailed == false;
+    Segment &segment = m_segments.back();
+
+    if(success
+            && m_writeBuffer.size() > 0)
+    {
+        success = ensureFileSize(*m_activeFile,
+                                 segment.dataSize + m_writeBuffer.size(),
+                                 RECORD_LOG_ALLOCATION_STEP);
+
+        if(success)
+        {
+            success = m_activeFile->writeDataIntoFile(m_writeBuffer.data(),
+                                                      segment.dataSize,
+                                                      m_writeBuffer.size());
+        }
+
+        if(success
+                && m_syncOnWrite)
+        {
+            success = m_activeFile->syncFile();
+        }
+
+        // commit records
+        if(success)
+        {
+            segment.dataSize += m_writeBuffer.size();
+            segment.numberOfRecords += m_pendingRecords;
+            segment.lastTimestamp = m_pendingLastTimestamp;
+            m_lastTimestamp = m_pendingLastTimestamp;
+            m_index.insert(m_index.end(), m_pendingIndex.begin(), m_pendingIndex.end());
+        }
+    }
+
+    m_writeBuffer.clear();
+    m_pendingIndex.clear();
+    m_pendingRecords = 0;
+    m_pendingLastTimestamp = m_lastTimestamp;
+    m_writeFailed = false;
+
+    return success;
+}
+
+/**
+ * @brief get file-path of a segment-file
+ */
+const std::string
+RecordLog::getSegmentPath(const uint64_t segmentId) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%020lu.seg", segmentId);
+    return m_directoryPath + "/" + std::string(name);
+}
+
+/**
+ * @brief get file-path of the index-file of a segment
+ */
+const std::string
+RecordLog::getIndexPath(const uint64_t segmentId) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%020lu.idx", segmentId);
+    return m_directoryPath + "/" + std::string(name);
+}
+
+/**
+ * @brief get current information of a segment
+ *
+ * @param segmentId id of the requested segment
+ * @param segment reference for the result
+ *
+ * @return false, if segment doesn't exist, else true
+ */
+bool
+RecordLog::getSegmentInfo(const uint64_t segmentId,
+                          Segment &segment)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(const Segment &current : m_segments)
+    {
+        if(current.firstRecordId == segmentId)
+        {
+            segment = current;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief get current information of the segment, which follows a specific segment
+ *
+ * @param segmentId id of the segment before the requested one
+ * @param segment reference for the result
+ *
+ * @return false, if there is no following segment, else true
+ */
+bool
+RecordLog::getNextSegmentInfo(const uint64_t segmentId,
+                              Segment &segment)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    for(const Segment &current : m_segments)
+    {
+        if(current.firstRecordId > segmentId)
+        {
+            segment = current;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief get the last index-entry, which is not behind a specific record
+ *
+ * @param recordId id of the requested record
+ * @param entry reference for the result
+ *
+ * @return false, if record is older than the log, else true
+ */
+bool
+RecordLog::findIndexEntryById(const uint64_t recordId,
+                              IndexEntry &entry)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_index.size() == 0
+            || recordId < m_index.front().recordId)
+    {
+        return false;
+    }
+
+    auto it = std::upper_bound(m_index.begin(),
+                               m_index.end(),
+                               recordId,
+                               [](const uint64_t id, const IndexEntry &current) {
+                                   return id < current.recordId;
+                               });
+    entry = *(it - 1);
+
+    return true;
+}
+
+/**
+ * @brief get the last index-entry, which is before all records with a specific timestamp
+ *
+ * @param timestamp requested timestamp
+ * @param entry reference for the result
+ *
+ * @return false, if the log is empty, else true
+ */
+bool
+RecordLog::findIndexEntryByTimestamp(const uint64_t timestamp,
+                                     IndexEntry &entry)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    if(m_index.size() == 0) {
+        return false;
+    }
+
+    auto it = std::lower_bound(m_index.begin(),
+                               m_index.end(),
+                               timestamp,
+                               [](const IndexEntry &current, const uint64_t ts) {
+                                   return current.timestamp < ts;
+                               });
+    if(it != m_index.begin()) {
+        it--;
+    }
+    entry = *it;
+
+    return true;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param log log to read from
+ * @param readAheadSize number of bytes, which are read at once from the segment-files
+ */
+RecordLogReader::RecordLogReader(RecordLog &log,
+                                 const uint64_t readAheadSize)
+{
+    m_log = &log;
+    m_readAheadSize = readAheadSize;
+}
+
+/**
+ * @brief destructor
+ */
+RecordLogReader::~RecordLogReader() {}
+
+/**
+ * @brief move reader to a specific record, so the next call of next() returns this record
+ *
+ * @param recordId id of the record
+ *
+ * @return false, if record is not within the log, else true
+ */
+bool
+RecordLogReader::seekToRecord(const uint64_t recordId)
+{
+    if(recordId > m_log->getNextRecordId()) {
+        return false;
+    }
+
+    RecordLog::IndexEntry entry;
+    if(m_log->findIndexEntryById(recordId, entry) == false) {
+        return false;
+    }
+
+    if(openSegment(entry.segmentId, entry.filePosition, entry.recordId) == false) {
+        return false;
+    }
+
+    m_skipUntilId = recordId;
+    m_skipUntilTimestamp = 0;
+
+    return true;
+}
+
+/**
+ * @brief move reader to the first record with a timestamp not older than the requested one
+ *
+ * @param timestamp requested timestamp in nanoseconds
+ *
+ * @return false, if log is empty, else true
+ */
+bool
+RecordLogReader::seekToTimestamp(const uint64_t timestamp)
+{
+    RecordLog::IndexEntry entry;
+    if(m_log->findIndexEntryByTimestamp(timestamp, entry) == false) {
+        return false;
+    }
+
+    if(openSegment(entry.segmentId, entry.filePosition, entry.recordId) == false) {
+        return false;
+    }
+
+    m_skipUntilId = 0;
+    m_skipUntilTimestamp = timestamp;
+
+    return true;
+}
+
+/**
+ * @brief get the next record of the log. The data-pointer of the record is only valid until the
+ *        next call of this method.
+ *
+ * @param record reference for the result
+ *
+ * @return false, if there are no more records at the moment, else true
+ */
+bool
+RecordLogReader::next(LogRecord &record)
+{
+    // start at the beginning of the log, if no position was set before
+    if(m_file == nullptr
+            && seekToRecord(m_log->getFirstRecordId()) == false)
+    {
+        return false;
+    }
+
+    while(readNextRecord(record))
+    {
+        if(record.recordId >= m_skipUntilId
+                && record.timestamp >= m_skipUntilTimestamp)
+        {
+            m_skipUntilId = 0;
+            m_skipUntilTimestamp = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief open a segment-file for reading
+ *
+ * @param segmentId id of the segment
+ * @param filePosition position of the first record to read within the segment-file
+ * @param recordId id of the record at the file-position
+ *
+ * @return false, if segment doesn't exist, else true
+ */
+bool
+RecordLogReader::openSegment(const uint64_t segmentId,
+                             const uint64_t filePosition,
+                             const uint64_t recordId)
+{
+    RecordLog::Segment segment;
+    if(m_log->getSegmentInfo(segmentId, segment) == false) {
+        return false;
+    }
+
+    // BinaryFile would create the file, if it doesn't exist anymore
+    const std::string segmentPath = m_log->getSegmentPath(segmentId);
+    if(bfs::exists(segmentPath) == false) {
+        return false;
+    }
+
+    m_file.reset(new BinaryFile(segmentPath));
+    m_segmentId = segmentId;
+    m_segmentDataSize = segment.dataSize;
+    m_segmentSealed = segment.sealed;
+    m_filePosition = filePosition;
+    m_nextRecordId = recordId;
+    m_bufferFilePosition = 0;
+    m_bufferSize = 0;
+
+    return true;
+}
+
+/**
+ * @brief make sure, that the next bytes behind the current file-position are in the buffer
+ *
+ * @param numberOfBytes number of requested bytes
+ *
+ * @return false, if not enough data are available, else true
+ */
+bool
+RecordLogReader::ensureBuffered(const uint64_t numberOfBytes)
+{
+    return bufferFileRange(*m_file,
+                           m_buffer,
+                           m_bufferFilePosition,
+                           m_bufferSize,
+                           m_filePosition,
+                           numberOfBytes,
+                           m_segmentDataSize,
+                           m_readAheadSize);
+}
+
+/**
+ * @brief read the record at the current position and move to the following record
+ *
+ * @param record reference for the result
+ *
+ * @return false, if there are no more records at the moment, else true
+ */
+bool
+RecordLogReader::readNextRecord(LogRecord &record)
+{
+    const uint64_t headerSize = sizeof(RecordLog::RecordHeader);
+
+    // handle end of the current segment
+    while(m_filePosition + headerSize > m_segmentDataSize)
+    {
+        RecordLog::Segment segment;
+        if(m_log->getSegmentInfo(m_segmentId, segment) == false)
+        {
+            // segment was removed from the log, so continue with the following one
+            if(m_log->getNextSegmentInfo(m_segmentId, segment) == false
+                    || openSegment(segment.firstRecordId, 0, segment.firstRecordId) == false)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        // check if there were new records appended since the last read
+        if(segment.dataSize > m_segmentDataSize)
+        {
+            m_segmentDataSize = segment.dataSize;
+            m_segmentSealed = segment.sealed;
+            m_file->updateFileSize();
+            continue;
+        }
+
+        // go to next segment
+        if(segment.sealed == false
+                || m_log->getNextSegmentInfo(m_segmentId, segment) == false
+                || openSegment(segment.firstRecordId, 0, segment.firstRecordId) == false)
+        {
+            return false;
+        }
+    }
+
+    // read header
+    if(ensureBuffered(headerSize) == false) {
+        return false;
+    }
+    RecordLog::RecordHeader header;
+    memcpy(&header, &m_buffer[m_filePosition - m_bufferFilePosition], headerSize);
+
+    // read payload
+    if(ensureBuffered(headerSize + header.dataSize) == false) {
+        return false;
+    }
+    const uint8_t* data = &m_buffer[m_filePosition - m_bufferFilePosition + headerSize];
+    if(calcRecordChecksum(header.dataSize, header.timestamp, data) != header.checksum) {
+        return false;
+    }
+
+    record.recordId = m_nextRecordId;
+    record.timestamp = header.timestamp;
+    record.data = data;
+    record.dataSize = header.dataSize;
+
+    m_filePosition += headerSize + header.dataSize;
+    m_nextRecordId++;
+
+    return true;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -1,7 +1,7 @@
 TEMPLATE = subdirs
 CONFIG += ordered
 QT -= qt core gui
-CONFIG += c++14
+CONFIG += c++17
 
 SUBDIRS = \
     unit_tests
@@ -0,0 +1,263 @@
+/**
+ *  @file    append_writer_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "append_writer_test.h"
+
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/resource.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/append_writer.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+#include <libKitsunemimiCommon/common_methods/string_methods.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+AppendWriter_Test::AppendWriter_Test()
+    : Kitsunemimi::CompareTestHelper("AppendWriter_Test")
+{
+    initTest();
+    openFile_test();
+    appendText_test();
+    backgroundFlush_test();
+    concurrentAppend_test();
+    failedWrite_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+AppendWriter_Test::initTest()
+{
+    m_filePath = "/tmp/appendWriter_test.txt";
+    deleteFile();
+}
+
+/**
+ * openFile_test
+ */
+void
+AppendWriter_Test::openFile_test()
+{
+    std::string errorMessage = "";
+
+    AppendWriter writer;
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(fs::exists(m_filePath), true);
+
+    // negative test: already open
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), false);
+
+    TEST_EQUAL(writer.closeFile(), true);
+    TEST_EQUAL(writer.closeFile(), false);
+
+    // negative test: not open
+    TEST_EQUAL(writer.appendText("asdf"), false);
+    TEST_EQUAL(writer.flush(), false);
+    TEST_EQUAL(writer.syncFile(), false);
+
+    // negative test: directory not exist
+    TEST_EQUAL(writer.openFile("/tmp/fake_dir/fake_file", errorMessage), false);
+
+    deleteFile();
+}
+
+/**
+ * appendText_test
+ */
+void
+AppendWriter_Test::appendText_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+    writeFile(m_filePath, "existing\n", errorMessage, true);
+
+    AppendWriter writer(16, 0);
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), true);
+
+    // text stays in the buffer until flush
+    TEST_EQUAL(writer.appendText("line 1\n"), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "existing\n");
+    TEST_EQUAL(writer.flush(), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "existing\nline 1\n");
+
+    // text bigger than the buffer
+    TEST_EQUAL(writer.appendText("line 2\n"), true);
+    TEST_EQUAL(writer.appendText("this is a long line 3\n"), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "existing\nline 1\nline 2\nthis is a long line 3\n");
+
+    // sync
+    TEST_EQUAL(writer.appendText("line 4\n", true), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "existing\nline 1\nline 2\nthis is a long line 3\nline 4\n");
+
+    // close writes buffer
+    TEST_EQUAL(writer.appendText("line 5"), true);
+    TEST_EQUAL(writer.closeFile(), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "existing\nline 1\nline 2\nthis is a long line 3\nline 4\nline 5");
+
+    deleteFile();
+}
+
+/**
+ * backgroundFlush_test
+ */
+void
+AppendWriter_Test::backgroundFlush_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+
+    AppendWriter writer(1024, 10);
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(writer.appendText("asdf"), true);
+
+    // wait until the background-thread has written the buffer
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        readFile(content, m_filePath, errorMessage);
+        if(content == "asdf") {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    TEST_EQUAL(content, "asdf");
+
+    writer.closeFile();
+    deleteFile();
+}
+
+/**
+ * concurrentAppend_test
+ */
+void
+AppendWriter_Test::concurrentAppend_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+
+    AppendWriter writer(256, 1);
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), true);
+
+    // multiple threads append lines and some of them sync
+    std::vector<std::thread> threads;
+    for(uint32_t t = 0; t < 8; t++)
+    {
+        threads.push_back(std::thread([&writer, t]() {
+            for(uint32_t i = 0; i < 500; i++)
+            {
+                const std::string line = "thread " + std::to_string(t)
+                                         + " line " + std::to_string(i) + "\n";
+                writer.appendText(line, i % 100 == 0);
+            }
+        }));
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    TEST_EQUAL(writer.closeFile(), true);
+
+    // all lines must be complete and in order per thread
+    readFile(content, m_filePath, errorMessage);
+    std::vector<std::string> lines;
+    Kitsunemimi::splitStringByDelimiter(lines, content, '\n');
+
+    std::vector<uint32_t> nextLine(8, 0);
+    uint32_t numberOfLines = 0;
+    bool valid = true;
+    for(const std::string &line : lines)
+    {
+        if(line.size() == 0) {
+            continue;
+        }
+
+        const uint32_t thread = static_cast<uint32_t>(line.at(7) - '0');
+        if(line != "thread " + std::to_string(thread)
+                   + " line " + std::to_string(nextLine[thread]))
+        {
+            valid = false;
+        }
+        nextLine[thread]++;
+        numberOfLines++;
+    }
+    TEST_EQUAL(valid, true);
+    TEST_EQUAL(numberOfLines, 4000);
+
+    deleteFile();
+}
+
+/**
+ * failedWrite_test
+ */
+void
+AppendWriter_Test::failedWrite_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+
+    AppendWriter writer(1024, 0);
+    TEST_EQUAL(writer.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(writer.appendText("0123456789abcdefghij"), true);
+
+    // limit the file-size, so the buffer can only be written partially
+    struct rlimit oldLimit;
+    getrlimit(RLIMIT_FSIZE, &oldLimit);
+    struct rlimit newLimit = oldLimit;
+    newLimit.rlim_cur = 8;
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &newLimit);
+
+    TEST_EQUAL(writer.flush(), false);
+
+    setrlimit(RLIMIT_FSIZE, &oldLimit);
+    signal(SIGXFSZ, SIG_DFL);
+
+    // the already written part must not be written again
+    TEST_EQUAL(writer.flush(), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "0123456789abcdefghij");
+
+    writer.closeFile();
+    deleteFile();
+}
+
+/**
+ * closeTest
+ */
+void
+AppendWriter_Test::closeTest()
+{
+    deleteFile();
+}
+
+/**
+ * common usage to delete test-file
+ */
+void
+AppendWriter_Test::deleteFile()
+{
+    fs::path rootPathObj(m_filePath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,41 @@
+/**
+ *  @file    append_writer_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef APPEND_WRITER_TEST_H
+#define APPEND_WRITER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class AppendWriter_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    AppendWriter_Test();
+
+private:
+    void initTest();
+    void openFile_test();
+    void appendText_test();
+    void backgroundFlush_test();
+    void concurrentAppend_test();
+    void failedWrite_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFile();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // APPEND_WRITER_TEST_H
@@ -0,0 +1,240 @@
+/**
+ *  @file    change_tracker_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "change_tracker_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+ChangeTracker_Test::ChangeTracker_Test()
+    : Kitsunemimi::CompareTestHelper("ChangeTracker_Test")
+{
+    initTest();
+    scanChanges_test();
+    manifest_test();
+    waitForChanges_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+ChangeTracker_Test::initTest()
+{
+    std::string errorMessage = "";
+
+    m_directoryPath = "/tmp/changeTracker_test";
+    m_treePath = m_directoryPath + "/tree";
+    m_manifestPath = m_directoryPath + "/manifest";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_treePath + "/a/b");
+
+    writeFile(m_treePath + "/a/file1", "file1", errorMessage);
+    writeFile(m_treePath + "/a/b/file2", "file2", errorMessage);
+    writeFile(m_treePath + "/file3", "file3", errorMessage);
+}
+
+/**
+ * scanChanges_test
+ */
+void
+ChangeTracker_Test::scanChanges_test()
+{
+    std::string errorMessage = "";
+    std::vector<FileChange> changes;
+    ChangeTracker tracker;
+
+    // root is not a directory
+    TEST_EQUAL(tracker.initTracker(m_treePath + "/file3", m_manifestPath, errorMessage), false);
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), false);
+
+    TEST_EQUAL(tracker.initTracker(m_treePath + "/", m_manifestPath, errorMessage), true);
+    TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), false);
+
+    // first scan without manifest
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 3);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/a/file1"), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/a/b/file2"), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/file3"), true);
+    TEST_EQUAL(tracker.getNumberOfFiles(), 3);
+    TEST_EQUAL(fs::exists(m_manifestPath), true);
+
+    // nothing changed
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 0);
+
+    // add, modify and remove files
+    writeFile(m_treePath + "/a/file1", "modified file1", errorMessage);
+    writeFile(m_treePath + "/a/b/file4", "file4", errorMessage);
+    fs::remove(m_treePath + "/file3");
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 3);
+    TEST_EQUAL(hasChange(changes, FILE_MODIFIED, m_treePath + "/a/file1"), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/a/b/file4"), true);
+    TEST_EQUAL(hasChange(changes, FILE_REMOVED, m_treePath + "/file3"), true);
+
+    // remove a complete subtree
+    fs::remove_all(m_treePath + "/a/b");
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 2);
+    TEST_EQUAL(hasChange(changes, FILE_REMOVED, m_treePath + "/a/b/file2"), true);
+    TEST_EQUAL(hasChange(changes, FILE_REMOVED, m_treePath + "/a/b/file4"), true);
+    TEST_EQUAL(tracker.getNumberOfFiles(), 1);
+
+    TEST_EQUAL(tracker.closeTracker(errorMessage), true);
+    TEST_EQUAL(tracker.closeTracker(errorMessage), false);
+}
+
+/**
+ * manifest_test
+ */
+void
+ChangeTracker_Test::manifest_test()
+{
+    std::string errorMessage = "";
+    std::vector<FileChange> changes;
+
+    // the state of the last scan is loaded from the manifest
+    {
+        ChangeTracker tracker;
+        TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), true);
+        TEST_EQUAL(tracker.getNumberOfFiles(), 1);
+        TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+        TEST_EQUAL(changes.size(), 0);
+
+        writeFile(m_treePath + "/file5", "file5", errorMessage);
+        TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+        TEST_EQUAL(changes.size(), 1);
+        TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/file5"), true);
+    }
+
+    {
+        ChangeTracker tracker(false);
+        TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), true);
+        TEST_EQUAL(tracker.getNumberOfFiles(), 2);
+        TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+        TEST_EQUAL(changes.size(), 0);
+    }
+
+    // a broken manifest is ignored
+    std::string content = "";
+    readFile(content, m_manifestPath, errorMessage);
+    content[content.size() - 1] ^= 0x55;
+    writeFile(m_manifestPath, content, errorMessage);
+
+    ChangeTracker tracker;
+    TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), true);
+    TEST_EQUAL(tracker.getNumberOfFiles(), 0);
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 2);
+}
+
+/**
+ * waitForChanges_test
+ */
+void
+ChangeTracker_Test::waitForChanges_test()
+{
+    std::string errorMessage = "";
+    std::vector<FileChange> changes;
+    ChangeTracker tracker;
+
+    TEST_EQUAL(tracker.waitForChanges(changes, 10, errorMessage), false);
+
+    TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), true);
+    TEST_EQUAL(tracker.startWatching(errorMessage), true);
+    TEST_EQUAL(tracker.startWatching(errorMessage), false);
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 0);
+
+    // timeout without any event
+    TEST_EQUAL(tracker.waitForChanges(changes, 10, errorMessage), true);
+    TEST_EQUAL(changes.size(), 0);
+
+    // new file
+    writeFile(m_treePath + "/a/file6", "file6", errorMessage);
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/a/file6"), true);
+
+    // modified file
+    writeFile(m_treePath + "/a/file6", "modified file6", errorMessage);
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(hasChange(changes, FILE_MODIFIED, m_treePath + "/a/file6"), true);
+
+    // new directory, which is watched afterwards
+    fs::create_directories(m_treePath + "/c/d");
+    writeFile(m_treePath + "/c/d/file7", "file7", errorMessage);
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/c/d/file7"), true);
+
+    writeFile(m_treePath + "/c/d/file8", "file8", errorMessage);
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(changes.size(), 1);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/c/d/file8"), true);
+
+    // moved directory
+    fs::rename(m_treePath + "/c", m_treePath + "/e");
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(changes.size(), 4);
+    TEST_EQUAL(hasChange(changes, FILE_REMOVED, m_treePath + "/c/d/file7"), true);
+    TEST_EQUAL(hasChange(changes, FILE_ADDED, m_treePath + "/e/d/file8"), true);
+
+    // removed file in the moved directory
+    fs::remove(m_treePath + "/e/d/file7");
+    TEST_EQUAL(tracker.waitForChanges(changes, 1000, errorMessage), true);
+    TEST_EQUAL(changes.size(), 1);
+    TEST_EQUAL(hasChange(changes, FILE_REMOVED, m_treePath + "/e/d/file7"), true);
+
+    // the manifest contains the changes of the live-mode
+    TEST_EQUAL(tracker.closeTracker(errorMessage), true);
+    TEST_EQUAL(tracker.initTracker(m_treePath, m_manifestPath, errorMessage), true);
+    TEST_EQUAL(tracker.getNumberOfFiles(), 4);
+    TEST_EQUAL(tracker.scanChanges(changes, errorMessage), true);
+    TEST_EQUAL(changes.size(), 0);
+}
+
+/**
+ * closeTest
+ */
+void
+ChangeTracker_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+/**
+ * @brief check if a specific change exist
+ */
+bool
+ChangeTracker_Test::hasChange(const std::vector<FileChange> &changes,
+                              const ChangeType type,
+                              const std::string &path)
+{
+    for(const FileChange &change : changes)
+    {
+        if(change.type == type
+                && change.path == path)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,45 @@
+/**
+ *  @file    change_tracker_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef CHANGE_TRACKER_TEST_H
+#define CHANGE_TRACKER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+#include <libKitsunemimiPersistence/files/change_tracker.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class ChangeTracker_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    ChangeTracker_Test();
+
+private:
+    void initTest();
+    void scanChanges_test();
+    void manifest_test();
+    void waitForChanges_test();
+    void closeTest();
+
+    bool hasChange(const std::vector<FileChange> &changes,
+                   const ChangeType type,
+                   const std::string &path);
+
+    std::string m_directoryPath = "";
+    std::string m_treePath = "";
+    std::string m_manifestPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // CHANGE_TRACKER_TEST_H
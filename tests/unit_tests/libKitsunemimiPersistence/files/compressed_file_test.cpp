@@ -0,0 +1,326 @@
+/**
+ *  @file    compressed_file_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "compressed_file_test.h"
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/compressed_file.h>
+#include <libKitsunemimiPersistence/files/line_reader.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+CompressedFile_Test::CompressedFile_Test()
+    : Kitsunemimi::CompareTestHelper("CompressedFile_Test")
+{
+    initTest();
+    gzip_test();
+    zstd_test();
+    writer_test();
+    lineReader_test();
+    brokenFile_test();
+    failedWrite_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+CompressedFile_Test::initTest()
+{
+    m_directoryPath = "/tmp/compressedFile_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath);
+}
+
+/**
+ * gzip_test
+ */
+void
+CompressedFile_Test::gzip_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/file.gz";
+    std::string content = "";
+    CompressionType compression = NO_COMPRESSION;
+
+    TEST_EQUAL(writeCompressedFile(filePath, "line1\nline2\n", GZIP_COMPRESSION, errorMessage),
+               true);
+    TEST_EQUAL(detectCompression(compression, filePath, errorMessage), true);
+    TEST_EQUAL(compression, GZIP_COMPRESSION);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "line1\nline2\n");
+
+    // appended text is a second gzip-member
+    TEST_EQUAL(appendCompressedText(filePath, "line3\n", GZIP_COMPRESSION, errorMessage), true);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "line1\nline2\nline3\n");
+
+    // uncompressed files are read too
+    writeFile(m_directoryPath + "/plain.txt", "plain text", errorMessage, true);
+    TEST_EQUAL(detectCompression(compression, m_directoryPath + "/plain.txt", errorMessage), true);
+    TEST_EQUAL(compression, NO_COMPRESSION);
+    TEST_EQUAL(readCompressedFile(content, m_directoryPath + "/plain.txt", errorMessage), true);
+    TEST_EQUAL(content, "plain text");
+
+    // negative test: file not exist
+    TEST_EQUAL(readCompressedFile(content, filePath + "_fake", errorMessage), false);
+    TEST_EQUAL(detectCompression(compression, filePath + "_fake", errorMessage), false);
+}
+
+/**
+ * zstd_test
+ */
+void
+CompressedFile_Test::zstd_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/file.zst";
+    std::string content = "";
+
+#ifdef WITH_ZSTD
+    CompressionType compression = NO_COMPRESSION;
+
+    TEST_EQUAL(writeCompressedFile(filePath, "line1\nline2\n", ZSTD_COMPRESSION, errorMessage),
+               true);
+    TEST_EQUAL(detectCompression(compression, filePath, errorMessage), true);
+    TEST_EQUAL(compression, ZSTD_COMPRESSION);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "line1\nline2\n");
+
+    // appended text is a second zstd-frame
+    TEST_EQUAL(appendCompressedText(filePath, "line3\n", ZSTD_COMPRESSION, errorMessage), true);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "line1\nline2\nline3\n");
+
+    // negative test: truncated file
+    std::string text = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    writeCompressedFile(filePath, text, ZSTD_COMPRESSION, errorMessage);
+    fs::resize_file(filePath, fs::file_size(filePath) / 2);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), false);
+#else
+    // negative test: not supported without zstd
+    TEST_EQUAL(writeCompressedFile(filePath, "line1\n", ZSTD_COMPRESSION, errorMessage), false);
+#endif
+}
+
+/**
+ * writer_test
+ */
+void
+CompressedFile_Test::writer_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/writer.gz";
+    std::string content = "";
+
+    // small output-buffer to write the compressed data in multiple parts
+    CompressedWriter writer(GZIP_COMPRESSION, 1, 64);
+    TEST_EQUAL(writer.writeText("abc", errorMessage), false);
+    TEST_EQUAL(writer.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(writer.openFile(filePath, errorMessage), false);
+
+    std::string expected = "";
+    bool writeResult = true;
+    for(uint32_t i = 0; i < 1000; i++)
+    {
+        const std::string line = "line " + std::to_string(i * 7919) + "\n";
+        writeResult = writer.writeText(line, errorMessage) && writeResult;
+        expected += line;
+    }
+    TEST_EQUAL(writeResult, true);
+
+    // file is replaced while closing
+    const bool existsBeforeClose = fs::exists(filePath);
+    TEST_EQUAL(existsBeforeClose, false);
+    TEST_EQUAL(writer.closeFile(errorMessage), true);
+    TEST_EQUAL(writer.closeFile(errorMessage), false);
+
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    const bool sameContent = content == expected;
+    TEST_EQUAL(sameContent, true);
+
+    // reuse the writer for an empty file
+    TEST_EQUAL(writer.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(writer.closeFile(errorMessage), true);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "");
+}
+
+/**
+ * lineReader_test
+ */
+void
+CompressedFile_Test::lineReader_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/lines.gz";
+
+    // many blocks of decompressed data with lines over the block-borders
+    std::string content = "";
+    for(uint32_t i = 0; i < 200000; i++) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    content += "last line without line-break";
+    TEST_EQUAL(writeCompressedFile(filePath, content, GZIP_COMPRESSION, errorMessage), true);
+
+    LineReader reader(4096);
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+
+    std::string_view line;
+    uint32_t numberOfLines = 0;
+    bool linesCorrect = true;
+    while(reader.next(line))
+    {
+        if(numberOfLines < 200000
+                && line != "line " + std::to_string(numberOfLines))
+        {
+            linesCorrect = false;
+        }
+        numberOfLines++;
+    }
+
+    TEST_EQUAL(reader.m_errorMessage, "");
+    TEST_EQUAL(numberOfLines, 200001);
+    TEST_EQUAL(linesCorrect, true);
+    TEST_EQUAL(std::string(line), "last line without line-break");
+
+    // close in the middle of the file
+    TEST_EQUAL(reader.closeFile(), true);
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "line 0");
+    TEST_EQUAL(reader.closeFile(), true);
+}
+
+/**
+ * brokenFile_test
+ */
+void
+CompressedFile_Test::brokenFile_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/broken.gz";
+    std::string content = "";
+
+    std::string text = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    writeCompressedFile(filePath, text, GZIP_COMPRESSION, errorMessage);
+
+    // negative test: truncated file
+    fs::resize_file(filePath, fs::file_size(filePath) / 2);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), false);
+
+    LineReader reader;
+    std::string_view line;
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+    while(reader.next(line)) {}
+    const bool hasError = reader.m_errorMessage.size() > 0;
+    TEST_EQUAL(hasError, true);
+    reader.closeFile();
+
+    // negative test: broken data behind a valid header
+    writeFile(filePath, std::string("\x1f\x8b", 2) + "not really compressed", errorMessage, true);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), false);
+}
+
+/**
+ * failedWrite_test
+ */
+void
+CompressedFile_Test::failedWrite_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/failed.gz";
+    std::string content = "";
+    writeCompressedFile(filePath, "original\n", GZIP_COMPRESSION, errorMessage);
+    const uint64_t originalSize = fs::file_size(filePath);
+
+    // pseudo-random text, which can not be compressed much
+    std::string text = "";
+    uint32_t random = 42;
+    for(uint32_t i = 0; i < 64 * 1024; i++)
+    {
+        random = random * 1103515245 + 12345;
+        text += static_cast<char>('a' + (random >> 16) % 26);
+    }
+
+    // limit the file-size, so writing fails
+    struct rlimit oldLimit;
+    getrlimit(RLIMIT_FSIZE, &oldLimit);
+    struct rlimit newLimit = oldLimit;
+    signal(SIGXFSZ, SIG_IGN);
+
+    // replace the file
+    CompressedWriter writer(GZIP_COMPRESSION, 1, 64);
+    TEST_EQUAL(writer.openFile(filePath, errorMessage), true);
+    newLimit.rlim_cur = 256;
+    setrlimit(RLIMIT_FSIZE, &newLimit);
+    TEST_EQUAL(writer.writeText(text, errorMessage), false);
+    setrlimit(RLIMIT_FSIZE, &oldLimit);
+    TEST_EQUAL(writer.closeFile(errorMessage), false);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "original\n");
+
+    // append to the file
+    TEST_EQUAL(writer.openFile(filePath, errorMessage, true), true);
+    newLimit.rlim_cur = originalSize + 256;
+    setrlimit(RLIMIT_FSIZE, &newLimit);
+    TEST_EQUAL(writer.writeText(text, errorMessage), false);
+    setrlimit(RLIMIT_FSIZE, &oldLimit);
+    TEST_EQUAL(writer.closeFile(errorMessage), false);
+    TEST_EQUAL(fs::file_size(filePath), originalSize);
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "original\n");
+
+    signal(SIGXFSZ, SIG_DFL);
+
+    // a writer, which is not closed, doesn't replace the file
+    {
+        CompressedWriter abandonedWriter;
+        TEST_EQUAL(abandonedWriter.openFile(filePath, errorMessage), true);
+        TEST_EQUAL(abandonedWriter.writeText("abandoned\n", errorMessage), true);
+    }
+    TEST_EQUAL(readCompressedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(content, "original\n");
+
+    // no temporary files are left
+    uint64_t numberOfTempFiles = 0;
+    for(fs::directory_iterator it(m_directoryPath); it != fs::directory_iterator(); it++)
+    {
+        if(it->path().filename().string().find(".tmp.") != std::string::npos) {
+            numberOfTempFiles++;
+        }
+    }
+    TEST_EQUAL(numberOfTempFiles, 0);
+}
+
+/**
+ * closeTest
+ */
+void
+CompressedFile_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,41 @@
+/**
+ *  @file    compressed_file_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef COMPRESSED_FILE_TEST_H
+#define COMPRESSED_FILE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class CompressedFile_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    CompressedFile_Test();
+
+private:
+    void initTest();
+    void gzip_test();
+    void zstd_test();
+    void writer_test();
+    void lineReader_test();
+    void brokenFile_test();
+    void failedWrite_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // COMPRESSED_FILE_TEST_H
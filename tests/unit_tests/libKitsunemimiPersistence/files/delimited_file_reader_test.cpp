@@ -0,0 +1,230 @@
+/**
+ *  @file    delimited_file_reader_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "delimited_file_reader_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/delimited_file_reader.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+DelimitedFileReader_Test::DelimitedFileReader_Test()
+    : Kitsunemimi::CompareTestHelper("DelimitedFileReader_Test")
+{
+    initTest();
+    nextRecord_test();
+    quotedFields_test();
+    readColumns_test();
+    unescapeField_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+DelimitedFileReader_Test::initTest()
+{
+    m_directoryPath = "/tmp/delimitedFileReader_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath);
+}
+
+/**
+ * nextRecord_test
+ */
+void
+DelimitedFileReader_Test::nextRecord_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/simple.tsv";
+    writeFile(filePath, "id\tname\tvalue\r\n1\tpoi\t\r\n2\t\tasdf", errorMessage, true);
+
+    DelimitedFileReader reader('\t');
+    std::vector<std::string_view> fields;
+
+    TEST_EQUAL(reader.nextRecord(fields), false);
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), false);
+
+    TEST_EQUAL(reader.nextRecord(fields), true);
+    TEST_EQUAL(fields.size(), 3);
+    TEST_EQUAL(std::string(fields.at(0)), "id");
+    TEST_EQUAL(std::string(fields.at(2)), "value");
+
+    // empty field at the end before a windows line-break
+    TEST_EQUAL(reader.nextRecord(fields), true);
+    TEST_EQUAL(fields.size(), 3);
+    TEST_EQUAL(std::string(fields.at(1)), "poi");
+    TEST_EQUAL(std::string(fields.at(2)), "");
+
+    // last record without line-break
+    TEST_EQUAL(reader.nextRecord(fields), true);
+    TEST_EQUAL(fields.size(), 3);
+    TEST_EQUAL(std::string(fields.at(1)), "");
+    TEST_EQUAL(std::string(fields.at(2)), "asdf");
+
+    TEST_EQUAL(reader.nextRecord(fields), false);
+    TEST_EQUAL(reader.m_recordNumber, 3);
+
+    TEST_EQUAL(reader.closeFile(), true);
+    TEST_EQUAL(reader.closeFile(), false);
+
+    // empty file
+    writeFile(m_directoryPath + "/empty.csv", "", errorMessage, true);
+    TEST_EQUAL(reader.openFile(m_directoryPath + "/empty.csv", errorMessage), true);
+    TEST_EQUAL(reader.nextRecord(fields), false);
+    reader.closeFile();
+
+    // negative test: file not exist
+    TEST_EQUAL(reader.openFile(filePath + "_fake", errorMessage), false);
+}
+
+/**
+ * quotedFields_test
+ */
+void
+DelimitedFileReader_Test::quotedFields_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/quoted.csv";
+    writeFile(filePath,
+              "\"a,b\",\"multi\nline\",\"say \"\"hello\"\"\"\r\n"
+              "plain,\"\",\"x\"\n",
+              errorMessage,
+              true);
+
+    DelimitedFileReader reader;
+    std::vector<std::string_view> fields;
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+
+    TEST_EQUAL(reader.nextRecord(fields), true);
+    TEST_EQUAL(fields.size(), 3);
+    TEST_EQUAL(std::string(fields.at(0)), "a,b");
+    TEST_EQUAL(std::string(fields.at(1)), "multi\nline");
+    TEST_EQUAL(std::string(fields.at(2)), "say \"\"hello\"\"");
+    TEST_EQUAL(unescapeField(fields.at(2)), "say \"hello\"");
+
+    TEST_EQUAL(reader.nextRecord(fields), true);
+    TEST_EQUAL(fields.size(), 3);
+    TEST_EQUAL(std::string(fields.at(0)), "plain");
+    TEST_EQUAL(std::string(fields.at(1)), "");
+    TEST_EQUAL(std::string(fields.at(2)), "x");
+
+    TEST_EQUAL(reader.nextRecord(fields), false);
+}
+
+/**
+ * readColumns_test
+ */
+void
+DelimitedFileReader_Test::readColumns_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/columns.csv";
+
+    // records with quoted fields, which contain delimiters and line-breaks
+    std::string content = "";
+    for(uint32_t i = 0; i < 2000; i++)
+    {
+        content += std::to_string(i) + ",";
+        if(i % 3 == 0) {
+            content += "\"quoted, with\nline-break and \"\"quotes\"\"\"";
+        } else {
+            content += "value" + std::to_string(i * 31);
+        }
+        if(i % 5 == 0) {
+            content += ",extra";
+        }
+        content += "\n";
+    }
+    writeFile(filePath, content, errorMessage, true);
+
+    DelimitedFileReader reader;
+    TEST_EQUAL(reader.openFile(filePath, errorMessage), true);
+
+    // sequential result as reference
+    std::vector<std::vector<std::string>> expected;
+    std::vector<std::string_view> fields;
+    while(reader.nextRecord(fields))
+    {
+        std::vector<std::string> record;
+        for(const std::string_view &field : fields) {
+            record.push_back(std::string(field));
+        }
+        expected.push_back(record);
+    }
+    TEST_EQUAL(expected.size(), 2000);
+
+    // different chunk-sizes to move the chunk-borders into quoted fields
+    const std::vector<uint64_t> chunkSizes = {1, 7, 64, 1000, 1024 * 1024};
+    for(const uint64_t chunkSize : chunkSizes)
+    {
+        DelimitedColumns columns;
+        TEST_EQUAL(reader.readColumns(columns, errorMessage, 4, chunkSize), true);
+        TEST_EQUAL(columns.numberOfRecords, 2000);
+        TEST_EQUAL(columns.columns.size(), 3);
+
+        bool sameContent = true;
+        for(uint64_t record = 0; record < columns.numberOfRecords; record++)
+        {
+            for(uint64_t column = 0; column < columns.columns.size(); column++)
+            {
+                const std::string_view field = reader.getField(columns.columns[column][record]);
+                const std::vector<std::string> &expectedRecord = expected[record];
+                if(column < expectedRecord.size())
+                {
+                    if(field != expectedRecord[column]) {
+                        sameContent = false;
+                    }
+                }
+                else if(field.size() != 0)
+                {
+                    sameContent = false;
+                }
+            }
+        }
+        TEST_EQUAL(sameContent, true);
+    }
+
+    reader.closeFile();
+
+    // negative test: no file open
+    DelimitedColumns columns;
+    TEST_EQUAL(reader.readColumns(columns, errorMessage), false);
+}
+
+/**
+ * unescapeField_test
+ */
+void
+DelimitedFileReader_Test::unescapeField_test()
+{
+    TEST_EQUAL(unescapeField(""), "");
+    TEST_EQUAL(unescapeField("no quotes"), "no quotes");
+    TEST_EQUAL(unescapeField("\"\"\"\""), "\"\"");
+    TEST_EQUAL(unescapeField("a''b", '\''), "a'b");
+}
+
+/**
+ * closeTest
+ */
+void
+DelimitedFileReader_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,39 @@
+/**
+ *  @file    delimited_file_reader_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef DELIMITED_FILE_READER_TEST_H
+#define DELIMITED_FILE_READER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class DelimitedFileReader_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    DelimitedFileReader_Test();
+
+private:
+    void initTest();
+    void nextRecord_test();
+    void quotedFields_test();
+    void readColumns_test();
+    void unescapeField_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // DELIMITED_FILE_READER_TEST_H
@@ -0,0 +1,194 @@
+/**
+ *  @file    file_cache_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "file_cache_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/file_cache.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+FileCache_Test::FileCache_Test()
+    : Kitsunemimi::CompareTestHelper("FileCache_Test")
+{
+    initTest();
+    readFile_test();
+    changedFile_test();
+    eviction_test();
+    processCache_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+FileCache_Test::initTest()
+{
+    m_directoryPath = "/tmp/fileCache_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath);
+}
+
+/**
+ * readFile_test
+ */
+void
+FileCache_Test::readFile_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/file.txt";
+    writeFile(filePath, "cached content", errorMessage, true);
+
+    FileCache cache;
+    std::shared_ptr<const std::string> content;
+    std::shared_ptr<const std::string> secondContent;
+
+    TEST_EQUAL(cache.readFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(*content, "cached content");
+    TEST_EQUAL(cache.getNumberOfFiles(), 1);
+    TEST_EQUAL(cache.getCacheSize(), 14);
+
+    // second read returns the same buffer
+    TEST_EQUAL(cache.readFile(secondContent, filePath, errorMessage), true);
+    const bool sameBuffer = content.get() == secondContent.get();
+    TEST_EQUAL(sameBuffer, true);
+
+    // content stays valid after removing it from the cache
+    cache.removeFile(filePath);
+    TEST_EQUAL(cache.getNumberOfFiles(), 0);
+    TEST_EQUAL(*content, "cached content");
+
+    // negative test: file not exist
+    TEST_EQUAL(cache.readFile(content, filePath + "_fake", errorMessage), false);
+    TEST_EQUAL(cache.getNumberOfFiles(), 0);
+}
+
+/**
+ * changedFile_test
+ */
+void
+FileCache_Test::changedFile_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/changed.txt";
+    writeFile(filePath, "old content", errorMessage, true);
+
+    FileCache cache;
+    std::shared_ptr<const std::string> content;
+    TEST_EQUAL(cache.readFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(*content, "old content");
+
+    // file with other size
+    appendText(filePath, " and more", errorMessage);
+    TEST_EQUAL(cache.readFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(*content, "old content and more");
+
+    // replaced file with same size
+    writeFileAtomic(filePath, "new content and more", errorMessage);
+    TEST_EQUAL(cache.readFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(*content, "new content and more");
+    TEST_EQUAL(cache.getNumberOfFiles(), 1);
+
+    // deleted file
+    fs::remove(filePath);
+    TEST_EQUAL(cache.readFile(content, filePath, errorMessage), false);
+}
+
+/**
+ * eviction_test
+ */
+void
+FileCache_Test::eviction_test()
+{
+    std::string errorMessage = "";
+    std::shared_ptr<const std::string> content;
+    FileCache cache(250);
+
+    // each file has 100 bytes, so only two fit into the cache
+    for(uint32_t i = 0; i < 3; i++)
+    {
+        const std::string filePath = m_directoryPath + "/evict_" + std::to_string(i);
+        writeFile(filePath, std::string(100, 'a' + static_cast<char>(i)), errorMessage, true);
+    }
+
+    cache.readFile(content, m_directoryPath + "/evict_0", errorMessage);
+    cache.readFile(content, m_directoryPath + "/evict_1", errorMessage);
+    cache.readFile(content, m_directoryPath + "/evict_0", errorMessage);
+    TEST_EQUAL(cache.getNumberOfFiles(), 2);
+
+    // evict_1 is the least recently used file
+    cache.readFile(content, m_directoryPath + "/evict_2", errorMessage);
+    TEST_EQUAL(cache.getNumberOfFiles(), 2);
+    TEST_EQUAL(cache.getCacheSize(), 200);
+
+    std::shared_ptr<const std::string> cached;
+    cache.readFile(cached, m_directoryPath + "/evict_0", errorMessage);
+    cache.readFile(content, m_directoryPath + "/evict_0", errorMessage);
+    const bool stillCached = cached.get() == content.get();
+    TEST_EQUAL(stillCached, true);
+
+    // files bigger than the cache are not cached
+    writeFile(m_directoryPath + "/big", std::string(300, 'x'), errorMessage, true);
+    TEST_EQUAL(cache.readFile(content, m_directoryPath + "/big", errorMessage), true);
+    TEST_EQUAL(content->size(), 300);
+    TEST_EQUAL(cache.getNumberOfFiles(), 2);
+
+    // smaller limit
+    cache.setMaxCacheSize(100);
+    TEST_EQUAL(cache.getNumberOfFiles(), 1);
+    cache.clear();
+    TEST_EQUAL(cache.getNumberOfFiles(), 0);
+    TEST_EQUAL(cache.getCacheSize(), 0);
+}
+
+/**
+ * processCache_test
+ */
+void
+FileCache_Test::processCache_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/process.txt";
+    writeFile(filePath, "process content", errorMessage, true);
+
+    std::shared_ptr<const std::string> content;
+    std::shared_ptr<const std::string> secondContent;
+    TEST_EQUAL(readCachedFile(content, filePath, errorMessage), true);
+    TEST_EQUAL(readCachedFile(secondContent, filePath, errorMessage), true);
+    TEST_EQUAL(*content, "process content");
+    const bool sameBuffer = content.get() == secondContent.get();
+    TEST_EQUAL(sameBuffer, true);
+
+    // disable caching
+    setFileCacheSize(0);
+    TEST_EQUAL(readCachedFile(secondContent, filePath, errorMessage), true);
+    const bool otherBuffer = content.get() != secondContent.get();
+    TEST_EQUAL(otherBuffer, true);
+
+    setFileCacheSize(64 * 1024 * 1024);
+    clearFileCache();
+}
+
+/**
+ * closeTest
+ */
+void
+FileCache_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,39 @@
+/**
+ *  @file    file_cache_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef FILE_CACHE_TEST_H
+#define FILE_CACHE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileCache_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    FileCache_Test();
+
+private:
+    void initTest();
+    void readFile_test();
+    void changedFile_test();
+    void eviction_test();
+    void processCache_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_CACHE_TEST_H
@@ -0,0 +1,281 @@
+/**
+ *  @file    file_filter_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "file_filter_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <time.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/file_filter.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+FileFilter_Test::FileFilter_Test()
+    : Kitsunemimi::CompareTestHelper("FileFilter_Test")
+{
+    initTest();
+    matchGlob_test();
+    addPattern_test();
+    matchFile_test();
+    matchDirectory_test();
+    listFiles_test();
+    iterateFiles_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+FileFilter_Test::initTest()
+{
+    std::string errorMessage = "";
+
+    m_directoryPath = "/tmp/fileFilter_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath + "/src/build");
+    fs::create_directories(m_directoryPath + "/docs");
+    fs::create_directories(m_directoryPath + "/.git/objects");
+
+    writeFile(m_directoryPath + "/README.md", "readme", errorMessage);
+    writeFile(m_directoryPath + "/src/main.cpp", "int main() {}", errorMessage);
+    writeFile(m_directoryPath + "/src/main.h", "", errorMessage);
+    writeFile(m_directoryPath + "/src/data.tar.gz", "0123456789", errorMessage);
+    writeFile(m_directoryPath + "/src/build/main.o", "object", errorMessage);
+    writeFile(m_directoryPath + "/docs/manual.md", "manual", errorMessage);
+    writeFile(m_directoryPath + "/.git/objects/abc", "object", errorMessage);
+}
+
+/**
+ * matchGlob_test
+ */
+void
+FileFilter_Test::matchGlob_test()
+{
+    TEST_EQUAL(matchGlob("*", ""), true);
+    TEST_EQUAL(matchGlob("*", "test.txt"), true);
+    TEST_EQUAL(matchGlob("*.txt", "test.txt"), true);
+    TEST_EQUAL(matchGlob("*.txt", "test.txt.bak"), false);
+    TEST_EQUAL(matchGlob("test?.log", "test1.log"), true);
+    TEST_EQUAL(matchGlob("test?.log", "test.log"), false);
+    TEST_EQUAL(matchGlob("*a*b*c", "xaybzc"), true);
+    TEST_EQUAL(matchGlob("*a*b*c", "xaybzcd"), false);
+    TEST_EQUAL(matchGlob("log[0-9]", "log5"), true);
+    TEST_EQUAL(matchGlob("log[0-9]", "logx"), false);
+    TEST_EQUAL(matchGlob("log[!0-9]", "logx"), true);
+    TEST_EQUAL(matchGlob("log[!0-9]", "log5"), false);
+    TEST_EQUAL(matchGlob("[]x]", "]"), true);
+    TEST_EQUAL(matchGlob("\\*", "*"), true);
+    TEST_EQUAL(matchGlob("\\*", "a"), false);
+}
+
+/**
+ * addPattern_test
+ */
+void
+FileFilter_Test::addPattern_test()
+{
+    FileFilter filter;
+    std::string errorMessage = "";
+
+    TEST_EQUAL(filter.addIncludePattern("*.cpp", errorMessage), true);
+    TEST_EQUAL(filter.addIncludePattern("test[0-9", errorMessage), false);
+    TEST_EQUAL(filter.addIncludePattern("src/*.cpp", errorMessage), false);
+    TEST_EQUAL(filter.addIncludePattern("", errorMessage), false);
+    TEST_EQUAL(filter.addExcludePattern("\\[", errorMessage), true);
+    TEST_EQUAL(filter.addExcludedDirectory("build", errorMessage), true);
+}
+
+/**
+ * matchFile_test
+ */
+void
+FileFilter_Test::matchFile_test()
+{
+    std::string errorMessage = "";
+    FileEntry entry;
+    entry.m_type = FILE_ENTRY;
+
+    // without rules all files are accepted
+    FileFilter emptyFilter;
+    entry.m_name = "test.txt";
+    TEST_EQUAL(emptyFilter.matchFile(entry), true);
+
+    FileFilter filter;
+    filter.addIncludePattern("Makefile", errorMessage);
+    filter.addIncludePattern("*.tar.gz", errorMessage);
+    filter.addIncludePattern("test_*.log", errorMessage);
+    filter.addIncludeExtension("cpp");
+    filter.addIncludeExtension(".h");
+    filter.addExcludePattern("*_old.cpp", errorMessage);
+    filter.addExcludeExtension("tmp");
+
+    entry.m_name = "Makefile";
+    TEST_EQUAL(filter.matchFile(entry), true);
+    entry.m_name = "archive.tar.gz";
+    TEST_EQUAL(filter.matchFile(entry), true);
+    entry.m_name = "archive.gz";
+    TEST_EQUAL(filter.matchFile(entry), false);
+    entry.m_name = "test_1.log";
+    TEST_EQUAL(filter.matchFile(entry), true);
+    entry.m_name = "main.cpp";
+    TEST_EQUAL(filter.matchFile(entry), true);
+    entry.m_name = "main.h";
+    TEST_EQUAL(filter.matchFile(entry), true);
+    entry.m_name = "main_old.cpp";
+    TEST_EQUAL(filter.matchFile(entry), false);
+    entry.m_name = "main.cpp.tmp";
+    TEST_EQUAL(filter.matchFile(entry), false);
+    entry.m_name = "main.hpp";
+    TEST_EQUAL(filter.matchFile(entry), false);
+}
+
+/**
+ * matchDirectory_test
+ */
+void
+FileFilter_Test::matchDirectory_test()
+{
+    std::string errorMessage = "";
+    FileEntry entry;
+    entry.m_type = DIRECTORY_ENTRY;
+
+    FileFilter filter;
+    filter.addExcludedDirectory(".git", errorMessage);
+    filter.addExcludedDirectory("build*", errorMessage);
+    // file-rules don't affect directories
+    filter.addIncludePattern("*.cpp", errorMessage);
+
+    entry.m_name = ".git";
+    TEST_EQUAL(filter.matchDirectory(entry), false);
+    entry.m_name = "build_debug";
+    TEST_EQUAL(filter.matchDirectory(entry), false);
+    entry.m_name = "src";
+    TEST_EQUAL(filter.matchDirectory(entry), true);
+}
+
+/**
+ * listFiles_test
+ */
+void
+FileFilter_Test::listFiles_test()
+{
+    std::string errorMessage = "";
+    std::vector<std::string> fileList;
+
+    // excluded directories and extensions
+    FileFilter filter;
+    filter.addExcludedDirectory(".git", errorMessage);
+    filter.addExcludedDirectory("build", errorMessage);
+    filter.addExcludeExtension("md");
+
+    bool result = listFiles(fileList, m_directoryPath, filter);
+    TEST_EQUAL(result, true);
+    std::sort(fileList.begin(), fileList.end());
+    TEST_EQUAL(fileList.size(), 3);
+    TEST_EQUAL(fileList.at(0), m_directoryPath + "/src/data.tar.gz");
+    TEST_EQUAL(fileList.at(1), m_directoryPath + "/src/main.cpp");
+    TEST_EQUAL(fileList.at(2), m_directoryPath + "/src/main.h");
+    fileList.clear();
+
+    // size-range
+    FileFilter sizeFilter;
+    sizeFilter.setSizeRange(1, 6);
+    result = listFiles(fileList, m_directoryPath, sizeFilter);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fileList.size(), 4);
+    fileList.clear();
+
+    // modification-time-range
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const int64_t nowTime = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    const int64_t hour = static_cast<int64_t>(3600) * 1000000000;
+
+    FileFilter timeFilter;
+    timeFilter.setModificationTimeRange(nowTime - hour, nowTime + hour);
+    result = listFiles(fileList, m_directoryPath, timeFilter);
+    TEST_EQUAL(fileList.size(), 7);
+    fileList.clear();
+
+    timeFilter.setModificationTimeRange(0, nowTime - hour);
+    result = listFiles(fileList, m_directoryPath, timeFilter);
+    TEST_EQUAL(fileList.size(), 0);
+    fileList.clear();
+
+    // file as root-path
+    FileFilter cppFilter;
+    cppFilter.addIncludeExtension("cpp");
+    result = listFiles(fileList, m_directoryPath + "/src/main.cpp", cppFilter);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fileList.size(), 1);
+    fileList.clear();
+
+    result = listFiles(fileList, m_directoryPath + "/src/main.h", cppFilter);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fileList.size(), 0);
+
+    // exceptions are only names and no patterns
+    result = listFiles(fileList, m_directoryPath, true, {".git", "build"});
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fileList.size(), 5);
+    fileList.clear();
+
+    result = listFiles(fileList, m_directoryPath, true, {".*", "b*", "[invalid"});
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fileList.size(), 7);
+    fileList.clear();
+}
+
+/**
+ * iterateFiles_test
+ */
+void
+FileFilter_Test::iterateFiles_test()
+{
+    std::string errorMessage = "";
+
+    FileFilter filter;
+    filter.addIncludePattern("main.*", errorMessage);
+
+    std::atomic<uint64_t> numberOfFiles(0);
+    std::atomic<uint64_t> numberOfDirs(0);
+    auto countEntries = [&](FileEntry &entry)
+    {
+        if(entry.m_type == DIRECTORY_ENTRY) {
+            numberOfDirs++;
+        } else {
+            numberOfFiles++;
+        }
+        return CONTINUE_WALK;
+    };
+
+    const bool result = iterateFiles(m_directoryPath, filter, countEntries, errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(numberOfFiles.load(), 3);
+    TEST_EQUAL(numberOfDirs.load(), 0);
+}
+
+/**
+ * closeTest
+ */
+void
+FileFilter_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,41 @@
+/**
+ *  @file    file_filter_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef FILE_FILTER_TEST_H
+#define FILE_FILTER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileFilter_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    FileFilter_Test();
+
+private:
+    void initTest();
+    void matchGlob_test();
+    void addPattern_test();
+    void matchFile_test();
+    void matchDirectory_test();
+    void listFiles_test();
+    void iterateFiles_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FILTER_TEST_H
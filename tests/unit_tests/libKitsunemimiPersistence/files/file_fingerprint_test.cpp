@@ -0,0 +1,229 @@
+/**
+ *  @file    file_fingerprint_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "file_fingerprint_test.h"
+
+#include <time.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/file_fingerprint.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+FileFingerprint_Test::FileFingerprint_Test()
+    : Kitsunemimi::CompareTestHelper("FileFingerprint_Test")
+{
+    initTest();
+    getFingerprint_test();
+    findDuplicates_test();
+    cache_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+FileFingerprint_Test::initTest()
+{
+    std::string errorMessage = "";
+    m_directoryPath = "/tmp/fileFingerprint_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath + "/sub");
+
+    std::string content = "";
+    for(uint32_t i = 0; i < 200 * 1024; i++) {
+        content.push_back(static_cast<char>('a' + (i * 7) % 26));
+    }
+
+    // identical files
+    writeFile(m_directoryPath + "/a", content, errorMessage);
+    writeFile(m_directoryPath + "/sub/b", content, errorMessage);
+
+    // same size and same first block, but different end
+    std::string changedEnd = content;
+    changedEnd[changedEnd.size() - 1] = '0';
+    writeFile(m_directoryPath + "/c", changedEnd, errorMessage);
+
+    // same size, but different first block
+    std::string changedStart = content;
+    changedStart[0] = '0';
+    writeFile(m_directoryPath + "/d", changedStart, errorMessage);
+
+    // unique size
+    writeFile(m_directoryPath + "/e", content + "e", errorMessage);
+
+    // identical small files and empty files
+    writeFile(m_directoryPath + "/sub/f", "hello", errorMessage);
+    writeFile(m_directoryPath + "/g", "hello", errorMessage);
+    writeFile(m_directoryPath + "/h", "", errorMessage);
+    writeFile(m_directoryPath + "/sub/i", "", errorMessage);
+}
+
+/**
+ * getFingerprint_test
+ */
+void
+FileFingerprint_Test::getFingerprint_test()
+{
+    std::string errorMessage = "";
+    FingerprintEngine engine(4);
+    FileFingerprint fingerprintA;
+    FileFingerprint fingerprintB;
+    FileFingerprint fingerprintC;
+
+    TEST_EQUAL(engine.getFingerprint(fingerprintA, m_directoryPath + "/a", errorMessage), true);
+    TEST_EQUAL(engine.m_readBytes, 200 * 1024);
+    TEST_EQUAL(engine.getFingerprint(fingerprintB, m_directoryPath + "/sub/b", errorMessage), true);
+    TEST_EQUAL(engine.getFingerprint(fingerprintC, m_directoryPath + "/c", errorMessage), true);
+
+    const bool equalAB = fingerprintA == fingerprintB;
+    const bool equalAC = fingerprintA == fingerprintC;
+    TEST_EQUAL(equalAB, true);
+    TEST_EQUAL(equalAC, false);
+
+    // no regular file
+    TEST_EQUAL(engine.getFingerprint(fingerprintA, m_directoryPath + "/sub", errorMessage), false);
+    TEST_EQUAL(engine.getFingerprint(fingerprintA, m_directoryPath + "/x", errorMessage), false);
+}
+
+/**
+ * findDuplicates_test
+ */
+void
+FileFingerprint_Test::findDuplicates_test()
+{
+    std::string errorMessage = "";
+    std::vector<DuplicateGroup> groups;
+    FingerprintEngine engine(4);
+
+    TEST_EQUAL(engine.findDuplicates(groups, m_directoryPath, errorMessage), true);
+    TEST_EQUAL(groups.size(), 2);
+    if(groups.size() == 2)
+    {
+        TEST_EQUAL(groups[0].fileSize, 200 * 1024);
+        TEST_EQUAL(groups[0].paths.size(), 2);
+        TEST_EQUAL(groups[0].paths[0], m_directoryPath + "/a");
+        TEST_EQUAL(groups[0].paths[1], m_directoryPath + "/sub/b");
+        TEST_EQUAL(groups[1].fileSize, 5);
+        TEST_EQUAL(groups[1].paths.size(), 2);
+    }
+
+    // the file with unique size is never read, the file with different first block is only read
+    // partially and only the remaining big files are read completely
+    const uint64_t expectedBytes = 4 * 64 * 1024 + 2 * 5 + 3 * 200 * 1024;
+    TEST_EQUAL(engine.m_readBytes, expectedBytes);
+
+    // with empty files
+    TEST_EQUAL(engine.findDuplicates(groups, m_directoryPath, errorMessage, 0), true);
+    TEST_EQUAL(groups.size(), 3);
+
+    // list of paths, which contains a missing file and a directory
+    std::vector<std::string> paths;
+    paths.push_back(m_directoryPath + "/a");
+    paths.push_back(m_directoryPath + "/c");
+    paths.push_back(m_directoryPath + "/d");
+    paths.push_back(m_directoryPath + "/sub");
+    paths.push_back(m_directoryPath + "/missing");
+    TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+    TEST_EQUAL(groups.size(), 0);
+
+    paths.push_back(m_directoryPath + "/sub/b");
+    TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+    TEST_EQUAL(groups.size(), 1);
+
+    // missing root
+    TEST_EQUAL(engine.findDuplicates(groups, m_directoryPath + "/missing", errorMessage), false);
+}
+
+/**
+ * cache_test
+ */
+void
+FileFingerprint_Test::cache_test()
+{
+    std::string errorMessage = "";
+    std::vector<DuplicateGroup> groups;
+    const std::string cachePath = m_directoryPath + "/../fileFingerprint_cache";
+
+    std::vector<std::string> paths;
+    listFiles(paths, m_directoryPath);
+    for(const std::string &path : paths) {
+        setOldTimestamp(path);
+    }
+
+    {
+        FingerprintEngine engine(4);
+        TEST_EQUAL(engine.loadCache(cachePath, errorMessage), true);
+        TEST_EQUAL(engine.getNumberOfCachedFiles(), 0);
+
+        TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+        TEST_EQUAL(groups.size(), 2);
+        TEST_EQUAL(engine.getNumberOfCachedFiles(), 6);
+
+        // unchanged files are not read again
+        TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+        TEST_EQUAL(groups.size(), 2);
+        TEST_EQUAL(engine.m_readBytes, 0);
+
+        TEST_EQUAL(engine.saveCache(cachePath, errorMessage), true);
+    }
+
+    // cache from file
+    FingerprintEngine engine(4);
+    TEST_EQUAL(engine.loadCache(cachePath, errorMessage), true);
+    TEST_EQUAL(engine.getNumberOfCachedFiles(), 6);
+    TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+    TEST_EQUAL(groups.size(), 2);
+    TEST_EQUAL(engine.m_readBytes, 0);
+
+    // changed file is read again
+    writeFile(m_directoryPath + "/g", "world", errorMessage);
+    fs::last_write_time(m_directoryPath + "/g", time(nullptr) - 200);
+    TEST_EQUAL(engine.findDuplicates(groups, paths, errorMessage), true);
+    TEST_EQUAL(groups.size(), 1);
+    TEST_EQUAL(engine.m_readBytes, 5);
+
+    // broken cache-file
+    std::string content = "";
+    readFile(content, cachePath, errorMessage);
+    content[content.size() - 1] ^= 0x55;
+    writeFile(cachePath, content, errorMessage);
+    FingerprintEngine brokenEngine;
+    TEST_EQUAL(brokenEngine.loadCache(cachePath, errorMessage), false);
+    TEST_EQUAL(brokenEngine.getNumberOfCachedFiles(), 0);
+
+    fs::remove(cachePath);
+}
+
+/**
+ * closeTest
+ */
+void
+FileFingerprint_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+/**
+ * @brief set the modification-time of a file into the past, so its fingerprint can be cached
+ */
+void
+FileFingerprint_Test::setOldTimestamp(const std::string &path)
+{
+    fs::last_write_time(path, time(nullptr) - 100);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
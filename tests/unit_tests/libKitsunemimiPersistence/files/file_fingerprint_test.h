@@ -0,0 +1,40 @@
+/**
+ *  @file    file_fingerprint_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef FILE_FINGERPRINT_TEST_H
+#define FILE_FINGERPRINT_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileFingerprint_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    FileFingerprint_Test();
+
+private:
+    void initTest();
+    void getFingerprint_test();
+    void findDuplicates_test();
+    void cache_test();
+    void closeTest();
+
+    void setOldTimestamp(const std::string &path);
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FINGERPRINT_TEST_H
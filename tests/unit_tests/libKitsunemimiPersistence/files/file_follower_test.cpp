@@ -0,0 +1,212 @@
+/**
+ *  @file    file_follower_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "file_follower_test.h"
+
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/file_follower.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+FileFollower_Test::FileFollower_Test()
+    : Kitsunemimi::CompareTestHelper("FileFollower_Test")
+{
+    initTest();
+    readNewLines_test();
+    truncate_test();
+    rotation_test();
+    waitForChange_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+FileFollower_Test::initTest()
+{
+    m_directoryPath = "/tmp/fileFollower_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath);
+}
+
+/**
+ * readNewLines_test
+ */
+void
+FileFollower_Test::readNewLines_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/read.log";
+    writeFile(filePath, "line1\nline2\n", errorMessage, true);
+
+    // small buffer to split lines over multiple reads
+    FileFollower follower(4);
+    std::vector<std::string> lines;
+
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), false);
+    TEST_EQUAL(follower.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(follower.openFile(filePath, errorMessage), false);
+
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 2);
+    TEST_EQUAL(lines.at(0), "line1");
+    TEST_EQUAL(lines.at(1), "line2");
+
+    // nothing new
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 0);
+
+    // incomplete line is held back
+    appendText(filePath, "line3-part", errorMessage);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 0);
+
+    appendText(filePath, "-end\nline4\n", errorMessage);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 2);
+    TEST_EQUAL(lines.at(0), "line3-part-end");
+    TEST_EQUAL(lines.at(1), "line4");
+    TEST_EQUAL(follower.m_position, 33);
+
+    TEST_EQUAL(follower.closeFile(), true);
+    TEST_EQUAL(follower.closeFile(), false);
+
+    // begin at the end of the file
+    TEST_EQUAL(follower.openFile(filePath, errorMessage, false), true);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 0);
+    appendText(filePath, "line5\n", errorMessage);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+    TEST_EQUAL(lines.at(0), "line5");
+    follower.closeFile();
+
+    // negative test: file not exist
+    TEST_EQUAL(follower.openFile(filePath + "_fake", errorMessage), false);
+}
+
+/**
+ * truncate_test
+ */
+void
+FileFollower_Test::truncate_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/truncate.log";
+    writeFile(filePath, "old line 1\nold line 2\n", errorMessage, true);
+
+    FileFollower follower;
+    std::vector<std::string> lines;
+    TEST_EQUAL(follower.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 2);
+
+    // truncate the file in place and write new content
+    fs::resize_file(filePath, 0);
+    appendText(filePath, "new\n", errorMessage);
+
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+    TEST_EQUAL(lines.at(0), "new");
+}
+
+/**
+ * rotation_test
+ */
+void
+FileFollower_Test::rotation_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/rotate.log";
+    writeFile(filePath, "first\n", errorMessage, true);
+
+    FileFollower follower;
+    std::vector<std::string> lines;
+    TEST_EQUAL(follower.openFile(filePath, errorMessage), true);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+
+    // rest of the old file is read before the new file
+    appendText(filePath, "second\nincomplete", errorMessage);
+    fs::rename(filePath, filePath + ".1");
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+    TEST_EQUAL(lines.at(0), "second");
+
+    writeFile(filePath, "third\n", errorMessage, true);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 2);
+    TEST_EQUAL(lines.at(0), "incomplete");
+    TEST_EQUAL(lines.at(1), "third");
+
+    appendText(filePath, "fourth\n", errorMessage);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+    TEST_EQUAL(lines.at(0), "fourth");
+}
+
+/**
+ * waitForChange_test
+ */
+void
+FileFollower_Test::waitForChange_test()
+{
+    std::string errorMessage = "";
+    const std::string filePath = m_directoryPath + "/wait.log";
+    writeFile(filePath, "", errorMessage, true);
+    writeFile(m_directoryPath + "/other.log", "", errorMessage, true);
+
+    FileFollower follower;
+    std::vector<std::string> lines;
+    TEST_EQUAL(follower.openFile(filePath, errorMessage), true);
+
+    TEST_EQUAL(follower.waitForChange(10), false);
+
+    // changes of other files in the directory are ignored
+    appendText(m_directoryPath + "/other.log", "other\n", errorMessage);
+    TEST_EQUAL(follower.waitForChange(10), false);
+
+    appendText(filePath, "changed\n", errorMessage);
+    TEST_EQUAL(follower.waitForChange(1000), true);
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+    TEST_EQUAL(lines.at(0), "changed");
+
+    // events of other files don't end the wait for the followed file
+    lines.clear();
+    appendText(m_directoryPath + "/other.log", "other\n", errorMessage);
+    std::thread writer([filePath]() {
+        std::string writeError = "";
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        appendText(filePath, "later\n", writeError);
+    });
+    TEST_EQUAL(follower.waitForChange(2000), true);
+    writer.join();
+    TEST_EQUAL(follower.readNewLines(lines, errorMessage), true);
+    TEST_EQUAL(lines.size(), 1);
+}
+
+/**
+ * closeTest
+ */
+void
+FileFollower_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
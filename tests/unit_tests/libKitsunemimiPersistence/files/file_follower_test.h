@@ -0,0 +1,39 @@
+/**
+ *  @file    file_follower_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef FILE_FOLLOWER_TEST_H
+#define FILE_FOLLOWER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class FileFollower_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    FileFollower_Test();
+
+private:
+    void initTest();
+    void readNewLines_test();
+    void truncate_test();
+    void rotation_test();
+    void waitForChange_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // FILE_FOLLOWER_TEST_H
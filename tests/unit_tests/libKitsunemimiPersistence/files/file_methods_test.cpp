@@ -21,7 +21,12 @@
  */
 
 #include "file_methods_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <libKitsunemimiPersistence/files/file_methods.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
 #include <libKitsunemimiCommon/process_execution.h>
 
 using Kitsunemimi::runSyncProcess;
@@ -38,6 +43,7 @@ FileMethods_Test::FileMethods_Test()
     : Kitsunemimi::CompareTestHelper("FileMethods_Test")
 {
     listFiles_test();
+    iterateFiles_test();
     renameFileOrDir_test();
     copyPath_test();
     createDirectory_test();
@@ -83,9 +89,149 @@ FileMethods_Test::listFiles_test()
     TEST_EQUAL(fileList.size(), 4);
     fileList.clear();
 
+    // exceptions are compared literally and not as glob-patterns
+    listFiles(fileList, "/tmp/listFiles_test/", true, std::vector<std::string>() = {"test*"});
+    TEST_EQUAL(fileList.size(), 6);
+    fileList.clear();
+
+    // paths of the found files
+    listFiles(fileList, "/tmp/listFiles_test/test1/");
+    std::sort(fileList.begin(), fileList.end());
+    TEST_EQUAL(fileList.size(), 2);
+    TEST_EQUAL(fileList.at(0), "/tmp/listFiles_test/test1/poi1");
+    TEST_EQUAL(fileList.at(1), "/tmp/listFiles_test/test1/poi2");
+    fileList.clear();
+
+    // non-existing path
+    bool result = listFiles(fileList, "/tmp/listFiles_test/fail");
+    TEST_EQUAL(result, false);
+    TEST_EQUAL(fileList.size(), 0);
+
+    // deeper tree with many directories, which are read by multiple threads
+    for(const std::string level1 : {"a", "b", "c", "d"})
+    {
+        for(const std::string level2 : {"1", "2", "3", "4", "5"})
+        {
+            for(const std::string level3 : {"x", "y", "z"})
+            {
+                const std::string dirPath = "/tmp/listFiles_test/deep/"
+                                            + level1 + "/" + level2 + "/" + level3;
+                runSyncProcess(std::string("mkdir -p " + dirPath).c_str());
+                runSyncProcess(std::string("touch " + dirPath + "/file").c_str());
+            }
+        }
+    }
+    runSyncProcess(std::string("ln -s /tmp/listFiles_test/test2 /tmp/listFiles_test/deep/link")
+                   .c_str());
+
+    result = listFiles(fileList, "/tmp/listFiles_test/deep");
+    TEST_EQUAL(result, true);
+    // symbolic links to directories are listed, but not followed
+    TEST_EQUAL(fileList.size(), 61);
+    std::sort(fileList.begin(), fileList.end());
+    const bool isUnique = std::unique(fileList.begin(), fileList.end()) == fileList.end();
+    TEST_EQUAL(isUnique, true);
+    TEST_EQUAL(fileList.at(0), "/tmp/listFiles_test/deep/a/1/x/file");
+    fileList.clear();
+
     runSyncProcess(std::string("rm -r /tmp/listFiles_test/").c_str());
 }
 
+/**
+ * @brief iterateFiles_test
+ */
+void
+FileMethods_Test::iterateFiles_test()
+{
+    bool result = false;
+    std::string errorMessage = "";
+
+    runSyncProcess(std::string("rm -r /tmp/iterateFiles_test/").c_str());
+    runSyncProcess(std::string("mkdir -p /tmp/iterateFiles_test/test1").c_str());
+    runSyncProcess(std::string("mkdir -p /tmp/iterateFiles_test/test2").c_str());
+    runSyncProcess(std::string("touch /tmp/iterateFiles_test/test1/poi1").c_str());
+    runSyncProcess(std::string("touch /tmp/iterateFiles_test/test2/poi1").c_str());
+    runSyncProcess(std::string("touch /tmp/iterateFiles_test/test2/poi2").c_str());
+    writeFile("/tmp/iterateFiles_test/poi1", "12345", errorMessage);
+
+    // all entries with metadata
+    std::mutex lock;
+    std::vector<std::string> paths;
+    uint64_t numberOfDirs = 0;
+    uint64_t fileSize = 0;
+    int64_t modificationTime = 0;
+    auto collectEntries = [&](FileEntry &entry)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        paths.push_back(entry.getPath());
+        if(entry.m_type == DIRECTORY_ENTRY) {
+            numberOfDirs++;
+        }
+        if(entry.getPath() == "/tmp/iterateFiles_test/poi1")
+        {
+            entry.getSize(fileSize);
+            entry.getModificationTime(modificationTime);
+        }
+        return CONTINUE_WALK;
+    };
+
+    result = iterateFiles("/tmp/iterateFiles_test", collectEntries, errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(paths.size(), 6);
+    TEST_EQUAL(numberOfDirs, 2);
+    TEST_EQUAL(fileSize, 5);
+    const bool hasTime = modificationTime > 0;
+    TEST_EQUAL(hasTime, true);
+    paths.clear();
+
+    // skip directory
+    auto skipTest2 = [&](FileEntry &entry)
+    {
+        if(entry.m_name == "test2") {
+            return SKIP_DIRECTORY;
+        }
+
+        std::unique_lock<std::mutex> guard(lock);
+        paths.push_back(entry.getPath());
+        return CONTINUE_WALK;
+    };
+
+    result = iterateFiles("/tmp/iterateFiles_test", skipTest2, errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(paths.size(), 3);
+    paths.clear();
+
+    // early termination
+    std::atomic<uint64_t> counter(0);
+    auto stopAfterTwo = [&](FileEntry &)
+    {
+        counter++;
+        if(counter == 2) {
+            return STOP_WALK;
+        }
+        return CONTINUE_WALK;
+    };
+
+    result = iterateFiles("/tmp/iterateFiles_test", stopAfterTwo, errorMessage, true, 1);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(counter.load(), 2);
+
+    // file as root-path
+    result = iterateFiles("/tmp/iterateFiles_test/poi1", collectEntries, errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(paths.size(), 1);
+    TEST_EQUAL(paths.at(0), "/tmp/iterateFiles_test/poi1");
+    TEST_EQUAL(fileSize, 5);
+    paths.clear();
+
+    // non-existing path
+    result = iterateFiles("/tmp/iterateFiles_test/fail", collectEntries, errorMessage);
+    TEST_EQUAL(result, false);
+    TEST_EQUAL(paths.size(), 0);
+
+    runSyncProcess(std::string("rm -r /tmp/iterateFiles_test/").c_str());
+}
+
 /**
  * @brief renameFileOrDir_test
  */
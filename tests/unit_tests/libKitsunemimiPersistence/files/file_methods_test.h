@@ -38,6 +38,7 @@ public:
 
 private:
     void listFiles_test();
+    void iterateFiles_test();
     void renameFileOrDir_test();
     void copyPath_test();
     void createDirectory_test();
@@ -0,0 +1,259 @@
+/**
+ *  @file    line_index_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "line_index_test.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/line_index.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+LineIndex_Test::LineIndex_Test()
+    : Kitsunemimi::CompareTestHelper("LineIndex_Test")
+{
+    initTest();
+    openIndex_test();
+    readLine_test();
+    replaceLine_test();
+    updateIndex_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+LineIndex_Test::initTest()
+{
+    m_filePath = "/tmp/lineIndex_test.txt";
+    deleteFiles();
+}
+
+/**
+ * openIndex_test
+ */
+void
+LineIndex_Test::openIndex_test()
+{
+    std::string errorMessage = "";
+    writeFile(m_filePath, "line 0\nline 1\nline 2\n", errorMessage, true);
+
+    LineIndex index;
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 3);
+    TEST_EQUAL(fs::exists(m_filePath + ".lidx"), true);
+
+    // negative test: already open
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), false);
+
+    TEST_EQUAL(index.closeIndex(), true);
+    TEST_EQUAL(index.closeIndex(), false);
+
+    // reopen with existing sidecar-file
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 3);
+    index.closeIndex();
+
+    // broken sidecar-file is rebuild
+    writeFile(m_filePath + ".lidx", "broken", errorMessage, true);
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 3);
+    index.closeIndex();
+
+    // negative test: file not exist
+    TEST_EQUAL(index.openIndex(m_filePath + "_fake", errorMessage), false);
+    TEST_EQUAL(fs::exists(m_filePath + "_fake"), false);
+
+    deleteFiles();
+}
+
+/**
+ * readLine_test
+ */
+void
+LineIndex_Test::readLine_test()
+{
+    std::string errorMessage = "";
+    std::string line = "";
+    writeFile(m_filePath, "first\n\nthird\nlast", errorMessage, true);
+
+    LineIndex index;
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 4);
+
+    TEST_EQUAL(index.readLine(3, line, errorMessage), true);
+    TEST_EQUAL(line, "last");
+    TEST_EQUAL(index.readLine(0, line, errorMessage), true);
+    TEST_EQUAL(line, "first");
+    TEST_EQUAL(index.readLine(1, line, errorMessage), true);
+    TEST_EQUAL(line, "");
+    TEST_EQUAL(index.readLine(2, line, errorMessage), true);
+    TEST_EQUAL(line, "third");
+
+    // negative test: line not exist
+    TEST_EQUAL(index.readLine(4, line, errorMessage), false);
+
+    // empty file
+    index.closeIndex();
+    writeFile(m_filePath, "", errorMessage, true);
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 0);
+
+    deleteFiles();
+}
+
+/**
+ * replaceLine_test
+ */
+void
+LineIndex_Test::replaceLine_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+    std::string line = "";
+
+    std::string fileContent = "";
+    for(uint32_t i = 0; i < 1000; i++) {
+        fileContent += "line " + std::to_string(i) + "\n";
+    }
+    writeFile(m_filePath, fileContent, errorMessage, true);
+
+    LineIndex index;
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+
+    // same size
+    TEST_EQUAL(index.replaceLine(10, "LINE 10", errorMessage), true);
+    // bigger
+    TEST_EQUAL(index.replaceLine(20, "this is a much longer line 20", errorMessage), true);
+    // smaller
+    TEST_EQUAL(index.replaceLine(30, "", errorMessage), true);
+    // last line
+    TEST_EQUAL(index.replaceLine(999, "end", errorMessage), true);
+
+    std::string expected = "";
+    for(uint32_t i = 0; i < 1000; i++)
+    {
+        if(i == 10) {
+            expected += "LINE 10\n";
+        } else if(i == 20) {
+            expected += "this is a much longer line 20\n";
+        } else if(i == 30) {
+            expected += "\n";
+        } else if(i == 999) {
+            expected += "end\n";
+        } else {
+            expected += "line " + std::to_string(i) + "\n";
+        }
+    }
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, expected);
+
+    TEST_EQUAL(index.getNumberOfLines(), 1000);
+    TEST_EQUAL(index.readLine(21, line, errorMessage), true);
+    TEST_EQUAL(line, "line 21");
+    TEST_EQUAL(index.readLine(999, line, errorMessage), true);
+    TEST_EQUAL(line, "end");
+
+    // index is still valid after reopen
+    index.closeIndex();
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.readLine(31, line, errorMessage), true);
+    TEST_EQUAL(line, "line 31");
+
+    // negative tests
+    TEST_EQUAL(index.replaceLine(1000, "asdf", errorMessage), false);
+    TEST_EQUAL(index.replaceLine(5, "as\ndf", errorMessage), false);
+
+    deleteFiles();
+}
+
+/**
+ * updateIndex_test
+ */
+void
+LineIndex_Test::updateIndex_test()
+{
+    std::string errorMessage = "";
+    std::string line = "";
+    writeFile(m_filePath, "line 0\nline 1\nincomplete", errorMessage, true);
+
+    LineIndex index;
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 3);
+
+    // continue the last line and add new lines
+    appendText(m_filePath, " line 2\nline 3\n", errorMessage);
+    TEST_EQUAL(index.updateIndex(errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 4);
+    TEST_EQUAL(index.readLine(2, line, errorMessage), true);
+    TEST_EQUAL(line, "incomplete line 2");
+    TEST_EQUAL(index.readLine(3, line, errorMessage), true);
+    TEST_EQUAL(line, "line 3");
+
+    // rewrite in-place with the same inode, where the file also grew
+    {
+        std::ofstream file(m_filePath, std::ios::out | std::ios::trunc);
+        file << "LINE 0 changed\nline 1\nincomplete line 2\nline 3\nline 4\n";
+    }
+    TEST_EQUAL(index.readLine(0, line, errorMessage), true);
+    TEST_EQUAL(line, "LINE 0 changed");
+    TEST_EQUAL(index.getNumberOfLines(), 5);
+    TEST_EQUAL(index.readLine(4, line, errorMessage), true);
+    TEST_EQUAL(line, "line 4");
+
+    // replace the file by a rename, so it gets a new inode
+    writeFile(m_filePath, "aaa\nbbb\nccc\n", errorMessage, true);
+    TEST_EQUAL(index.updateIndex(errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 3);
+    TEST_EQUAL(writeFileAtomic(m_filePath, "X\nY\n", errorMessage), true);
+    TEST_EQUAL(index.readLine(1, line, errorMessage), true);
+    TEST_EQUAL(line, "Y");
+    TEST_EQUAL(index.getNumberOfLines(), 2);
+    TEST_EQUAL(index.replaceLine(0, "new X", errorMessage), true);
+    TEST_EQUAL(readFile(line, m_filePath, errorMessage), true);
+    TEST_EQUAL(line, "new X\nY\n");
+
+    // changes, while the index was closed
+    index.closeIndex();
+    writeFile(m_filePath, "a\nb", errorMessage, true);
+    TEST_EQUAL(index.openIndex(m_filePath, errorMessage), true);
+    TEST_EQUAL(index.getNumberOfLines(), 2);
+    TEST_EQUAL(index.readLine(1, line, errorMessage), true);
+    TEST_EQUAL(line, "b");
+
+    deleteFiles();
+}
+
+/**
+ * closeTest
+ */
+void
+LineIndex_Test::closeTest()
+{
+    deleteFiles();
+}
+
+/**
+ * common usage to delete test-files
+ */
+void
+LineIndex_Test::deleteFiles()
+{
+    fs::remove(m_filePath);
+    fs::remove(m_filePath + ".lidx");
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,40 @@
+/**
+ *  @file    line_index_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef LINE_INDEX_TEST_H
+#define LINE_INDEX_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class LineIndex_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    LineIndex_Test();
+
+private:
+    void initTest();
+    void openIndex_test();
+    void readLine_test();
+    void replaceLine_test();
+    void updateIndex_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFiles();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // LINE_INDEX_TEST_H
@@ -0,0 +1,204 @@
+/**
+ *  @file    line_reader_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "line_reader_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/line_reader.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+LineReader_Test::LineReader_Test()
+    : Kitsunemimi::CompareTestHelper("LineReader_Test")
+{
+    initTest();
+    openFile_test();
+    next_test();
+    longLine_test();
+    manyLines_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+LineReader_Test::initTest()
+{
+    m_filePath = "/tmp/lineReader_test.txt";
+    deleteFile();
+}
+
+/**
+ * openFile_test
+ */
+void
+LineReader_Test::openFile_test()
+{
+    std::string errorMessage = "";
+    writeFile(m_filePath, "asdf", errorMessage, true);
+
+    LineReader reader;
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+
+    // negative test: already open
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), false);
+
+    TEST_EQUAL(reader.closeFile(), true);
+    TEST_EQUAL(reader.closeFile(), false);
+
+    // negative test: file not exist
+    TEST_EQUAL(reader.openFile(m_filePath + "_fake", errorMessage), false);
+
+    // negative test: not open
+    std::string_view line;
+    TEST_EQUAL(reader.next(line), false);
+
+    deleteFile();
+}
+
+/**
+ * next_test
+ */
+void
+LineReader_Test::next_test()
+{
+    std::string errorMessage = "";
+    std::string_view line;
+    std::string content = "this is a test\n"
+                          "\n"
+                          "and this is a third line, which is longer than a single vector\n"
+                          "last line without line-break";
+    writeFile(m_filePath, content, errorMessage, true);
+
+    LineReader reader;
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "this is a test");
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "");
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line),
+               "and this is a third line, which is longer than a single vector");
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "last line without line-break");
+    TEST_EQUAL(reader.m_lineNumber, 4);
+    TEST_EQUAL(reader.next(line), false);
+    TEST_EQUAL(reader.m_errorMessage, "");
+
+    // empty file has no lines
+    writeFile(m_filePath, "", errorMessage, true);
+    reader.closeFile();
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(reader.next(line), false);
+    TEST_EQUAL(reader.m_lineNumber, 0);
+
+    // line-break at the end doesn't create an additional empty line
+    writeFile(m_filePath, "a\nb\n", errorMessage, true);
+    reader.closeFile();
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "b");
+    TEST_EQUAL(reader.next(line), false);
+
+    deleteFile();
+}
+
+/**
+ * longLine_test
+ */
+void
+LineReader_Test::longLine_test()
+{
+    std::string errorMessage = "";
+    std::string_view line;
+
+    // line is much bigger than the buffer
+    const std::string longLine(20000, 'x');
+    writeFile(m_filePath, "first\n" + longLine + "\nlast", errorMessage, true);
+
+    LineReader reader(4096);
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "first");
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(line.size(), longLine.size());
+    TEST_EQUAL(std::string(line), longLine);
+    TEST_EQUAL(reader.next(line), true);
+    TEST_EQUAL(std::string(line), "last");
+    TEST_EQUAL(reader.next(line), false);
+
+    deleteFile();
+}
+
+/**
+ * manyLines_test
+ */
+void
+LineReader_Test::manyLines_test()
+{
+    std::string errorMessage = "";
+    std::string_view line;
+
+    // lines of different length, which are split over multiple buffer-fills
+    std::string content = "";
+    for(uint32_t i = 0; i < 5000; i++) {
+        content += std::string(i % 70, 'a') + std::to_string(i) + "\n";
+    }
+    writeFile(m_filePath, content, errorMessage, true);
+
+    LineReader reader(4096);
+    TEST_EQUAL(reader.openFile(m_filePath, errorMessage), true);
+
+    bool allMatch = true;
+    uint32_t counter = 0;
+    while(reader.next(line))
+    {
+        if(line != std::string(counter % 70, 'a') + std::to_string(counter)) {
+            allMatch = false;
+        }
+        counter++;
+    }
+    TEST_EQUAL(allMatch, true);
+    TEST_EQUAL(counter, 5000);
+    TEST_EQUAL(reader.m_lineNumber, 5000);
+
+    deleteFile();
+}
+
+/**
+ * closeTest
+ */
+void
+LineReader_Test::closeTest()
+{
+    deleteFile();
+}
+
+/**
+ * common usage to delete test-file
+ */
+void
+LineReader_Test::deleteFile()
+{
+    fs::path rootPathObj(m_filePath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,40 @@
+/**
+ *  @file    line_reader_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef LINE_READER_TEST_H
+#define LINE_READER_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class LineReader_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    LineReader_Test();
+
+private:
+    void initTest();
+    void openFile_test();
+    void next_test();
+    void longLine_test();
+    void manyLines_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFile();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // LINE_READER_TEST_H
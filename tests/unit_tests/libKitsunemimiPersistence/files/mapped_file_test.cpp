@@ -0,0 +1,135 @@
+/**
+ *  @file    mapped_file_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "mapped_file_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/mapped_file.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+MappedFile_Test::MappedFile_Test()
+    : Kitsunemimi::CompareTestHelper("MappedFile_Test")
+{
+    initTest();
+    openFile_test();
+    emptyFile_test();
+    closeFile_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+MappedFile_Test::initTest()
+{
+    m_filePath = "/tmp/mappedFile_test.txt";
+    deleteFile();
+}
+
+/**
+ * openFile_test
+ */
+void
+MappedFile_Test::openFile_test()
+{
+    std::string errorMessage = "";
+    std::string content = "this is a test\n"
+                          "and this is a second line";
+    writeFile(m_filePath, content, errorMessage, true);
+
+    MappedFile mappedFile;
+    TEST_EQUAL(mappedFile.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(mappedFile.m_size, content.size());
+    TEST_EQUAL(std::string(mappedFile.getContent()), content);
+    TEST_EQUAL(mappedFile.m_data[0], 't');
+
+    // negative test: already open
+    TEST_EQUAL(mappedFile.openFile(m_filePath, errorMessage), false);
+
+    // negative test: file not exist
+    MappedFile fakeFile;
+    TEST_EQUAL(fakeFile.openFile(m_filePath + "_fake", errorMessage), false);
+
+    // negative test: directory
+    TEST_EQUAL(fakeFile.openFile("/tmp", errorMessage), false);
+
+    deleteFile();
+}
+
+/**
+ * emptyFile_test
+ */
+void
+MappedFile_Test::emptyFile_test()
+{
+    std::string errorMessage = "";
+    writeFile(m_filePath, "", errorMessage, true);
+
+    MappedFile mappedFile;
+    TEST_EQUAL(mappedFile.openFile(m_filePath, errorMessage, true), true);
+    TEST_EQUAL(mappedFile.m_size, 0);
+    TEST_EQUAL(mappedFile.getContent().size(), 0);
+    TEST_EQUAL(mappedFile.closeFile(), true);
+
+    deleteFile();
+}
+
+/**
+ * closeFile_test
+ */
+void
+MappedFile_Test::closeFile_test()
+{
+    std::string errorMessage = "";
+    writeFile(m_filePath, "asdf", errorMessage, true);
+
+    MappedFile mappedFile;
+    TEST_EQUAL(mappedFile.closeFile(), false);
+    TEST_EQUAL(mappedFile.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(mappedFile.closeFile(), true);
+    TEST_EQUAL(mappedFile.getContent().size(), 0);
+    TEST_EQUAL(mappedFile.closeFile(), false);
+
+    // file can be mapped again after close
+    TEST_EQUAL(mappedFile.openFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(std::string(mappedFile.getContent()), "asdf");
+
+    deleteFile();
+}
+
+/**
+ * closeTest
+ */
+void
+MappedFile_Test::closeTest()
+{
+    deleteFile();
+}
+
+/**
+ * common usage to delete test-file
+ */
+void
+MappedFile_Test::deleteFile()
+{
+    fs::path rootPathObj(m_filePath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,39 @@
+/**
+ *  @file    mapped_file_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef MAPPED_FILE_TEST_H
+#define MAPPED_FILE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class MappedFile_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    MappedFile_Test();
+
+private:
+    void initTest();
+    void openFile_test();
+    void emptyFile_test();
+    void closeFile_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFile();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // MAPPED_FILE_TEST_H
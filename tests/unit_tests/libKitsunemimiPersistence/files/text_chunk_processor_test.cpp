@@ -0,0 +1,162 @@
+/**
+ *  @file    text_chunk_processor_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "text_chunk_processor_test.h"
+
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/text_chunk_processor.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+TextChunkProcessor_Test::TextChunkProcessor_Test()
+    : Kitsunemimi::CompareTestHelper("TextChunkProcessor_Test")
+{
+    initTest();
+    processTextChunks_test();
+    processTextLines_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+TextChunkProcessor_Test::initTest()
+{
+    m_filePath = "/tmp/textChunkProcessor_test.txt";
+    deleteFile();
+
+    m_content = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        m_content += "line " + std::to_string(i) + "\n";
+    }
+    m_content += "last line";
+
+    std::string errorMessage = "";
+    writeFile(m_filePath, m_content, errorMessage, true);
+}
+
+/**
+ * processTextChunks_test
+ */
+void
+TextChunkProcessor_Test::processTextChunks_test()
+{
+    std::string errorMessage = "";
+    std::vector<std::string> results;
+
+    // copy each chunk into its result and check the borders of the chunks
+    std::atomic<bool> validBorders(true);
+    auto copyChunk = [&](const TextChunk &chunk, std::string &result)
+    {
+        if(chunk.offset > 0 && m_content.at(chunk.offset - 1) != '\n') {
+            validBorders = false;
+        }
+        result = std::string(chunk.content);
+        return true;
+    };
+
+    bool ret = processTextChunks(m_filePath, copyChunk, results, errorMessage, 4, 1000);
+    TEST_EQUAL(ret, true);
+    const bool bordersOk = validBorders;
+    TEST_EQUAL(bordersOk, true);
+    const bool multipleChunks = results.size() > 50;
+    TEST_EQUAL(multipleChunks, true);
+
+    std::string combined = "";
+    for(const std::string &result : results) {
+        combined += result;
+    }
+    TEST_EQUAL(combined, m_content);
+
+    // chunk-size bigger than the file
+    ret = processTextChunks(m_filePath, copyChunk, results, errorMessage, 0);
+    TEST_EQUAL(ret, true);
+    TEST_EQUAL(results.size(), 1);
+
+    // negative test: callback fails
+    auto failingChunk = [&](const TextChunk &chunk, std::string &)
+    {
+        return chunk.chunkId != 3;
+    };
+    ret = processTextChunks(m_filePath, failingChunk, results, errorMessage, 4, 1000);
+    TEST_EQUAL(ret, false);
+
+    // negative test: file not exist
+    ret = processTextChunks(m_filePath + "_fake", copyChunk, results, errorMessage);
+    TEST_EQUAL(ret, false);
+}
+
+/**
+ * processTextLines_test
+ */
+void
+TextChunkProcessor_Test::processTextLines_test()
+{
+    std::string errorMessage = "";
+    std::vector<std::string> results;
+
+    // transform each line and combine the results in order
+    auto transformLine = [](const std::string_view &line, std::string &result)
+    {
+        result += "[" + std::string(line) + "]";
+        return true;
+    };
+
+    bool ret = processTextLines(m_filePath, transformLine, results, errorMessage, 8, 512);
+    TEST_EQUAL(ret, true);
+
+    std::string combined = "";
+    for(const std::string &result : results) {
+        combined += result;
+    }
+
+    std::string expected = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        expected += "[line " + std::to_string(i) + "]";
+    }
+    expected += "[last line]";
+    TEST_EQUAL(combined, expected);
+
+    // empty file
+    writeFile(m_filePath, "", errorMessage, true);
+    ret = processTextLines(m_filePath, transformLine, results, errorMessage);
+    TEST_EQUAL(ret, true);
+    TEST_EQUAL(results.size(), 0);
+}
+
+/**
+ * closeTest
+ */
+void
+TextChunkProcessor_Test::closeTest()
+{
+    deleteFile();
+}
+
+/**
+ * common usage to delete test-file
+ */
+void
+TextChunkProcessor_Test::deleteFile()
+{
+    fs::path rootPathObj(m_filePath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
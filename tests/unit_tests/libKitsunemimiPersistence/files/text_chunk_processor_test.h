@@ -0,0 +1,39 @@
+/**
+ *  @file    text_chunk_processor_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef TEXT_CHUNK_PROCESSOR_TEST_H
+#define TEXT_CHUNK_PROCESSOR_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class TextChunkProcessor_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    TextChunkProcessor_Test();
+
+private:
+    void initTest();
+    void processTextChunks_test();
+    void processTextLines_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    std::string m_content = "";
+    void deleteFile();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TEXT_CHUNK_PROCESSOR_TEST_H
@@ -0,0 +1,194 @@
+/**
+ *  @file    text_file_editor_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "text_file_editor_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/text_file_editor.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+TextFileEditor_Test::TextFileEditor_Test()
+    : Kitsunemimi::CompareTestHelper("TextFileEditor_Test")
+{
+    initTest();
+    lineChanges_test();
+    replaceContent_test();
+    invalidChanges_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+TextFileEditor_Test::initTest()
+{
+    m_filePath = "/tmp/textFileEditor_test.txt";
+    deleteFile();
+}
+
+/**
+ * lineChanges_test
+ */
+void
+TextFileEditor_Test::lineChanges_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+    writeFile(m_filePath, "line 0\nline 1\nline 2\nline 3\n", errorMessage, true);
+
+    TextFileEditor editor(m_filePath);
+    editor.replaceLine(1, "new line 1");
+    editor.deleteLine(2);
+    editor.insertLine(0, "before 0");
+    editor.insertLine(3, "before 3");
+    editor.insertLine(4, "at the end");
+    TEST_EQUAL(editor.getNumberOfChanges(), 5);
+
+    // nothing is changed before commit
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "line 0\nline 1\nline 2\nline 3\n");
+
+    TEST_EQUAL(editor.commit(errorMessage), true);
+    TEST_EQUAL(editor.getNumberOfChanges(), 0);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "before 0\nline 0\nnew line 1\nbefore 3\nline 3\nat the end\n");
+
+    // last line without line-break and last change for the same line wins
+    writeFile(m_filePath, "a\nb", errorMessage, true);
+    editor.deleteLine(1);
+    editor.replaceLine(1, "c");
+    editor.replaceLine(0, "x");
+    editor.deleteLine(0);
+    TEST_EQUAL(editor.commit(errorMessage, true), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "c");
+
+    // empty file
+    writeFile(m_filePath, "", errorMessage, true);
+    editor.insertLine(0, "first");
+    editor.insertLine(0, "second");
+    TEST_EQUAL(editor.commit(errorMessage), true);
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "first\nsecond");
+
+    deleteFile();
+}
+
+/**
+ * replaceContent_test
+ */
+void
+TextFileEditor_Test::replaceContent_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+    writeFile(m_filePath, "poi poi\nasdf\npoi\n", errorMessage, true);
+
+    TextFileEditor editor(m_filePath);
+    editor.replaceLine(1, "poi in replaced line");
+    editor.replaceContent("poi", "nani");
+    editor.insertLine(3, "poi after replacement");
+    editor.replaceContent("nani", "x");
+    TEST_EQUAL(editor.commit(errorMessage), true);
+
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "x x\nx in replaced line\nx\npoi after replacement\n");
+
+    // many lines in a file bigger than the write-buffer
+    std::string bigContent = "";
+    std::string expected = "";
+    for(uint32_t i = 0; i < 100000; i++)
+    {
+        bigContent += "key" + std::to_string(i) + "=value\n";
+        expected += "key" + std::to_string(i) + "=other\n";
+    }
+    writeFile(m_filePath, bigContent, errorMessage, true);
+    editor.replaceContent("=value", "=other");
+    TEST_EQUAL(editor.commit(errorMessage), true);
+    readFile(content, m_filePath, errorMessage);
+    const bool match = content == expected;
+    TEST_EQUAL(match, true);
+
+    deleteFile();
+}
+
+/**
+ * invalidChanges_test
+ */
+void
+TextFileEditor_Test::invalidChanges_test()
+{
+    std::string errorMessage = "";
+    std::string content = "";
+    writeFile(m_filePath, "line 0\nline 1", errorMessage, true);
+
+    TextFileEditor editor(m_filePath);
+
+    // negative test: line not exist
+    editor.replaceLine(0, "asdf");
+    editor.replaceLine(2, "asdf");
+    TEST_EQUAL(editor.commit(errorMessage), false);
+    editor.clear();
+
+    editor.insertLine(3, "asdf");
+    TEST_EQUAL(editor.commit(errorMessage), false);
+    editor.clear();
+
+    // negative test: invalid substring
+    editor.replaceContent("", "asdf");
+    TEST_EQUAL(editor.commit(errorMessage), false);
+    editor.clear();
+
+    editor.replaceContent("0\nline", "asdf");
+    TEST_EQUAL(editor.commit(errorMessage), false);
+    editor.clear();
+
+    // file is unchanged
+    readFile(content, m_filePath, errorMessage);
+    TEST_EQUAL(content, "line 0\nline 1");
+
+    // negative test: file not exist
+    TextFileEditor fakeEditor(m_filePath + "_fake");
+    fakeEditor.insertLine(0, "asdf");
+    TEST_EQUAL(fakeEditor.commit(errorMessage), false);
+    TEST_EQUAL(fs::exists(m_filePath + "_fake"), false);
+
+    deleteFile();
+}
+
+/**
+ * closeTest
+ */
+void
+TextFileEditor_Test::closeTest()
+{
+    deleteFile();
+}
+
+/**
+ * common usage to delete test-file
+ */
+void
+TextFileEditor_Test::deleteFile()
+{
+    fs::path rootPathObj(m_filePath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,39 @@
+/**
+ *  @file    text_file_editor_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef TEXT_FILE_EDITOR_TEST_H
+#define TEXT_FILE_EDITOR_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class TextFileEditor_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    TextFileEditor_Test();
+
+private:
+    void initTest();
+    void lineChanges_test();
+    void replaceContent_test();
+    void invalidChanges_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFile();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TEXT_FILE_EDITOR_TEST_H
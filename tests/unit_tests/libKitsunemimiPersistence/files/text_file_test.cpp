@@ -8,6 +8,7 @@
 
 #include "text_file_test.h"
 
+#include <sys/stat.h>
 #include <boost/filesystem.hpp>
 #include <libKitsunemimiPersistence/files/text_file.h>
 
@@ -23,7 +24,9 @@ TextFile_Test::TextFile_Test()
 {
     initTest();
     writeFile_test();
+    writeFileAtomic_test();
     readFile_test();
+    readFiles_test();
     appendText_test();
     replaceLine_test();
     replaceContent_test();
@@ -67,6 +70,59 @@ TextFile_Test::writeFile_test()
     deleteFile();
 }
 
+/**
+ * writeFileAtomic_test
+ */
+void
+TextFile_Test::writeFileAtomic_test()
+{
+    bool ret;
+    std::string errorMessage = "";
+    std::string fileContent = "";
+
+    // create new file
+    ret = writeFileAtomic(m_filePath, "first content", errorMessage);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, m_filePath, errorMessage);
+    TEST_EQUAL(fileContent, "first content");
+
+    // overwrite existing file and keep its access-rights
+    chmod(m_filePath.c_str(), 0640);
+    ret = writeFileAtomic(m_filePath, "second content", errorMessage, true);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, m_filePath, errorMessage);
+    TEST_EQUAL(fileContent, "second content");
+    struct stat fileStat;
+    stat(m_filePath.c_str(), &fileStat);
+    const uint32_t mode = fileStat.st_mode & 0777;
+    TEST_EQUAL(mode, 0640);
+
+    // no temporary files are left
+    uint32_t numberOfFiles = 0;
+    for(const fs::directory_entry &entry : fs::directory_iterator("/tmp"))
+    {
+        if(entry.path().filename().string().find("textFile_test.txt.tmp") != std::string::npos) {
+            numberOfFiles++;
+        }
+    }
+    TEST_EQUAL(numberOfFiles, 0);
+
+    // create missing parent-directory
+    const std::string nestedPath = "/tmp/textFile_test_dir/nested.txt";
+    ret = writeFileAtomic(nestedPath, "nested", errorMessage);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, nestedPath, errorMessage);
+    TEST_EQUAL(fileContent, "nested");
+
+    // negative test: target is a directory
+    ret = writeFileAtomic("/tmp/textFile_test_dir", "asdf", errorMessage);
+    TEST_EQUAL(ret, false);
+
+    // cleanup
+    fs::remove_all("/tmp/textFile_test_dir");
+    deleteFile();
+}
+
 /**
  * readFile_test
  */
@@ -92,10 +148,87 @@ TextFile_Test::readFile_test()
     ret = readFile(fileContent, m_filePath + "_fake", errorMessage);
     TEST_EQUAL(ret, false);
 
+    // content bigger than the minimal read-buffer
+    std::string bigContent = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        bigContent += "line " + std::to_string(i) + "\n";
+    }
+    writeFile(m_filePath, bigContent, errorMessage, true);
+    ret = readFile(fileContent, m_filePath, errorMessage);
+    TEST_EQUAL(ret, true);
+    TEST_EQUAL(fileContent, bigContent);
+
+    // file with a reported size of 0, which nevertheless has content
+    fileContent = "";
+    ret = readFile(fileContent, "/proc/self/status", errorMessage);
+    TEST_EQUAL(ret, true);
+    const bool hasContent = fileContent.find("Name:") != std::string::npos;
+    TEST_EQUAL(hasContent, true);
+
     // cleanup
     deleteFile();
 }
 
+/**
+ * readFiles_test
+ */
+void
+TextFile_Test::readFiles_test()
+{
+    bool ret;
+    std::string errorMessage = "";
+    const std::string directoryPath = "/tmp/textFile_test_read_files";
+    fs::remove_all(directoryPath);
+
+    std::vector<std::string> filePaths;
+    for(uint32_t i = 0; i < 200; i++)
+    {
+        const std::string filePath = directoryPath + "/file_" + std::to_string(i) + ".txt";
+        writeFile(filePath, "content " + std::to_string(i), errorMessage, true);
+        filePaths.push_back(filePath);
+    }
+
+    // read all files
+    std::vector<ReadFileResult> results;
+    ret = readFiles(results, filePaths);
+    TEST_EQUAL(ret, true);
+    TEST_EQUAL(results.size(), 200);
+
+    bool allMatch = true;
+    for(uint32_t i = 0; i < 200; i++)
+    {
+        if(results.at(i).success == false
+                || results.at(i).content != "content " + std::to_string(i))
+        {
+            allMatch = false;
+        }
+    }
+    TEST_EQUAL(allMatch, true);
+
+    // negative test: one file not exist
+    filePaths.insert(filePaths.begin() + 10, directoryPath + "/fake.txt");
+    ret = readFiles(results, filePaths, 4);
+    TEST_EQUAL(ret, false);
+    TEST_EQUAL(results.size(), 201);
+    TEST_EQUAL(results.at(10).success, false);
+    const bool hasError = results.at(10).errorMessage.size() > 0;
+    TEST_EQUAL(hasError, true);
+    TEST_EQUAL(results.at(11).content, "content 10");
+
+    // negative test: directory
+    std::string fileContent = "";
+    ret = readFile(fileContent, directoryPath, errorMessage);
+    TEST_EQUAL(ret, false);
+
+    // empty list
+    ret = readFiles(results, std::vector<std::string>());
+    TEST_EQUAL(ret, true);
+    TEST_EQUAL(results.size(), 0);
+
+    // cleanup
+    fs::remove_all(directoryPath);
+}
+
 /**
  * appendText_test
  */
@@ -200,6 +333,39 @@ TextFile_Test::replaceContent_test()
                           "nani";
     TEST_EQUAL(fileContent, compare);
 
+    // no match keeps the file unchanged
+    ret = replaceContent(m_filePath, "not in file", "asdf", errorMessage);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, m_filePath, errorMessage);
+    TEST_EQUAL(fileContent, compare);
+
+    // negative test: empty content to replace
+    ret = replaceContent(m_filePath, "", "asdf", errorMessage);
+    TEST_EQUAL(ret, false);
+
+    // many matches in a file bigger than one chunk, also across the chunk-borders
+    std::string bigContent = "";
+    std::string bigCompare = "";
+    while(bigContent.size() < 3 * 1024 * 1024)
+    {
+        const std::string filler(bigContent.size() % 13, 'p');
+        bigContent += filler + "poipoi;";
+        bigCompare += filler + "naninani;";
+    }
+    writeFile(m_filePath, bigContent, errorMessage, true);
+    ret = replaceContent(m_filePath, "poi", "nani", errorMessage);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, m_filePath, errorMessage);
+    const bool bigMatch = fileContent == bigCompare;
+    TEST_EQUAL(bigMatch, true);
+
+    // replace with shorter content
+    ret = replaceContent(m_filePath, "nani;", "", errorMessage);
+    TEST_EQUAL(ret, true);
+    readFile(fileContent, m_filePath, errorMessage);
+    const bool noSeparator = fileContent.find(';') == std::string::npos;
+    TEST_EQUAL(noSeparator, true);
+
     // cleanup
     deleteFile();
 }
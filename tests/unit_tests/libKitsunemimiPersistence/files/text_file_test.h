@@ -25,7 +25,9 @@ public:
 private:
     void initTest();
     void writeFile_test();
+    void writeFileAtomic_test();
     void readFile_test();
+    void readFiles_test();
     void appendText_test();
     void replaceLine_test();
     void replaceContent_test();
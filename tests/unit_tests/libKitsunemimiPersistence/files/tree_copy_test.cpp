@@ -0,0 +1,257 @@
+/**
+ *  @file    tree_copy_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "tree_copy_test.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/tree_copy.h>
+#include <libKitsunemimiPersistence/files/file_methods.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+TreeCopy_Test::TreeCopy_Test()
+    : Kitsunemimi::CompareTestHelper("TreeCopy_Test")
+{
+    initTest();
+    copyTree_test();
+    copySparseFile_test();
+    copyForce_test();
+    copyFailure_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+TreeCopy_Test::initTest()
+{
+    std::string errorMessage = "";
+
+    m_directoryPath = "/tmp/treeCopy_test";
+    m_sourcePath = m_directoryPath + "/source";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_sourcePath + "/dir1/dir2");
+    fs::create_directories(m_sourcePath + "/readonly");
+
+    // file, which needs multiple parts to copy
+    std::string bigContent = "";
+    for(uint32_t i = 0; i < 2 * 1024 * 1024; i++) {
+        bigContent += "0123456789"[i % 10];
+        bigContent += "poi-";
+        bigContent += "abc"[i % 3];
+        bigContent += "\n";
+    }
+    bigContent += bigContent;
+    bigContent += "end";
+
+    writeFile(m_sourcePath + "/big", bigContent, errorMessage);
+    writeFile(m_sourcePath + "/empty", "", errorMessage);
+    writeFile(m_sourcePath + "/dir1/file1", "file1", errorMessage);
+    writeFile(m_sourcePath + "/dir1/dir2/file2", "file2", errorMessage);
+    writeFile(m_sourcePath + "/readonly/file3", "file3", errorMessage);
+    chmod((m_sourcePath + "/dir1/file1").c_str(), 0640);
+    chmod((m_sourcePath + "/readonly").c_str(), 0555);
+    symlink("dir1/file1", (m_sourcePath + "/link").c_str());
+}
+
+/**
+ * copyTree_test
+ */
+void
+TreeCopy_Test::copyTree_test()
+{
+    std::string errorMessage = "";
+    const std::string targetPath = m_directoryPath + "/target";
+
+    CopyProgress lastProgress;
+    uint64_t numberOfCalls = 0;
+    auto progressCallback = [&](const CopyProgress &progress)
+    {
+        lastProgress = progress;
+        numberOfCalls++;
+    };
+
+    bool result = copyTree(m_sourcePath, targetPath, errorMessage, false, progressCallback, 4);
+    TEST_EQUAL(result, true);
+
+    // content
+    std::string sourceContent = "";
+    std::string targetContent = "";
+    readFile(sourceContent, m_sourcePath + "/big", errorMessage);
+    readFile(targetContent, targetPath + "/big", errorMessage);
+    TEST_EQUAL(targetContent.size(), sourceContent.size());
+    const bool isEqual = targetContent == sourceContent;
+    TEST_EQUAL(isEqual, true);
+
+    readFile(targetContent, targetPath + "/dir1/dir2/file2", errorMessage);
+    TEST_EQUAL(targetContent, "file2");
+    readFile(targetContent, targetPath + "/readonly/file3", errorMessage);
+    TEST_EQUAL(targetContent, "file3");
+    TEST_EQUAL(fs::exists(targetPath + "/empty"), true);
+    TEST_EQUAL(fs::file_size(targetPath + "/empty"), 0);
+
+    // permissions and links
+    struct stat targetStat;
+    stat((targetPath + "/dir1/file1").c_str(), &targetStat);
+    const uint32_t fileMode = targetStat.st_mode & 07777;
+    TEST_EQUAL(fileMode, 0640);
+    stat((targetPath + "/readonly").c_str(), &targetStat);
+    const uint32_t directoryMode = targetStat.st_mode & 07777;
+    TEST_EQUAL(directoryMode, 0555);
+    TEST_EQUAL(fs::is_symlink(targetPath + "/link"), true);
+    TEST_EQUAL(fs::read_symlink(targetPath + "/link").string(), "dir1/file1");
+
+    // progress
+    const bool hasCalls = numberOfCalls > 0;
+    TEST_EQUAL(hasCalls, true);
+    TEST_EQUAL(lastProgress.numberOfFiles, 5);
+    TEST_EQUAL(lastProgress.copiedFiles, 5);
+    TEST_EQUAL(lastProgress.numberOfBytes, sourceContent.size() + 15);
+    TEST_EQUAL(lastProgress.copiedBytes, sourceContent.size() + 15);
+
+    // single file and single link
+    result = copyTree(m_sourcePath + "/dir1/file1", m_directoryPath + "/file1", errorMessage);
+    TEST_EQUAL(result, true);
+    readFile(targetContent, m_directoryPath + "/file1", errorMessage);
+    TEST_EQUAL(targetContent, "file1");
+
+    result = copyTree(m_sourcePath + "/link", m_directoryPath + "/link", errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fs::is_symlink(m_directoryPath + "/link"), true);
+
+    chmod((targetPath + "/readonly").c_str(), 0755);
+    fs::remove_all(targetPath);
+}
+
+/**
+ * copySparseFile_test
+ */
+void
+TreeCopy_Test::copySparseFile_test()
+{
+    std::string errorMessage = "";
+    const std::string sourcePath = m_directoryPath + "/sparse";
+    const std::string targetPath = m_directoryPath + "/sparse_copy";
+    const uint64_t fileSize = 64 * 1024 * 1024;
+
+    // file with data at the start and in the middle and a hole at the end
+    const int fd = open(sourcePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TEST_EQUAL(pwrite(fd, "start", 5, 0), 5);
+    TEST_EQUAL(pwrite(fd, "middle", 6, 32 * 1024 * 1024), 6);
+    TEST_EQUAL(ftruncate(fd, fileSize), 0);
+    close(fd);
+
+    const bool result = copyTree(sourcePath, targetPath, errorMessage);
+    TEST_EQUAL(result, true);
+
+    struct stat targetStat;
+    stat(targetPath.c_str(), &targetStat);
+    TEST_EQUAL(targetStat.st_size, fileSize);
+    const bool isSparse = static_cast<uint64_t>(targetStat.st_blocks) * 512 < fileSize / 2;
+    TEST_EQUAL(isSparse, true);
+
+    char buffer[7];
+    const int targetFd = open(targetPath.c_str(), O_RDONLY);
+    TEST_EQUAL(pread(targetFd, buffer, 5, 0), 5);
+    TEST_EQUAL(std::string(buffer, 5), "start");
+    TEST_EQUAL(pread(targetFd, buffer, 6, 32 * 1024 * 1024), 6);
+    TEST_EQUAL(std::string(buffer, 6), "middle");
+    TEST_EQUAL(pread(targetFd, buffer, 1, fileSize - 1), 1);
+    TEST_EQUAL(buffer[0], '\0');
+    close(targetFd);
+
+    fs::remove(sourcePath);
+    fs::remove(targetPath);
+}
+
+/**
+ * copyForce_test
+ */
+void
+TreeCopy_Test::copyForce_test()
+{
+    std::string errorMessage = "";
+    const std::string targetPath = m_directoryPath + "/target";
+
+    fs::create_directories(targetPath + "/dir1/file1");
+    writeFile(targetPath + "/big", "old", errorMessage);
+    writeFile(targetPath + "/other", "other", errorMessage);
+
+    // existing target without force
+    bool result = copyTree(m_sourcePath, targetPath, errorMessage, false);
+    TEST_EQUAL(result, false);
+
+    // existing files are replaced and directories are merged
+    result = copyTree(m_sourcePath, targetPath, errorMessage, true);
+    TEST_EQUAL(result, true);
+
+    std::string targetContent = "";
+    readFile(targetContent, targetPath + "/dir1/file1", errorMessage);
+    TEST_EQUAL(targetContent, "file1");
+    TEST_EQUAL(fs::file_size(targetPath + "/big"), fs::file_size(m_sourcePath + "/big"));
+    TEST_EQUAL(fs::exists(targetPath + "/other"), true);
+
+    chmod((targetPath + "/readonly").c_str(), 0755);
+    fs::remove_all(targetPath);
+}
+
+/**
+ * copyFailure_test
+ */
+void
+TreeCopy_Test::copyFailure_test()
+{
+    std::string errorMessage = "";
+
+    bool result = copyTree(m_directoryPath + "/fail", m_directoryPath + "/target", errorMessage);
+    TEST_EQUAL(result, false);
+
+    result = copyTree(m_sourcePath, m_sourcePath + "/dir1/copy", errorMessage);
+    TEST_EQUAL(result, false);
+    TEST_EQUAL(fs::exists(m_sourcePath + "/dir1/copy"), false);
+
+    // target inside of the source, which is hidden by a relative path and ".."
+    const fs::path oldWorkingDirectory = fs::current_path();
+    fs::current_path(m_sourcePath + "/dir1");
+    result = copyTree("../dir1", "dir2/../dir2/copy", errorMessage);
+    TEST_EQUAL(result, false);
+    result = copyTree(m_sourcePath, "./dir2/copy", errorMessage);
+    TEST_EQUAL(result, false);
+    fs::current_path(oldWorkingDirectory);
+    TEST_EQUAL(fs::exists(m_sourcePath + "/dir1/dir2/copy"), false);
+
+    // target inside of the source, which is hidden by a symbolic link
+    symlink((m_sourcePath + "/dir1").c_str(), (m_directoryPath + "/sourceLink").c_str());
+    result = copyTree(m_sourcePath, m_directoryPath + "/sourceLink/copy", errorMessage);
+    TEST_EQUAL(result, false);
+    TEST_EQUAL(fs::exists(m_sourcePath + "/dir1/copy"), false);
+    fs::remove(m_directoryPath + "/sourceLink");
+}
+
+/**
+ * closeTest
+ */
+void
+TreeCopy_Test::closeTest()
+{
+    chmod((m_sourcePath + "/readonly").c_str(), 0755);
+    fs::remove_all(m_directoryPath);
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,40 @@
+/**
+ *  @file    tree_copy_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef TREE_COPY_TEST_H
+#define TREE_COPY_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class TreeCopy_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    TreeCopy_Test();
+
+private:
+    void initTest();
+    void copyTree_test();
+    void copySparseFile_test();
+    void copyForce_test();
+    void copyFailure_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+    std::string m_sourcePath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TREE_COPY_TEST_H
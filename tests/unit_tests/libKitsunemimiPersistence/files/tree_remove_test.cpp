@@ -0,0 +1,162 @@
+/**
+ *  @file    tree_remove_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "tree_remove_test.h"
+
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/files/tree_remove.h>
+#include <libKitsunemimiPersistence/files/text_file.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+TreeRemove_Test::TreeRemove_Test()
+    : Kitsunemimi::CompareTestHelper("TreeRemove_Test")
+{
+    initTest();
+    removeTree_test();
+    removeAsync_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+TreeRemove_Test::initTest()
+{
+    m_directoryPath = "/tmp/treeRemove_test";
+    fs::remove_all(m_directoryPath);
+    fs::create_directories(m_directoryPath);
+}
+
+/**
+ * removeTree_test
+ */
+void
+TreeRemove_Test::removeTree_test()
+{
+    std::string errorMessage = "";
+    const std::string treePath = m_directoryPath + "/tree";
+
+    // directory-tree with many directories on multiple levels
+    createTree(treePath);
+    symlink(m_directoryPath.c_str(), (treePath + "/link").c_str());
+
+    bool result = removeTree(treePath + "/", errorMessage, 4);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fs::exists(treePath), false);
+
+    // the target of the symbolic link still exist
+    TEST_EQUAL(fs::exists(m_directoryPath), true);
+
+    // already deleted
+    result = removeTree(treePath, errorMessage);
+    TEST_EQUAL(result, true);
+
+    // single file and symbolic link
+    writeFile(m_directoryPath + "/file", "file", errorMessage);
+    symlink(m_directoryPath.c_str(), (m_directoryPath + "/link").c_str());
+    result = removeTree(m_directoryPath + "/file", errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fs::exists(m_directoryPath + "/file"), false);
+    result = removeTree(m_directoryPath + "/link", errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(fs::is_symlink(m_directoryPath + "/link"), false);
+    TEST_EQUAL(fs::exists(m_directoryPath), true);
+}
+
+/**
+ * removeAsync_test
+ */
+void
+TreeRemove_Test::removeAsync_test()
+{
+    std::string errorMessage = "";
+    const std::string trashPath = m_directoryPath + "/trash";
+
+    // not initialized
+    {
+        TreeRemover remover;
+        TEST_EQUAL(remover.removeAsync(m_directoryPath + "/tree", errorMessage), false);
+    }
+
+    // trash-path is a file
+    {
+        writeFile(m_directoryPath + "/file", "file", errorMessage);
+        TreeRemover remover;
+        TEST_EQUAL(remover.initTrash(m_directoryPath + "/file", errorMessage), false);
+        TEST_EQUAL(fs::exists(m_directoryPath + "/file"), true);
+    }
+
+    // leftover of a previous run
+    createTree(trashPath + "/leftover");
+
+    TreeRemover remover(2);
+    TEST_EQUAL(remover.initTrash(trashPath, errorMessage), true);
+    TEST_EQUAL(remover.initTrash(trashPath, errorMessage), false);
+
+    createTree(m_directoryPath + "/tree1");
+    createTree(m_directoryPath + "/tree2");
+
+    TEST_EQUAL(remover.removeAsync(m_directoryPath + "/tree1", errorMessage), true);
+    TEST_EQUAL(remover.removeAsync(m_directoryPath + "/tree2", errorMessage), true);
+    TEST_EQUAL(remover.removeAsync(m_directoryPath + "/fail", errorMessage), true);
+
+    // paths are moved away directly
+    TEST_EQUAL(fs::exists(m_directoryPath + "/tree1"), false);
+    TEST_EQUAL(fs::exists(m_directoryPath + "/tree2"), false);
+
+    TEST_EQUAL(remover.waitUntilEmpty(errorMessage), true);
+    TEST_EQUAL(fs::exists(trashPath), true);
+    TEST_EQUAL(fs::is_empty(trashPath), true);
+}
+
+/**
+ * closeTest
+ */
+void
+TreeRemove_Test::closeTest()
+{
+    fs::remove_all(m_directoryPath);
+}
+
+/**
+ * @brief create a directory-tree with 4 levels and 2 files in each directory
+ *
+ * @param path path of the new tree
+ */
+void
+TreeRemove_Test::createTree(const std::string &path)
+{
+    std::string errorMessage = "";
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        for(uint32_t j = 0; j < 5; j++)
+        {
+            for(uint32_t k = 0; k < 5; k++)
+            {
+                const std::string dirPath = path + "/" + std::to_string(i)
+                                            + "/" + std::to_string(j)
+                                            + "/" + std::to_string(k);
+                fs::create_directories(dirPath);
+                writeFile(dirPath + "/file1", "file1", errorMessage);
+                writeFile(dirPath + "/file2", "file2", errorMessage);
+            }
+        }
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
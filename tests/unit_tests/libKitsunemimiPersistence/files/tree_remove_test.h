@@ -0,0 +1,39 @@
+/**
+ *  @file    tree_remove_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef TREE_REMOVE_TEST_H
+#define TREE_REMOVE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class TreeRemove_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    TreeRemove_Test();
+
+private:
+    void initTest();
+    void removeTree_test();
+    void removeAsync_test();
+    void closeTest();
+
+    void createTree(const std::string &path);
+
+    std::string m_directoryPath = "";
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // TREE_REMOVE_TEST_H
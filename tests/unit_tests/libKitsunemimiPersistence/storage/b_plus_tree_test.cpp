@@ -0,0 +1,332 @@
+/**
+ *  @file    b_plus_tree_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "b_plus_tree_test.h"
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/storage/b_plus_tree.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+/**
+ * @brief create key with fixed length, so the order of the strings matches the numbers
+ */
+static const std::string
+createKey(const uint64_t number)
+{
+    std::string key = std::to_string(number);
+    return "key-" + std::string(8 - key.size(), '0') + key;
+}
+
+BPlusTree_Test::BPlusTree_Test()
+    : Kitsunemimi::CompareTestHelper("BPlusTree_Test")
+{
+    initTest();
+    insertGet_test();
+    remove_test();
+    iterator_test();
+    reopen_test();
+    bulkLoad_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+BPlusTree_Test::initTest()
+{
+    m_filePath = "/tmp/bPlusTree_test.tree";
+    deleteFile(m_filePath);
+}
+
+/**
+ * insertGet_test
+ */
+void
+BPlusTree_Test::insertGet_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    BPlusTree tree(512, 16);
+
+    TEST_EQUAL(tree.insert("key", "value"), false);
+    TEST_EQUAL(tree.initTree(m_filePath, errorMessage), true);
+    TEST_EQUAL(tree.initTree(m_filePath, errorMessage), false);
+
+    TEST_EQUAL(tree.insert("key1", "value1"), true);
+    TEST_EQUAL(tree.insert("key2", "value2"), true);
+    TEST_EQUAL(tree.insert("key1", "value1-new"), true);
+    TEST_EQUAL(tree.insert("", "empty-key"), true);
+    TEST_EQUAL(tree.getNumberOfKeys(), 3);
+
+    TEST_EQUAL(tree.get("key1", value), true);
+    TEST_EQUAL(value, "value1-new");
+    TEST_EQUAL(tree.get("", value), true);
+    TEST_EQUAL(value, "empty-key");
+
+    // enforce multiple splits with small pages and a small cache
+    bool allFound = true;
+    for(uint64_t i = 0; i < 2000; i++) {
+        tree.insert(createKey((i * 7919) % 2000), "value" + std::to_string((i * 7919) % 2000));
+    }
+    for(uint64_t i = 0; i < 2000; i++)
+    {
+        if(tree.get(createKey(i), value) == false
+                || value != "value" + std::to_string(i))
+        {
+            allFound = false;
+        }
+    }
+    TEST_EQUAL(allFound, true);
+    TEST_EQUAL(tree.getNumberOfKeys(), 2003);
+
+    // negative test
+    TEST_EQUAL(tree.get("fail", value), false);
+    TEST_EQUAL(tree.insert("key", std::string(tree.getMaxEntrySize(), 'x')), false);
+    TEST_EQUAL(tree.insert("", std::string(tree.getMaxEntrySize(), 'x')), true);
+
+    // negative test: failed write must not change the number of keys
+    struct rlimit oldLimit;
+    getrlimit(RLIMIT_FSIZE, &oldLimit);
+    struct rlimit newLimit = oldLimit;
+    newLimit.rlim_cur = 1;
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &newLimit);
+
+    TEST_EQUAL(tree.insert("write-fail", "value"), false);
+
+    setrlimit(RLIMIT_FSIZE, &oldLimit);
+    signal(SIGXFSZ, SIG_DFL);
+    TEST_EQUAL(tree.getNumberOfKeys(), 2003);
+
+    TEST_EQUAL(tree.flush(), true);
+    TEST_EQUAL(tree.closeTree(), true);
+    TEST_EQUAL(tree.closeTree(), false);
+
+    // negative test: wrong page-size
+    BPlusTree wrongTree(1024);
+    TEST_EQUAL(wrongTree.initTree(m_filePath, errorMessage), false);
+    BPlusTree invalidTree(1000);
+    TEST_EQUAL(invalidTree.initTree(m_filePath, errorMessage), false);
+
+    deleteFile(m_filePath);
+}
+
+/**
+ * remove_test
+ */
+void
+BPlusTree_Test::remove_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    BPlusTree tree(512, 16);
+    tree.initTree(m_filePath, errorMessage);
+
+    for(uint64_t i = 0; i < 500; i++) {
+        tree.insert(createKey(i), "value" + std::to_string(i));
+    }
+
+    TEST_EQUAL(tree.remove(createKey(100)), true);
+    TEST_EQUAL(tree.remove(createKey(100)), false);
+    TEST_EQUAL(tree.remove("fail"), false);
+    TEST_EQUAL(tree.get(createKey(100), value), false);
+    TEST_EQUAL(tree.get(createKey(101), value), true);
+    TEST_EQUAL(value, "value101");
+    TEST_EQUAL(tree.getNumberOfKeys(), 499);
+
+    // remove all and insert again
+    for(uint64_t i = 0; i < 500; i++) {
+        tree.remove(createKey(i));
+    }
+    TEST_EQUAL(tree.getNumberOfKeys(), 0);
+    TEST_EQUAL(tree.insert(createKey(100), "new"), true);
+    TEST_EQUAL(tree.get(createKey(100), value), true);
+    TEST_EQUAL(value, "new");
+
+    tree.closeTree();
+    deleteFile(m_filePath);
+}
+
+/**
+ * iterator_test
+ */
+void
+BPlusTree_Test::iterator_test()
+{
+    std::string errorMessage = "";
+    std::string key = "";
+    std::string value = "";
+    BPlusTree tree(512, 16);
+    tree.initTree(m_filePath, errorMessage);
+
+    // empty tree
+    BPlusTreeIterator emptyIterator(tree);
+    TEST_EQUAL(emptyIterator.next(key, value), false);
+
+    for(uint64_t i = 0; i < 1000; i++) {
+        tree.insert(createKey((i * 7919) % 1000), "value" + std::to_string((i * 7919) % 1000));
+    }
+    for(uint64_t i = 0; i < 1000; i += 2) {
+        tree.remove(createKey(i));
+    }
+
+    // full scan in ascending order
+    BPlusTreeIterator iterator(tree);
+    bool ordered = true;
+    uint64_t counter = 0;
+    while(iterator.next(key, value))
+    {
+        if(key != createKey(counter * 2 + 1)) {
+            ordered = false;
+        }
+        counter++;
+    }
+    TEST_EQUAL(ordered, true);
+    TEST_EQUAL(counter, 500);
+
+    // range-scan
+    TEST_EQUAL(iterator.seek(createKey(500)), true);
+    TEST_EQUAL(iterator.next(key, value), true);
+    TEST_EQUAL(key, createKey(501));
+    TEST_EQUAL(value, "value501");
+    TEST_EQUAL(iterator.next(key, value), true);
+    TEST_EQUAL(key, createKey(503));
+
+    TEST_EQUAL(iterator.seek(createKey(999)), true);
+    TEST_EQUAL(iterator.next(key, value), true);
+    TEST_EQUAL(key, createKey(999));
+    TEST_EQUAL(iterator.next(key, value), false);
+
+    TEST_EQUAL(iterator.seekToFirst(), true);
+    TEST_EQUAL(iterator.next(key, value), true);
+    TEST_EQUAL(key, createKey(1));
+
+    tree.closeTree();
+    deleteFile(m_filePath);
+}
+
+/**
+ * reopen_test
+ */
+void
+BPlusTree_Test::reopen_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+
+    BPlusTree tree(512, 16);
+    tree.initTree(m_filePath, errorMessage);
+    for(uint64_t i = 0; i < 1000; i++) {
+        tree.insert(createKey(i), "value" + std::to_string(i));
+    }
+    tree.closeTree();
+
+    BPlusTree reopenedTree(512, 16);
+    TEST_EQUAL(reopenedTree.initTree(m_filePath, errorMessage), true);
+    TEST_EQUAL(reopenedTree.getNumberOfKeys(), 1000);
+    TEST_EQUAL(reopenedTree.get(createKey(777), value), true);
+    TEST_EQUAL(value, "value777");
+    TEST_EQUAL(reopenedTree.insert(createKey(1000), "value1000"), true);
+    TEST_EQUAL(reopenedTree.get(createKey(1000), value), true);
+    reopenedTree.closeTree();
+
+    deleteFile(m_filePath);
+}
+
+/**
+ * bulkLoad_test
+ */
+void
+BPlusTree_Test::bulkLoad_test()
+{
+    std::string errorMessage = "";
+    std::string key = "";
+    std::string value = "";
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    for(uint64_t i = 0; i < 5000; i++) {
+        entries.push_back(std::make_pair(createKey(i), "value" + std::to_string(i)));
+    }
+
+    BPlusTree tree(512, 16);
+    tree.initTree(m_filePath, errorMessage);
+    TEST_EQUAL(tree.bulkLoad(entries, errorMessage), true);
+    TEST_EQUAL(tree.getNumberOfKeys(), 5000);
+
+    bool allFound = true;
+    for(uint64_t i = 0; i < 5000; i++)
+    {
+        if(tree.get(createKey(i), value) == false
+                || value != "value" + std::to_string(i))
+        {
+            allFound = false;
+        }
+    }
+    TEST_EQUAL(allFound, true);
+
+    BPlusTreeIterator iterator(tree);
+    uint64_t counter = 0;
+    while(iterator.next(key, value)) {
+        counter++;
+    }
+    TEST_EQUAL(counter, 5000);
+
+    // further inserts after bulk-load
+    TEST_EQUAL(tree.insert(createKey(2500) + "a", "between"), true);
+    TEST_EQUAL(tree.get(createKey(2500) + "a", value), true);
+    TEST_EQUAL(value, "between");
+
+    // negative test
+    TEST_EQUAL(tree.bulkLoad(entries, errorMessage), false);
+    tree.closeTree();
+    deleteFile(m_filePath);
+
+    std::vector<std::pair<std::string, std::string>> unsorted;
+    unsorted.push_back(std::make_pair("b", "value"));
+    unsorted.push_back(std::make_pair("a", "value"));
+    tree.initTree(m_filePath, errorMessage);
+    TEST_EQUAL(tree.bulkLoad(unsorted, errorMessage), false);
+
+    tree.closeTree();
+    deleteFile(m_filePath);
+}
+
+/**
+ * closeTest
+ */
+void
+BPlusTree_Test::closeTest()
+{
+    deleteFile(m_filePath);
+}
+
+/**
+ * common usage to delete test-file
+ *
+ * @param path path of the file to delete
+ */
+void
+BPlusTree_Test::deleteFile(const std::string &path)
+{
+    fs::path rootPathObj(path);
+    if(fs::exists(rootPathObj)) {
+        fs::remove(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
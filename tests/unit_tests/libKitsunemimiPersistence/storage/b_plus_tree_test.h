@@ -0,0 +1,41 @@
+/**
+ *  @file    b_plus_tree_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef B_PLUS_TREE_TEST_H
+#define B_PLUS_TREE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class BPlusTree_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    BPlusTree_Test();
+
+private:
+    void initTest();
+    void insertGet_test();
+    void remove_test();
+    void iterator_test();
+    void reopen_test();
+    void bulkLoad_test();
+    void closeTest();
+
+    std::string m_filePath = "";
+    void deleteFile(const std::string &path);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // B_PLUS_TREE_TEST_H
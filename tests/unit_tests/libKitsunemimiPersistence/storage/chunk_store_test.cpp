@@ -0,0 +1,315 @@
+/**
+ *  @file    chunk_store_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "chunk_store_test.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/storage/chunk_store.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+ChunkStore_Test::ChunkStore_Test()
+    : Kitsunemimi::CompareTestHelper("ChunkStore_Test")
+{
+    initTest();
+    storeRestoreData_test();
+    deduplication_test();
+    storeRestoreFiles_test();
+    reopen_test();
+    recovery_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+ChunkStore_Test::initTest()
+{
+    m_directoryPath = "/tmp/chunkStore_test";
+    m_filesPath = "/tmp/chunkStore_test_files";
+    deleteDirectory(m_directoryPath);
+    deleteDirectory(m_filesPath);
+}
+
+/**
+ * storeRestoreData_test
+ */
+void
+ChunkStore_Test::storeRestoreData_test()
+{
+    std::string errorMessage = "";
+    std::string restored = "";
+    std::vector<ChunkHash> recipe;
+    ChunkStore store(1024);
+
+    const std::string data = createTestData(100000, 1);
+    TEST_EQUAL(store.storeData(data.c_str(), data.size(), recipe), false);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), false);
+
+    TEST_EQUAL(store.storeData(data.c_str(), data.size(), recipe), true);
+    const bool multipleChunks = recipe.size() > 10 && recipe.size() < 400;
+    TEST_EQUAL(multipleChunks, true);
+    TEST_EQUAL(store.getStoredSize(), data.size());
+    TEST_EQUAL(store.restoreData(recipe, restored), true);
+    bool isEqual = restored == data;
+    TEST_EQUAL(isEqual, true);
+
+    // empty data
+    TEST_EQUAL(store.storeData("", 0, recipe), true);
+    TEST_EQUAL(recipe.size(), 0);
+    TEST_EQUAL(store.restoreData(recipe, restored), true);
+    TEST_EQUAL(restored, "");
+
+    // negative test
+    ChunkHash unknownHash;
+    recipe.push_back(unknownHash);
+    TEST_EQUAL(store.restoreData(recipe, restored), false);
+
+    TEST_EQUAL(store.flush(), true);
+    TEST_EQUAL(store.closeStore(), true);
+    TEST_EQUAL(store.closeStore(), false);
+
+    deleteDirectory(m_directoryPath);
+}
+
+/**
+ * deduplication_test
+ */
+void
+ChunkStore_Test::deduplication_test()
+{
+    std::string errorMessage = "";
+    std::string restored = "";
+    std::vector<ChunkHash> recipe1;
+    std::vector<ChunkHash> recipe2;
+    ChunkStore store(1024);
+    store.initStore(m_directoryPath, errorMessage);
+
+    const std::string data = createTestData(200000, 2);
+    store.storeData(data.c_str(), data.size(), recipe1);
+    const uint64_t numberOfChunks = store.getNumberOfChunks();
+
+    // identical data don't need new chunks
+    TEST_EQUAL(store.storeData(data.c_str(), data.size(), recipe2), true);
+    TEST_EQUAL(store.getNumberOfChunks(), numberOfChunks);
+    TEST_EQUAL(recipe1.size(), recipe2.size());
+
+    // an insertion only changes the chunks around it
+    std::string modified = data;
+    modified.insert(100000, "inserted text");
+    TEST_EQUAL(store.storeData(modified.c_str(), modified.size(), recipe2), true);
+    const bool fewNewChunks = store.getNumberOfChunks() - numberOfChunks < 5;
+    TEST_EQUAL(fewNewChunks, true);
+    TEST_EQUAL(store.restoreData(recipe2, restored), true);
+    const bool isEqual = restored == modified;
+    TEST_EQUAL(isEqual, true);
+
+    store.closeStore();
+    deleteDirectory(m_directoryPath);
+}
+
+/**
+ * storeRestoreFiles_test
+ */
+void
+ChunkStore_Test::storeRestoreFiles_test()
+{
+    std::string errorMessage = "";
+    std::vector<ChunkHash> recipe;
+    std::vector<std::vector<ChunkHash>> recipes;
+    ChunkStore store(1024, 64 * 1024, 4);
+    store.initStore(m_directoryPath, errorMessage);
+    fs::create_directories(m_filesPath);
+
+    // create files, where half of them have the same content
+    std::vector<std::string> sourcePaths;
+    std::vector<std::string> targetPaths;
+    std::vector<std::string> contents;
+    for(uint64_t i = 0; i < 8; i++)
+    {
+        const std::string path = m_filesPath + "/source" + std::to_string(i);
+        contents.push_back(createTestData(30000 + i * 1000, i % 4));
+        std::ofstream file(path, std::ios_base::binary);
+        file << contents.back();
+        sourcePaths.push_back(path);
+        targetPaths.push_back(m_filesPath + "/target" + std::to_string(i));
+    }
+
+    TEST_EQUAL(store.storeFiles(sourcePaths, recipes, errorMessage), true);
+    TEST_EQUAL(recipes.size(), 8);
+    const bool deduplicated = store.getStoredSize() < 8 * 30000;
+    TEST_EQUAL(deduplicated, true);
+
+    TEST_EQUAL(store.restoreFiles(recipes, targetPaths, errorMessage), true);
+    bool allEqual = true;
+    for(uint64_t i = 0; i < 8; i++)
+    {
+        std::ifstream file(targetPaths.at(i), std::ios_base::binary);
+        const std::string content((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+        if(content != contents.at(i)) {
+            allEqual = false;
+        }
+    }
+    TEST_EQUAL(allEqual, true);
+
+    // single file
+    TEST_EQUAL(store.storeFile(sourcePaths.at(0), recipe, errorMessage), true);
+    TEST_EQUAL(recipe.size(), recipes.at(0).size());
+    TEST_EQUAL(store.restoreFile(recipe, targetPaths.at(1), errorMessage), true);
+    TEST_EQUAL(fs::file_size(targetPaths.at(1)), contents.at(0).size());
+
+    // negative test
+    sourcePaths.push_back(m_filesPath + "/fail");
+    TEST_EQUAL(store.storeFiles(sourcePaths, recipes, errorMessage), false);
+    TEST_EQUAL(store.storeFile(m_filesPath + "/fail", recipe, errorMessage), false);
+    TEST_EQUAL(store.restoreFiles(recipes, targetPaths, errorMessage), false);
+
+    store.closeStore();
+    deleteDirectory(m_directoryPath);
+    deleteDirectory(m_filesPath);
+}
+
+/**
+ * reopen_test
+ */
+void
+ChunkStore_Test::reopen_test()
+{
+    std::string errorMessage = "";
+    std::string restored = "";
+    std::vector<ChunkHash> recipe;
+
+    const std::string data = createTestData(300000, 5);
+    uint64_t numberOfChunks = 0;
+    {
+        // small packs to get multiple sealed packs with index-files
+        ChunkStore store(1024, 32 * 1024);
+        store.initStore(m_directoryPath, errorMessage);
+        store.storeData(data.c_str(), data.size(), recipe);
+        numberOfChunks = store.getNumberOfChunks();
+    }
+
+    // files with other names must be ignored
+    {
+        std::ofstream strayFile(m_directoryPath + "/backup.pack");
+        strayFile << "stray";
+    }
+
+    ChunkStore store(1024, 32 * 1024);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.getNumberOfChunks(), numberOfChunks);
+    TEST_EQUAL(store.getStoredSize(), data.size());
+    TEST_EQUAL(store.restoreData(recipe, restored), true);
+    bool isEqual = restored == data;
+    TEST_EQUAL(isEqual, true);
+
+    store.closeStore();
+    deleteDirectory(m_directoryPath);
+}
+
+/**
+ * recovery_test
+ */
+void
+ChunkStore_Test::recovery_test()
+{
+    std::string errorMessage = "";
+    std::string restored = "";
+    std::vector<ChunkHash> recipe;
+
+    const std::string data = createTestData(50000, 6);
+    {
+        ChunkStore store(1024);
+        store.initStore(m_directoryPath, errorMessage);
+        store.storeData(data.c_str(), data.size(), recipe);
+    }
+
+    // simulate incomplete write at the end of the active pack
+    {
+        const std::string packPath = m_directoryPath + "/00000000000000000000.pack";
+        std::ofstream packFile(packPath, std::ios_base::app | std::ios_base::binary);
+        packFile << "broken chunk";
+    }
+
+    ChunkStore store(1024);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.restoreData(recipe, restored), true);
+    bool isEqual = restored == data;
+    TEST_EQUAL(isEqual, true);
+
+    // store is still writable
+    const std::string newData = createTestData(10000, 7);
+    TEST_EQUAL(store.storeData(newData.c_str(), newData.size(), recipe), true);
+    TEST_EQUAL(store.restoreData(recipe, restored), true);
+    isEqual = restored == newData;
+    TEST_EQUAL(isEqual, true);
+
+    store.closeStore();
+    deleteDirectory(m_directoryPath);
+}
+
+/**
+ * closeTest
+ */
+void
+ChunkStore_Test::closeTest()
+{
+    deleteDirectory(m_directoryPath);
+    deleteDirectory(m_filesPath);
+}
+
+/**
+ * @brief create pseudo-random test-data
+ *
+ * @param size number of bytes
+ * @param seed seed for the generated content
+ *
+ * @return test-data
+ */
+std::string
+ChunkStore_Test::createTestData(const uint64_t size,
+                                const uint64_t seed)
+{
+    std::string data(size, '\0');
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for(uint64_t i = 0; i < size; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        data[i] = static_cast<char>(state & 0xFF);
+    }
+
+    return data;
+}
+
+/**
+ * common usage to delete test-directory
+ *
+ * @param path path of the directory to delete
+ */
+void
+ChunkStore_Test::deleteDirectory(const std::string &path)
+{
+    fs::path rootPathObj(path);
+    if(fs::exists(rootPathObj)) {
+        fs::remove_all(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
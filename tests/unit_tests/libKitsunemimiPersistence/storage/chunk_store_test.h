@@ -0,0 +1,44 @@
+/**
+ *  @file    chunk_store_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef CHUNK_STORE_TEST_H
+#define CHUNK_STORE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class ChunkStore_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    ChunkStore_Test();
+
+private:
+    void initTest();
+    void storeRestoreData_test();
+    void deduplication_test();
+    void storeRestoreFiles_test();
+    void reopen_test();
+    void recovery_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+    std::string m_filesPath = "";
+    std::string createTestData(const uint64_t size,
+                               const uint64_t seed);
+    void deleteDirectory(const std::string &path);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // CHUNK_STORE_TEST_H
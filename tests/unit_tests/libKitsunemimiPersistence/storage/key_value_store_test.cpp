@@ -0,0 +1,330 @@
+/**
+ *  @file    key_value_store_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "key_value_store_test.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/storage/key_value_store.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+KeyValueStore_Test::KeyValueStore_Test()
+    : Kitsunemimi::CompareTestHelper("KeyValueStore_Test")
+{
+    initTest();
+    putGet_test();
+    remove_test();
+    reopen_test();
+    recovery_test();
+    compact_test();
+    brokenEntry_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+KeyValueStore_Test::initTest()
+{
+    m_directoryPath = "/tmp/keyValueStore_test";
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * putGet_test
+ */
+void
+KeyValueStore_Test::putGet_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    KeyValueStore store;
+
+    TEST_EQUAL(store.put("key", "value"), false);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), false);
+
+    TEST_EQUAL(store.put("key1", "value1"), true);
+    TEST_EQUAL(store.put("key2", "value2"), true);
+    TEST_EQUAL(store.put("key1", "value1-new"), true);
+    TEST_EQUAL(store.put("empty", ""), true);
+    TEST_EQUAL(store.getNumberOfKeys(), 3);
+
+    TEST_EQUAL(store.get("key1", value), true);
+    TEST_EQUAL(value, "value1-new");
+    TEST_EQUAL(store.get("key2", value), true);
+    TEST_EQUAL(value, "value2");
+    TEST_EQUAL(store.get("empty", value), true);
+    TEST_EQUAL(value, "");
+
+    // negative test
+    TEST_EQUAL(store.get("fail", value), false);
+
+    TEST_EQUAL(store.flush(), true);
+    TEST_EQUAL(store.closeStore(), true);
+    TEST_EQUAL(store.closeStore(), false);
+
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * remove_test
+ */
+void
+KeyValueStore_Test::remove_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    KeyValueStore store;
+    store.initStore(m_directoryPath, errorMessage);
+
+    store.put("key1", "value1");
+    store.put("key2", "value2");
+
+    TEST_EQUAL(store.remove("key1"), true);
+    TEST_EQUAL(store.remove("key1"), false);
+    TEST_EQUAL(store.get("key1", value), false);
+    TEST_EQUAL(store.get("key2", value), true);
+    TEST_EQUAL(store.getNumberOfKeys(), 1);
+
+    store.closeStore();
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * reopen_test
+ */
+void
+KeyValueStore_Test::reopen_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+
+    {
+        KeyValueStore store(1024);
+        store.initStore(m_directoryPath, errorMessage);
+        for(uint32_t i = 0; i < 100; i++) {
+            store.put("key" + std::to_string(i), "value" + std::to_string(i));
+        }
+        store.remove("key42");
+        store.put("key7", "updated");
+        store.closeStore();
+    }
+
+    KeyValueStore store(1024);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.getNumberOfKeys(), 99);
+    TEST_EQUAL(store.get("key42", value), false);
+    TEST_EQUAL(store.get("key7", value), true);
+    TEST_EQUAL(value, "updated");
+    TEST_EQUAL(store.get("key99", value), true);
+    TEST_EQUAL(value, "value99");
+
+    store.closeStore();
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * recovery_test
+ */
+void
+KeyValueStore_Test::recovery_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    const std::string copyPath = m_directoryPath + "_copy";
+    deleteStore(copyPath);
+
+    // create a snapshot and write more entries behind the snapshot
+    {
+        KeyValueStore store(1024);
+        store.initStore(m_directoryPath, errorMessage);
+        for(uint32_t i = 0; i < 50; i++) {
+            store.put("key" + std::to_string(i), "value" + std::to_string(i));
+        }
+        store.closeStore();
+    }
+
+    KeyValueStore store(1024);
+    store.initStore(m_directoryPath, errorMessage);
+    for(uint32_t i = 50; i < 80; i++) {
+        store.put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    store.remove("key3");
+    store.put("key4", "updated");
+    store.flush();
+
+    // copy the store while it is open to simulate a crash and add a broken entry
+    fs::create_directory(copyPath);
+    std::string lastFile = "";
+    for(fs::directory_iterator it(m_directoryPath); it != fs::directory_iterator(); ++it)
+    {
+        fs::copy_file(it->path(), copyPath + "/" + it->path().filename().string());
+        if(it->path().extension() == ".vlog"
+                && it->path().filename().string() > lastFile)
+        {
+            lastFile = it->path().filename().string();
+        }
+    }
+    {
+        std::ofstream file(copyPath + "/" + lastFile, std::ios_base::app | std::ios_base::binary);
+        file << "broken entry";
+    }
+
+    KeyValueStore recovered(1024);
+    TEST_EQUAL(recovered.initStore(copyPath, errorMessage), true);
+    TEST_EQUAL(recovered.getNumberOfKeys(), 79);
+    TEST_EQUAL(recovered.get("key3", value), false);
+    TEST_EQUAL(recovered.get("key4", value), true);
+    TEST_EQUAL(value, "updated");
+    TEST_EQUAL(recovered.get("key79", value), true);
+    TEST_EQUAL(value, "value79");
+    TEST_EQUAL(recovered.put("key80", "value80"), true);
+    recovered.closeStore();
+
+    // recovery without snapshot
+    fs::remove(copyPath + "/index.snapshot");
+    TEST_EQUAL(recovered.initStore(copyPath, errorMessage), true);
+    TEST_EQUAL(recovered.getNumberOfKeys(), 80);
+    TEST_EQUAL(recovered.get("key3", value), false);
+    TEST_EQUAL(recovered.get("key4", value), true);
+    TEST_EQUAL(value, "updated");
+    recovered.closeStore();
+
+    store.closeStore();
+    deleteStore(copyPath);
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * compact_test
+ */
+void
+KeyValueStore_Test::compact_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+    KeyValueStore store(512, 2.0f);
+    store.initStore(m_directoryPath, errorMessage);
+
+    // overwrite the same keys multiple times to create many outdated entries
+    for(uint32_t round = 0; round < 10; round++)
+    {
+        for(uint32_t i = 0; i < 20; i++) {
+            store.put("key" + std::to_string(i), "value" + std::to_string(round));
+        }
+    }
+    store.remove("key0");
+
+    const uint64_t numberOfFilesBefore = std::distance(fs::directory_iterator(m_directoryPath),
+                                                       fs::directory_iterator());
+    TEST_EQUAL(store.compact(), true);
+    const uint64_t numberOfFilesAfter = std::distance(fs::directory_iterator(m_directoryPath),
+                                                      fs::directory_iterator());
+    const bool isSmaller = numberOfFilesAfter < numberOfFilesBefore;
+    TEST_EQUAL(isSmaller, true);
+    TEST_EQUAL(fs::exists(m_directoryPath + "/compaction.marker"), false);
+
+    // check content after compaction
+    TEST_EQUAL(store.getNumberOfKeys(), 19);
+    TEST_EQUAL(store.get("key0", value), false);
+    TEST_EQUAL(store.get("key5", value), true);
+    TEST_EQUAL(value, "value9");
+
+    // check content after reopen
+    store.closeStore();
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(store.getNumberOfKeys(), 19);
+    TEST_EQUAL(store.get("key0", value), false);
+    TEST_EQUAL(store.get("key19", value), true);
+    TEST_EQUAL(value, "value9");
+
+    store.closeStore();
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * brokenEntry_test
+ */
+void
+KeyValueStore_Test::brokenEntry_test()
+{
+    std::string errorMessage = "";
+    std::string value = "";
+
+    // files with other names are ignored
+    fs::create_directories(m_directoryPath);
+    {
+        std::ofstream strayFile(m_directoryPath + "/backup.vlog");
+        strayFile << "stray";
+    }
+
+    KeyValueStore store(512, 2.0f);
+    TEST_EQUAL(store.initStore(m_directoryPath, errorMessage), true);
+    for(uint32_t round = 0; round < 10; round++)
+    {
+        for(uint32_t i = 0; i < 20; i++) {
+            store.put("key" + std::to_string(i), "value" + std::to_string(round));
+        }
+    }
+
+    // break the last entry of the first value-log-file
+    const std::string firstFile = m_directoryPath + "/00000000000000000000.vlog";
+    const uint64_t firstFileSize = fs::file_size(firstFile);
+    {
+        std::fstream file(firstFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(firstFileSize - 1));
+        file.put('X');
+    }
+
+    // negative test: broken entries are not copied
+    const uint64_t numberOfFilesBefore = std::distance(fs::directory_iterator(m_directoryPath),
+                                                       fs::directory_iterator());
+    TEST_EQUAL(store.compact(), false);
+    const uint64_t numberOfFilesAfter = std::distance(fs::directory_iterator(m_directoryPath),
+                                                      fs::directory_iterator());
+    TEST_EQUAL(numberOfFilesAfter, numberOfFilesBefore);
+    TEST_EQUAL(store.get("key19", value), true);
+    TEST_EQUAL(value, "value9");
+
+    store.closeStore();
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * closeTest
+ */
+void
+KeyValueStore_Test::closeTest()
+{
+    deleteStore(m_directoryPath);
+}
+
+/**
+ * common usage to delete test-directory
+ *
+ * @param path path of the directory to delete
+ */
+void
+KeyValueStore_Test::deleteStore(const std::string &path)
+{
+    fs::path rootPathObj(path);
+    if(fs::exists(rootPathObj)) {
+        fs::remove_all(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,42 @@
+/**
+ *  @file    key_value_store_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef KEY_VALUE_STORE_TEST_H
+#define KEY_VALUE_STORE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class KeyValueStore_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    KeyValueStore_Test();
+
+private:
+    void initTest();
+    void putGet_test();
+    void remove_test();
+    void reopen_test();
+    void recovery_test();
+    void compact_test();
+    void brokenEntry_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+    void deleteStore(const std::string &path);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // KEY_VALUE_STORE_TEST_H
@@ -0,0 +1,273 @@
+/**
+ *  @file    persistent_queue_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "persistent_queue_test.h"
+
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/storage/persistent_queue.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+PersistentQueue_Test::PersistentQueue_Test()
+    : Kitsunemimi::CompareTestHelper("PersistentQueue_Test")
+{
+    initTest();
+    enqueueDequeue_test();
+    acknowledge_test();
+    multipleConsumers_test();
+    reopen_test();
+    removeSegments_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+PersistentQueue_Test::initTest()
+{
+    m_directoryPath = "/tmp/persistentQueue_test";
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * enqueueDequeue_test
+ */
+void
+PersistentQueue_Test::enqueueDequeue_test()
+{
+    std::string errorMessage = "";
+    std::vector<QueueItem> items;
+    PersistentQueue queue;
+
+    TEST_EQUAL(queue.enqueue("item", 4), false);
+    TEST_EQUAL(queue.addConsumer("consumer"), false);
+    TEST_EQUAL(queue.initQueue(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(queue.initQueue(m_directoryPath, errorMessage), false);
+
+    // consumer on empty queue
+    TEST_EQUAL(queue.addConsumer("consumer"), true);
+    TEST_EQUAL(queue.addConsumer("consumer"), false);
+    TEST_EQUAL(queue.dequeue("consumer", items, 10), true);
+    TEST_EQUAL(items.size(), 0);
+
+    TEST_EQUAL(queue.enqueue("item0", 5), true);
+    std::vector<std::string> batch = {"item1", "item2", "item3"};
+    TEST_EQUAL(queue.enqueue(batch), true);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer"), 4);
+
+    TEST_EQUAL(queue.dequeue("consumer", items, 3), true);
+    TEST_EQUAL(items.size(), 3);
+    TEST_EQUAL(items.at(0).itemId, 0);
+    TEST_EQUAL(items.at(0).data, "item0");
+    TEST_EQUAL(items.at(2).data, "item2");
+    TEST_EQUAL(queue.dequeue("consumer", items, 3), true);
+    TEST_EQUAL(items.size(), 1);
+    TEST_EQUAL(items.at(0).data, "item3");
+    TEST_EQUAL(queue.dequeue("consumer", items, 3), true);
+    TEST_EQUAL(items.size(), 0);
+
+    // negative test
+    TEST_EQUAL(queue.dequeue("fail", items, 3), false);
+
+    TEST_EQUAL(queue.flush(), true);
+    TEST_EQUAL(queue.closeQueue(), true);
+    TEST_EQUAL(queue.closeQueue(), false);
+
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * acknowledge_test
+ */
+void
+PersistentQueue_Test::acknowledge_test()
+{
+    std::string errorMessage = "";
+    std::vector<QueueItem> items;
+    PersistentQueue queue;
+    queue.initQueue(m_directoryPath, errorMessage);
+    queue.addConsumer("consumer");
+
+    std::vector<std::string> batch = {"item0", "item1", "item2", "item3"};
+    queue.enqueue(batch);
+    queue.dequeue("consumer", items, 2);
+
+    // items can only be acknowledged after they were delivered
+    TEST_EQUAL(queue.acknowledge("consumer", 2), false);
+    TEST_EQUAL(queue.acknowledge("consumer", 0), true);
+    TEST_EQUAL(queue.acknowledge("consumer", 0), true);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer"), 3);
+    TEST_EQUAL(queue.acknowledge("fail", 0), false);
+
+    // not acknowledged items are delivered again after rewind
+    TEST_EQUAL(queue.rewind("consumer"), true);
+    TEST_EQUAL(queue.dequeue("consumer", items, 10), true);
+    TEST_EQUAL(items.size(), 3);
+    TEST_EQUAL(items.at(0).data, "item1");
+    TEST_EQUAL(queue.acknowledge("consumer", 3), true);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer"), 0);
+
+    queue.closeQueue();
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * multipleConsumers_test
+ */
+void
+PersistentQueue_Test::multipleConsumers_test()
+{
+    std::string errorMessage = "";
+    std::vector<QueueItem> items;
+    PersistentQueue queue;
+    queue.initQueue(m_directoryPath, errorMessage);
+
+    // new consumer starts at the oldest item within the queue
+    queue.enqueue("item0", 5);
+    queue.addConsumer("consumer1");
+    queue.enqueue("item1", 5);
+    queue.addConsumer("consumer2");
+
+    TEST_EQUAL(queue.dequeue("consumer1", items, 10), true);
+    TEST_EQUAL(items.size(), 2);
+    queue.acknowledge("consumer1", 1);
+
+    TEST_EQUAL(queue.dequeue("consumer2", items, 1), true);
+    TEST_EQUAL(items.size(), 1);
+    TEST_EQUAL(items.at(0).data, "item0");
+
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer1"), 0);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer2"), 2);
+
+    TEST_EQUAL(queue.removeConsumer("consumer2"), true);
+    TEST_EQUAL(queue.removeConsumer("consumer2"), false);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer2"), 0);
+
+    queue.closeQueue();
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * reopen_test
+ */
+void
+PersistentQueue_Test::reopen_test()
+{
+    std::string errorMessage = "";
+    std::vector<QueueItem> items;
+
+    {
+        PersistentQueue queue(SYNC_DURABILITY);
+        queue.initQueue(m_directoryPath, errorMessage);
+        queue.addConsumer("consumer");
+        std::vector<std::string> batch = {"item0", "item1", "item2", "item3"};
+        queue.enqueue(batch);
+        queue.dequeue("consumer", items, 3);
+        queue.acknowledge("consumer", 1);
+    }
+
+    // delivered but not acknowledged items are delivered again
+    PersistentQueue queue;
+    TEST_EQUAL(queue.initQueue(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(queue.addConsumer("consumer"), false);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer"), 2);
+    TEST_EQUAL(queue.dequeue("consumer", items, 10), true);
+    TEST_EQUAL(items.size(), 2);
+    TEST_EQUAL(items.at(0).itemId, 2);
+    TEST_EQUAL(items.at(0).data, "item2");
+
+    queue.closeQueue();
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * removeSegments_test
+ */
+void
+PersistentQueue_Test::removeSegments_test()
+{
+    std::string errorMessage = "";
+    std::vector<QueueItem> items;
+    PersistentQueue queue(NO_DURABILITY, 256);
+    queue.initQueue(m_directoryPath, errorMessage);
+    queue.addConsumer("consumer1");
+    queue.addConsumer("consumer2");
+
+    for(uint64_t i = 0; i < 100; i++)
+    {
+        const std::string item = "item" + std::to_string(i);
+        queue.enqueue(item.c_str(), item.size());
+    }
+
+    const uint64_t numberOfFiles = std::distance(fs::directory_iterator(m_directoryPath),
+                                                 fs::directory_iterator());
+
+    // segments are only deleted, when acknowledged by all consumers
+    queue.dequeue("consumer1", items, 100);
+    queue.acknowledge("consumer1", 99);
+    uint64_t currentNumber = std::distance(fs::directory_iterator(m_directoryPath),
+                                           fs::directory_iterator());
+    TEST_EQUAL(currentNumber, numberOfFiles);
+
+    queue.dequeue("consumer2", items, 50);
+    queue.acknowledge("consumer2", 49);
+    currentNumber = std::distance(fs::directory_iterator(m_directoryPath),
+                                  fs::directory_iterator());
+    bool isSmaller = currentNumber < numberOfFiles;
+    TEST_EQUAL(isSmaller, true);
+
+    // reader continues behind removed segments
+    queue.enqueue("item100", 7);
+    TEST_EQUAL(queue.dequeue("consumer2", items, 100), true);
+    TEST_EQUAL(items.size(), 51);
+    TEST_EQUAL(items.at(0).itemId, 50);
+    TEST_EQUAL(items.at(50).data, "item100");
+
+    // reopen after removed segments
+    queue.closeQueue();
+    TEST_EQUAL(queue.initQueue(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(queue.getNumberOfPendingItems("consumer2"), 51);
+    TEST_EQUAL(queue.dequeue("consumer2", items, 1), true);
+    TEST_EQUAL(items.size(), 1);
+    TEST_EQUAL(items.at(0).itemId, 50);
+
+    queue.closeQueue();
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * closeTest
+ */
+void
+PersistentQueue_Test::closeTest()
+{
+    deleteQueue(m_directoryPath);
+}
+
+/**
+ * common usage to delete test-directory
+ *
+ * @param path path of the directory to delete
+ */
+void
+PersistentQueue_Test::deleteQueue(const std::string &path)
+{
+    fs::path rootPathObj(path);
+    if(fs::exists(rootPathObj)) {
+        fs::remove_all(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
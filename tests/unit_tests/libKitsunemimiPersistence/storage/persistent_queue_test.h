@@ -0,0 +1,41 @@
+/**
+ *  @file    persistent_queue_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef PERSISTENT_QUEUE_TEST_H
+#define PERSISTENT_QUEUE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class PersistentQueue_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    PersistentQueue_Test();
+
+private:
+    void initTest();
+    void enqueueDequeue_test();
+    void acknowledge_test();
+    void multipleConsumers_test();
+    void reopen_test();
+    void removeSegments_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+    void deleteQueue(const std::string &path);
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // PERSISTENT_QUEUE_TEST_H
@@ -0,0 +1,349 @@
+/**
+ *  @file    record_log_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#include "record_log_test.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <libKitsunemimiPersistence/storage/record_log.h>
+
+namespace fs=boost::filesystem;
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+RecordLog_Test::RecordLog_Test()
+    : Kitsunemimi::CompareTestHelper("RecordLog_Test")
+{
+    initTest();
+    appendRecord_test();
+    appendRecords_test();
+    seekToRecord_test();
+    seekToTimestamp_test();
+    recovery_test();
+    removeSegmentsBefore_test();
+    closeTest();
+}
+
+/**
+ * initTest
+ */
+void
+RecordLog_Test::initTest()
+{
+    m_directoryPath = "/tmp/recordLog_test";
+    deleteLog();
+}
+
+/**
+ * appendRecord_test
+ */
+void
+RecordLog_Test::appendRecord_test()
+{
+    std::string errorMessage = "";
+    RecordLog log(1024, 4);
+
+    TEST_EQUAL(log.appendRecord("asdf", 4), false);
+    TEST_EQUAL(log.initLog(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(log.initLog(m_directoryPath, errorMessage), false);
+
+    // write enough records to create multiple segments
+    for(uint64_t i = 0; i < 100; i++)
+    {
+        const std::string content = "record-" + std::to_string(i);
+        TEST_EQUAL(log.appendRecord(content.c_str(), content.size(), 1000 + i), true);
+    }
+    TEST_EQUAL(log.getFirstRecordId(), 0);
+    TEST_EQUAL(log.getNextRecordId(), 100);
+    TEST_EQUAL(log.flush(), true);
+
+    // replay all records
+    RecordLogReader reader(log, 64);
+    LogRecord record;
+    uint64_t counter = 0;
+    bool allCorrect = true;
+    while(reader.next(record))
+    {
+        const std::string content(reinterpret_cast<const char*>(record.data), record.dataSize);
+        if(record.recordId != counter
+                || record.timestamp != 1000 + counter
+                || content != "record-" + std::to_string(counter))
+        {
+            allCorrect = false;
+        }
+        counter++;
+    }
+    TEST_EQUAL(counter, 100);
+    TEST_EQUAL(allCorrect, true);
+
+    // reader continues, when new records are appended
+    TEST_EQUAL(log.appendRecord("poi", 3), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 100);
+    TEST_EQUAL(std::string(reinterpret_cast<const char*>(record.data), record.dataSize), "poi");
+    TEST_EQUAL(reader.next(record), false);
+
+    // timestamps are never decreasing
+    const bool timestampIncreased = record.timestamp >= 1099;
+    TEST_EQUAL(timestampIncreased, true);
+
+    TEST_EQUAL(log.closeLog(), true);
+    TEST_EQUAL(log.closeLog(), false);
+
+    deleteLog();
+}
+
+/**
+ * appendRecords_test
+ */
+void
+RecordLog_Test::appendRecords_test()
+{
+    std::string errorMessage = "";
+    RecordLog log(256, 2);
+    log.initLog(m_directoryPath, errorMessage);
+
+    // batch is bigger than a segment, so it must be split
+    std::vector<std::string> records;
+    for(uint64_t i = 0; i < 50; i++) {
+        records.push_back("batch-" + std::to_string(i));
+    }
+    TEST_EQUAL(log.appendRecords(records, 42), true);
+    TEST_EQUAL(log.getNextRecordId(), 50);
+
+    RecordLogReader reader(log);
+    LogRecord record;
+    uint64_t counter = 0;
+    while(reader.next(record))
+    {
+        const std::string content(reinterpret_cast<const char*>(record.data), record.dataSize);
+        TEST_EQUAL(content, records.at(counter));
+        counter++;
+    }
+    TEST_EQUAL(counter, 50);
+
+    log.closeLog();
+    deleteLog();
+}
+
+/**
+ * seekToRecord_test
+ */
+void
+RecordLog_Test::seekToRecord_test()
+{
+    std::string errorMessage = "";
+    RecordLog log(512, 8);
+    log.initLog(m_directoryPath, errorMessage);
+
+    for(uint64_t i = 0; i < 200; i++)
+    {
+        const std::string content = std::to_string(i);
+        log.appendRecord(content.c_str(), content.size(), 100 + i);
+    }
+
+    RecordLogReader reader(log);
+    LogRecord record;
+
+    TEST_EQUAL(reader.seekToRecord(137), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 137);
+    TEST_EQUAL(std::string(reinterpret_cast<const char*>(record.data), record.dataSize), "137");
+
+    TEST_EQUAL(reader.seekToRecord(0), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 0);
+
+    TEST_EQUAL(reader.seekToRecord(199), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 199);
+    TEST_EQUAL(reader.next(record), false);
+
+    // negative test
+    TEST_EQUAL(reader.seekToRecord(500), false);
+
+    log.closeLog();
+    deleteLog();
+}
+
+/**
+ * seekToTimestamp_test
+ */
+void
+RecordLog_Test::seekToTimestamp_test()
+{
+    std::string errorMessage = "";
+    RecordLog log(512, 8);
+    log.initLog(m_directoryPath, errorMessage);
+
+    // every timestamp is used for two records
+    for(uint64_t i = 0; i < 200; i++)
+    {
+        const std::string content = std::to_string(i);
+        log.appendRecord(content.c_str(), content.size(), 1000 + (i / 2) * 10);
+    }
+
+    RecordLogReader reader(log);
+    LogRecord record;
+
+    TEST_EQUAL(reader.seekToTimestamp(1500), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 100);
+    TEST_EQUAL(record.timestamp, 1500);
+
+    TEST_EQUAL(reader.seekToTimestamp(1505), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 102);
+
+    TEST_EQUAL(reader.seekToTimestamp(0), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 0);
+
+    TEST_EQUAL(reader.seekToTimestamp(99999), true);
+    TEST_EQUAL(reader.next(record), false);
+
+    log.closeLog();
+    deleteLog();
+}
+
+/**
+ * recovery_test
+ */
+void
+RecordLog_Test::recovery_test()
+{
+    std::string errorMessage = "";
+
+    // create log with multiple sealed segments
+    {
+        RecordLog log(512, 8);
+        log.initLog(m_directoryPath, errorMessage);
+        for(uint64_t i = 0; i < 100; i++)
+        {
+            const std::string content = std::to_string(i);
+            log.appendRecord(content.c_str(), content.size(), 100 + i);
+        }
+        log.closeLog();
+    }
+
+    // find last segment and append a broken record
+    std::string lastSegment = "";
+    for(fs::directory_iterator it(m_directoryPath); it != fs::directory_iterator(); ++it)
+    {
+        if(it->path().extension() == ".seg"
+                && it->path().string() > lastSegment)
+        {
+            lastSegment = it->path().string();
+        }
+    }
+    {
+        std::ofstream segmentFile(lastSegment, std::ios_base::app | std::ios_base::binary);
+        segmentFile << "broken record";
+    }
+
+    // reopen log
+    RecordLog log(512, 8);
+    TEST_EQUAL(log.initLog(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(log.getNextRecordId(), 100);
+    TEST_EQUAL(log.appendRecord("new", 3), true);
+
+    RecordLogReader reader(log);
+    LogRecord record;
+    uint64_t counter = 0;
+    std::string lastContent = "";
+    while(reader.next(record))
+    {
+        lastContent = std::string(reinterpret_cast<const char*>(record.data), record.dataSize);
+        counter++;
+    }
+    TEST_EQUAL(counter, 101);
+    TEST_EQUAL(lastContent, "new");
+
+    log.closeLog();
+    deleteLog();
+}
+
+/**
+ * removeSegmentsBefore_test
+ */
+void
+RecordLog_Test::removeSegmentsBefore_test()
+{
+    std::string errorMessage = "";
+    RecordLog log(512, 8);
+    log.initLog(m_directoryPath, errorMessage);
+
+    std::vector<std::string> records;
+    for(uint64_t i = 0; i < 100; i++) {
+        records.push_back("record" + std::to_string(i));
+    }
+    log.appendRecords(records);
+
+    // nothing to remove
+    TEST_EQUAL(log.removeSegmentsBefore(0), 0);
+    TEST_EQUAL(log.getFirstRecordId(), 0);
+
+    const bool removed = log.removeSegmentsBefore(50) > 0;
+    TEST_EQUAL(removed, true);
+    const bool inRange = log.getFirstRecordId() > 0 && log.getFirstRecordId() <= 50;
+    TEST_EQUAL(inRange, true);
+
+    // removed records can not be read anymore
+    RecordLogReader reader(log);
+    LogRecord record;
+    TEST_EQUAL(reader.seekToRecord(0), false);
+    TEST_EQUAL(reader.seekToRecord(50), true);
+    TEST_EQUAL(reader.next(record), true);
+    TEST_EQUAL(record.recordId, 50);
+
+    // active segment is never removed
+    log.removeSegmentsBefore(1000);
+    TEST_EQUAL(log.getNextRecordId(), 100);
+    TEST_EQUAL(log.appendRecord("new", 3), true);
+
+    // reopen log without the removed segments, where files with other names are ignored
+    const uint64_t firstRecordId = log.getFirstRecordId();
+    log.closeLog();
+    {
+        std::ofstream strayFile(m_directoryPath + "/backup.seg");
+        strayFile << "stray";
+    }
+    TEST_EQUAL(log.initLog(m_directoryPath, errorMessage), true);
+    TEST_EQUAL(log.getFirstRecordId(), firstRecordId);
+    TEST_EQUAL(log.getNextRecordId(), 101);
+
+    log.closeLog();
+    deleteLog();
+}
+
+/**
+ * closeTest
+ */
+void
+RecordLog_Test::closeTest()
+{
+    deleteLog();
+}
+
+/**
+ * common usage to delete test-directory
+ */
+void
+RecordLog_Test::deleteLog()
+{
+    fs::path rootPathObj(m_directoryPath);
+    if(fs::exists(rootPathObj)) {
+        fs::remove_all(rootPathObj);
+    }
+}
+
+} // namespace Persistence
+} // namespace Kitsunemimi
@@ -0,0 +1,42 @@
+/**
+ *  @file    record_log_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef RECORD_LOG_TEST_H
+#define RECORD_LOG_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+namespace Persistence
+{
+
+class RecordLog_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+public:
+    RecordLog_Test();
+
+private:
+    void initTest();
+    void appendRecord_test();
+    void appendRecords_test();
+    void seekToRecord_test();
+    void seekToTimestamp_test();
+    void recovery_test();
+    void removeSegmentsBefore_test();
+    void closeTest();
+
+    std::string m_directoryPath = "";
+    void deleteLog();
+};
+
+} // namespace Persistence
+} // namespace Kitsunemimi
+
+#endif // RECORD_LOG_TEST_H
@@ -13,6 +13,26 @@
 #include <libKitsunemimiPersistence/files/file_methods_test.h>
 #include <libKitsunemimiPersistence/database/sqlite_test.h>
 #include <libKitsunemimiPersistence/logger/logger_test.h>
+#include <libKitsunemimiPersistence/storage/record_log_test.h>
+#include <libKitsunemimiPersistence/storage/key_value_store_test.h>
+#include <libKitsunemimiPersistence/storage/b_plus_tree_test.h>
+#include <libKitsunemimiPersistence/storage/persistent_queue_test.h>
+#include <libKitsunemimiPersistence/storage/chunk_store_test.h>
+#include <libKitsunemimiPersistence/files/mapped_file_test.h>
+#include <libKitsunemimiPersistence/files/line_reader_test.h>
+#include <libKitsunemimiPersistence/files/text_chunk_processor_test.h>
+#include <libKitsunemimiPersistence/files/line_index_test.h>
+#include <libKitsunemimiPersistence/files/append_writer_test.h>
+#include <libKitsunemimiPersistence/files/text_file_editor_test.h>
+#include <libKitsunemimiPersistence/files/file_cache_test.h>
+#include <libKitsunemimiPersistence/files/file_follower_test.h>
+#include <libKitsunemimiPersistence/files/compressed_file_test.h>
+#include <libKitsunemimiPersistence/files/delimited_file_reader_test.h>
+#include <libKitsunemimiPersistence/files/file_filter_test.h>
+#include <libKitsunemimiPersistence/files/tree_copy_test.h>
+#include <libKitsunemimiPersistence/files/tree_remove_test.h>
+#include <libKitsunemimiPersistence/files/change_tracker_test.h>
+#include <libKitsunemimiPersistence/files/file_fingerprint_test.h>
 
 int main()
 {
@@ -22,4 +42,24 @@ int main()
     Kitsunemimi::Persistence::BinaryFile_withoutDirectIO_Test();
     Kitsunemimi::Persistence::Sqlite_Test();
     Kitsunemimi::Persistence::Logger_Test();
+    Kitsunemimi::Persistence::RecordLog_Test();
+    Kitsunemimi::Persistence::KeyValueStore_Test();
+    Kitsunemimi::Persistence::BPlusTree_Test();
+    Kitsunemimi::Persistence::PersistentQueue_Test();
+    Kitsunemimi::Persistence::ChunkStore_Test();
+    Kitsunemimi::Persistence::MappedFile_Test();
+    Kitsunemimi::Persistence::LineReader_Test();
+    Kitsunemimi::Persistence::TextChunkProcessor_Test();
+    Kitsunemimi::Persistence::LineIndex_Test();
+    Kitsunemimi::Persistence::AppendWriter_Test();
+    Kitsunemimi::Persistence::TextFileEditor_Test();
+    Kitsunemimi::Persistence::FileCache_Test();
+    Kitsunemimi::Persistence::FileFollower_Test();
+    Kitsunemimi::Persistence::CompressedFile_Test();
+    Kitsunemimi::Persistence::DelimitedFileReader_Test();
+    Kitsunemimi::Persistence::FileFilter_Test();
+    Kitsunemimi::Persistence::TreeCopy_Test();
+    Kitsunemimi::Persistence::TreeRemove_Test();
+    Kitsunemimi::Persistence::ChangeTracker_Test();
+    Kitsunemimi::Persistence::FileFingerprint_Test();
 }
@@ -3,7 +3,7 @@ include(../../defaults.pri)
 QT -= qt core gui
 
 CONFIG   -= app_bundle
-CONFIG += c++14 console
+CONFIG += c++17 console
 
 LIBS += -L../../src -lKitsunemimiPersistence
 
@@ -14,18 +14,43 @@ INCLUDEPATH += ../../../libKitsunemimiCommon/include
 
 INCLUDEPATH += $$PWD
 
-LIBS +=  -lboost_filesystem -lboost_system
+LIBS +=  -lboost_filesystem -lboost_system -lpthread -lz
 
 with_sqlite {
     LIBS += -lsqlite3
 }
 
+with_zstd {
+    DEFINES += WITH_ZSTD
+    LIBS += -lzstd
+}
+
 SOURCES += \
     libKitsunemimiPersistence/files/text_file_test.cpp \
     libKitsunemimiPersistence/logger/logger_test.cpp \
     libKitsunemimiPersistence/files/binary_file_with_directIO_test.cpp \
     libKitsunemimiPersistence/files/binary_file_without_directIO_test.cpp \
     libKitsunemimiPersistence/files/file_methods_test.cpp \
+    libKitsunemimiPersistence/storage/record_log_test.cpp \
+    libKitsunemimiPersistence/storage/key_value_store_test.cpp \
+    libKitsunemimiPersistence/storage/b_plus_tree_test.cpp \
+    libKitsunemimiPersistence/storage/persistent_queue_test.cpp \
+    libKitsunemimiPersistence/storage/chunk_store_test.cpp \
+    libKitsunemimiPersistence/files/mapped_file_test.cpp \
+    libKitsunemimiPersistence/files/line_reader_test.cpp \
+    libKitsunemimiPersistence/files/text_chunk_processor_test.cpp \
+    libKitsunemimiPersistence/files/line_index_test.cpp \
+    libKitsunemimiPersistence/files/append_writer_test.cpp \
+    libKitsunemimiPersistence/files/text_file_editor_test.cpp \
+    libKitsunemimiPersistence/files/file_cache_test.cpp \
+    libKitsunemimiPersistence/files/file_follower_test.cpp \
+    libKitsunemimiPersistence/files/compressed_file_test.cpp \
+    libKitsunemimiPersistence/files/delimited_file_reader_test.cpp \
+    libKitsunemimiPersistence/files/file_filter_test.cpp \
+    libKitsunemimiPersistence/files/tree_copy_test.cpp \
+    libKitsunemimiPersistence/files/tree_remove_test.cpp \
+    libKitsunemimiPersistence/files/change_tracker_test.cpp \
+    libKitsunemimiPersistence/files/file_fingerprint_test.cpp
 
 with_sqlite {
     SOURCES += main_with_sqlite.cpp \
@@ -39,7 +64,27 @@ HEADERS += \
     libKitsunemimiPersistence/logger/logger_test.h \
     libKitsunemimiPersistence/files/binary_file_with_directIO_test.h \
     libKitsunemimiPersistence/files/binary_file_without_directIO_test.h \
-    libKitsunemimiPersistence/files/file_methods_test.h
+    libKitsunemimiPersistence/files/file_methods_test.h \
+    libKitsunemimiPersistence/storage/record_log_test.h \
+    libKitsunemimiPersistence/storage/key_value_store_test.h \
+    libKitsunemimiPersistence/storage/b_plus_tree_test.h \
+    libKitsunemimiPersistence/storage/persistent_queue_test.h \
+    libKitsunemimiPersistence/storage/chunk_store_test.h \
+    libKitsunemimiPersistence/files/mapped_file_test.h \
+    libKitsunemimiPersistence/files/line_reader_test.h \
+    libKitsunemimiPersistence/files/text_chunk_processor_test.h \
+    libKitsunemimiPersistence/files/line_index_test.h \
+    libKitsunemimiPersistence/files/append_writer_test.h \
+    libKitsunemimiPersistence/files/text_file_editor_test.h \
+    libKitsunemimiPersistence/files/file_cache_test.h \
+    libKitsunemimiPersistence/files/file_follower_test.h \
+    libKitsunemimiPersistence/files/compressed_file_test.h \
+    libKitsunemimiPersistence/files/delimited_file_reader_test.h \
+    libKitsunemimiPersistence/files/file_filter_test.h \
+    libKitsunemimiPersistence/files/tree_copy_test.h \
+    libKitsunemimiPersistence/files/tree_remove_test.h \
+    libKitsunemimiPersistence/files/change_tracker_test.h \
+    libKitsunemimiPersistence/files/file_fingerprint_test.h
 
 with_sqlite {
     HEADERS += libKitsunemimiPersistence/database/sqlite_test.h